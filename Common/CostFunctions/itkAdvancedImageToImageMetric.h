@@ -278,6 +278,11 @@ public:
   itkGetConstReferenceMacro(UseMetricSingleThreaded, bool);
   itkBooleanMacro(UseMetricSingleThreaded);
 
+  /** Inheriting classes can specify whether GetValueAndDerivative() may be called concurrently
+   * with other metrics, once BeforeThreadedGetValueAndDerivative() has been called single-threaded;
+   * This method allows the user to inspect this setting. */
+  itkGetConstMacro(SupportsConcurrentGetValueAndDerivative, bool);
+
   /** Select the use of multi-threading*/
   // \todo: maybe these can be united, check base class.
   itkSetMacro(UseMultiThread, bool);
@@ -412,6 +417,7 @@ protected:
 
   /** Variables for multi-threading. */
   bool m_UseMetricSingleThreaded;
+  bool m_SupportsConcurrentGetValueAndDerivative;
   bool m_UseMultiThread;
   bool m_UseOpenMP;
 
@@ -480,6 +486,10 @@ protected:
    * Make sure to set it before calling Initialize; default: false. */
   itkSetMacro(UseImageSampler, bool);
 
+  /** Inheriting classes that do all thread-unsafe work of GetValueAndDerivative() in
+   * BeforeThreadedGetValueAndDerivative() can specify so; default: false. */
+  itkSetMacro(SupportsConcurrentGetValueAndDerivative, bool);
+
   /** Check if enough samples have been found to compute a reliable
    * estimate of the value/derivative; throws an exception if not. */
   virtual void
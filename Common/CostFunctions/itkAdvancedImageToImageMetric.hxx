@@ -85,6 +85,7 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::AdvancedImageToImageMetri
 
   /** Threading related variables. */
   this->m_UseMetricSingleThreaded = true;
+  this->m_SupportsConcurrentGetValueAndDerivative = false;
   this->m_UseMultiThread = false;
 
   /** OpenMP related. Switch to on when available */
@@ -307,8 +307,9 @@ protected:
 
   struct ParzenWindowHistogramGetValueAndDerivativePerThreadStruct
   {
-    SizeValueType   st_NumberOfPixelsCounted;
-    JointPDFPointer st_JointPDF;
+    SizeValueType              st_NumberOfPixelsCounted;
+    JointPDFPointer            st_JointPDF;
+    JointPDFDerivativesPointer st_JointPDFDerivatives;
   };
   itkPadStruct(ITK_CACHE_LINE_ALIGNMENT,
                ParzenWindowHistogramGetValueAndDerivativePerThreadStruct,
@@ -340,6 +341,35 @@ protected:
   void
   LaunchComputePDFsThreaderCallback(void) const;
 
+  /** Multi-threaded version of the ComputePDFsAndPDFDerivatives function.
+   * Each thread accumulates a partial joint histogram and a partial joint
+   * histogram derivative. Thread 0 directly uses m_JointPDFDerivatives as
+   * its partial result, the other threads use their own pre-allocated one.
+   */
+  inline void
+  ThreadedComputePDFsAndPDFDerivatives(ThreadIdType threadId);
+
+  /** Accumulate the results of ThreadedComputePDFsAndPDFDerivatives.
+   * The joint histogram derivatives are summed multi-threadedly.
+   */
+  inline void
+  AfterThreadedComputePDFsAndPDFDerivatives(void) const;
+
+  /** Helper function to launch the threads. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  ComputePDFsAndPDFDerivativesThreaderCallback(void * arg);
+
+  /** Helper function to launch the threads. */
+  void
+  LaunchComputePDFsAndPDFDerivativesThreaderCallback(void) const;
+
+  /** Helper function to sum the per-thread joint histogram derivatives
+   * into m_JointPDFDerivatives. Each thread handles a contiguous part of
+   * the buffer.
+   */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  AccumulateJointPDFDerivativesThreaderCallback(void * arg);
+
   /** Compute the Parzen values given an image value and a starting histogram index
    * Compute the values at (parzenWindowIndex - parzenWindowTerm + k) for
    * k = 0 ... kernelsize-1
@@ -360,7 +390,8 @@ protected:
                                const RealType &                   movingImageValue,
                                const DerivativeType *             imageJacobian,
                                const NonZeroJacobianIndicesType * nzji,
-                               JointPDFType *                     jointPDF) const;
+                               JointPDFType *                     jointPDF,
+                               JointPDFDerivativesType *          jointPDFDerivatives) const;
 
   /** Update the joint PDF and the incremental pdfs.
    * The input is a pixel pair (fixed, moving, moving mask) and
@@ -391,7 +422,8 @@ protected:
   UpdateJointPDFDerivatives(const JointPDFIndexType &          pdfIndex,
                             double                             factor,
                             const DerivativeType &             imageJacobian,
-                            const NonZeroJacobianIndicesType & nzji) const;
+                            const NonZeroJacobianIndicesType & nzji,
+                            JointPDFDerivativesType *          jointPDFDerivatives) const;
 
   /** Multiply the pdf entries by the given normalization factor. */
   virtual void
@@ -426,7 +458,12 @@ protected:
    * So, the JointPDF is more like a histogram than a true pdf...
    * The histograms are left unnormalized since it may be faster to
    * not do this explicitly.
+   * Executes multi-threadedly when m_UseMultiThread == true, using per-thread
+   * partial joint histogram derivatives.
    */
+  virtual void
+  ComputePDFsAndPDFDerivativesSingleThreaded(const ParametersType & parameters) const;
+
   virtual void
   ComputePDFsAndPDFDerivatives(const ParametersType & parameters) const;
 
@@ -65,6 +65,7 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ParzenWindow
   this->SetUseImageSampler(true);
   this->SetUseFixedImageLimiter(true);
   this->SetUseMovingImageLimiter(true);
+  this->SetSupportsConcurrentGetValueAndDerivative(true);
 
   this->m_UseExplicitPDFDerivatives = true;
 
@@ -455,6 +456,21 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::InitializeTh
   jointPDFRegion.SetIndex(jointPDFIndex);
   jointPDFRegion.SetSize(jointPDFSize);
 
+  /** Construct regions for the joint histogram derivatives. These are only
+   * needed by the threads other than thread 0, in case of explicit pdf derivatives.
+   */
+  const bool useThreadedJointPDFDerivatives = this->GetUseDerivative() && this->m_UseExplicitPDFDerivatives &&
+                                              !this->GetUseFiniteDifferenceDerivative();
+  JointPDFDerivativesRegionType jointPDFDerivativesRegion;
+  JointPDFDerivativesIndexType  jointPDFDerivativesIndex;
+  JointPDFDerivativesSizeType   jointPDFDerivativesSize;
+  jointPDFDerivativesIndex.Fill(0);
+  jointPDFDerivativesSize[0] = this->GetNumberOfParameters();
+  jointPDFDerivativesSize[1] = this->m_NumberOfMovingHistogramBins;
+  jointPDFDerivativesSize[2] = this->m_NumberOfFixedHistogramBins;
+  jointPDFDerivativesRegion.SetIndex(jointPDFDerivativesIndex);
+  jointPDFDerivativesRegion.SetSize(jointPDFDerivativesSize);
+
   const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
 
   /** Only resize the array of structs when needed. */
@@ -483,6 +499,24 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::InitializeTh
       jointPDF->SetRegions(jointPDFRegion);
       jointPDF->Allocate();
     }
+
+    // Initialize the joint pdf derivatives; thread 0 uses m_JointPDFDerivatives
+    JointPDFDerivativesPointer & jointPDFDerivatives =
+      this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[i].st_JointPDFDerivatives;
+    if (!useThreadedJointPDFDerivatives || i == 0)
+    {
+      jointPDFDerivatives = nullptr;
+      continue;
+    }
+    if (jointPDFDerivatives.IsNull())
+    {
+      jointPDFDerivatives = JointPDFDerivativesType::New();
+    }
+    if (jointPDFDerivatives->GetLargestPossibleRegion() != jointPDFDerivativesRegion)
+    {
+      jointPDFDerivatives->SetRegions(jointPDFDerivativesRegion);
+      jointPDFDerivatives->Allocate();
+    }
   }
 
 } // end InitializeThreadingParameters()
@@ -555,7 +589,8 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::UpdateJointP
   const RealType &                   movingImageValue,
   const DerivativeType *             imageJacobian,
   const NonZeroJacobianIndicesType * nzji,
-  JointPDFType *                     jointPDF) const
+  JointPDFType *                     jointPDF,
+  JointPDFDerivativesType *          jointPDFDerivatives) const
 {
   typedef ImageScanlineIterator<JointPDFType> PDFIteratorType;
 
@@ -626,7 +661,8 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::UpdateJointP
       for (unsigned int m = 0; m < movingParzenValues.GetSize(); ++m)
       {
         it.Value() += static_cast<PDFValueType>(fv * movingParzenValues[m]);
-        this->UpdateJointPDFDerivatives(it.GetIndex(), fv_et * derivativeMovingParzenValues[m], *imageJacobian, *nzji);
+        this->UpdateJointPDFDerivatives(
+          it.GetIndex(), fv_et * derivativeMovingParzenValues[m], *imageJacobian, *nzji, jointPDFDerivatives);
         ++it;
       }
       it.NextLine();
@@ -646,12 +682,13 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::UpdateJointP
   const JointPDFIndexType &          pdfIndex,
   double                             factor,
   const DerivativeType &             imageJacobian,
-  const NonZeroJacobianIndicesType & nzji) const
+  const NonZeroJacobianIndicesType & nzji,
+  JointPDFDerivativesType *          jointPDFDerivatives) const
 {
   /** Get the pointer to the element with index [0, pdfIndex[0], pdfIndex[1]]. */
-  PDFDerivativeValueType * derivPtr = this->m_JointPDFDerivatives->GetBufferPointer() +
-                                      (pdfIndex[0] * this->m_JointPDFDerivatives->GetOffsetTable()[1]) +
-                                      (pdfIndex[1] * this->m_JointPDFDerivatives->GetOffsetTable()[2]);
+  PDFDerivativeValueType * derivPtr = jointPDFDerivatives->GetBufferPointer() +
+                                      (pdfIndex[0] * jointPDFDerivatives->GetOffsetTable()[1]) +
+                                      (pdfIndex[1] * jointPDFDerivatives->GetOffsetTable()[2]);
 
   if (nzji.size() == this->GetNumberOfParameters())
   {
@@ -1064,7 +1101,7 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsS
 
       /** Compute this sample's contribution to the joint distributions. */
       this->UpdateJointPDFAndDerivatives(
-        fixedImageValue, movingImageValue, nullptr, nullptr, this->m_JointPDF.GetPointer());
+        fixedImageValue, movingImageValue, nullptr, nullptr, this->m_JointPDF.GetPointer(), nullptr);
     }
 
   } // end iterating over fixed image spatial sample container for loop
@@ -1192,7 +1229,8 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ThreadedComp
       movingImageValue = this->GetMovingImageLimiter()->Evaluate(movingImageValue);
 
       /** Compute this sample's contribution to the joint distributions. */
-      this->UpdateJointPDFAndDerivatives(fixedImageValue, movingImageValue, nullptr, nullptr, jointPDF.GetPointer());
+      this->UpdateJointPDFAndDerivatives(
+        fixedImageValue, movingImageValue, nullptr, nullptr, jointPDF.GetPointer(), nullptr);
     }
   } // end iterating over fixed image spatial sample container for loop
 
@@ -1308,12 +1346,12 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::LaunchComput
 
 
 /**
- * ************************ ComputePDFsAndPDFDerivatives *******************
+ * ************************ ComputePDFsAndPDFDerivativesSingleThreaded *******************
  */
 
 template <class TFixedImage, class TMovingImage>
 void
-ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsAndPDFDerivatives(
+ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsAndPDFDerivativesSingleThreaded(
   const ParametersType & parameters) const
 {
   /** Initialize some variables. */
@@ -1394,8 +1432,12 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsA
       this->EvaluateTransformJacobianInnerProduct(jacobian, movingImageDerivative, imageJacobian);
 
       /** Update the joint pdf and the joint pdf derivatives. */
-      this->UpdateJointPDFAndDerivatives(
-        fixedImageValue, movingImageValue, &imageJacobian, &nzji, this->m_JointPDF.GetPointer());
+      this->UpdateJointPDFAndDerivatives(fixedImageValue,
+                                         movingImageValue,
+                                         &imageJacobian,
+                                         &nzji,
+                                         this->m_JointPDF.GetPointer(),
+                                         this->m_JointPDFDerivatives.GetPointer());
 
     } // end if-block check sampleOk
   }   // end iterating over fixed image spatial sample container for loop
@@ -1410,9 +1452,259 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsA
     this->m_Alpha = 1.0 / static_cast<double>(this->m_NumberOfPixelsCounted);
   }
 
+} // end ComputePDFsAndPDFDerivativesSingleThreaded()
+
+
+/**
+ * ************************ ComputePDFsAndPDFDerivatives *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsAndPDFDerivatives(
+  const ParametersType & parameters) const
+{
+  /** Option for now to still use the single threaded code. */
+  if (!this->m_UseMultiThread)
+  {
+    return this->ComputePDFsAndPDFDerivativesSingleThreaded(parameters);
+  }
+
+  /** Call non-thread-safe stuff, such as:
+   *   this->SetTransformParameters( parameters );
+   *   this->GetImageSampler()->Update();
+   * See ComputePDFs() for more information.
+   */
+  this->BeforeThreadedGetValueAndDerivative(parameters);
+
+  /** Launch multi-threading JointPDF and JointPDFDerivatives computation. */
+  this->LaunchComputePDFsAndPDFDerivativesThreaderCallback();
+
+  /** Gather the results from all threads. */
+  this->AfterThreadedComputePDFsAndPDFDerivatives();
+
 } // end ComputePDFsAndPDFDerivatives()
 
 
+/**
+ * ******************* ThreadedComputePDFsAndPDFDerivatives *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ThreadedComputePDFsAndPDFDerivatives(
+  ThreadIdType threadId)
+{
+  /** Get a handle to the pre-allocated joint PDF and joint PDF derivatives
+   * for the current thread. Thread 0 directly writes in m_JointPDFDerivatives,
+   * which saves the memory and accumulation time of one partial result.
+   * The initialization is performed here, so that it is done multi-threadedly.
+   */
+  AlignedParzenWindowHistogramGetValueAndDerivativePerThreadStruct & perThreadVariables =
+    this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[threadId];
+  JointPDFPointer &         jointPDF = perThreadVariables.st_JointPDF;
+  JointPDFDerivativesType * jointPDFDerivatives =
+    (threadId == 0) ? this->m_JointPDFDerivatives.GetPointer() : perThreadVariables.st_JointPDFDerivatives.GetPointer();
+  jointPDF->FillBuffer(NumericTraits<PDFValueType>::ZeroValue());
+  jointPDFDerivatives->FillBuffer(NumericTraits<PDFDerivativeValueType>::ZeroValue());
+
+  /** Array that stores dM(x)/dmu, and the sparse jacobian+indices. */
+  NonZeroJacobianIndicesType nzji(this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices());
+  DerivativeType             imageJacobian(nzji.size());
+  TransformJacobianType      jacobian;
+
+  /** Get a handle to the sample container. */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  const unsigned long         sampleContainerSize = sampleContainer->Size();
+
+  /** Get the samples for this thread. */
+  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
+    std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(Self::GetNumberOfWorkUnits())));
+
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end = nrOfSamplesPerThreads * (threadId + 1);
+  pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
+  pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
+
+  /** Create iterator over the sample container. */
+  typename ImageSampleContainerType::ConstIterator fiter;
+  typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
+  typename ImageSampleContainerType::ConstIterator fend = sampleContainer->Begin();
+  fbegin += (int)pos_begin;
+  fend += (int)pos_end;
+
+  /** Create variables to store intermediate results. circumvent false sharing */
+  unsigned long numberOfPixelsCounted = 0;
+
+  /** Loop over sample container and compute contribution of each sample to pdfs. */
+  for (fiter = fbegin; fiter != fend; ++fiter)
+  {
+    /** Read fixed coordinates and initialize some variables. */
+    const FixedImagePointType & fixedPoint = (*fiter).Value().m_ImageCoordinates;
+    RealType                    movingImageValue;
+    MovingImagePointType        mappedPoint;
+    MovingImageDerivativeType   movingImageDerivative;
+
+    /** Transform point and check if it is inside the B-spline support region. */
+    bool sampleOk = this->TransformPoint(fixedPoint, mappedPoint);
+
+    /** Check if point is inside mask. */
+    if (sampleOk)
+    {
+      sampleOk = this->IsInsideMovingMask(mappedPoint);
+    }
+
+    /** Compute the moving image value M(T(x)) and derivative dM/dx and check if
+     * the point is inside the moving image buffer.
+     */
+    if (sampleOk)
+    {
+      sampleOk = this->EvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, &movingImageDerivative);
+    }
+
+    if (sampleOk)
+    {
+      numberOfPixelsCounted++;
+
+      /** Get the fixed image value. */
+      RealType fixedImageValue = static_cast<RealType>((*fiter).Value().m_ImageValue);
+
+      /** Make sure the values fall within the histogram range. */
+      fixedImageValue = this->GetFixedImageLimiter()->Evaluate(fixedImageValue);
+      movingImageValue = this->GetMovingImageLimiter()->Evaluate(movingImageValue, movingImageDerivative);
+
+      /** Get the TransformJacobian dT/dmu. */
+      this->EvaluateTransformJacobian(fixedPoint, jacobian, nzji);
+
+      /** Compute the inner product (dM/dx)^T (dT/dmu). */
+      this->EvaluateTransformJacobianInnerProduct(jacobian, movingImageDerivative, imageJacobian);
+
+      /** Update the joint pdf and the joint pdf derivatives. */
+      this->UpdateJointPDFAndDerivatives(
+        fixedImageValue, movingImageValue, &imageJacobian, &nzji, jointPDF.GetPointer(), jointPDFDerivatives);
+
+    } // end if-block check sampleOk
+  }   // end iterating over fixed image spatial sample container for loop
+
+  /** Only update these variables at the end to prevent unnecessary "false sharing". */
+  perThreadVariables.st_NumberOfPixelsCounted = numberOfPixelsCounted;
+
+} // end ThreadedComputePDFsAndPDFDerivatives()
+
+
+/**
+ * ******************* AfterThreadedComputePDFsAndPDFDerivatives *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::AfterThreadedComputePDFsAndPDFDerivatives(
+  void) const
+{
+  /** Accumulate the number of pixels and the joint histograms, and compute alpha. */
+  this->AfterThreadedComputePDFs();
+
+  /** Accumulate the joint histogram derivatives multi-threadedly.
+   * Thread 0 already wrote into m_JointPDFDerivatives.
+   */
+  if (Self::GetNumberOfWorkUnits() > 1)
+  {
+    this->m_Threader->SetSingleMethod(
+      this->AccumulateJointPDFDerivativesThreaderCallback,
+      const_cast<void *>(static_cast<const void *>(&this->m_ParzenWindowHistogramThreaderParameters)));
+    this->m_Threader->SingleMethodExecute();
+  }
+
+} // end AfterThreadedComputePDFsAndPDFDerivatives()
+
+
+/**
+ * **************** ComputePDFsAndPDFDerivativesThreaderCallback *******
+ */
+
+template <class TFixedImage, class TMovingImage>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsAndPDFDerivativesThreaderCallback(
+  void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType     threadId = infoStruct->WorkUnitID;
+
+  ParzenWindowHistogramMultiThreaderParameterType * temp =
+    static_cast<ParzenWindowHistogramMultiThreaderParameterType *>(infoStruct->UserData);
+
+  temp->m_Metric->ThreadedComputePDFsAndPDFDerivatives(threadId);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ComputePDFsAndPDFDerivativesThreaderCallback()
+
+
+/**
+ * *********************** LaunchComputePDFsAndPDFDerivativesThreaderCallback***************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::LaunchComputePDFsAndPDFDerivativesThreaderCallback(
+  void) const
+{
+  /** Setup threader. */
+  this->m_Threader->SetSingleMethod(
+    this->ComputePDFsAndPDFDerivativesThreaderCallback,
+    const_cast<void *>(static_cast<const void *>(&this->m_ParzenWindowHistogramThreaderParameters)));
+
+  /** Launch. */
+  this->m_Threader->SingleMethodExecute();
+
+} // end LaunchComputePDFsAndPDFDerivativesThreaderCallback()
+
+
+/**
+ * **************** AccumulateJointPDFDerivativesThreaderCallback *******
+ */
+
+template <class TFixedImage, class TMovingImage>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::AccumulateJointPDFDerivativesThreaderCallback(
+  void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType     threadId = infoStruct->WorkUnitID;
+  ThreadIdType     nrOfThreads = infoStruct->NumberOfWorkUnits;
+
+  ParzenWindowHistogramMultiThreaderParameterType * temp =
+    static_cast<ParzenWindowHistogramMultiThreaderParameterType *>(infoStruct->UserData);
+  Self * metric = temp->m_Metric;
+
+  /** Determine the part of the flat buffer this thread is responsible for. */
+  const SizeValueType numberOfElements =
+    metric->m_JointPDFDerivatives->GetBufferedRegion().GetNumberOfPixels();
+  const SizeValueType subSize = static_cast<SizeValueType>(
+    std::ceil(static_cast<double>(numberOfElements) / static_cast<double>(nrOfThreads)));
+  const SizeValueType jmin = std::min(threadId * subSize, numberOfElements);
+  const SizeValueType jmax = std::min((threadId + 1) * subSize, numberOfElements);
+
+  /** Add the partial results of threads 1 .. n-1 to the result of thread 0.
+   * The inner loop runs over contiguous memory, so that it is vectorized by the compiler.
+   */
+  PDFDerivativeValueType * resultPtr = metric->m_JointPDFDerivatives->GetBufferPointer();
+  for (ThreadIdType i = 1; i < metric->GetNumberOfWorkUnits(); ++i)
+  {
+    const JointPDFDerivativesType * partialJointPDFDerivatives =
+      metric->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[i].st_JointPDFDerivatives;
+    const PDFDerivativeValueType * partialPtr = partialJointPDFDerivatives->GetBufferPointer();
+    for (SizeValueType j = jmin; j < jmax; ++j)
+    {
+      resultPtr[j] += partialPtr[j];
+    }
+  }
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end AccumulateJointPDFDerivativesThreaderCallback()
+
+
 /**
  * ************************ ComputePDFsAndIncrementalPDFs *******************
  */
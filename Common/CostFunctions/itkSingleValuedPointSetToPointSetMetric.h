@@ -172,6 +172,11 @@ public:
   itkGetConstReferenceMacro(UseMetricSingleThreaded, bool);
   itkBooleanMacro(UseMetricSingleThreaded);
 
+  /** Inheriting classes can specify whether GetValueAndDerivative() may be called concurrently
+   * with other metrics, once BeforeThreadedGetValueAndDerivative() has been called single-threaded;
+   * This method allows the user to inspect this setting. */
+  itkGetConstMacro(SupportsConcurrentGetValueAndDerivative, bool);
+
 protected:
   SingleValuedPointSetToPointSetMetric();
   ~SingleValuedPointSetToPointSetMetric() override = default;
@@ -180,6 +185,10 @@ protected:
   void
   PrintSelf(std::ostream & os, Indent indent) const override;
 
+  /** Inheriting classes that do all thread-unsafe work of GetValueAndDerivative() in
+   * BeforeThreadedGetValueAndDerivative() can specify so; default: false. */
+  itkSetMacro(SupportsConcurrentGetValueAndDerivative, bool);
+
   /** Member variables. */
   FixedPointSetConstPointer   m_FixedPointSet;
   MovingPointSetConstPointer  m_MovingPointSet;
@@ -191,6 +200,7 @@ protected:
 
   /** Variables for multi-threading. */
   bool m_UseMetricSingleThreaded;
+  bool m_SupportsConcurrentGetValueAndDerivative;
 
 private:
   SingleValuedPointSetToPointSetMetric(const Self &) = delete;
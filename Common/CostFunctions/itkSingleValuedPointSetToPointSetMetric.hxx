@@ -55,6 +55,7 @@ SingleValuedPointSetToPointSetMetric<TFixedPointSet, TMovingPointSet>::SingleVal
   this->m_NumberOfPointsCounted = 0;
 
   this->m_UseMetricSingleThreaded = true;
+  this->m_SupportsConcurrentGetValueAndDerivative = false;
 
 } // end Constructor
 
@@ -25,6 +25,7 @@
 
 #include <initializer_list>
 #include <limits>
+#include <sstream>
 #include <string>
 #include <type_traits> // For is_floating_point.
 #include <vector>
@@ -329,6 +330,52 @@ GTEST_TEST(Conversion, ToString)
 }
 
 
+GTEST_TEST(Conversion, AppendIntegerToString)
+{
+  const auto expectEqualToStreamOutput = [](const long long integerValue) {
+    std::string text = "prefix";
+    Conversion::AppendIntegerToString(text, integerValue);
+
+    std::ostringstream outputStream;
+    outputStream << "prefix" << integerValue;
+    EXPECT_EQ(text, outputStream.str());
+  };
+
+  for (const long long integerValue : { 0LL, 1LL, -1LL, 9LL, 10LL, -10LL, 123456789LL, -987654321LL })
+  {
+    expectEqualToStreamOutput(integerValue);
+  }
+  expectEqualToStreamOutput(std::numeric_limits<long long>::min());
+  expectEqualToStreamOutput(std::numeric_limits<long long>::max());
+}
+
+
+GTEST_TEST(Conversion, AppendFixedPointToString)
+{
+  using DoubleLimits = std::numeric_limits<double>;
+
+  const auto expectEqualToStreamOutput = [](const double scalar) {
+    std::string text = "prefix";
+    Conversion::AppendFixedPointToString(text, scalar);
+
+    std::ostringstream outputStream;
+    outputStream << std::showpoint << std::fixed << "prefix" << scalar;
+    EXPECT_EQ(text, outputStream.str());
+  };
+
+  for (const double scalar : { 0.0, -0.0, 0.5, -1.0, 0.1, 1.0 / 3.0, 2.5e-7, -7.5e-7, 123456.789, 1e21, -1e21 })
+  {
+    expectEqualToStreamOutput(scalar);
+  }
+  expectEqualToStreamOutput(static_cast<float>(0.1));
+  expectEqualToStreamOutput(DoubleLimits::epsilon());
+  expectEqualToStreamOutput(DoubleLimits::lowest());
+  expectEqualToStreamOutput(DoubleLimits::max());
+  expectEqualToStreamOutput(DoubleLimits::infinity());
+  expectEqualToStreamOutput(-DoubleLimits::infinity());
+}
+
+
 GTEST_TEST(Conversion, ToVectorOfStrings)
 {
   using VectorOfStrings = std::vector<std::string>;
@@ -458,3 +505,30 @@ GTEST_TEST(Conversion, LosslessRoundTripOfParameterValue)
     Expect_lossless_round_trip_of_parameter_value<bool>(parameterValue);
   }
 }
+
+
+GTEST_TEST(Conversion, MemoryBudgetToNumberOfStreamDivisions)
+{
+  // A 3D image of 163840 bytes, which is 0.15625 megabytes.
+  const itk::Size<3> size3D{ { 64, 32, 10 } };
+
+  // No budget means no streaming.
+  EXPECT_EQ(Conversion::MemoryBudgetToNumberOfStreamDivisions(size3D, 8.0, 0.0), 1U);
+  EXPECT_EQ(Conversion::MemoryBudgetToNumberOfStreamDivisions(size3D, 8.0, -1.0), 1U);
+
+  // The number of divisions is rounded up, to stay within the budget.
+  EXPECT_EQ(Conversion::MemoryBudgetToNumberOfStreamDivisions(size3D, 8.0, 1.0), 1U);
+  EXPECT_EQ(Conversion::MemoryBudgetToNumberOfStreamDivisions(size3D, 8.0, 0.15625), 1U);
+  EXPECT_EQ(Conversion::MemoryBudgetToNumberOfStreamDivisions(size3D, 8.0, 0.05), 4U);
+  EXPECT_EQ(Conversion::MemoryBudgetToNumberOfStreamDivisions(size3D, 16.0, 0.05), 7U);
+
+  // The slabs are at least one slice thick.
+  EXPECT_EQ(Conversion::MemoryBudgetToNumberOfStreamDivisions(size3D, 8.0, 1e-6), 10U);
+
+  // A 2D image of 4 megabytes.
+  const itk::Size<2> size2D{ { 1024, 256 } };
+  EXPECT_EQ(Conversion::MemoryBudgetToNumberOfStreamDivisions(size2D, 16.0, 4.0), 1U);
+  EXPECT_EQ(Conversion::MemoryBudgetToNumberOfStreamDivisions(size2D, 16.0, 3.0), 2U);
+  EXPECT_EQ(Conversion::MemoryBudgetToNumberOfStreamDivisions(size2D, 16.0, 1.0), 4U);
+  EXPECT_EQ(Conversion::MemoryBudgetToNumberOfStreamDivisions(size2D, 16.0, 1e-9), 256U);
+}
@@ -0,0 +1,212 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// Tests that the pipelines of the ResultImageMemoryBudget and DeformationFieldMemoryBudget
+// parameters write the same files with and without streaming.
+#include "elxConversion.h"
+#include "itkImageFileCastWriter.h"
+
+#include <itkAffineTransform.h>
+#include <itkChangeInformationImageFilter.h>
+#include <itkImage.h>
+#include <itkImageFileReader.h>
+#include <itkImageFileWriter.h>
+#include <itkImageRegionIterator.h>
+#include <itkLinearInterpolateImageFunction.h>
+#include <itkResampleImageFilter.h>
+#include <itkTransformToDisplacementFieldFilter.h>
+#include <itksys/SystemTools.hxx>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <string>
+
+
+namespace
+{
+constexpr unsigned int ImageDimension = 3;
+using FloatImageType = itk::Image<float, ImageDimension>;
+using TransformType = itk::AffineTransform<double, ImageDimension>;
+
+const itk::Size<ImageDimension> imageSize{ { 17, 13, 11 } };
+
+/** A memory budget, in megabytes, that is small enough to have the images written in several slabs. */
+constexpr double memoryBudget = 0.005;
+
+
+/** An affine transform with a rotation and a translation, so that the displacements differ between the slabs. */
+TransformType::Pointer
+CreateTransform()
+{
+  const auto                      transform = TransformType::New();
+  TransformType::OutputVectorType translation;
+  translation[0] = 1.25;
+  translation[1] = -0.5;
+  translation[2] = 0.75;
+  transform->Translate(translation);
+  transform->Rotate(0, 2, 0.1);
+  return transform;
+}
+
+
+/** Reads the specified image file, and removes the file afterwards. */
+template <typename TImage>
+typename TImage::Pointer
+ReadAndRemoveImage(const std::string & fileName)
+{
+  const auto reader = itk::ImageFileReader<TImage>::New();
+  reader->SetFileName(fileName);
+  reader->Update();
+  const typename TImage::Pointer image = reader->GetOutput();
+
+  itksys::SystemTools::RemoveFile(fileName);
+  return image;
+}
+
+
+template <typename TImage>
+void
+ExpectEqualImages(const TImage & expectedImage, const TImage & actualImage)
+{
+  ASSERT_EQ(actualImage.GetBufferedRegion(), expectedImage.GetBufferedRegion());
+  EXPECT_EQ(actualImage.GetSpacing(), expectedImage.GetSpacing());
+  EXPECT_EQ(actualImage.GetOrigin(), expectedImage.GetOrigin());
+  EXPECT_EQ(actualImage.GetDirection(), expectedImage.GetDirection());
+
+  const auto * const expected = expectedImage.GetBufferPointer();
+  const auto * const actual = actualImage.GetBufferPointer();
+  for (itk::SizeValueType i = 0; i < expectedImage.GetBufferedRegion().GetNumberOfPixels(); ++i)
+  {
+    EXPECT_EQ(actual[i], expected[i]);
+  }
+}
+
+
+/** Resamples an image and writes it with the specified output component type, like
+ * ResamplerBase::WriteResultImage(). */
+template <typename TResultPixel>
+void
+Expect_streamed_result_image_equals_unstreamed_result_image(const std::string & outputComponentType)
+{
+  /** The moving image has a non-trivial pattern, with negative and fractional values. */
+  const auto movingImage = FloatImageType::New();
+  movingImage->SetRegions(imageSize);
+  movingImage->Allocate();
+  for (itk::ImageRegionIterator<FloatImageType> it(movingImage, movingImage->GetBufferedRegion()); !it.IsAtEnd();
+       ++it)
+  {
+    const auto & index = it.GetIndex();
+    it.Set(static_cast<float>(100.0 * std::sin(0.3 * index[0] + 0.2 * index[1]) - 2.5 * index[2]));
+  }
+
+  /** Each voxel is resampled, and cast to a pixel type of at most the size of a double. */
+  const unsigned int numberOfStreamDivisions =
+    elastix::Conversion::MemoryBudgetToNumberOfStreamDivisions(imageSize, sizeof(float) + sizeof(double), memoryBudget);
+  ASSERT_GT(numberOfStreamDivisions, 1U);
+
+  const auto WriteResultImage = [&movingImage, &outputComponentType](const std::string &  fileName,
+                                                                     const unsigned int numberOfDivisions) {
+    const auto resampler = itk::ResampleImageFilter<FloatImageType, FloatImageType, double>::New();
+    resampler->SetInput(movingImage);
+    resampler->SetTransform(CreateTransform());
+    resampler->SetInterpolator(itk::LinearInterpolateImageFunction<FloatImageType, double>::New());
+    resampler->SetDefaultPixelValue(-7.0f);
+    resampler->SetSize(imageSize);
+
+    const auto writer = itk::ImageFileCastWriter<FloatImageType>::New();
+    writer->SetInput(resampler->GetOutput());
+    writer->SetFileName(fileName);
+    writer->SetOutputComponentType(outputComponentType.c_str());
+    writer->SetNumberOfStreamDivisions(numberOfDivisions);
+    writer->Update();
+  };
+
+  const std::string directory = itksys::SystemTools::GetCurrentWorkingDirectory() + '/';
+  const std::string unstreamedFileName = directory + "StreamedWriteGTest_unstreamed_result.mha";
+  const std::string streamedFileName = directory + "StreamedWriteGTest_streamed_result.mha";
+  WriteResultImage(unstreamedFileName, 1);
+  WriteResultImage(streamedFileName, numberOfStreamDivisions);
+
+  using ResultImageType = itk::Image<TResultPixel, ImageDimension>;
+  const auto expectedImage = ReadAndRemoveImage<ResultImageType>(unstreamedFileName);
+  const auto actualImage = ReadAndRemoveImage<ResultImageType>(streamedFileName);
+  ExpectEqualImages(*expectedImage, *actualImage);
+}
+
+} // namespace
+
+
+GTEST_TEST(StreamedWrite, ResultImage)
+{
+  Expect_streamed_result_image_equals_unstreamed_result_image<short>("short");
+  Expect_streamed_result_image_equals_unstreamed_result_image<float>("float");
+  Expect_streamed_result_image_equals_unstreamed_result_image<double>("double");
+}
+
+
+// Generates and writes a deformation field, like TransformBase::StreamDeformationFieldImage().
+GTEST_TEST(StreamedWrite, DeformationField)
+{
+  using DeformationFieldImageType = itk::Image<itk::Vector<float, ImageDimension>, ImageDimension>;
+  using GeneratorType = itk::TransformToDisplacementFieldFilter<DeformationFieldImageType, double>;
+  using ChangeInfoFilterType = itk::ChangeInformationImageFilter<DeformationFieldImageType>;
+
+  const unsigned int numberOfStreamDivisions = elastix::Conversion::MemoryBudgetToNumberOfStreamDivisions(
+    imageSize, sizeof(itk::Vector<float, ImageDimension>), memoryBudget);
+  ASSERT_GT(numberOfStreamDivisions, 1U);
+
+  /** The direction is restored by the ChangeInformationImageFilter, as when UseDirectionCosines is false. */
+  FloatImageType::DirectionType direction;
+  direction.SetIdentity();
+  direction[0][0] = std::cos(0.2);
+  direction[0][1] = -std::sin(0.2);
+  direction[1][0] = std::sin(0.2);
+  direction[1][1] = std::cos(0.2);
+
+  const auto WriteDeformationField = [direction](const std::string & fileName, const unsigned int numberOfDivisions) {
+    const auto generator = GeneratorType::New();
+    generator->SetSize(imageSize);
+    generator->SetOutputSpacing(itk::MakeFilled<FloatImageType::SpacingType>(0.75));
+    generator->SetOutputOrigin(itk::MakeFilled<FloatImageType::PointType>(-2.0));
+    generator->SetTransform(CreateTransform());
+
+    const auto infoChanger = ChangeInfoFilterType::New();
+    infoChanger->SetOutputDirection(direction);
+    infoChanger->SetChangeDirection(true);
+    infoChanger->SetInput(generator->GetOutput());
+
+    const auto writer = itk::ImageFileWriter<DeformationFieldImageType>::New();
+    writer->SetInput(infoChanger->GetOutput());
+    writer->SetFileName(fileName);
+    writer->SetNumberOfStreamDivisions(numberOfDivisions);
+    writer->Update();
+  };
+
+  const std::string directory = itksys::SystemTools::GetCurrentWorkingDirectory() + '/';
+  const std::string unstreamedFileName = directory + "StreamedWriteGTest_unstreamed_deformationField.mha";
+  const std::string streamedFileName = directory + "StreamedWriteGTest_streamed_deformationField.mha";
+  WriteDeformationField(unstreamedFileName, 1);
+  WriteDeformationField(streamedFileName, numberOfStreamDivisions);
+
+  const auto expectedImage = ReadAndRemoveImage<DeformationFieldImageType>(unstreamedFileName);
+  const auto actualImage = ReadAndRemoveImage<DeformationFieldImageType>(streamedFileName);
+  ExpectEqualImages(*expectedImage, *actualImage);
+  EXPECT_EQ(actualImage->GetDirection(), direction);
+}
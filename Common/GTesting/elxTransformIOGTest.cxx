@@ -448,7 +448,8 @@ struct WithDimension
         { "GridOrigin", expectedZeros },
         { "GridSize", expectedZeros },
         { "GridSpacing", expectedOnes },
-        { "UseCyclicTransform", { expectedFalse } } });
+        { "UseCyclicTransform", { expectedFalse } },
+        { "UseSinglePrecisionBSplineCoefficients", { expectedFalse } } });
     WithElastixTransform<SimilarityTransformElastix>::Test_CreateTransformParametersMap_for_default_transform(
       { { "CenterOfRotationPoint", expectedZeros } });
     WithElastixTransform<SplineKernelTransform>::Test_CreateTransformParametersMap_for_default_transform(
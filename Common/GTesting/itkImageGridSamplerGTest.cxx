@@ -0,0 +1,181 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkImageGridSampler.h"
+
+#include <itkImage.h>
+#include <itkImageMaskSpatialObject.h>
+#include <itkImageRegionIteratorWithIndex.h>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+
+template <unsigned int VDimension>
+typename itk::Image<float, VDimension>::Pointer
+CreateImage(const typename itk::Image<float, VDimension>::SizeType & imageSize)
+{
+  using ImageType = itk::Image<float, VDimension>;
+
+  const auto                      image = ImageType::New();
+  typename ImageType::SpacingType spacing;
+  typename ImageType::PointType   origin;
+  for (unsigned int dim = 0; dim < VDimension; ++dim)
+  {
+    spacing[dim] = 0.5 + dim;
+    origin[dim] = -1.0 - dim;
+  }
+  image->SetRegions(imageSize);
+  image->SetSpacing(spacing);
+  image->SetOrigin(origin);
+  image->Allocate();
+
+  // Give each pixel a distinct value, so that any difference in the samples shows up.
+  float value = 0.0f;
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+  {
+    it.Set(value);
+    value += 1.0f;
+  }
+  return image;
+}
+
+
+template <unsigned int VDimension>
+typename itk::ImageMaskSpatialObject<VDimension>::Pointer
+CreateSphericalMask(const itk::Image<float, VDimension> & image)
+{
+  using MaskSpatialObjectType = itk::ImageMaskSpatialObject<VDimension>;
+  using MaskImageType = typename MaskSpatialObjectType::ImageType;
+
+  const auto maskImage = MaskImageType::New();
+  maskImage->CopyInformation(&image);
+  maskImage->SetRegions(image.GetLargestPossibleRegion());
+  maskImage->Allocate();
+
+  const auto & size = image.GetLargestPossibleRegion().GetSize();
+  for (itk::ImageRegionIteratorWithIndex<MaskImageType> it(maskImage, maskImage->GetBufferedRegion()); !it.IsAtEnd();
+       ++it)
+  {
+    // Off-center, so that the bounding box of the mask does not coincide with the image.
+    double squaredDistance = 0.0;
+    for (unsigned int dim = 0; dim < VDimension; ++dim)
+    {
+      const double distance = (it.GetIndex()[dim] - 0.6 * size[dim]) / (0.35 * size[dim]);
+      squaredDistance += distance * distance;
+    }
+    it.Set(squaredDistance <= 1.0 ? 1 : 0);
+  }
+
+  const auto mask = MaskSpatialObjectType::New();
+  mask->SetImage(maskImage);
+  mask->Update();
+  return mask;
+}
+
+
+template <unsigned int VDimension>
+void
+Expect_multi_threaded_samples_equal_single_threaded_samples(
+  const itk::Image<float, VDimension> &                      image,
+  const typename itk::Image<float, VDimension>::RegionType & inputImageRegion,
+  const itk::SpatialObject<VDimension> * const               mask,
+  const unsigned int                                         gridSpacing)
+{
+  using SamplerType = itk::ImageGridSampler<itk::Image<float, VDimension>>;
+
+  typename SamplerType::SampleGridSpacingType sampleGridSpacing;
+  sampleGridSpacing.Fill(gridSpacing);
+
+  const auto GenerateSamples = [&](const bool useMultiThread, const itk::ThreadIdType numberOfWorkUnits) {
+    const auto sampler = SamplerType::New();
+    sampler->SetInput(&image);
+    sampler->SetInputImageRegion(inputImageRegion);
+    sampler->SetMask(mask);
+    sampler->SetSampleGridSpacing(sampleGridSpacing);
+    sampler->SetUseMultiThread(useMultiThread);
+    sampler->SetNumberOfWorkUnits(numberOfWorkUnits);
+    sampler->Update();
+    return typename SamplerType::ImageSampleContainerPointer(sampler->GetOutput());
+  };
+
+  const auto expectedSamples = GenerateSamples(false, 1);
+  ASSERT_GT(expectedSamples->Size(), 0);
+
+  for (const itk::ThreadIdType numberOfWorkUnits : { 1, 2, 3, 5, 8 })
+  {
+    const auto actualSamples = GenerateSamples(true, numberOfWorkUnits);
+    ASSERT_EQ(actualSamples->Size(), expectedSamples->Size());
+
+    for (std::size_t i = 0; i < expectedSamples->Size(); ++i)
+    {
+      const auto & expectedSample = expectedSamples->ElementAt(i);
+      const auto & actualSample = actualSamples->ElementAt(i);
+      EXPECT_EQ(actualSample.m_ImageCoordinates, expectedSample.m_ImageCoordinates);
+      EXPECT_EQ(actualSample.m_ImageValue, expectedSample.m_ImageValue);
+    }
+  }
+}
+
+
+template <unsigned int VDimension>
+void
+Expect_multi_threaded_samples_equal_single_threaded_samples(
+  const typename itk::Image<float, VDimension>::SizeType & imageSize)
+{
+  using RegionType = typename itk::Image<float, VDimension>::RegionType;
+
+  const auto image = CreateImage<VDimension>(imageSize);
+  const auto mask = CreateSphericalMask<VDimension>(*image);
+
+  // A region that does not start at the origin, and does not end at the end of the image.
+  RegionType smallerRegion;
+  for (unsigned int dim = 0; dim < VDimension; ++dim)
+  {
+    smallerRegion.SetIndex(dim, 2);
+    smallerRegion.SetSize(dim, imageSize[dim] - 5);
+  }
+
+  for (const unsigned int gridSpacing : { 1, 2, 3 })
+  {
+    Expect_multi_threaded_samples_equal_single_threaded_samples<VDimension>(
+      *image, image->GetLargestPossibleRegion(), nullptr, gridSpacing);
+    Expect_multi_threaded_samples_equal_single_threaded_samples<VDimension>(
+      *image, smallerRegion, nullptr, gridSpacing);
+    Expect_multi_threaded_samples_equal_single_threaded_samples<VDimension>(
+      *image, image->GetLargestPossibleRegion(), mask, gridSpacing);
+    Expect_multi_threaded_samples_equal_single_threaded_samples<VDimension>(*image, smallerRegion, mask, gridSpacing);
+  }
+}
+
+} // namespace
+
+
+GTEST_TEST(ImageGridSampler, MultiThreadedEqualsSingleThreaded2D)
+{
+  Expect_multi_threaded_samples_equal_single_threaded_samples<2>({ 23, 17 });
+}
+
+
+GTEST_TEST(ImageGridSampler, MultiThreadedEqualsSingleThreaded3D)
+{
+  Expect_multi_threaded_samples_equal_single_threaded_samples<3>({ 13, 11, 16 });
+}
@@ -0,0 +1,355 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkRecursiveBSplineTransform.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+
+namespace
+{
+/** Gives access to the single precision copy of the coefficients. */
+template <unsigned int NDimension>
+class SinglePrecisionTestTransform : public itk::RecursiveBSplineTransform<double, NDimension, 3>
+{
+public:
+  using Self = SinglePrecisionTestTransform;
+  using Superclass = itk::RecursiveBSplineTransform<double, NDimension, 3>;
+  using Pointer = itk::SmartPointer<Self>;
+  itkNewMacro(Self);
+
+  using Superclass::SinglePrecisionCoefficientsAreUpToDate;
+
+  typename Superclass::SinglePrecisionImageType *
+  GetSinglePrecisionCoefficientImage(const unsigned int j) const
+  {
+    return this->m_SinglePrecisionCoefficientImages[j].GetPointer();
+  }
+};
+
+
+template <unsigned int NDimension>
+void
+Expect_SinglePrecisionCoefficients_give_nearly_equal_TransformPoint()
+{
+  using TransformType = itk::RecursiveBSplineTransform<double, NDimension, 3>;
+  using PointType = typename TransformType::InputPointType;
+
+  typename TransformType::RegionType gridRegion;
+  typename TransformType::SizeType   gridSize;
+  gridSize.Fill(8);
+  gridRegion.SetSize(gridSize);
+
+  const auto doubleTransform = TransformType::New();
+  const auto singleTransform = TransformType::New();
+  for (const auto transform : { doubleTransform, singleTransform })
+  {
+    transform->SetGridRegion(gridRegion);
+  }
+  singleTransform->UseSinglePrecisionCoefficientsOn();
+  EXPECT_TRUE(singleTransform->GetUseSinglePrecisionCoefficients());
+  EXPECT_FALSE(doubleTransform->GetUseSinglePrecisionCoefficients());
+
+  typename TransformType::ParametersType parameters(doubleTransform->GetNumberOfParameters());
+  for (unsigned int i = 0; i < parameters.GetSize(); ++i)
+  {
+    parameters[i] = std::sin(0.1 * i);
+  }
+  doubleTransform->SetParameters(parameters);
+  singleTransform->SetParametersByValue(parameters);
+
+  std::vector<PointType> points;
+  for (double position = 2.05; position < 4.5; position += 0.37)
+  {
+    PointType point;
+    point.Fill(position);
+    point[0] += 0.11;
+    points.push_back(point);
+  }
+
+  std::vector<PointType> transformedPoints(points.size());
+  singleTransform->TransformPoints(points.data(), transformedPoints.data(), points.size());
+
+  for (std::size_t n = 0; n < points.size(); ++n)
+  {
+    const PointType expectedPoint = doubleTransform->TransformPoint(points[n]);
+    const PointType actualPoint = singleTransform->TransformPoint(points[n]);
+    for (unsigned int j = 0; j < NDimension; ++j)
+    {
+      EXPECT_NEAR(actualPoint[j], expectedPoint[j], 1e-5);
+      EXPECT_EQ(transformedPoints[n][j], actualPoint[j]);
+    }
+    EXPECT_NE(expectedPoint, points[n]);
+  }
+}
+
+
+template <unsigned int NDimension>
+void
+Expect_SinglePrecisionCoefficients_are_not_used_when_out_of_date()
+{
+  using TransformType = itk::RecursiveBSplineTransform<double, NDimension, 3>;
+  using PointType = typename TransformType::InputPointType;
+
+  typename TransformType::RegionType gridRegion;
+  typename TransformType::SizeType   gridSize;
+  gridSize.Fill(8);
+  gridRegion.SetSize(gridSize);
+
+  typename TransformType::RegionType smallerGridRegion;
+  gridSize.Fill(6);
+  smallerGridRegion.SetSize(gridSize);
+
+  /** Enable single precision before any coefficients are set. */
+  const auto doubleTransform = TransformType::New();
+  const auto singleTransform = TransformType::New();
+  singleTransform->UseSinglePrecisionCoefficientsOn();
+  for (const auto transform : { doubleTransform, singleTransform })
+  {
+    transform->SetGridRegion(gridRegion);
+  }
+
+  typename TransformType::ParametersType parameters(doubleTransform->GetNumberOfParameters());
+  for (unsigned int i = 0; i < parameters.GetSize(); ++i)
+  {
+    parameters[i] = std::sin(0.1 * i);
+  }
+
+  PointType point;
+  point.Fill(2.55);
+
+  const auto expectSameResultsAsDoubleTransform = [doubleTransform, singleTransform, point] {
+    const PointType expectedPoint = doubleTransform->TransformPoint(point);
+    PointType       transformedPoint;
+    singleTransform->TransformPoints(&point, &transformedPoint, 1);
+    EXPECT_EQ(singleTransform->TransformPoint(point), expectedPoint);
+    EXPECT_EQ(transformedPoint, expectedPoint);
+  };
+
+  /** The parameters are maintained by the caller, so they remain valid for a smaller grid region. */
+  for (const auto transform : { doubleTransform, singleTransform })
+  {
+    transform->SetParameters(parameters);
+  }
+
+  /** Setting a different grid region leaves the copy out of date, until the parameters are set again. */
+  for (const auto transform : { doubleTransform, singleTransform })
+  {
+    transform->SetGridRegion(smallerGridRegion);
+  }
+  expectSameResultsAsDoubleTransform();
+
+  /** SetIdentity() modifies the coefficients in place. */
+  for (const auto transform : { doubleTransform, singleTransform })
+  {
+    transform->SetGridRegion(gridRegion);
+    transform->SetParametersByValue(parameters);
+    transform->SetIdentity();
+  }
+  expectSameResultsAsDoubleTransform();
+  EXPECT_EQ(singleTransform->TransformPoint(point), point);
+}
+
+
+template <unsigned int NDimension>
+void
+Expect_SinglePrecisionCoefficients_are_used_when_up_to_date()
+{
+  using TransformType = itk::RecursiveBSplineTransform<double, NDimension, 3>;
+  using TestTransformType = SinglePrecisionTestTransform<NDimension>;
+  using PointType = typename TransformType::InputPointType;
+
+  typename TransformType::RegionType gridRegion;
+  typename TransformType::SizeType   gridSize;
+  gridSize.Fill(8);
+  gridRegion.SetSize(gridSize);
+
+  const auto doubleTransform = TransformType::New();
+  const auto singleTransform = TestTransformType::New();
+  doubleTransform->SetGridRegion(gridRegion);
+  singleTransform->SetGridRegion(gridRegion);
+  singleTransform->UseSinglePrecisionCoefficientsOn();
+
+  typename TransformType::ParametersType parameters(doubleTransform->GetNumberOfParameters());
+  for (unsigned int i = 0; i < parameters.GetSize(); ++i)
+  {
+    parameters[i] = std::sin(0.1 * i);
+  }
+  doubleTransform->SetParameters(parameters);
+  singleTransform->SetParameters(parameters);
+  ASSERT_TRUE(singleTransform->SinglePrecisionCoefficientsAreUpToDate());
+
+  /** Shift the single precision copy only, without modifying the transform. As the B-spline
+   * weights sum to one, the points within the valid region are then shifted by the same amount.
+   */
+  const float shifts[3] = { 0.5f, -0.75f, 1.25f };
+  for (unsigned int j = 0; j < NDimension; ++j)
+  {
+    const auto image = singleTransform->GetSinglePrecisionCoefficientImage(j);
+    ASSERT_NE(image, nullptr);
+    float * const buffer = image->GetBufferPointer();
+    for (itk::SizeValueType i = 0; i < image->GetBufferedRegion().GetNumberOfPixels(); ++i)
+    {
+      buffer[i] += shifts[j];
+    }
+  }
+  ASSERT_TRUE(singleTransform->SinglePrecisionCoefficientsAreUpToDate());
+
+  std::vector<PointType> points;
+  for (double position = 2.05; position < 4.5; position += 0.37)
+  {
+    PointType point;
+    point.Fill(position);
+    point[0] += 0.11;
+    points.push_back(point);
+  }
+
+  std::vector<PointType> transformedPoints(points.size());
+  singleTransform->TransformPoints(points.data(), transformedPoints.data(), points.size());
+
+  for (std::size_t n = 0; n < points.size(); ++n)
+  {
+    const PointType expectedPoint = doubleTransform->TransformPoint(points[n]);
+    const PointType actualPoint = singleTransform->TransformPoint(points[n]);
+    for (unsigned int j = 0; j < NDimension; ++j)
+    {
+      EXPECT_NEAR(actualPoint[j], expectedPoint[j] + shifts[j], 1e-5);
+      EXPECT_NEAR(transformedPoints[n][j], expectedPoint[j] + shifts[j], 1e-5);
+    }
+  }
+
+  /** Setting the parameters again refreshes the copy, which removes the shift. */
+  singleTransform->SetParameters(parameters);
+  ASSERT_TRUE(singleTransform->SinglePrecisionCoefficientsAreUpToDate());
+  for (const PointType & point : points)
+  {
+    const PointType expectedPoint = doubleTransform->TransformPoint(point);
+    const PointType actualPoint = singleTransform->TransformPoint(point);
+    for (unsigned int j = 0; j < NDimension; ++j)
+    {
+      EXPECT_NEAR(actualPoint[j], expectedPoint[j], 1e-5);
+    }
+  }
+
+  /** Switching single precision off releases the copy. */
+  singleTransform->UseSinglePrecisionCoefficientsOff();
+  EXPECT_FALSE(singleTransform->SinglePrecisionCoefficientsAreUpToDate());
+  EXPECT_EQ(singleTransform->GetSinglePrecisionCoefficientImage(0), nullptr);
+  EXPECT_EQ(singleTransform->TransformPoint(points.front()), doubleTransform->TransformPoint(points.front()));
+}
+
+
+template <unsigned int NDimension>
+void
+Expect_TransformPointAndGetSpatialJacobian_gives_same_results_as_separate_calls()
+{
+  using TransformType = itk::RecursiveBSplineTransform<double, NDimension, 3>;
+  using PointType = typename TransformType::InputPointType;
+  using SpatialJacobianType = typename TransformType::SpatialJacobianType;
+
+  typename TransformType::RegionType gridRegion;
+  typename TransformType::SizeType   gridSize;
+  gridSize.Fill(8);
+  gridRegion.SetSize(gridSize);
+
+  const auto transform = TransformType::New();
+  transform->SetGridRegion(gridRegion);
+
+  typename TransformType::ParametersType parameters(transform->GetNumberOfParameters());
+  for (unsigned int i = 0; i < parameters.GetSize(); ++i)
+  {
+    parameters[i] = std::sin(0.1 * i);
+  }
+  transform->SetParameters(parameters);
+
+  // The points include some outside the valid region of the grid.
+  for (double position = -1.0; position < 8.5; position += 0.37)
+  {
+    PointType point;
+    point.Fill(position);
+    point[0] += 0.11;
+
+    PointType           actualPoint;
+    SpatialJacobianType actualSpatialJacobian;
+    transform->TransformPointAndGetSpatialJacobian(point, actualPoint, actualSpatialJacobian);
+
+    SpatialJacobianType expectedSpatialJacobian;
+    transform->GetSpatialJacobian(point, expectedSpatialJacobian);
+    EXPECT_EQ(actualSpatialJacobian, expectedSpatialJacobian);
+
+    const PointType expectedPoint = transform->TransformPoint(point);
+    for (unsigned int j = 0; j < NDimension; ++j)
+    {
+      EXPECT_NEAR(actualPoint[j], expectedPoint[j], 1e-12);
+    }
+  }
+}
+} // namespace
+
+
+GTEST_TEST(RecursiveBSplineTransform, SinglePrecisionCoefficients2D)
+{
+  Expect_SinglePrecisionCoefficients_give_nearly_equal_TransformPoint<2>();
+}
+
+
+GTEST_TEST(RecursiveBSplineTransform, SinglePrecisionCoefficients3D)
+{
+  Expect_SinglePrecisionCoefficients_give_nearly_equal_TransformPoint<3>();
+}
+
+
+GTEST_TEST(RecursiveBSplineTransform, SinglePrecisionCoefficientsOutOfDate2D)
+{
+  Expect_SinglePrecisionCoefficients_are_not_used_when_out_of_date<2>();
+}
+
+
+GTEST_TEST(RecursiveBSplineTransform, SinglePrecisionCoefficientsOutOfDate3D)
+{
+  Expect_SinglePrecisionCoefficients_are_not_used_when_out_of_date<3>();
+}
+
+
+GTEST_TEST(RecursiveBSplineTransform, SinglePrecisionCoefficientsAreUsed2D)
+{
+  Expect_SinglePrecisionCoefficients_are_used_when_up_to_date<2>();
+}
+
+
+GTEST_TEST(RecursiveBSplineTransform, SinglePrecisionCoefficientsAreUsed3D)
+{
+  Expect_SinglePrecisionCoefficients_are_used_when_up_to_date<3>();
+}
+
+
+GTEST_TEST(RecursiveBSplineTransform, TransformPointAndGetSpatialJacobian2D)
+{
+  Expect_TransformPointAndGetSpatialJacobian_gives_same_results_as_separate_calls<2>();
+}
+
+
+GTEST_TEST(RecursiveBSplineTransform, TransformPointAndGetSpatialJacobian3D)
+{
+  Expect_TransformPointAndGetSpatialJacobian_gives_same_results_as_separate_calls<3>();
+}
@@ -0,0 +1,256 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "BendingEnergyPenalty/itkTransformBendingEnergyPenaltyTerm.h"
+
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkImageFullSampler.h"
+
+#include <itkImage.h>
+#include <itkImageMaskSpatialObject.h>
+#include <itkLinearInterpolateImageFunction.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace
+{
+
+template <unsigned int NDimension>
+class BendingEnergyTestFixture
+{
+public:
+  using ImageType = itk::Image<float, NDimension>;
+  using PenaltyTermType = itk::TransformBendingEnergyPenaltyTerm<ImageType, double>;
+  using TransformType = itk::AdvancedBSplineDeformableTransform<double, NDimension, 3>;
+  using SamplerType = itk::ImageFullSampler<ImageType>;
+  using InterpolatorType = itk::LinearInterpolateImageFunction<ImageType, double>;
+  using MaskSpatialObjectType = itk::ImageMaskSpatialObject<NDimension>;
+  using DirectionType = typename ImageType::DirectionType;
+  using ParametersType = typename PenaltyTermType::ParametersType;
+  using DerivativeType = typename PenaltyTermType::DerivativeType;
+
+  /** Creates a fixed image with anisotropic pixels, and a B-spline grid that covers it, with an
+   * anisotropic grid spacing. The fixed image and the grid are rotated in the plane of the first
+   * two axes, by the specified angles.
+   */
+  BendingEnergyTestFixture(const double imageRotationAngle, const double gridRotationAngle)
+  {
+    const DirectionType imageDirection = CreateRotation(imageRotationAngle);
+    const DirectionType gridDirection = CreateRotation(gridRotationAngle);
+
+    typename ImageType::SizeType    imageSize;
+    typename ImageType::SpacingType imageSpacing;
+    for (unsigned int d = 0; d < NDimension; ++d)
+    {
+      imageSize[d] = (NDimension == 2) ? 40 - 4 * d : 20 - 2 * d;
+      imageSpacing[d] = 0.5 + 0.25 * d;
+    }
+    m_FixedImage = ImageType::New();
+    m_FixedImage->SetRegions(imageSize);
+    m_FixedImage->SetSpacing(imageSpacing);
+    m_FixedImage->SetDirection(imageDirection);
+    m_FixedImage->Allocate(true);
+
+    /** The grid index of the image origin is 2 along each grid axis, and the grid extends far enough
+     * to have the whole image, up to the outer pixel edges, inside the valid B-spline region.
+     */
+    typename TransformType::SpacingType gridSpacing;
+    typename TransformType::SizeType    gridSize;
+    typename TransformType::OriginType  gridOrigin;
+    double                              imageExtent = 0.0;
+    for (unsigned int d = 0; d < NDimension; ++d)
+    {
+      imageExtent = std::max(imageExtent, imageSize[d] * imageSpacing[d]);
+    }
+    for (unsigned int d = 0; d < NDimension; ++d)
+    {
+      gridSpacing[d] = 4.0 + d;
+      gridSize[d] = static_cast<itk::SizeValueType>(std::ceil(imageExtent / gridSpacing[d])) + 5;
+    }
+    for (unsigned int d = 0; d < NDimension; ++d)
+    {
+      gridOrigin[d] = 0.0;
+      for (unsigned int e = 0; e < NDimension; ++e)
+      {
+        gridOrigin[d] -= gridDirection[d][e] * 2.0 * gridSpacing[e];
+      }
+    }
+
+    m_Transform = TransformType::New();
+    m_Transform->SetGridRegion(typename TransformType::RegionType(gridSize));
+    m_Transform->SetGridSpacing(gridSpacing);
+    m_Transform->SetGridOrigin(gridOrigin);
+    m_Transform->SetGridDirection(gridDirection);
+
+    /** A smooth, but non-trivial deformation. */
+    m_Parameters.SetSize(m_Transform->GetNumberOfParameters());
+    for (unsigned int i = 0; i < m_Parameters.GetSize(); ++i)
+    {
+      m_Parameters[i] = 0.5 * std::sin(0.37 * i) + 0.2 * std::cos(1.3 * i);
+    }
+    m_Transform->SetParameters(m_Parameters);
+  }
+
+
+  /** Creates and initializes a penalty term. */
+  typename PenaltyTermType::Pointer
+  CreatePenaltyTerm(const bool useAnalyticBendingEnergy, const bool useMultiThread, const bool useMask) const
+  {
+    const auto penaltyTerm = PenaltyTermType::New();
+    penaltyTerm->SetFixedImage(m_FixedImage);
+    penaltyTerm->SetMovingImage(m_FixedImage);
+    penaltyTerm->SetFixedImageRegion(m_FixedImage->GetLargestPossibleRegion());
+    penaltyTerm->SetInterpolator(InterpolatorType::New());
+    penaltyTerm->SetTransform(m_Transform);
+    penaltyTerm->SetImageSampler(SamplerType::New());
+    penaltyTerm->SetUseMultiThread(useMultiThread);
+    penaltyTerm->SetUseAnalyticBendingEnergy(useAnalyticBendingEnergy);
+
+    if (useMask)
+    {
+      /** A mask that includes all pixels, so that only its presence makes a difference. */
+      const auto maskImage = MaskSpatialObjectType::ImageType::New();
+      maskImage->CopyInformation(m_FixedImage);
+      maskImage->SetRegions(m_FixedImage->GetLargestPossibleRegion());
+      maskImage->Allocate();
+      maskImage->FillBuffer(1);
+      const auto mask = MaskSpatialObjectType::New();
+      mask->SetImage(maskImage);
+      mask->Update();
+      penaltyTerm->SetFixedImageMask(mask);
+    }
+
+    penaltyTerm->Initialize();
+    return penaltyTerm;
+  }
+
+
+  /** Expects the value and derivative of the penalty term to equal those of the sample-based computation.
+   * The analytic energy is the exact integral over the pixels, whereas the samples evaluate it at
+   * the pixel centers only, so the tolerance is relative.
+   */
+  void
+  ExpectEqualToSampleBased(const PenaltyTermType & penaltyTerm, const double relativeTolerance) const
+  {
+    const auto sampleBasedPenaltyTerm = this->CreatePenaltyTerm(false, false, false);
+    ASSERT_FALSE(sampleBasedPenaltyTerm->GetAnalyticBendingEnergyIsAvailable());
+
+    typename PenaltyTermType::MeasureType expectedValue{};
+    DerivativeType                        expectedDerivative;
+    sampleBasedPenaltyTerm->GetValueAndDerivative(m_Parameters, expectedValue, expectedDerivative);
+    ASSERT_GT(expectedValue, 0.0);
+
+    typename PenaltyTermType::MeasureType actualValue{};
+    DerivativeType                        actualDerivative;
+    penaltyTerm.GetValueAndDerivative(m_Parameters, actualValue, actualDerivative);
+    EXPECT_NEAR(actualValue, expectedValue, relativeTolerance * expectedValue);
+    EXPECT_NEAR(penaltyTerm.GetValue(m_Parameters), expectedValue, relativeTolerance * expectedValue);
+
+    ASSERT_EQ(actualDerivative.GetSize(), expectedDerivative.GetSize());
+    const double maximumDerivative = expectedDerivative.inf_norm();
+    ASSERT_GT(maximumDerivative, 0.0);
+    for (unsigned int i = 0; i < expectedDerivative.GetSize(); ++i)
+    {
+      EXPECT_NEAR(actualDerivative[i], expectedDerivative[i], relativeTolerance * maximumDerivative);
+    }
+  }
+
+private:
+  static DirectionType
+  CreateRotation(const double angle)
+  {
+    DirectionType rotation;
+    rotation.SetIdentity();
+    rotation[0][0] = std::cos(angle);
+    rotation[0][1] = -std::sin(angle);
+    rotation[1][0] = std::sin(angle);
+    rotation[1][1] = std::cos(angle);
+    return rotation;
+  }
+
+  typename ImageType::Pointer     m_FixedImage;
+  typename TransformType::Pointer m_Transform;
+  ParametersType                  m_Parameters;
+};
+
+
+template <unsigned int NDimension>
+void
+Expect_analytic_bending_energy_equals_sample_based_bending_energy()
+{
+  /** Both axis-aligned, and rotated by the same angle. */
+  for (const double angle : { 0.0, 0.3 })
+  {
+    const BendingEnergyTestFixture<NDimension> fixture(angle, angle);
+    for (const bool useMultiThread : { false, true })
+    {
+      const auto penaltyTerm = fixture.CreatePenaltyTerm(true, useMultiThread, false);
+      ASSERT_TRUE(penaltyTerm->GetAnalyticBendingEnergyIsAvailable());
+      fixture.ExpectEqualToSampleBased(*penaltyTerm, 1e-2);
+    }
+  }
+}
+
+
+template <unsigned int NDimension>
+void
+Expect_sample_based_bending_energy_with_mask_or_unaligned_grid()
+{
+  /** The analytic energy would be integrated over the bounding box of the rotated fixed image. */
+  const BendingEnergyTestFixture<NDimension> unalignedFixture(0.3, 0.0);
+  const auto unalignedPenaltyTerm = unalignedFixture.CreatePenaltyTerm(true, false, false);
+  EXPECT_FALSE(unalignedPenaltyTerm->GetAnalyticBendingEnergyIsAvailable());
+  unalignedFixture.ExpectEqualToSampleBased(*unalignedPenaltyTerm, 1e-12);
+
+  /** The analytic energy would ignore the mask. */
+  const BendingEnergyTestFixture<NDimension> fixture(0.0, 0.0);
+  const auto                                 maskedPenaltyTerm = fixture.CreatePenaltyTerm(true, false, true);
+  EXPECT_FALSE(maskedPenaltyTerm->GetAnalyticBendingEnergyIsAvailable());
+}
+
+} // namespace
+
+
+GTEST_TEST(TransformBendingEnergyPenaltyTerm, AnalyticEqualsSampleBased2D)
+{
+  Expect_analytic_bending_energy_equals_sample_based_bending_energy<2>();
+}
+
+
+GTEST_TEST(TransformBendingEnergyPenaltyTerm, AnalyticEqualsSampleBased3D)
+{
+  Expect_analytic_bending_energy_equals_sample_based_bending_energy<3>();
+}
+
+
+GTEST_TEST(TransformBendingEnergyPenaltyTerm, SampleBasedWithMaskOrUnalignedGrid2D)
+{
+  Expect_sample_based_bending_energy_with_mask_or_unaligned_grid<2>();
+}
+
+
+GTEST_TEST(TransformBendingEnergyPenaltyTerm, SampleBasedWithMaskOrUnalignedGrid3D)
+{
+  Expect_sample_based_bending_energy_with_mask_or_unaligned_grid<3>();
+}
@@ -0,0 +1,148 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "RigidityPenalty/itkTransformRigidityPenaltyTerm.h"
+
+#include <itkImage.h>
+#include <itkImageRegionIterator.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+
+namespace
+{
+/** Gives access to the fused separable filtering of the penalty term. */
+template <unsigned int NDimension>
+class FilterSeparableTestPenaltyTerm
+  : public itk::TransformRigidityPenaltyTerm<itk::Image<float, NDimension>, double>
+{
+public:
+  using Self = FilterSeparableTestPenaltyTerm;
+  using Superclass = itk::TransformRigidityPenaltyTerm<itk::Image<float, NDimension>, double>;
+  using Pointer = itk::SmartPointer<Self>;
+  itkNewMacro(Self);
+
+  using Superclass::FilterSeparableFused;
+};
+
+
+/** Filters the image with a pipeline of NeighborhoodOperatorImageFilters, one per dimension. */
+template <class TPenaltyTerm>
+typename TPenaltyTerm::CoefficientImagePointer
+FilterSeparable(const typename TPenaltyTerm::CoefficientImageType *          image,
+                const std::vector<typename TPenaltyTerm::NeighborhoodType> & operators)
+{
+  const unsigned int dimension = TPenaltyTerm::CoefficientImageType::ImageDimension;
+
+  std::vector<typename TPenaltyTerm::NOIFType::Pointer> filters(dimension);
+  for (unsigned int i = 0; i < dimension; ++i)
+  {
+    filters[i] = TPenaltyTerm::NOIFType::New();
+    filters[i]->SetOperator(operators[i]);
+    filters[i]->SetInput(i == 0 ? image : filters[i - 1]->GetOutput());
+  }
+  filters[dimension - 1]->Update();
+  return filters[dimension - 1]->GetOutput();
+}
+
+
+template <unsigned int NDimension>
+void
+Expect_FilterSeparableFused_gives_same_results_as_NeighborhoodOperatorImageFilters(
+  const itk::Size<NDimension> & imageSize)
+{
+  using PenaltyTermType = FilterSeparableTestPenaltyTerm<NDimension>;
+  using CoefficientImageType = typename PenaltyTermType::CoefficientImageType;
+  using NeighborhoodType = typename PenaltyTermType::NeighborhoodType;
+
+  /** Create an image with non-trivial pixel values. */
+  const auto image = CoefficientImageType::New();
+  image->SetRegions(imageSize);
+  image->Allocate();
+  double                                         pixelNumber = 0.0;
+  itk::ImageRegionIterator<CoefficientImageType> it(image, image->GetBufferedRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it, ++pixelNumber)
+  {
+    it.Set(std::sin(0.37 * pixelNumber) + 0.001 * pixelNumber);
+  }
+
+  /** Create operator sets that have some, but not all, of their 1D passes in common. */
+  const double       kernels[3][3] = { { -0.5, 0.0, 0.5 }, { 1.0 / 6.0, 2.0 / 3.0, 1.0 / 6.0 }, { 1.0, -2.0, 1.0 } };
+  const unsigned int kernelIndices[5][3] = { { 1, 1, 0 }, { 1, 0, 1 }, { 0, 1, 1 }, { 2, 1, 1 }, { 1, 2, 0 } };
+
+  std::vector<std::vector<NeighborhoodType>> operatorSets(5, std::vector<NeighborhoodType>(NDimension));
+  for (unsigned int m = 0; m < operatorSets.size(); ++m)
+  {
+    for (unsigned int d = 0; d < NDimension; ++d)
+    {
+      typename NeighborhoodType::SizeType radius;
+      radius.Fill(0);
+      radius[d] = 1;
+      NeighborhoodType & F = operatorSets[m][d];
+      F.SetRadius(radius);
+      for (unsigned int k = 0; k < 3; ++k)
+      {
+        F[k] = kernels[kernelIndices[m][d]][k];
+      }
+    }
+  }
+
+  const auto penaltyTerm = PenaltyTermType::New();
+  for (const bool useMultiThread : { false, true })
+  {
+    penaltyTerm->SetUseMultiThread(useMultiThread);
+
+    std::vector<typename CoefficientImageType::Pointer> actualImages;
+    penaltyTerm->FilterSeparableFused(image, operatorSets, actualImages);
+    ASSERT_EQ(actualImages.size(), operatorSets.size());
+
+    for (unsigned int m = 0; m < operatorSets.size(); ++m)
+    {
+      const auto expectedImage = FilterSeparable<PenaltyTermType>(image, operatorSets[m]);
+      ASSERT_EQ(actualImages[m]->GetBufferedRegion(), expectedImage->GetBufferedRegion());
+
+      const double * const actual = actualImages[m]->GetBufferPointer();
+      const double * const expected = expectedImage->GetBufferPointer();
+      for (itk::SizeValueType i = 0; i < expectedImage->GetBufferedRegion().GetNumberOfPixels(); ++i)
+      {
+        EXPECT_NEAR(actual[i], expected[i], 1e-12);
+      }
+    }
+  }
+}
+
+} // namespace
+
+
+GTEST_TEST(TransformRigidityPenaltyTerm, FilterSeparableFused2D)
+{
+  Expect_FilterSeparableFused_gives_same_results_as_NeighborhoodOperatorImageFilters<2>(itk::Size<2>{ { 37, 23 } });
+}
+
+
+GTEST_TEST(TransformRigidityPenaltyTerm, FilterSeparableFused3D)
+{
+  // The slices are large enough to have the last dimension processed in multiple blocks.
+  Expect_FilterSeparableFused_gives_same_results_as_NeighborhoodOperatorImageFilters<3>(
+    itk::Size<3>{ { 64, 48, 21 } });
+}
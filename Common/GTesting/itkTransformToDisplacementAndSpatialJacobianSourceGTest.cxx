@@ -0,0 +1,243 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkTransformToDisplacementAndSpatialJacobianSource.h"
+
+#include "itkRecursiveBSplineTransform.h"
+#include "itkTransformToDeterminantOfSpatialJacobianSource.h"
+#include "itkTransformToSpatialJacobianSource.h"
+
+#include <itkImage.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionIterator.h>
+#include <itkLinearInterpolateImageFunction.h>
+#include <itkResampleImageFilter.h>
+#include <itkTransformToDisplacementFieldFilter.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+
+namespace
+{
+
+template <typename TImage, typename TExpectNearPixel>
+void
+ExpectEqualPixels(const TImage & expectedImage, const TImage & actualImage, const TExpectNearPixel & expectNearPixel)
+{
+  ASSERT_EQ(actualImage.GetLargestPossibleRegion(), expectedImage.GetLargestPossibleRegion());
+  EXPECT_EQ(actualImage.GetSpacing(), expectedImage.GetSpacing());
+  EXPECT_EQ(actualImage.GetOrigin(), expectedImage.GetOrigin());
+  EXPECT_EQ(actualImage.GetDirection(), expectedImage.GetDirection());
+
+  itk::ImageRegionConstIterator<TImage> expectedIt(&expectedImage, expectedImage.GetLargestPossibleRegion());
+  itk::ImageRegionConstIterator<TImage> actualIt(&actualImage, actualImage.GetLargestPossibleRegion());
+  for (; !expectedIt.IsAtEnd(); ++expectedIt, ++actualIt)
+  {
+    expectNearPixel(expectedIt.Get(), actualIt.Get());
+  }
+}
+
+
+template <unsigned int NDimension>
+void
+Expect_single_pass_equals_separate_filters()
+{
+  using TransformType = itk::RecursiveBSplineTransform<double, NDimension, 3>;
+  using DisplacementFieldImageType = itk::Image<itk::Vector<float, NDimension>, NDimension>;
+  using DeterminantImageType = itk::Image<float, NDimension>;
+  using SpatialJacobianImageType = itk::Image<itk::Matrix<float, NDimension, NDimension>, NDimension>;
+  using ImageType = itk::Image<float, NDimension>;
+  using SourceType = itk::TransformToDisplacementAndSpatialJacobianSource<DisplacementFieldImageType,
+                                                                         DeterminantImageType,
+                                                                         SpatialJacobianImageType,
+                                                                         ImageType,
+                                                                         double>;
+  using InterpolatorType = itk::LinearInterpolateImageFunction<ImageType, double>;
+  using DisplacementFieldFilterType = itk::TransformToDisplacementFieldFilter<DisplacementFieldImageType, double>;
+  using DeterminantSourceType = itk::TransformToDeterminantOfSpatialJacobianSource<DeterminantImageType, double>;
+  using SpatialJacobianSourceType = itk::TransformToSpatialJacobianSource<SpatialJacobianImageType, double>;
+
+  /** A B-spline transform with a smooth, but non-trivial deformation. */
+  const auto                          transform = TransformType::New();
+  typename TransformType::SizeType    gridSize;
+  typename TransformType::RegionType  gridRegion;
+  typename TransformType::SpacingType gridSpacing;
+  typename TransformType::OriginType  gridOrigin;
+  gridSize.Fill(10);
+  gridRegion.SetSize(gridSize);
+  gridSpacing.Fill(4.0);
+  gridOrigin.Fill(-8.0);
+  transform->SetGridRegion(gridRegion);
+  transform->SetGridSpacing(gridSpacing);
+  transform->SetGridOrigin(gridOrigin);
+  typename TransformType::ParametersType parameters(transform->GetNumberOfParameters());
+  for (unsigned int i = 0; i < parameters.GetSize(); ++i)
+  {
+    parameters[i] = 0.8 * std::sin(0.3 * i);
+  }
+  transform->SetParameters(parameters);
+
+  /** The moving image, with a smooth intensity pattern. */
+  const auto                   movingImage = ImageType::New();
+  typename ImageType::SizeType movingImageSize;
+  movingImageSize.Fill(16);
+  movingImage->SetRegions(movingImageSize);
+  movingImage->Allocate();
+  for (itk::ImageRegionIterator<ImageType> it(movingImage, movingImage->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+  {
+    double value = 0.0;
+    for (unsigned int d = 0; d < NDimension; ++d)
+    {
+      value += std::cos(0.4 * (d + 1) * it.GetIndex()[d]);
+    }
+    it.Set(static_cast<float>(10.0 * value));
+  }
+
+  /** An output grid that is partly outside the moving image, and slightly rotated. */
+  typename ImageType::SizeType      outputSize;
+  typename ImageType::IndexType     outputIndex;
+  typename ImageType::SpacingType   outputSpacing;
+  typename ImageType::PointType     outputOrigin;
+  typename ImageType::DirectionType outputDirection;
+  outputSize.Fill(14);
+  outputIndex.Fill(1);
+  outputSpacing.Fill(1.3);
+  outputOrigin.Fill(-2.5);
+  outputDirection.SetIdentity();
+  outputDirection[0][0] = std::cos(0.1);
+  outputDirection[0][1] = -std::sin(0.1);
+  outputDirection[1][0] = std::sin(0.1);
+  outputDirection[1][1] = std::cos(0.1);
+  const float defaultPixelValue = -7.0f;
+
+  /** The single pass. */
+  const auto source = SourceType::New();
+  source->SetTransform(transform);
+  source->SetOutputSize(outputSize);
+  source->SetOutputIndex(outputIndex);
+  source->SetOutputSpacing(outputSpacing);
+  source->SetOutputOrigin(outputOrigin);
+  source->SetOutputDirection(outputDirection);
+  source->SetGenerateDisplacementField(true);
+  source->SetGenerateDeterminantOfSpatialJacobian(true);
+  source->SetGenerateSpatialJacobian(true);
+  source->SetGenerateResultImage(true);
+  source->SetMovingImage(movingImage);
+  source->SetInterpolator(InterpolatorType::New());
+  source->SetDefaultPixelValue(defaultPixelValue);
+  source->Update();
+
+  /** The separate filters, as used by transformix when only one of the outputs is requested. */
+  const auto displacementFieldFilter = DisplacementFieldFilterType::New();
+  displacementFieldFilter->SetTransform(transform);
+  displacementFieldFilter->SetSize(outputSize);
+  displacementFieldFilter->SetOutputStartIndex(outputIndex);
+  displacementFieldFilter->SetOutputSpacing(outputSpacing);
+  displacementFieldFilter->SetOutputOrigin(outputOrigin);
+  displacementFieldFilter->SetOutputDirection(outputDirection);
+  displacementFieldFilter->Update();
+
+  const auto determinantSource = DeterminantSourceType::New();
+  determinantSource->SetTransform(transform);
+  determinantSource->SetOutputSize(outputSize);
+  determinantSource->SetOutputIndex(outputIndex);
+  determinantSource->SetOutputSpacing(outputSpacing);
+  determinantSource->SetOutputOrigin(outputOrigin);
+  determinantSource->SetOutputDirection(outputDirection);
+  determinantSource->Update();
+
+  const auto spatialJacobianSource = SpatialJacobianSourceType::New();
+  spatialJacobianSource->SetTransform(transform);
+  spatialJacobianSource->SetOutputSize(outputSize);
+  spatialJacobianSource->SetOutputIndex(outputIndex);
+  spatialJacobianSource->SetOutputSpacing(outputSpacing);
+  spatialJacobianSource->SetOutputOrigin(outputOrigin);
+  spatialJacobianSource->SetOutputDirection(outputDirection);
+  spatialJacobianSource->Update();
+
+  const auto resampler = itk::ResampleImageFilter<ImageType, ImageType, double>::New();
+  resampler->SetInput(movingImage);
+  resampler->SetTransform(transform);
+  resampler->SetInterpolator(InterpolatorType::New());
+  resampler->SetDefaultPixelValue(defaultPixelValue);
+  resampler->SetSize(outputSize);
+  resampler->SetOutputStartIndex(outputIndex);
+  resampler->SetOutputSpacing(outputSpacing);
+  resampler->SetOutputOrigin(outputOrigin);
+  resampler->SetOutputDirection(outputDirection);
+  resampler->Update();
+
+  /** The single pass computes the transformed point from the spatial Jacobian evaluation,
+   * which may differ from TransformPoint() in the last bits only.
+   */
+  ExpectEqualPixels(
+    *displacementFieldFilter->GetOutput(),
+    *source->GetDisplacementFieldOutput(),
+    [](const itk::Vector<float, NDimension> & expected, const itk::Vector<float, NDimension> & actual) {
+      for (unsigned int d = 0; d < NDimension; ++d)
+      {
+        EXPECT_NEAR(actual[d], expected[d], 1e-5);
+      }
+    });
+  ExpectEqualPixels(
+    *determinantSource->GetOutput(),
+    *source->GetDeterminantOfSpatialJacobianOutput(),
+    [](const float expected, const float actual) { EXPECT_NEAR(actual, expected, 1e-5); });
+  ExpectEqualPixels(
+    *spatialJacobianSource->GetOutput(),
+    *source->GetSpatialJacobianOutput(),
+    [](const itk::Matrix<float, NDimension, NDimension> & expected,
+       const itk::Matrix<float, NDimension, NDimension> & actual) {
+      for (unsigned int i = 0; i < NDimension; ++i)
+      {
+        for (unsigned int j = 0; j < NDimension; ++j)
+        {
+          EXPECT_NEAR(actual[i][j], expected[i][j], 1e-5);
+        }
+      }
+    });
+
+  /** Both pixels inside and outside the moving image must be present, to test both cases. */
+  unsigned int numberOfDefaultPixels = 0;
+  ExpectEqualPixels(*resampler->GetOutput(),
+                    *source->GetResultImageOutput(),
+                    [&numberOfDefaultPixels, defaultPixelValue](const float expected, const float actual) {
+                      EXPECT_NEAR(actual, expected, 1e-3);
+                      numberOfDefaultPixels += (expected == defaultPixelValue) ? 1 : 0;
+                    });
+  EXPECT_GT(numberOfDefaultPixels, 0);
+  EXPECT_LT(numberOfDefaultPixels, source->GetResultImageOutput()->GetLargestPossibleRegion().GetNumberOfPixels());
+}
+
+} // namespace
+
+
+GTEST_TEST(TransformToDisplacementAndSpatialJacobianSource, SinglePassEqualsSeparateFilters2D)
+{
+  Expect_single_pass_equals_separate_filters<2>();
+}
+
+
+GTEST_TEST(TransformToDisplacementAndSpatialJacobianSource, SinglePassEqualsSeparateFilters3D)
+{
+  Expect_single_pass_equals_separate_filters<3>();
+}
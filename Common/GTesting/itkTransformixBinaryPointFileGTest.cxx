@@ -0,0 +1,130 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkTransformixBinaryPointFile.h"
+
+#include <itkPoint.h>
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+using itk::TransformixBinaryPointFile;
+
+
+GTEST_TEST(TransformixBinaryPointFile, ReadHeaderReturnsFalseOnTextFile)
+{
+  std::istringstream stream("point\n2\n1.0 2.0\n3.0 4.0\n");
+
+  TransformixBinaryPointFile::HeaderType header;
+  EXPECT_FALSE(TransformixBinaryPointFile::ReadHeader(stream, header));
+
+  // The text can still be read from the start of the stream.
+  std::string firstWord;
+  stream >> firstWord;
+  EXPECT_EQ(firstWord, "point");
+}
+
+
+GTEST_TEST(TransformixBinaryPointFile, WriteAndReadPoints)
+{
+  using PointType = itk::Point<double, 3>;
+
+  std::vector<PointType> points(5);
+  for (std::size_t i = 0; i < points.size(); ++i)
+  {
+    points[i][0] = static_cast<double>(i);
+    points[i][1] = -0.5 * static_cast<double>(i);
+    points[i][2] = 1.0e6 + 0.25 * static_cast<double>(i);
+  }
+
+  std::stringstream stream;
+  TransformixBinaryPointFile::WriteHeader(stream, TransformixBinaryPointFile::CreateHeader(3, points.size(), true));
+  TransformixBinaryPointFile::WritePoints(stream, points.data(), points.size());
+
+  TransformixBinaryPointFile::HeaderType header;
+  ASSERT_TRUE(TransformixBinaryPointFile::ReadHeader(stream, header));
+  EXPECT_EQ(header.Dimension, 3U);
+  EXPECT_EQ(header.BytesPerValue, sizeof(double));
+  EXPECT_EQ(header.PointsAreIndices, 1U);
+  ASSERT_EQ(header.NumberOfPoints, points.size());
+
+  // Read the points as double, and as float.
+  std::vector<PointType> actualPoints(points.size());
+  const auto             position = stream.tellg();
+  TransformixBinaryPointFile::ReadPoints(stream, header, actualPoints.data());
+  EXPECT_EQ(actualPoints, points);
+
+  std::vector<itk::Point<float, 3>> actualFloatPoints(points.size());
+  stream.seekg(position);
+  TransformixBinaryPointFile::ReadPoints(stream, header, actualFloatPoints.data());
+  for (std::size_t i = 0; i < points.size(); ++i)
+  {
+    for (unsigned int d = 0; d < 3; ++d)
+    {
+      EXPECT_EQ(actualFloatPoints[i][d], static_cast<float>(points[i][d]));
+    }
+  }
+}
+
+
+GTEST_TEST(TransformixBinaryPointFile, ReadHeaderThrowsWhenFileIsTooSmall)
+{
+  const std::vector<itk::Point<double, 2>> points(3);
+
+  // The file does not contain the coordinates of the points.
+  std::stringstream emptyStream;
+  TransformixBinaryPointFile::WriteHeader(emptyStream, TransformixBinaryPointFile::CreateHeader(2, 3, false));
+
+  TransformixBinaryPointFile::HeaderType header;
+  EXPECT_THROW(TransformixBinaryPointFile::ReadHeader(emptyStream, header), itk::ExceptionObject);
+
+  // The file contains the coordinates of fewer points than specified.
+  std::stringstream truncatedStream;
+  TransformixBinaryPointFile::WriteHeader(truncatedStream, TransformixBinaryPointFile::CreateHeader(2, 4, false));
+  TransformixBinaryPointFile::WritePoints(truncatedStream, points.data(), points.size());
+  EXPECT_THROW(TransformixBinaryPointFile::ReadHeader(truncatedStream, header), itk::ExceptionObject);
+
+  // A huge number of points must not overflow the size computation.
+  std::stringstream hugeStream;
+  TransformixBinaryPointFile::WriteHeader(hugeStream,
+                                          TransformixBinaryPointFile::CreateHeader(2, UINT64_C(1) << 61, false));
+  TransformixBinaryPointFile::WritePoints(hugeStream, points.data(), points.size());
+  EXPECT_THROW(TransformixBinaryPointFile::ReadHeader(hugeStream, header), itk::ExceptionObject);
+}
+
+
+GTEST_TEST(TransformixBinaryPointFile, ReadPointsThrowsOnMismatch)
+{
+  const std::vector<itk::Point<double, 2>> points(3);
+
+  std::stringstream stream;
+  TransformixBinaryPointFile::WriteHeader(stream, TransformixBinaryPointFile::CreateHeader(2, points.size(), false));
+  TransformixBinaryPointFile::WritePoints(stream, points.data(), points.size());
+
+  TransformixBinaryPointFile::HeaderType header;
+  ASSERT_TRUE(TransformixBinaryPointFile::ReadHeader(stream, header));
+
+  // The dimension does not match.
+  std::vector<itk::Point<double, 3>> points3D(points.size());
+  EXPECT_THROW(TransformixBinaryPointFile::ReadPoints(stream, header, points3D.data()), itk::ExceptionObject);
+}
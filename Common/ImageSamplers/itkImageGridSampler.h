@@ -147,12 +147,42 @@ protected:
   void
   GenerateData(void) override;
 
+  /** Multi-threaded functionality that does the work. */
+  void
+  BeforeThreadedGenerateData(void) override;
+
+  void
+  ThreadedGenerateData(const InputImageRegionType & inputRegionForThread, ThreadIdType threadId) override;
+
+  void
+  AfterThreadedGenerateData(void) override;
+
+  /** Compute the index of the first grid point and the size of the grid,
+   * such that the grid is centered on the cropped input image region. */
+  virtual void
+  ComputeSampleGrid(SampleGridIndexType & sampleGridIndex, SampleGridSizeType & sampleGridSize) const;
+
+  /** Compute the part of the grid, given by its first grid point and its size, that lies within a region.
+   * Grid points beyond the end of the grid are excluded, also when the region extends further. */
+  virtual void
+  ComputeSampleGridInRegion(const SampleGridIndexType &  sampleGridIndex,
+                            const SampleGridSizeType &   sampleGridSize,
+                            const InputImageRegionType & region,
+                            SampleGridIndexType &        regionGridIndex,
+                            SampleGridSizeType &         regionGridSize) const;
+
   /** An array of integer spacing factors */
   SampleGridSpacingType m_SampleGridSpacing;
 
   /** The number of samples entered in the SetNumberOfSamples method */
   unsigned long m_RequestedNumberOfSamples;
 
+  /** Member variables used when threading. Without a mask, each thread writes
+   * its samples directly to the output, starting at its own offset. */
+  SampleGridIndexType        m_ThreaderSampleGridIndex;
+  SampleGridSizeType         m_ThreaderSampleGridSize;
+  std::vector<unsigned long> m_ThreaderSampleOffsets;
+
 private:
   /** The deleted copy constructor. */
   ImageGridSampler(const Self &) = delete;
@@ -63,6 +63,13 @@ template <class TInputImage>
 void
 ImageGridSampler<TInputImage>::GenerateData(void)
 {
+  /** If desired we exercise a multi-threaded version. */
+  if (this->m_UseMultiThread)
+  {
+    /** Calls ThreadedGenerateData(). */
+    return Superclass::GenerateData();
+  }
+
   /** Get handles to the input image, output sample container, and the mask. */
   InputImageConstPointer                     inputImage = this->GetInput();
   typename ImageSampleContainerType::Pointer sampleContainer = this->GetOutput();
@@ -71,33 +78,14 @@ ImageGridSampler<TInputImage>::GenerateData(void)
   /** Clear the container. */
   sampleContainer->Initialize();
 
-  /** Set up a region iterator within the user specified image region. */
-  typedef ImageRegionConstIteratorWithIndex<InputImageType> InputImageIterator;
-  InputImageIterator                                        iter(inputImage, this->GetCroppedInputImageRegion());
-
   /** Take into account the possibility of a smaller bounding box around the mask */
   this->SetNumberOfSamples(this->m_RequestedNumberOfSamples);
 
   /** Determine the grid. */
-  SampleGridIndexType        index;
-  SampleGridSizeType         sampleGridSize;
-  SampleGridIndexType        sampleGridIndex = this->GetCroppedInputImageRegion().GetIndex();
-  const InputImageSizeType & inputImageSize = this->GetCroppedInputImageRegion().GetSize();
-  unsigned long              numberOfSamplesOnGrid = 1;
-  for (unsigned int dim = 0; dim < InputImageDimension; dim++)
-  {
-    /** The number of sample point along one dimension. */
-    sampleGridSize[dim] = 1 + ((inputImageSize[dim] - 1) / this->GetSampleGridSpacing()[dim]);
-
-    /** The position of the first sample along this dimension is
-     * chosen to center the grid nicely on the input image region.
-     */
-    sampleGridIndex[dim] +=
-      (inputImageSize[dim] - ((sampleGridSize[dim] - 1) * this->GetSampleGridSpacing()[dim] + 1)) / 2;
-
-    /** Update the number of samples on the grid. */
-    numberOfSamplesOnGrid *= sampleGridSize[dim];
-  }
+  SampleGridIndexType index;
+  SampleGridSizeType  sampleGridSize;
+  SampleGridIndexType sampleGridIndex;
+  this->ComputeSampleGrid(sampleGridIndex, sampleGridSize);
 
   /** Prepare for looping over the grid. */
   unsigned int dim_z = 1;
@@ -210,6 +198,227 @@ ImageGridSampler<TInputImage>::GenerateData(void)
 } // end GenerateData()
 
 
+/**
+ * ******************* BeforeThreadedGenerateData *******************
+ */
+
+template <class TInputImage>
+void
+ImageGridSampler<TInputImage>::BeforeThreadedGenerateData(void)
+{
+  /** Initialize the sample containers of the threads. */
+  Superclass::BeforeThreadedGenerateData();
+
+  /** Take into account the possibility of a smaller bounding box around the mask */
+  this->SetNumberOfSamples(this->m_RequestedNumberOfSamples);
+
+  /** Determine the grid. */
+  this->ComputeSampleGrid(this->m_ThreaderSampleGridIndex, this->m_ThreaderSampleGridSize);
+
+  /** Get handles to the output sample container and the mask. */
+  typename ImageSampleContainerType::Pointer sampleContainer = this->GetOutput();
+  typename MaskType::ConstPointer            mask = this->GetMask();
+  sampleContainer->Initialize();
+
+  if (mask.IsNotNull())
+  {
+    if (mask->GetSource())
+    {
+      mask->GetSource()->Update();
+    }
+    return;
+  }
+
+  /** Without a mask, the number of grid points in the region of each thread is known
+   * in advance. Therefore the threads can directly write to the output, which saves
+   * combining the results afterwards. Threads that do not get a region get no samples.
+   */
+  const ThreadIdType numberOfWorkUnits = this->GetNumberOfWorkUnits();
+  this->m_ThreaderSampleOffsets.assign(numberOfWorkUnits + 1, 0);
+  for (ThreadIdType threadId = 0; threadId < numberOfWorkUnits; ++threadId)
+  {
+    unsigned long        numberOfSamplesThisThread = 0;
+    InputImageRegionType region;
+    if (threadId < this->SplitRequestedRegion(threadId, numberOfWorkUnits, region))
+    {
+      SampleGridIndexType regionGridIndex;
+      SampleGridSizeType  regionGridSize;
+      this->ComputeSampleGridInRegion(
+        this->m_ThreaderSampleGridIndex, this->m_ThreaderSampleGridSize, region, regionGridIndex, regionGridSize);
+      numberOfSamplesThisThread = regionGridSize.CalculateProductOfElements();
+    }
+    this->m_ThreaderSampleOffsets[threadId + 1] = this->m_ThreaderSampleOffsets[threadId] + numberOfSamplesThisThread;
+  }
+
+  /** Allocate the output. */
+  sampleContainer->resize(this->m_ThreaderSampleOffsets[numberOfWorkUnits]);
+
+} // end BeforeThreadedGenerateData()
+
+
+/**
+ * ******************* ThreadedGenerateData *******************
+ */
+
+template <class TInputImage>
+void
+ImageGridSampler<TInputImage>::ThreadedGenerateData(const InputImageRegionType & inputRegionForThread,
+                                                    ThreadIdType                 threadId)
+{
+  /** Get handles to the input image, mask and the output. */
+  InputImageConstPointer          inputImage = this->GetInput();
+  typename MaskType::ConstPointer mask = this->GetMask();
+  ImageSampleContainerPointer &   sampleContainerThisThread = this->m_ThreaderSampleContainer[threadId];
+
+  /** Without a mask, the samples are written directly to the storage of the output.
+   * Its SetElement() would call Modified() from all threads, which is not thread-safe.
+   */
+  typename ImageSampleContainerType::STLContainerType & samples = this->GetOutput()->CastToSTLContainer();
+
+  /** Determine the part of the grid in the region of this thread. */
+  SampleGridIndexType regionGridIndex;
+  SampleGridSizeType  regionGridSize;
+  this->ComputeSampleGridInRegion(this->m_ThreaderSampleGridIndex,
+                                  this->m_ThreaderSampleGridSize,
+                                  inputRegionForThread,
+                                  regionGridIndex,
+                                  regionGridSize);
+  const unsigned long numberOfSamplesOnGrid = regionGridSize.CalculateProductOfElements();
+  if (numberOfSamplesOnGrid == 0)
+  {
+    return;
+  }
+
+  /** Loop over the grid points in scan order, so that the combined
+   * output of all threads is equal to that of the single-threaded version.
+   */
+  SampleGridIndexType index = regionGridIndex;
+  SampleGridSizeType  gridPosition;
+  gridPosition.Fill(0);
+  unsigned long   sampleId = (mask.IsNull()) ? this->m_ThreaderSampleOffsets[threadId] : 0;
+  ImageSampleType tempSample;
+  for (unsigned long i = 0; i < numberOfSamplesOnGrid; ++i)
+  {
+    /** Translate index to point. */
+    inputImage->TransformIndexToPhysicalPoint(index, tempSample.m_ImageCoordinates);
+
+    if (mask.IsNull())
+    {
+      /** Get sampled fixed image value and store the sample in the output. */
+      tempSample.m_ImageValue = inputImage->GetPixel(index);
+      samples[sampleId] = tempSample;
+      ++sampleId;
+    }
+    else if (mask->IsInsideInWorldSpace(tempSample.m_ImageCoordinates))
+    {
+      /** Get sampled fixed image value and store the sample in the container of this thread. */
+      tempSample.m_ImageValue = inputImage->GetPixel(index);
+      sampleContainerThisThread->push_back(tempSample);
+    }
+
+    /** Jump to the next position on the grid. */
+    for (unsigned int dim = 0; dim < InputImageDimension; ++dim)
+    {
+      ++gridPosition[dim];
+      index[dim] += this->m_SampleGridSpacing[dim];
+      if (gridPosition[dim] < regionGridSize[dim])
+      {
+        break;
+      }
+      gridPosition[dim] = 0;
+      index[dim] = regionGridIndex[dim];
+    }
+  }
+
+} // end ThreadedGenerateData()
+
+
+/**
+ * ******************* AfterThreadedGenerateData *******************
+ */
+
+template <class TInputImage>
+void
+ImageGridSampler<TInputImage>::AfterThreadedGenerateData(void)
+{
+  /** Without a mask, the samples are already in the output. */
+  if (this->GetMask() == nullptr)
+  {
+    this->GetOutput()->Modified();
+    return;
+  }
+
+  /** Combine the results of all threads. */
+  Superclass::AfterThreadedGenerateData();
+
+} // end AfterThreadedGenerateData()
+
+
+/**
+ * ******************* ComputeSampleGrid *******************
+ */
+
+template <class TInputImage>
+void
+ImageGridSampler<TInputImage>::ComputeSampleGrid(SampleGridIndexType & sampleGridIndex,
+                                                 SampleGridSizeType &  sampleGridSize) const
+{
+  sampleGridIndex = this->GetCroppedInputImageRegion().GetIndex();
+  const InputImageSizeType & inputImageSize = this->GetCroppedInputImageRegion().GetSize();
+  for (unsigned int dim = 0; dim < InputImageDimension; dim++)
+  {
+    /** The number of sample point along one dimension. */
+    sampleGridSize[dim] = 1 + ((inputImageSize[dim] - 1) / this->GetSampleGridSpacing()[dim]);
+
+    /** The position of the first sample along this dimension is
+     * chosen to center the grid nicely on the input image region.
+     */
+    sampleGridIndex[dim] +=
+      (inputImageSize[dim] - ((sampleGridSize[dim] - 1) * this->GetSampleGridSpacing()[dim] + 1)) / 2;
+  }
+
+} // end ComputeSampleGrid()
+
+
+/**
+ * ******************* ComputeSampleGridInRegion *******************
+ */
+
+template <class TInputImage>
+void
+ImageGridSampler<TInputImage>::ComputeSampleGridInRegion(const SampleGridIndexType &  sampleGridIndex,
+                                                         const SampleGridSizeType &   sampleGridSize,
+                                                         const InputImageRegionType & region,
+                                                         SampleGridIndexType &        regionGridIndex,
+                                                         SampleGridSizeType &         regionGridSize) const
+{
+  for (unsigned int dim = 0; dim < InputImageDimension; dim++)
+  {
+    const SampleGridSpacingValueType spacing = this->GetSampleGridSpacing()[dim];
+    const SampleGridSpacingValueType regionBegin = region.GetIndex()[dim];
+    const SampleGridSpacingValueType regionEnd =
+      regionBegin + static_cast<SampleGridSpacingValueType>(region.GetSize()[dim]);
+
+    /** The region may extend beyond the grid, for example when it is a part of the requested
+     * region of the input image, while the grid only covers the cropped input image region.
+     */
+    const SampleGridSpacingValueType gridEnd =
+      sampleGridIndex[dim] + static_cast<SampleGridSpacingValueType>(sampleGridSize[dim] - 1) * spacing + 1;
+    const SampleGridSpacingValueType end = std::min(regionEnd, gridEnd);
+
+    /** The first grid point at or after the start of the region. */
+    SampleGridSpacingValueType first = sampleGridIndex[dim];
+    if (first < regionBegin)
+    {
+      first += ((regionBegin - first + spacing - 1) / spacing) * spacing;
+    }
+    regionGridIndex[dim] = first;
+    regionGridSize[dim] = (sampleGridSize[dim] > 0 && first < end) ? 1 + (end - 1 - first) / spacing : 0;
+  }
+
+} // end ComputeSampleGridInRegion()
+
+
 /**
  * ******************* SetNumberOfSamples *******************
  */
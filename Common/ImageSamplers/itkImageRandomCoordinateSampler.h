@@ -22,6 +22,8 @@
 #include "itkInterpolateImageFunction.h"
 #include "itkBSplineInterpolateImageFunction.h"
 #include "itkMersenneTwisterRandomVariateGenerator.h"
+#include <atomic>
+#include <cstdint>
 
 namespace itk
 {
@@ -33,6 +35,11 @@ namespace itk
  * This image sampler generates not only samples that correspond with
  * pixel locations, but selects points in physical space.
  *
+ * When multi-threading is enabled, also the masked case is processed in parallel.
+ * Each sample then gets its own counter-based random stream, derived from a single
+ * seed that is drawn from the global random generator. Therefore, the selected
+ * samples only depend on the RandomSeed, and not on the number of threads.
+ *
  * \ingroup ImageSamplers
  */
 
@@ -86,7 +93,10 @@ public:
   typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
   typedef typename RandomGeneratorType::Pointer                  RandomGeneratorPointer;
 
-  /** Set/Get the interpolator. A 3rd order B-spline interpolator is used by default. */
+  /** Set/Get the interpolator. A 3rd order B-spline interpolator is used by default.
+   * For a B-spline interpolator, the coefficients are only computed when the input
+   * image or the interpolator changed, not each time new samples are selected.
+   * A LinearInterpolateImageFunction is a much cheaper alternative. */
   itkSetObjectMacro(Interpolator, InterpolatorType);
   itkGetModifiableObjectMacro(Interpolator, InterpolatorType);
 
@@ -123,6 +133,37 @@ protected:
   void
   ThreadedGenerateData(const InputImageRegionType & inputRegionForThread, ThreadIdType threadId) override;
 
+  /** Masked version of BeforeThreadedGenerateData(). */
+  virtual void
+  BeforeThreadedGenerateDataWithMask(void);
+
+  /** Checks whether all threads found enough samples inside the mask. */
+  void
+  AfterThreadedGenerateData(void) override;
+
+  /** Masked version of ThreadedGenerateData(). The threads take blocks of samples
+   * and write them directly to the output. Every sample uses its own counter-based
+   * random stream, so that the result is independent of the number of threads. */
+  virtual void
+  ThreadedGenerateDataWithMask(ThreadIdType threadId);
+
+  /** Generate a point in a bounding box, using the counter-based random stream of
+   * the given sample. The counter is incremented for each random number drawn. */
+  void
+  GenerateRandomCoordinateForSample(const unsigned long                   sampleId,
+                                    std::uint64_t &                       counter,
+                                    const InputImageContinuousIndexType & smallestContIndex,
+                                    const InputImageContinuousIndexType & largestContIndex,
+                                    InputImageContinuousIndexType &       randomContIndex) const;
+
+  /** Hash function that maps a counter to a random 64-bit integer. */
+  static std::uint64_t
+  Hash(std::uint64_t x);
+
+  /** Connect the input image to the interpolator, if not done already. */
+  virtual void
+  SetUpInterpolator(void);
+
   /** Generate a point randomly in a bounding box. */
   virtual void
   GenerateRandomCoordinate(const InputImageContinuousIndexType & smallestContIndex,
@@ -152,6 +193,17 @@ private:
   operator=(const Self &) = delete;
 
   bool m_UseRandomSampleRegion;
+
+  /** The time at which the interpolator was last connected to the input image. */
+  TimeStamp m_InterpolatorSetUpTime;
+
+  /** Member variables used when threading with a mask. */
+  std::uint64_t                 m_ThreaderRandomSeed;
+  InputImageContinuousIndexType m_ThreaderSmallestContIndex;
+  InputImageContinuousIndexType m_ThreaderLargestContIndex;
+  std::atomic<unsigned long>    m_ThreaderNextSampleBlock;
+  std::atomic<unsigned long>    m_ThreaderNumberOfSamplesTried;
+  std::atomic<bool>             m_ThreaderMaskSamplingFailed;
 };
 
 } // end namespace itk
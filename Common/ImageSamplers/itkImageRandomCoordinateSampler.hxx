@@ -42,6 +42,11 @@ ImageRandomCoordinateSampler<TInputImage>::ImageRandomCoordinateSampler()
   this->m_UseRandomSampleRegion = false;
   this->m_SampleRegionSize.Fill(1.0);
 
+  this->m_ThreaderRandomSeed = 0;
+  this->m_ThreaderNextSampleBlock = 0;
+  this->m_ThreaderNumberOfSamplesTried = 0;
+  this->m_ThreaderMaskSamplingFailed = false;
+
 } // end Constructor
 
 
@@ -53,9 +58,9 @@ template <class TInputImage>
 void
 ImageRandomCoordinateSampler<TInputImage>::GenerateData(void)
 {
-  /** Get a handle to the mask. If there was no mask supplied we exercise a multi-threaded version. */
+  /** Get a handle to the mask. Both with and without a mask a multi-threaded version exists. */
   typename MaskType::ConstPointer mask = this->GetMask();
-  if (mask.IsNull() && this->m_UseMultiThread)
+  if (this->m_UseMultiThread)
   {
     /** Calls ThreadedGenerateData(). */
     return Superclass::GenerateData();
@@ -67,7 +72,7 @@ ImageRandomCoordinateSampler<TInputImage>::GenerateData(void)
   typename InterpolatorType::Pointer         interpolator = this->GetModifiableInterpolator();
 
   /** Set up the interpolator. */
-  interpolator->SetInputImage(inputImage); // only once?
+  this->SetUpInterpolator();
 
   /** Convert inputImageRegion to bounding box in physical space. */
   InputImageSizeType unitSize;
@@ -159,6 +164,31 @@ ImageRandomCoordinateSampler<TInputImage>::GenerateData(void)
 } // end GenerateData()
 
 
+/**
+ * ******************* SetUpInterpolator *******************
+ */
+
+template <class TInputImage>
+void
+ImageRandomCoordinateSampler<TInputImage>::SetUpInterpolator(void)
+{
+  /** Setting the input of a B-spline interpolator triggers the computation of
+   * its coefficients, which costs a full pass over the image. Therefore, only do
+   * this when the input image or the interpolator changed, which normally happens
+   * once per resolution, and not every time that new samples are selected.
+   */
+  InputImageConstPointer inputImage = this->GetInput();
+  if (this->m_Interpolator->GetInputImage() != inputImage.GetPointer() ||
+      inputImage->GetMTime() > this->m_InterpolatorSetUpTime.GetMTime() ||
+      this->m_Interpolator->GetMTime() > this->m_InterpolatorSetUpTime.GetMTime())
+  {
+    this->m_Interpolator->SetInputImage(inputImage);
+    this->m_InterpolatorSetUpTime.Modified();
+  }
+
+} // end SetUpInterpolator()
+
+
 /**
  * ******************* BeforeThreadedGenerateData *******************
  */
@@ -168,8 +198,14 @@ void
 ImageRandomCoordinateSampler<TInputImage>::BeforeThreadedGenerateData(void)
 {
   /** Set up the interpolator. */
-  typename InterpolatorType::Pointer interpolator = this->GetModifiableInterpolator();
-  interpolator->SetInputImage(this->GetInput()); // only once per resolution?
+  this->SetUpInterpolator();
+
+  /** In case of a mask the threads generate their own random numbers. */
+  typename MaskType::ConstPointer mask = this->GetMask();
+  if (mask.IsNotNull())
+  {
+    return this->BeforeThreadedGenerateDataWithMask();
+  }
 
   /** Clear the random number list. */
   this->m_RandomNumberList.resize(0);
@@ -206,6 +242,50 @@ ImageRandomCoordinateSampler<TInputImage>::BeforeThreadedGenerateData(void)
 } // end BeforeThreadedGenerateData()
 
 
+/**
+ * ******************* BeforeThreadedGenerateDataWithMask *******************
+ */
+
+template <class TInputImage>
+void
+ImageRandomCoordinateSampler<TInputImage>::BeforeThreadedGenerateDataWithMask(void)
+{
+  /** Update the mask. */
+  typename MaskType::ConstPointer mask = this->GetMask();
+  if (mask->GetSource())
+  {
+    mask->GetSource()->Update();
+  }
+
+  /** Convert inputImageRegion to bounding box in physical space. */
+  InputImageSizeType unitSize;
+  unitSize.Fill(1);
+  InputImageIndexType           smallestIndex = this->GetCroppedInputImageRegion().GetIndex();
+  InputImageIndexType           largestIndex = smallestIndex + this->GetCroppedInputImageRegion().GetSize() - unitSize;
+  InputImageContinuousIndexType smallestImageCIndex(smallestIndex);
+  InputImageContinuousIndexType largestImageCIndex(largestIndex);
+  this->GenerateSampleRegion(
+    smallestImageCIndex, largestImageCIndex, this->m_ThreaderSmallestContIndex, this->m_ThreaderLargestContIndex);
+
+  /** Draw a single seed for all random streams from the global generator,
+   * which is initialized by the RandomSeed parameter. */
+  const std::uint64_t seedHigh = this->m_RandomGenerator->GetIntegerVariate();
+  const std::uint64_t seedLow = this->m_RandomGenerator->GetIntegerVariate();
+  this->m_ThreaderRandomSeed = (seedHigh << 32) | seedLow;
+
+  /** Reset the shared counters. */
+  this->m_ThreaderNextSampleBlock = 0;
+  this->m_ThreaderNumberOfSamplesTried = 0;
+  this->m_ThreaderMaskSamplingFailed = false;
+
+  /** The threads write directly into the output, at the position of each sample. */
+  typename ImageSampleContainerType::Pointer sampleContainer = this->GetOutput();
+  sampleContainer->clear();
+  sampleContainer->resize(this->GetNumberOfSamples());
+
+} // end BeforeThreadedGenerateDataWithMask()
+
+
 /**
  * ******************* ThreadedGenerateData *******************
  */
@@ -214,11 +294,11 @@ template <class TInputImage>
 void
 ImageRandomCoordinateSampler<TInputImage>::ThreadedGenerateData(const InputImageRegionType &, ThreadIdType threadId)
 {
-  /** Sanity check. */
+  /** In case of a mask, use the dedicated implementation. */
   typename MaskType::ConstPointer mask = this->GetMask();
   if (mask.IsNotNull())
   {
-    itkExceptionMacro(<< "ERROR: do not call this function when a mask is supplied.");
+    return this->ThreadedGenerateDataWithMask(threadId);
   }
 
   /** Get handle to the input image. */
@@ -267,6 +347,107 @@ ImageRandomCoordinateSampler<TInputImage>::ThreadedGenerateData(const InputImage
 } // end ThreadedGenerateData()
 
 
+/**
+ * ******************* ThreadedGenerateDataWithMask *******************
+ */
+
+template <class TInputImage>
+void
+ImageRandomCoordinateSampler<TInputImage>::ThreadedGenerateDataWithMask(ThreadIdType itkNotUsed(threadId))
+{
+  /** Get handles to the input image, mask, interpolator, and output. */
+  InputImageConstPointer                     inputImage = this->GetInput();
+  typename MaskType::ConstPointer            mask = this->GetMask();
+  const InterpolatorType *                   interpolator = this->m_Interpolator.GetPointer();
+  typename ImageSampleContainerType::Pointer sampleContainer = this->GetOutput();
+
+  /** Set up some variables that are used to make sure we are not forever
+   * walking around on this image, trying to look for valid samples. */
+  const unsigned long numberOfSamples = this->GetNumberOfSamples();
+  const unsigned long maximumNumberOfSamplesToTry = 10 * numberOfSamples;
+
+  /** The number of samples that a thread takes at once. */
+  const unsigned long blockSize = 256;
+
+  /** Take blocks of samples until all samples are generated. Since every sample
+   * has its own random stream, it does not matter which thread processes it. */
+  InputImageContinuousIndexType sampleCIndex;
+  unsigned long                 blockId = this->m_ThreaderNextSampleBlock++;
+  while (blockId * blockSize < numberOfSamples && !this->m_ThreaderMaskSamplingFailed)
+  {
+    const unsigned long blockBegin = blockId * blockSize;
+    const unsigned long blockEnd = std::min(blockBegin + blockSize, numberOfSamples);
+
+    unsigned long numberOfSamplesTriedInBlock = 0;
+    for (unsigned long sampleId = blockBegin; sampleId < blockEnd; ++sampleId)
+    {
+      /** Make a reference to the current sample in the container. */
+      InputImagePointType &  samplePoint = sampleContainer->ElementAt(sampleId).m_ImageCoordinates;
+      ImageSampleValueType & sampleValue = sampleContainer->ElementAt(sampleId).m_ImageValue;
+
+      /** Walk over the image until we find a valid point. */
+      std::uint64_t counter = 0;
+      do
+      {
+        /** Check if we are not trying eternally to find a valid point. */
+        ++numberOfSamplesTriedInBlock;
+        if (numberOfSamplesTriedInBlock > maximumNumberOfSamplesToTry)
+        {
+          this->m_ThreaderMaskSamplingFailed = true;
+          return;
+        }
+
+        /** Generate a point in the input image region. */
+        this->GenerateRandomCoordinateForSample(
+          sampleId, counter, this->m_ThreaderSmallestContIndex, this->m_ThreaderLargestContIndex, sampleCIndex);
+        inputImage->TransformContinuousIndexToPhysicalPoint(sampleCIndex, samplePoint);
+
+      } while (!interpolator->IsInsideBuffer(sampleCIndex) || !mask->IsInsideInWorldSpace(samplePoint));
+
+      /** Compute the value at the point. */
+      sampleValue = static_cast<ImageSampleValueType>(interpolator->EvaluateAtContinuousIndex(sampleCIndex));
+    }
+
+    /** Check the total number of tries of all threads. */
+    if (this->m_ThreaderNumberOfSamplesTried.fetch_add(numberOfSamplesTriedInBlock) + numberOfSamplesTriedInBlock >
+        maximumNumberOfSamplesToTry)
+    {
+      this->m_ThreaderMaskSamplingFailed = true;
+      return;
+    }
+
+    blockId = this->m_ThreaderNextSampleBlock++;
+  }
+
+} // end ThreadedGenerateDataWithMask()
+
+
+/**
+ * ******************* AfterThreadedGenerateData *******************
+ */
+
+template <class TInputImage>
+void
+ImageRandomCoordinateSampler<TInputImage>::AfterThreadedGenerateData(void)
+{
+  /** Without a mask, combine the results of all threads. */
+  typename MaskType::ConstPointer mask = this->GetMask();
+  if (mask.IsNull())
+  {
+    return Superclass::AfterThreadedGenerateData();
+  }
+
+  /** With a mask, the samples are already in the output. */
+  if (this->m_ThreaderMaskSamplingFailed)
+  {
+    this->GetOutput()->clear();
+    itkExceptionMacro(<< "Could not find enough image samples within "
+                      << "reasonable time. Probably the mask is too small");
+  }
+
+} // end AfterThreadedGenerateData()
+
+
 /**
  * ******************* GenerateRandomCoordinate *******************
  */
@@ -286,6 +467,47 @@ ImageRandomCoordinateSampler<TInputImage>::GenerateRandomCoordinate(
 } // end GenerateRandomCoordinate()
 
 
+/**
+ * ******************* GenerateRandomCoordinateForSample *******************
+ */
+
+template <class TInputImage>
+void
+ImageRandomCoordinateSampler<TInputImage>::GenerateRandomCoordinateForSample(
+  const unsigned long                   sampleId,
+  std::uint64_t &                       counter,
+  const InputImageContinuousIndexType & smallestContIndex,
+  const InputImageContinuousIndexType & largestContIndex,
+  InputImageContinuousIndexType &       randomContIndex) const
+{
+  /** The random stream of a sample is keyed by the seed and the sample id. */
+  const std::uint64_t key = Self::Hash(this->m_ThreaderRandomSeed ^ Self::Hash(sampleId));
+  for (unsigned int i = 0; i < InputImageDimension; ++i, ++counter)
+  {
+    /** Convert the upper 53 bits to a uniform number in [0,1). */
+    const double uniform = (Self::Hash(key + counter) >> 11) * (1.0 / 9007199254740992.0);
+    randomContIndex[i] = static_cast<InputImagePointValueType>(
+      smallestContIndex[i] + uniform * (largestContIndex[i] - smallestContIndex[i]));
+  }
+} // end GenerateRandomCoordinateForSample()
+
+
+/**
+ * ******************* Hash *******************
+ */
+
+template <class TInputImage>
+std::uint64_t
+ImageRandomCoordinateSampler<TInputImage>::Hash(std::uint64_t x)
+{
+  /** The SplitMix64 finalizer. */
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+} // end Hash()
+
+
 /**
  * ******************* GenerateSampleRegion *******************
  */
@@ -34,9 +34,10 @@ template <class TInputImage>
 void
 ImageRandomSampler<TInputImage>::GenerateData(void)
 {
-  /** Get a handle to the mask. If there was no mask supplied we exercise a multi-threaded version. */
+  /** Get a handle to the mask. If desired we exercise a multi-threaded version,
+   * which in case of a mask draws from the index of voxels inside the mask. */
   typename MaskType::ConstPointer mask = this->GetMask();
-  if (mask.IsNull() && this->m_UseMultiThread)
+  if (this->m_UseMultiThread)
   {
     /** Calls ThreadedGenerateData(). */
     return Superclass::GenerateData();
@@ -138,13 +139,6 @@ template <class TInputImage>
 void
 ImageRandomSampler<TInputImage>::ThreadedGenerateData(const InputImageRegionType &, ThreadIdType threadId)
 {
-  /** Sanity check. */
-  typename MaskType::ConstPointer mask = this->GetMask();
-  if (mask.IsNotNull())
-  {
-    itkExceptionMacro(<< "ERROR: do not call this function when a mask is supplied.");
-  }
-
   /** Get handle to the input image. */
   InputImageConstPointer inputImage = this->GetInput();
 
@@ -165,6 +159,7 @@ ImageRandomSampler<TInputImage>::ThreadedGenerateData(const InputImageRegionType
   typename ImageSampleContainerType::ConstIterator end = sampleContainerThisThread->End();
 
   /** Fill the local sample container. */
+  const bool          useMask = this->GetMask() != nullptr;
   unsigned long       sampleId = sampleStart;
   InputImageSizeType  regionSize = this->GetCroppedInputImageRegion().GetSize();
   InputImageIndexType regionIndex = this->GetCroppedInputImageRegion().GetIndex();
@@ -172,16 +167,25 @@ ImageRandomSampler<TInputImage>::ThreadedGenerateData(const InputImageRegionType
   {
     unsigned long randomPosition = static_cast<unsigned long>(this->m_RandomNumberList[sampleId]);
 
-    /** Translate randomPosition to an index, copied from ImageRandomConstIteratorWithIndex. */
-    unsigned long       residual;
+    /** Translate randomPosition to an index. In case of a mask, look it up
+     * in the mask voxel index, which only contains voxels inside the mask. */
     InputImageIndexType positionIndex;
-    for (unsigned int dim = 0; dim < InputImageDimension; dim++)
+    if (useMask)
     {
-      const unsigned long sizeInThisDimension = regionSize[dim];
-      residual = randomPosition % sizeInThisDimension;
-      positionIndex[dim] = residual + regionIndex[dim];
-      randomPosition -= residual;
-      randomPosition /= sizeInThisDimension;
+      positionIndex = this->GetMaskVoxelIndex(randomPosition);
+    }
+    else
+    {
+      /** Copied from ImageRandomConstIteratorWithIndex. */
+      unsigned long residual;
+      for (unsigned int dim = 0; dim < InputImageDimension; dim++)
+      {
+        const unsigned long sizeInThisDimension = regionSize[dim];
+        residual = randomPosition % sizeInThisDimension;
+        positionIndex[dim] = residual + regionIndex[dim];
+        randomPosition -= residual;
+        randomPosition /= sizeInThisDimension;
+      }
     }
 
     /** Transform index to the physical coordinates and put it in the sample. */
@@ -55,8 +55,18 @@ ImageRandomSamplerBase<TInputImage>::BeforeThreadedGenerateData(void)
   this->m_RandomNumberList.resize(0);
   this->m_RandomNumberList.reserve(this->m_NumberOfSamples);
 
-  /** Fill the list with random numbers. */
-  const double numPixels = static_cast<double>(this->GetCroppedInputImageRegion().GetNumberOfPixels());
+  /** Fill the list with random numbers. In case of a mask, these are positions
+   * in the index of voxels inside the mask, otherwise positions in the region. */
+  double numPixels = static_cast<double>(this->GetCroppedInputImageRegion().GetNumberOfPixels());
+  if (this->GetMask())
+  {
+    this->UpdateMaskVoxelIndex();
+    numPixels = static_cast<double>(this->GetNumberOfMaskVoxels());
+    if (numPixels == 0.0)
+    {
+      itkExceptionMacro(<< "ERROR: the mask does not contain any voxel within the InputImageRegion.");
+    }
+  }
   localGenerator->GetVariateWithOpenRange(numPixels - 0.5); // dummy jump
   for (unsigned long i = 0; i < this->m_NumberOfSamples; i++)
   {
@@ -20,7 +20,6 @@
 
 #include "itkImageRandomSamplerBase.h"
 #include "itkMersenneTwisterRandomVariateGenerator.h"
-#include "itkImageFullSampler.h"
 
 namespace itk
 {
@@ -30,7 +29,9 @@ namespace itk
  *
  * This version takes into account that the mask may be very small.
  * Also, it may be more efficient when very many different sample sets
- * of the same input image are required, because it does some precomputation.
+ * of the same input image are required, because it does some precomputation:
+ * the voxels inside the mask are indexed once (see UpdateMaskVoxelIndex()),
+ * after which each sample is drawn in constant time.
  * \ingroup ImageSamplers
  */
 
@@ -63,6 +64,7 @@ public:
   typedef typename Superclass::ImageSampleContainerType     ImageSampleContainerType;
   typedef typename Superclass::ImageSampleContainerPointer  ImageSampleContainerPointer;
   typedef typename Superclass::MaskType                     MaskType;
+  typedef typename Superclass::ImageSampleValueType         ImageSampleValueType;
 
   /** The input image dimension. */
   itkStaticConstMacro(InputImageDimension, unsigned int, Superclass::InputImageDimension);
@@ -76,9 +78,6 @@ public:
   typedef typename RandomGeneratorType::Pointer                  RandomGeneratorPointer;
 
 protected:
-  typedef itk::ImageFullSampler<InputImageType>     InternalFullSamplerType;
-  typedef typename InternalFullSamplerType::Pointer InternalFullSamplerPointer;
-
   /** The constructor. */
   ImageRandomSamplerSparseMask();
   /** The destructor. */
@@ -99,8 +98,7 @@ protected:
   void
   ThreadedGenerateData(const InputImageRegionType & inputRegionForThread, ThreadIdType threadId) override;
 
-  RandomGeneratorPointer     m_RandomGenerator;
-  InternalFullSamplerPointer m_InternalFullSampler;
+  RandomGeneratorPointer m_RandomGenerator;
 
 private:
   /** The deleted copy constructor. */
@@ -33,8 +33,6 @@ ImageRandomSamplerSparseMask<TInputImage>::ImageRandomSamplerSparseMask()
   /** Setup random generator. */
   this->m_RandomGenerator = RandomGeneratorType::GetInstance();
 
-  this->m_InternalFullSampler = InternalFullSamplerType::New();
-
 } // end Constructor
 
 
@@ -62,35 +60,12 @@ ImageRandomSamplerSparseMask<TInputImage>::GenerateData(void)
   /** Clear the container. */
   sampleContainer->Initialize();
 
-  /** Make sure the internal full sampler is up-to-date. */
-  this->m_InternalFullSampler->SetInput(inputImage);
-  this->m_InternalFullSampler->SetMask(mask);
-  this->m_InternalFullSampler->SetInputImageRegion(this->GetCroppedInputImageRegion());
-
-  /** Use try/catch, since the full sampler may crash, due to insufficient memory. */
-  try
-  {
-    this->m_InternalFullSampler->Update();
-  }
-  catch (ExceptionObject & err)
+  /** Make sure the index of the voxels inside the mask is up-to-date. */
+  this->UpdateMaskVoxelIndex();
+  const unsigned long numberOfValidSamples = this->GetNumberOfMaskVoxels();
+  if (numberOfValidSamples == 0)
   {
-    std::string message = "ERROR: This ImageSampler internally uses the "
-                          "ImageFullSampler. Updating of this internal sampler raised the "
-                          "exception:\n";
-    message += err.GetDescription();
-
-    std::string            fullSamplerMessage = err.GetDescription();
-    std::string::size_type loc =
-      fullSamplerMessage.find("ERROR: failed to allocate memory for the sample container", 0);
-    if (loc != std::string::npos && this->GetMask() == nullptr)
-    {
-      message += "\nYou are using the ImageRandomSamplerSparseMask sampler, "
-                 "but you did not set a mask. The internal ImageFullSampler therefore "
-                 "requires a lot of memory. Consider using the ImageRandomSampler "
-                 "instead.";
-    }
-    const char * message2 = message.c_str();
-    itkExceptionMacro(<< message2);
+    itkExceptionMacro(<< "ERROR: the mask does not contain any voxel within the InputImageRegion.");
   }
 
   /** If desired we exercise a multi-threaded version. */
@@ -100,15 +75,16 @@ ImageRandomSamplerSparseMask<TInputImage>::GenerateData(void)
     return Superclass::GenerateData();
   }
 
-  /** Get a handle to the full sampler output. */
-  typename ImageSampleContainerType::Pointer allValidSamples = this->m_InternalFullSampler->GetOutput();
-  unsigned long                              numberOfValidSamples = allValidSamples->Size();
-
-  /** Take random samples from the allValidSamples-container. */
+  /** Take random samples from the voxels inside the mask. */
+  sampleContainer->reserve(this->GetNumberOfSamples());
+  ImageSampleType sample;
   for (unsigned int i = 0; i < this->GetNumberOfSamples(); ++i)
   {
-    unsigned long randomIndex = this->m_RandomGenerator->GetIntegerVariate(numberOfValidSamples - 1);
-    sampleContainer->push_back(allValidSamples->ElementAt(randomIndex));
+    unsigned long             randomIndex = this->m_RandomGenerator->GetIntegerVariate(numberOfValidSamples - 1);
+    const InputImageIndexType index = this->GetMaskVoxelIndex(randomIndex);
+    inputImage->TransformIndexToPhysicalPoint(index, sample.m_ImageCoordinates);
+    sample.m_ImageValue = static_cast<ImageSampleValueType>(inputImage->GetPixel(index));
+    sampleContainer->push_back(sample);
   }
 
 } // end GenerateData()
@@ -126,8 +102,8 @@ ImageRandomSamplerSparseMask<TInputImage>::BeforeThreadedGenerateData(void)
   this->m_RandomNumberList.resize(0);
   this->m_RandomNumberList.reserve(this->m_NumberOfSamples);
 
-  /** Get a handle to the full sampler output size. */
-  const unsigned long numberOfValidSamples = this->m_InternalFullSampler->GetOutput()->Size();
+  /** The number of voxels inside the mask. */
+  const unsigned long numberOfValidSamples = this->GetNumberOfMaskVoxels();
 
   /** Fill the list with random numbers. */
   for (unsigned int i = 0; i < this->GetNumberOfSamples(); ++i)
@@ -155,8 +131,8 @@ template <class TInputImage>
 void
 ImageRandomSamplerSparseMask<TInputImage>::ThreadedGenerateData(const InputImageRegionType &, ThreadIdType threadId)
 {
-  /** Get a handle to the full sampler output. */
-  typename ImageSampleContainerType::Pointer allValidSamples = this->m_InternalFullSampler->GetOutput();
+  /** Get handle to the input image. */
+  InputImageConstPointer inputImage = this->GetInput();
 
   /** Figure out which samples to process. */
   unsigned long chunkSize = this->GetNumberOfSamples() / this->GetNumberOfWorkUnits();
@@ -174,12 +150,14 @@ ImageRandomSamplerSparseMask<TInputImage>::ThreadedGenerateData(const InputImage
   typename ImageSampleContainerType::Iterator      iter;
   typename ImageSampleContainerType::ConstIterator end = sampleContainerThisThread->End();
 
-  /** Take random samples from the allValidSamples-container. */
+  /** Take random samples from the voxels inside the mask. */
   unsigned long sampleId = sampleStart;
   for (iter = sampleContainerThisThread->Begin(); iter != end; ++iter, sampleId++)
   {
-    unsigned long randomIndex = static_cast<unsigned long>(this->m_RandomNumberList[sampleId]);
-    (*iter).Value() = allValidSamples->ElementAt(randomIndex);
+    unsigned long             randomIndex = static_cast<unsigned long>(this->m_RandomNumberList[sampleId]);
+    const InputImageIndexType index = this->GetMaskVoxelIndex(randomIndex);
+    inputImage->TransformIndexToPhysicalPoint(index, (*iter).Value().m_ImageCoordinates);
+    (*iter).Value().m_ImageValue = static_cast<ImageSampleValueType>(inputImage->GetPixel(index));
   }
 
 } // end ThreadedGenerateData()
@@ -195,7 +173,6 @@ ImageRandomSamplerSparseMask<TInputImage>::PrintSelf(std::ostream & os, Indent i
 {
   Superclass::PrintSelf(os, indent);
 
-  os << indent << "InternalFullSampler: " << this->m_InternalFullSampler.GetPointer() << std::endl;
   os << indent << "RandomGenerator: " << this->m_RandomGenerator.GetPointer() << std::endl;
 
 } // end PrintSelf()
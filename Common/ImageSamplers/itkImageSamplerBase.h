@@ -212,6 +212,27 @@ protected:
   void
   CropInputImageRegion(void);
 
+  /** Make sure the mask voxel index is up-to-date. This index is a compact list of the
+   * voxels in the cropped input image region that are inside the (first) mask, stored as
+   * runs of consecutive voxels in scan order. It is only rebuilt when the mask, the input
+   * image or the cropped region changed, so typically once per resolution. Random samplers
+   * use it to draw voxels inside the mask in O(1) per sample, instead of walking the region.
+   */
+  virtual void
+  UpdateMaskVoxelIndex(void);
+
+  /** Get the number of voxels in the mask voxel index. */
+  unsigned long
+  GetNumberOfMaskVoxels(void) const
+  {
+    return this->m_MaskVoxelRunEnds.empty() ? 0 : this->m_MaskVoxelRunEnds.back();
+  }
+
+
+  /** Get the image index of the n-th voxel in the mask voxel index, with n < GetNumberOfMaskVoxels(). */
+  InputImageIndexType
+  GetMaskVoxelIndex(unsigned long n) const;
+
   /** Multi-threaded function that does the work. */
   void
   BeforeThreadedGenerateData(void) override;
@@ -243,6 +264,14 @@ private:
 
   InputImageRegionType m_CroppedInputImageRegion;
   InputImageRegionType m_DummyInputImageRegion;
+
+  /** The mask voxel index. For each run, the offset of its first voxel in the
+   * cropped input image region, and the number of mask voxels up to and including it. */
+  std::vector<unsigned long> m_MaskVoxelRunOffsets;
+  std::vector<unsigned long> m_MaskVoxelRunEnds;
+  InputImageRegionType       m_MaskVoxelIndexRegion;
+  MaskConstPointer           m_MaskVoxelIndexMask;
+  TimeStamp                  m_MaskVoxelIndexBuildTime;
 };
 
 } // end namespace itk
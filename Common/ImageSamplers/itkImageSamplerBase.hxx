@@ -19,6 +19,8 @@
 #define itkImageSamplerBase_hxx
 
 #include "itkImageSamplerBase.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include <algorithm>
 
 namespace itk
 {
@@ -389,6 +391,98 @@ ImageSamplerBase<TInputImage>::CropInputImageRegion(void)
 } // end CropInputImageRegion()
 
 
+/**
+ * ******************* UpdateMaskVoxelIndex *******************
+ */
+
+template <class TInputImage>
+void
+ImageSamplerBase<TInputImage>::UpdateMaskVoxelIndex(void)
+{
+  /** Without a mask, there is nothing to index. */
+  InputImageConstPointer inputImage = this->GetInput();
+  if (this->m_Mask.IsNull() || !inputImage)
+  {
+    this->m_MaskVoxelRunOffsets.clear();
+    this->m_MaskVoxelRunEnds.clear();
+    this->m_MaskVoxelIndexMask = nullptr;
+    return;
+  }
+
+  /** Check if the existing index is still valid. */
+  const InputImageRegionType & region = this->GetCroppedInputImageRegion();
+  if (this->m_MaskVoxelIndexMask == this->m_Mask && this->m_MaskVoxelIndexRegion == region &&
+      this->m_Mask->GetMTime() < this->m_MaskVoxelIndexBuildTime.GetMTime() &&
+      inputImage->GetMTime() < this->m_MaskVoxelIndexBuildTime.GetMTime())
+  {
+    return;
+  }
+
+  /** Walk once over the region in scan order, and store the runs of voxels inside the mask. */
+  this->m_MaskVoxelRunOffsets.clear();
+  this->m_MaskVoxelRunEnds.clear();
+  typedef ImageRegionConstIteratorWithIndex<InputImageType> IteratorType;
+  IteratorType                                              it(inputImage, region);
+  InputImagePointType                                       point;
+  unsigned long                                             offset = 0;
+  unsigned long                                             numberOfMaskVoxels = 0;
+  bool                                                      previousInside = false;
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it, ++offset)
+  {
+    inputImage->TransformIndexToPhysicalPoint(it.GetIndex(), point);
+    const bool inside = this->m_Mask->IsInsideInWorldSpace(point);
+    if (inside)
+    {
+      ++numberOfMaskVoxels;
+      if (previousInside)
+      {
+        this->m_MaskVoxelRunEnds.back() = numberOfMaskVoxels;
+      }
+      else
+      {
+        this->m_MaskVoxelRunOffsets.push_back(offset);
+        this->m_MaskVoxelRunEnds.push_back(numberOfMaskVoxels);
+      }
+    }
+    previousInside = inside;
+  }
+
+  /** Store the state for which the index was built. */
+  this->m_MaskVoxelIndexMask = this->m_Mask;
+  this->m_MaskVoxelIndexRegion = region;
+  this->m_MaskVoxelIndexBuildTime.Modified();
+
+} // end UpdateMaskVoxelIndex()
+
+
+/**
+ * ******************* GetMaskVoxelIndex *******************
+ */
+
+template <class TInputImage>
+typename ImageSamplerBase<TInputImage>::InputImageIndexType
+ImageSamplerBase<TInputImage>::GetMaskVoxelIndex(unsigned long n) const
+{
+  /** Find the run that contains the n-th voxel. */
+  const std::size_t run =
+    std::upper_bound(this->m_MaskVoxelRunEnds.begin(), this->m_MaskVoxelRunEnds.end(), n) -
+    this->m_MaskVoxelRunEnds.begin();
+  const unsigned long runBegin = (run == 0) ? 0 : this->m_MaskVoxelRunEnds[run - 1];
+  unsigned long       offset = this->m_MaskVoxelRunOffsets[run] + (n - runBegin);
+
+  /** Translate the offset in the region to an index. */
+  const InputImageSizeType & regionSize = this->m_MaskVoxelIndexRegion.GetSize();
+  InputImageIndexType        index = this->m_MaskVoxelIndexRegion.GetIndex();
+  for (unsigned int dim = 0; dim < InputImageDimension; ++dim)
+  {
+    index[dim] += offset % regionSize[dim];
+    offset /= regionSize[dim];
+  }
+  return index;
+
+} // end GetMaskVoxelIndex()
+
+
 /**
  * ******************* BeforeThreadedGenerateData *******************
  */
@@ -464,6 +558,7 @@ ImageSamplerBase<TInputImage>::PrintSelf(std::ostream & os, Indent indent) const
     os << indent.GetNextIndent() << this->m_InputImageRegionVector[i] << std::endl;
   }
   os << indent << "CroppedInputImageRegion" << this->m_CroppedInputImageRegion << std::endl;
+  os << indent << "NumberOfMaskVoxels: " << this->GetNumberOfMaskVoxels() << std::endl;
 
 } // end PrintSelf()
 
@@ -160,6 +160,15 @@ public:
   OutputPointType
   TransformPoint(const InputPointType & point) const override;
 
+  /** Method to transform a block of points. The combination method is selected
+   * once for the whole block, and the batched methods of the initial and
+   * current transforms are used.
+   */
+  void
+  TransformPoints(const InputPointType * inputPoints,
+                  OutputPointType *      outputPoints,
+                  const std::size_t      numberOfPoints) const override;
+
   /** ITK4 change:
    * The following pure virtual functions must be overloaded.
    * For now just throw an exception, since these are not used in elastix.
@@ -263,10 +272,26 @@ public:
                                            DerivativeType &                imageJacobian,
                                            NonZeroJacobianIndicesType &    nonZeroJacobianIndices) const override;
 
+  /** Compute the inner product of the Jacobian with the moving image gradient for a block of points. */
+  void
+  EvaluateJacobianWithImageGradientProducts(const InputPointType *          ipps,
+                                            const MovingImageGradientType * movingImageGradients,
+                                            DerivativeType *                imageJacobians,
+                                            NonZeroJacobianIndicesType *    nonZeroJacobianIndices,
+                                            const std::size_t               numberOfPoints) const override;
+
   /** Compute the spatial Jacobian of the transformation. */
   void
   GetSpatialJacobian(const InputPointType & ipp, SpatialJacobianType & sj) const override;
 
+  /** Compute both the transformed point and the spatial Jacobian of the transformation.
+   * With composition, the initial transform is evaluated only once.
+   */
+  void
+  TransformPointAndGetSpatialJacobian(const InputPointType & ipp,
+                                      OutputPointType &      opp,
+                                      SpatialJacobianType &  sj) const override;
+
   /** Compute the spatial Hessian of the transformation. */
   void
   GetSpatialHessian(const InputPointType & ipp, SpatialHessianType & sh) const override;
@@ -1485,6 +1485,56 @@ AdvancedCombinationTransform<TScalarType, NDimensions>::TransformPoint(const Inp
 } // end TransformPoint()
 
 
+/**
+ * ****************** TransformPoints ****************************
+ */
+
+template <typename TScalarType, unsigned int NDimensions>
+void
+AdvancedCombinationTransform<TScalarType, NDimensions>::TransformPoints(const InputPointType * inputPoints,
+                                                                        OutputPointType *      outputPoints,
+                                                                        const std::size_t      numberOfPoints) const
+{
+  if (this->m_CurrentTransform.IsNull())
+  {
+    this->NoCurrentTransformSet();
+  }
+  else if (this->m_InitialTransform.IsNull())
+  {
+    /** CURRENT ONLY: T(x) = T_1(x). */
+    this->m_CurrentTransform->TransformPoints(inputPoints, outputPoints, numberOfPoints);
+  }
+  else if (this->m_UseAddition)
+  {
+    /** ADDITION: T(x) = T_0(x) + T_1(x) - x. */
+    std::vector<OutputPointType> initialOutputPoints(numberOfPoints);
+    this->m_InitialTransform->TransformPoints(inputPoints, initialOutputPoints.data(), numberOfPoints);
+    for (std::size_t n = 0; n < numberOfPoints; ++n)
+    {
+      for (unsigned int i = 0; i < SpaceDimension; ++i)
+      {
+        initialOutputPoints[n][i] -= inputPoints[n][i];
+      }
+    }
+    this->m_CurrentTransform->TransformPoints(inputPoints, outputPoints, numberOfPoints);
+    for (std::size_t n = 0; n < numberOfPoints; ++n)
+    {
+      for (unsigned int i = 0; i < SpaceDimension; ++i)
+      {
+        outputPoints[n][i] += initialOutputPoints[n][i];
+      }
+    }
+  }
+  else
+  {
+    /** COMPOSITION: T(x) = T_1( T_0(x) ), computed in place in the output. */
+    this->m_InitialTransform->TransformPoints(inputPoints, outputPoints, numberOfPoints);
+    this->m_CurrentTransform->TransformPoints(outputPoints, outputPoints, numberOfPoints);
+  }
+
+} // end TransformPoints()
+
+
 /**
  * ****************** GetJacobian ****************************
  */
@@ -1521,6 +1571,41 @@ AdvancedCombinationTransform<TScalarType, NDimensions>::EvaluateJacobianWithImag
 } // end EvaluateJacobianWithImageGradientProduct()
 
 
+/**
+ * ****************** EvaluateJacobianWithImageGradientProducts ****************************
+ */
+
+template <typename TScalarType, unsigned int NDimensions>
+void
+AdvancedCombinationTransform<TScalarType, NDimensions>::EvaluateJacobianWithImageGradientProducts(
+  const InputPointType *          ipps,
+  const MovingImageGradientType * movingImageGradients,
+  DerivativeType *                imageJacobians,
+  NonZeroJacobianIndicesType *    nonZeroJacobianIndices,
+  const std::size_t               numberOfPoints) const
+{
+  if (this->m_CurrentTransform.IsNull())
+  {
+    this->NoCurrentTransformSet();
+  }
+  else if (this->m_InitialTransform.IsNull() || this->m_UseAddition)
+  {
+    /** CURRENT ONLY and ADDITION: J(x) = J_1(x). */
+    this->m_CurrentTransform->EvaluateJacobianWithImageGradientProducts(
+      ipps, movingImageGradients, imageJacobians, nonZeroJacobianIndices, numberOfPoints);
+  }
+  else
+  {
+    /** COMPOSITION: J(x) = J_1( T_0(x) ). */
+    std::vector<InputPointType> initialOutputPoints(numberOfPoints);
+    this->m_InitialTransform->TransformPoints(ipps, initialOutputPoints.data(), numberOfPoints);
+    this->m_CurrentTransform->EvaluateJacobianWithImageGradientProducts(
+      initialOutputPoints.data(), movingImageGradients, imageJacobians, nonZeroJacobianIndices, numberOfPoints);
+  }
+
+} // end EvaluateJacobianWithImageGradientProducts()
+
+
 /**
  * ****************** GetSpatialJacobian ****************************
  */
@@ -1536,6 +1621,53 @@ AdvancedCombinationTransform<TScalarType, NDimensions>::GetSpatialJacobian(const
 } // end GetSpatialJacobian()
 
 
+/**
+ * ****************** TransformPointAndGetSpatialJacobian ****************************
+ */
+
+template <typename TScalarType, unsigned int NDimensions>
+void
+AdvancedCombinationTransform<TScalarType, NDimensions>::TransformPointAndGetSpatialJacobian(
+  const InputPointType & ipp,
+  OutputPointType &      opp,
+  SpatialJacobianType &  sj) const
+{
+  if (this->m_CurrentTransform.IsNull())
+  {
+    this->NoCurrentTransformSet();
+  }
+  else if (this->m_InitialTransform.IsNull())
+  {
+    /** CURRENT ONLY: T(x) = T_1(x). */
+    this->m_CurrentTransform->TransformPointAndGetSpatialJacobian(ipp, opp, sj);
+  }
+  else if (this->m_UseAddition)
+  {
+    /** ADDITION: T(x) = T_0(x) + T_1(x) - x. */
+    OutputPointType     out0;
+    SpatialJacobianType sj0, sj1, identity;
+    this->m_InitialTransform->TransformPointAndGetSpatialJacobian(ipp, out0, sj0);
+    this->m_CurrentTransform->TransformPointAndGetSpatialJacobian(ipp, opp, sj1);
+    for (unsigned int i = 0; i < SpaceDimension; ++i)
+    {
+      opp[i] += (out0[i] - ipp[i]);
+    }
+    identity.SetIdentity();
+    sj = sj0 + sj1 - identity;
+  }
+  else
+  {
+    /** COMPOSITION: T(x) = T_1( T_0(x) ). */
+    OutputPointType     out0;
+    SpatialJacobianType sj0, sj1;
+    this->m_InitialTransform->TransformPointAndGetSpatialJacobian(ipp, out0, sj0);
+    this->m_CurrentTransform->TransformPointAndGetSpatialJacobian(out0, opp, sj1);
+    sj = sj1 * sj0;
+  }
+
+} // end TransformPointAndGetSpatialJacobian()
+
+
 /**
  * ****************** GetSpatialHessian ****************************
  */
@@ -347,6 +347,12 @@ public:
   OutputPointType
   TransformPoint(const InputPointType & point) const override;
 
+  /** Transform a block of points, with the matrix and offset kept in local variables. */
+  void
+  TransformPoints(const InputPointType * inputPoints,
+                  OutputPointType *      outputPoints,
+                  const std::size_t      numberOfPoints) const override;
+
   OutputVectorType
   TransformVector(const InputVectorType & vector) const override;
 
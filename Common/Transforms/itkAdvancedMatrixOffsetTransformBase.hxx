@@ -252,6 +252,46 @@ AdvancedMatrixOffsetTransformBase<TScalarType, NInputDimensions, NOutputDimensio
 }
 
 
+// Transform a block of points
+template <class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions>
+void
+AdvancedMatrixOffsetTransformBase<TScalarType, NInputDimensions, NOutputDimensions>::TransformPoints(
+  const InputPointType * inputPoints,
+  OutputPointType *      outputPoints,
+  const std::size_t      numberOfPoints) const
+{
+  /** Copy the matrix and offset to local arrays, so that the compiler
+   * can keep them in registers and vectorize the loop over the points. */
+  ScalarType matrix[NOutputDimensions][NInputDimensions];
+  ScalarType offset[NOutputDimensions];
+  for (unsigned int i = 0; i < NOutputDimensions; ++i)
+  {
+    for (unsigned int j = 0; j < NInputDimensions; ++j)
+    {
+      matrix[i][j] = this->m_Matrix[i][j];
+    }
+    offset[i] = this->m_Offset[i];
+  }
+
+  for (std::size_t n = 0; n < numberOfPoints; ++n)
+  {
+    /** Use a temporary, since the input and output may be the same. */
+    const InputPointType & point = inputPoints[n];
+    OutputPointType        outputPoint;
+    for (unsigned int i = 0; i < NOutputDimensions; ++i)
+    {
+      ScalarType value = 0.0;
+      for (unsigned int j = 0; j < NInputDimensions; ++j)
+      {
+        value += matrix[i][j] * point[j];
+      }
+      outputPoint[i] = value + offset[i];
+    }
+    outputPoints[n] = outputPoint;
+  }
+}
+
+
 // Transform a vector
 template <class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions>
 typename AdvancedMatrixOffsetTransformBase<TScalarType, NInputDimensions, NOutputDimensions>::OutputVectorType
@@ -193,6 +193,28 @@ public:
                                            DerivativeType &                imageJacobian,
                                            NonZeroJacobianIndicesType &    nonZeroJacobianIndices) const;
 
+  /** Transform a block of points at once: outputPoints[i] = T(inputPoints[i]), for i < numberOfPoints.
+   * The input and output arrays may be the same. The default implementation calls
+   * TransformPoint() for each point. Subclasses override it with a loop in which the
+   * per-point overhead, like virtual calls and setup of the transform data, is avoided.
+   */
+  virtual void
+  TransformPoints(const InputPointType * inputPoints,
+                  OutputPointType *      outputPoints,
+                  const std::size_t      numberOfPoints) const;
+
+  /** Compute the inner product of the Jacobian with the moving image gradient for a block
+   * of points. The results for point i are stored in imageJacobians[i] and nonZeroJacobianIndices[i],
+   * which need to be sized as for EvaluateJacobianWithImageGradientProduct(). The default
+   * implementation calls EvaluateJacobianWithImageGradientProduct() for each point.
+   */
+  virtual void
+  EvaluateJacobianWithImageGradientProducts(const InputPointType *          ipps,
+                                            const MovingImageGradientType * movingImageGradients,
+                                            DerivativeType *                imageJacobians,
+                                            NonZeroJacobianIndicesType *    nonZeroJacobianIndices,
+                                            const std::size_t               numberOfPoints) const;
+
   /** Compute the spatial Jacobian of the transformation.
    *
    * The spatial Jacobian is expressed as a vector of partial derivatives of the
@@ -222,6 +244,16 @@ public:
   virtual void
   GetSpatialJacobian(const InputPointType & ipp, SpatialJacobianType & sj) const = 0;
 
+  /** Compute both the transformed point and the spatial Jacobian of the transformation,
+   * at the same point. The default implementation calls TransformPoint() and
+   * GetSpatialJacobian(). Subclasses override it when both follow from a single
+   * evaluation of the transform.
+   */
+  virtual void
+  TransformPointAndGetSpatialJacobian(const InputPointType & ipp,
+                                      OutputPointType &      opp,
+                                      SpatialJacobianType &  sj) const;
+
   /** Override some pure virtual ITK4 functions. */
   void
   ComputeJacobianWithRespectToParameters(const InputPointType & itkNotUsed(p),
@@ -106,6 +106,64 @@ AdvancedTransform<TScalarType, NInputDimensions, NOutputDimensions>::EvaluateJac
 } // end EvaluateJacobianWithImageGradientProduct()
 
 
+/**
+ * ********************* TransformPoints ****************************
+ */
+
+template <class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions>
+void
+AdvancedTransform<TScalarType, NInputDimensions, NOutputDimensions>::TransformPoints(
+  const InputPointType * inputPoints,
+  OutputPointType *      outputPoints,
+  const std::size_t      numberOfPoints) const
+{
+  for (std::size_t i = 0; i < numberOfPoints; ++i)
+  {
+    outputPoints[i] = this->TransformPoint(inputPoints[i]);
+  }
+
+} // end TransformPoints()
+
+
+/**
+ * ********************* EvaluateJacobianWithImageGradientProducts ****************************
+ */
+
+template <class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions>
+void
+AdvancedTransform<TScalarType, NInputDimensions, NOutputDimensions>::EvaluateJacobianWithImageGradientProducts(
+  const InputPointType *          ipps,
+  const MovingImageGradientType * movingImageGradients,
+  DerivativeType *                imageJacobians,
+  NonZeroJacobianIndicesType *    nonZeroJacobianIndices,
+  const std::size_t               numberOfPoints) const
+{
+  for (std::size_t i = 0; i < numberOfPoints; ++i)
+  {
+    this->EvaluateJacobianWithImageGradientProduct(
+      ipps[i], movingImageGradients[i], imageJacobians[i], nonZeroJacobianIndices[i]);
+  }
+
+} // end EvaluateJacobianWithImageGradientProducts()
+
+
+/**
+ * ********************* TransformPointAndGetSpatialJacobian ****************************
+ */
+
+template <class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions>
+void
+AdvancedTransform<TScalarType, NInputDimensions, NOutputDimensions>::TransformPointAndGetSpatialJacobian(
+  const InputPointType & ipp,
+  OutputPointType &      opp,
+  SpatialJacobianType &  sj) const
+{
+  opp = this->TransformPoint(ipp);
+  this->GetSpatialJacobian(ipp, sj);
+
+} // end TransformPointAndGetSpatialJacobian()
+
+
 /**
  * ********************* GetNumberOfNonZeroJacobianIndices ****************************
  */
@@ -124,6 +124,37 @@ public:
   typename DerivativeKernelType::Pointer            m_DerivativeKernel;
   typename SecondOrderDerivativeKernelType::Pointer m_SecondOrderDerivativeKernel;
 
+  /** Typedefs for the single precision copy of the B-spline coefficients. */
+  typedef Image<float, itkGetStaticConstMacro(SpaceDimension)> SinglePrecisionImageType;
+  typedef typename SinglePrecisionImageType::Pointer           SinglePrecisionImagePointer;
+
+  /** Set/Get whether TransformPoint() and TransformPoints() evaluate the B-spline using
+   * a single precision copy of the coefficients. This halves the memory traffic of the
+   * coefficient lookups, at the cost of single precision accuracy of the displacement.
+   * The copy is refreshed whenever the parameters or the coefficient images are set.
+   * When the transform is modified otherwise, e.g. by SetGridRegion() or SetIdentity(),
+   * the double precision coefficients are used until the parameters are set again.
+   * The parameters themselves, the Jacobians and the spatial derivatives remain in double
+   * precision. Default: false.
+   */
+  virtual void
+  SetUseSinglePrecisionCoefficients(const bool _arg);
+
+  itkGetConstMacro(UseSinglePrecisionCoefficients, bool);
+  itkBooleanMacro(UseSinglePrecisionCoefficients);
+
+  /** Set the transformation parameters, and update the single precision coefficients. */
+  void
+  SetParameters(const ParametersType & parameters) override;
+
+  /** Set the transformation parameters by value, and update the single precision coefficients. */
+  void
+  SetParametersByValue(const ParametersType & parameters) override;
+
+  /** Set the coefficient images, and update the single precision coefficients. */
+  void
+  SetCoefficientImages(ImagePointer images[]) override;
+
   /** Compute point transformation. This one is commonly used.
    * It calls RecursiveBSplineTransformImplementation2::InterpolateTransformPoint
    * for a recursive implementation.
@@ -131,6 +162,14 @@ public:
   OutputPointType
   TransformPoint(const InputPointType & point) const override;
 
+  /** Transform a block of points. The setup that is shared by all points,
+   * like the coefficient pointers and the offset table, is done only once.
+   */
+  void
+  TransformPoints(const InputPointType * inputPoints,
+                  OutputPointType *      outputPoints,
+                  const std::size_t      numberOfPoints) const override;
+
   /** Compute the Jacobian of the transformation. */
   void
   GetJacobian(const InputPointType &       ipp,
@@ -146,10 +185,30 @@ public:
                                            DerivativeType &                imageJacobian,
                                            NonZeroJacobianIndicesType &    nonZeroJacobianIndices) const override;
 
+  /** Compute the inner product of the Jacobian with the moving image gradient for a block of points.
+   * The weight buffers and the support region are set up only once.
+   */
+  void
+  EvaluateJacobianWithImageGradientProducts(const InputPointType *          ipps,
+                                            const MovingImageGradientType * movingImageGradients,
+                                            DerivativeType *                imageJacobians,
+                                            NonZeroJacobianIndicesType *    nonZeroJacobianIndices,
+                                            const std::size_t               numberOfPoints) const override;
+
   /** Compute the spatial Jacobian of the transformation. */
   void
   GetSpatialJacobian(const InputPointType & ipp, SpatialJacobianType & sj) const override;
 
+  /** Compute both the transformed point and the spatial Jacobian of the transformation.
+   * The recursive computation of the spatial Jacobian delivers the displacement as a
+   * by-product. The double precision coefficients are used, also when single precision
+   * coefficients are enabled.
+   */
+  void
+  TransformPointAndGetSpatialJacobian(const InputPointType & ipp,
+                                      OutputPointType &      opp,
+                                      SpatialJacobianType &  sj) const override;
+
   /** Compute the spatial Hessian of the transformation. */
   void
   GetSpatialHessian(const InputPointType & ipp, SpatialHessianType & sh) const override;
@@ -198,6 +257,21 @@ protected:
   ComputeNonZeroJacobianIndices(NonZeroJacobianIndicesType & nonZeroJacobianIndices,
                                 const RegionType &           supportRegion) const override;
 
+  /** Copy the coefficient images to m_SinglePrecisionCoefficientImages, if
+   * m_UseSinglePrecisionCoefficients is set. Otherwise release the copy.
+   */
+  virtual void
+  UpdateSinglePrecisionCoefficients(void);
+
+  /** Returns whether the single precision copy is in use, and matches the current coefficient images. */
+  bool
+  SinglePrecisionCoefficientsAreUpToDate(void) const;
+
+  /** Single precision copy of the coefficient images. */
+  bool                        m_UseSinglePrecisionCoefficients{ false };
+  SinglePrecisionImagePointer m_SinglePrecisionCoefficientImages[NDimensions];
+  TimeStamp                   m_SinglePrecisionCoefficientsUpdateTime;
+
 private:
   RecursiveBSplineTransform(const Self &) = delete;
   void
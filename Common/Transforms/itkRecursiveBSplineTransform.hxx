@@ -22,6 +22,7 @@
 
 #include "itkRecursiveBSplineTransformImplementation.h"
 
+#include <algorithm> // For copy.
 
 namespace itk
 {
@@ -41,6 +42,133 @@ RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::RecursiveBSplineT
 } // end Constructor()
 
 
+/**
+ * ********************* SetUseSinglePrecisionCoefficients ****************************
+ */
+
+template <typename TScalar, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::SetUseSinglePrecisionCoefficients(const bool _arg)
+{
+  if (this->m_UseSinglePrecisionCoefficients != _arg)
+  {
+    this->m_UseSinglePrecisionCoefficients = _arg;
+    this->Modified();
+    this->UpdateSinglePrecisionCoefficients();
+  }
+} // end SetUseSinglePrecisionCoefficients()
+
+
+/**
+ * ********************* SetParameters ****************************
+ */
+
+template <typename TScalar, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::SetParameters(const ParametersType & parameters)
+{
+  this->Superclass::SetParameters(parameters);
+  this->UpdateSinglePrecisionCoefficients();
+} // end SetParameters()
+
+
+/**
+ * ********************* SetParametersByValue ****************************
+ */
+
+template <typename TScalar, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::SetParametersByValue(const ParametersType & parameters)
+{
+  this->Superclass::SetParametersByValue(parameters);
+  this->UpdateSinglePrecisionCoefficients();
+} // end SetParametersByValue()
+
+
+/**
+ * ********************* SetCoefficientImages ****************************
+ */
+
+template <typename TScalar, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::SetCoefficientImages(ImagePointer images[])
+{
+  this->Superclass::SetCoefficientImages(images);
+  this->UpdateSinglePrecisionCoefficients();
+} // end SetCoefficientImages()
+
+
+/**
+ * ********************* UpdateSinglePrecisionCoefficients ****************************
+ */
+
+template <typename TScalar, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::UpdateSinglePrecisionCoefficients(void)
+{
+  for (unsigned int j = 0; j < SpaceDimension; ++j)
+  {
+    /** Release the copy when it is not used, or when the coefficient buffer does not
+     * (yet) match the grid, e.g. after SetGridRegion() and before SetParameters().
+     */
+    const ImageType * coefficientImage = this->m_CoefficientImages[j].GetPointer();
+    if (!this->m_UseSinglePrecisionCoefficients || coefficientImage == nullptr ||
+        coefficientImage->GetBufferPointer() == nullptr ||
+        coefficientImage->GetPixelContainer()->Size() < coefficientImage->GetBufferedRegion().GetNumberOfPixels())
+    {
+      this->m_SinglePrecisionCoefficientImages[j] = nullptr;
+      continue;
+    }
+
+    /** Only reallocate if the grid changed. */
+    const RegionType & region = coefficientImage->GetBufferedRegion();
+    if (this->m_SinglePrecisionCoefficientImages[j].IsNull() ||
+        this->m_SinglePrecisionCoefficientImages[j]->GetBufferedRegion() != region)
+    {
+      this->m_SinglePrecisionCoefficientImages[j] = SinglePrecisionImageType::New();
+      this->m_SinglePrecisionCoefficientImages[j]->SetRegions(region);
+      this->m_SinglePrecisionCoefficientImages[j]->Allocate();
+    }
+
+    const PixelType * coefficients = coefficientImage->GetBufferPointer();
+    std::copy(coefficients,
+              coefficients + region.GetNumberOfPixels(),
+              this->m_SinglePrecisionCoefficientImages[j]->GetBufferPointer());
+  }
+  this->m_SinglePrecisionCoefficientsUpdateTime.Modified();
+} // end UpdateSinglePrecisionCoefficients()
+
+
+/**
+ * ********************* SinglePrecisionCoefficientsAreUpToDate ****************************
+ */
+
+template <typename TScalar, unsigned int NDimensions, unsigned int VSplineOrder>
+bool
+RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::SinglePrecisionCoefficientsAreUpToDate(void) const
+{
+  /** The copy is out of date when the transform has been modified since the last
+   * update, e.g. by SetGridRegion() or SetIdentity().
+   */
+  if (!this->m_UseSinglePrecisionCoefficients ||
+      this->m_SinglePrecisionCoefficientsUpdateTime.GetMTime() < this->GetMTime())
+  {
+    return false;
+  }
+
+  for (unsigned int j = 0; j < SpaceDimension; ++j)
+  {
+    if (this->m_SinglePrecisionCoefficientImages[j].IsNull() || this->m_CoefficientImages[j].IsNull() ||
+        this->m_SinglePrecisionCoefficientImages[j]->GetBufferedRegion() !=
+          this->m_CoefficientImages[j]->GetBufferedRegion())
+    {
+      return false;
+    }
+  }
+  return true;
+} // end SinglePrecisionCoefficientsAreUpToDate()
+
+
 /**
  * ********************* TransformPoint ****************************
  */
@@ -92,16 +220,32 @@ RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::TransformPoint(co
     totalOffsetToSupportIndex += supportIndex[j] * bsplineOffsetTable[j];
   }
 
-  ScalarType * mu[SpaceDimension];
-  for (unsigned int j = 0; j < SpaceDimension; ++j)
+  /** Call the (vectorized) recursive TransformPoint function, either on the
+   * single precision copy of the coefficients or on the coefficients themselves.
+   */
+  ScalarType displacement[SpaceDimension];
+  if (this->SinglePrecisionCoefficientsAreUpToDate())
   {
-    mu[j] = this->m_CoefficientImages[j]->GetBufferPointer() + totalOffsetToSupportIndex;
+    float * muSingle[SpaceDimension];
+    float   displacementSingle[SpaceDimension];
+    for (unsigned int j = 0; j < SpaceDimension; ++j)
+    {
+      muSingle[j] = this->m_SinglePrecisionCoefficientImages[j]->GetBufferPointer() + totalOffsetToSupportIndex;
+    }
+    RecursiveBSplineTransformVectorizedImplementation<SpaceDimension, SpaceDimension, SplineOrder, float>::
+      TransformPoint(displacementSingle, muSingle, bsplineOffsetTable, weightsArray1D);
+    std::copy(displacementSingle, displacementSingle + SpaceDimension, displacement);
+  }
+  else
+  {
+    ScalarType * mu[SpaceDimension];
+    for (unsigned int j = 0; j < SpaceDimension; ++j)
+    {
+      mu[j] = this->m_CoefficientImages[j]->GetBufferPointer() + totalOffsetToSupportIndex;
+    }
+    RecursiveBSplineTransformVectorizedImplementation<SpaceDimension, SpaceDimension, SplineOrder, TScalar>::
+      TransformPoint(displacement, mu, bsplineOffsetTable, weightsArray1D);
   }
-
-  /** Call the recursive TransformPoint function. */
-  ScalarType displacement[SpaceDimension];
-  RecursiveBSplineTransformImplementation<SpaceDimension, SpaceDimension, SplineOrder, TScalar>::TransformPoint(
-    displacement, mu, bsplineOffsetTable, weightsArray1D);
 
   // The output point is the start point + displacement.
   for (unsigned int j = 0; j < SpaceDimension; ++j)
@@ -113,6 +257,109 @@ RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::TransformPoint(co
 } // end TransformPoint()
 
 
+/**
+ * ********************* TransformPoints ****************************
+ */
+
+template <typename TScalar, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::TransformPoints(
+  const InputPointType * inputPoints,
+  OutputPointType *      outputPoints,
+  const std::size_t      numberOfPoints) const
+{
+  /** Check if the coefficient image has been set. */
+  if (!this->m_CoefficientImages[0])
+  {
+    itkWarningMacro(<< "B-spline coefficients have not been set");
+    for (std::size_t n = 0; n < numberOfPoints; ++n)
+    {
+      outputPoints[n] = inputPoints[n];
+    }
+    return;
+  }
+
+  /** Define some constants. */
+  const unsigned int numberOfWeights = RecursiveBSplineWeightFunctionType::NumberOfWeights;
+
+  /** Allocate weights on the stack: */
+  typename WeightsType::ValueType weightsArray1D[numberOfWeights];
+  WeightsType                     weights1D(weightsArray1D, numberOfWeights, false);
+
+  /** Initialize the helper variables that are the same for all points. */
+  const OffsetValueType * bsplineOffsetTable = this->m_CoefficientImages[0]->GetOffsetTable();
+  const bool              useSinglePrecision = this->SinglePrecisionCoefficientsAreUpToDate();
+  ScalarType *            coefficientBuffers[SpaceDimension];
+  float *                 singlePrecisionCoefficientBuffers[SpaceDimension];
+  for (unsigned int j = 0; j < SpaceDimension; ++j)
+  {
+    coefficientBuffers[j] = this->m_CoefficientImages[j]->GetBufferPointer();
+    singlePrecisionCoefficientBuffers[j] =
+      useSinglePrecision ? this->m_SinglePrecisionCoefficientImages[j]->GetBufferPointer() : nullptr;
+  }
+
+  ContinuousIndexType cindex;
+  IndexType           supportIndex;
+  ScalarType *        mu[SpaceDimension];
+  float *             muSingle[SpaceDimension];
+  ScalarType          displacement[SpaceDimension];
+  float               displacementSingle[SpaceDimension];
+  for (std::size_t n = 0; n < numberOfPoints; ++n)
+  {
+    /** Use a copy, since the input and output may be the same. */
+    const InputPointType point = inputPoints[n];
+
+    /** Convert to continuous index. */
+    this->TransformPointToContinuousGridIndex(point, cindex);
+
+    // NOTE: if the support region does not lie totally within the grid
+    // we assume zero displacement and return the input point
+    if (!this->InsideValidRegion(cindex))
+    {
+      outputPoints[n] = point;
+      continue;
+    }
+
+    // Compute interpolation weighs and store them in weights1D
+    this->m_RecursiveBSplineWeightFunction->Evaluate(cindex, weights1D, supportIndex);
+
+    OffsetValueType totalOffsetToSupportIndex = 0;
+    for (unsigned int j = 0; j < SpaceDimension; ++j)
+    {
+      totalOffsetToSupportIndex += supportIndex[j] * bsplineOffsetTable[j];
+    }
+
+    /** Call the (vectorized) recursive TransformPoint function. */
+    if (useSinglePrecision)
+    {
+      for (unsigned int j = 0; j < SpaceDimension; ++j)
+      {
+        muSingle[j] = singlePrecisionCoefficientBuffers[j] + totalOffsetToSupportIndex;
+      }
+      RecursiveBSplineTransformVectorizedImplementation<SpaceDimension, SpaceDimension, SplineOrder, float>::
+        TransformPoint(displacementSingle, muSingle, bsplineOffsetTable, weightsArray1D);
+      std::copy(displacementSingle, displacementSingle + SpaceDimension, displacement);
+    }
+    else
+    {
+      for (unsigned int j = 0; j < SpaceDimension; ++j)
+      {
+        mu[j] = coefficientBuffers[j] + totalOffsetToSupportIndex;
+      }
+      RecursiveBSplineTransformVectorizedImplementation<SpaceDimension, SpaceDimension, SplineOrder, TScalar>::
+        TransformPoint(displacement, mu, bsplineOffsetTable, weightsArray1D);
+    }
+
+    // The output point is the start point + displacement.
+    for (unsigned int j = 0; j < SpaceDimension; ++j)
+    {
+      outputPoints[n][j] = displacement[j] + point[j];
+    }
+  }
+
+} // end TransformPoints()
+
+
 /**
  * ********************* GetJacobian ****************************
  */
@@ -232,7 +479,7 @@ RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::EvaluateJacobianW
     migArray[j] = movingImageGradient[j];
   }
   ParametersValueType * imageJacobianPointer = imageJacobian.data_block();
-  RecursiveBSplineTransformImplementation<SpaceDimension, SpaceDimension, SplineOrder, TScalar>::
+  RecursiveBSplineTransformVectorizedImplementation<SpaceDimension, SpaceDimension, SplineOrder, TScalar>::
     EvaluateJacobianWithImageGradientProduct(imageJacobianPointer, migArray, weightsArray1D, 1.0);
 
   /** Setup support region needed for the nonZeroJacobianIndices. */
@@ -248,6 +495,69 @@ RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::EvaluateJacobianW
 } // end EvaluateJacobianWithImageGradientProduct()
 
 
+/**
+ * ********************* EvaluateJacobianWithImageGradientProducts ****************************
+ */
+
+template <class TScalar, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::EvaluateJacobianWithImageGradientProducts(
+  const InputPointType *          ipps,
+  const MovingImageGradientType * movingImageGradients,
+  DerivativeType *                imageJacobians,
+  NonZeroJacobianIndicesType *    nonZeroJacobianIndices,
+  const std::size_t               numberOfPoints) const
+{
+  /** Initialize the helper variables that are the same for all points. */
+  const NumberOfParametersType    nnzji = this->GetNumberOfNonZeroJacobianIndices();
+  const unsigned int              numberOfWeights = RecursiveBSplineWeightFunctionType::NumberOfWeights;
+  typename WeightsType::ValueType weightsArray1D[numberOfWeights];
+  WeightsType                     weights1D(weightsArray1D, numberOfWeights, false);
+  RegionType                      supportRegion;
+  supportRegion.SetSize(this->m_SupportSize);
+
+  ContinuousIndexType cindex;
+  IndexType           supportIndex;
+  double              migArray[SpaceDimension]; // InternalFloatType
+  for (std::size_t n = 0; n < numberOfPoints; ++n)
+  {
+    /** Convert the physical point to a continuous index. */
+    this->TransformPointToContinuousGridIndex(ipps[n], cindex);
+
+    /** NOTE: if the support region does not lie totally within the grid
+     * we assume zero displacement and zero Jacobian.
+     */
+    NonZeroJacobianIndicesType & nzji = nonZeroJacobianIndices[n];
+    if (!this->InsideValidRegion(cindex))
+    {
+      nzji.resize(nnzji);
+      for (NumberOfParametersType i = 0; i < nnzji; ++i)
+      {
+        nzji[i] = i;
+      }
+      continue;
+    }
+
+    /** Compute the interpolation weights. */
+    this->m_RecursiveBSplineWeightFunction->Evaluate(cindex, weights1D, supportIndex);
+
+    /** Recursively compute the inner product of the Jacobian and the moving image gradient. */
+    for (unsigned int j = 0; j < SpaceDimension; ++j)
+    {
+      migArray[j] = movingImageGradients[n][j];
+    }
+    ParametersValueType * imageJacobianPointer = imageJacobians[n].data_block();
+    RecursiveBSplineTransformVectorizedImplementation<SpaceDimension, SpaceDimension, SplineOrder, TScalar>::
+      EvaluateJacobianWithImageGradientProduct(imageJacobianPointer, migArray, weightsArray1D, 1.0);
+
+    /** Compute the nonzero Jacobian indices. */
+    supportRegion.SetIndex(supportIndex);
+    this->ComputeNonZeroJacobianIndices(nzji, supportRegion);
+  }
+
+} // end EvaluateJacobianWithImageGradientProducts()
+
+
 /**
  * ********************* GetSpatialJacobian ****************************
  */
@@ -256,6 +566,24 @@ template <class TScalar, unsigned int NDimensions, unsigned int VSplineOrder>
 void
 RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::GetSpatialJacobian(const InputPointType & ipp,
                                                                                   SpatialJacobianType &  sj) const
+{
+  /** The transformed point is a free by-product of the spatial Jacobian. */
+  OutputPointType opp;
+  this->Self::TransformPointAndGetSpatialJacobian(ipp, opp, sj);
+
+} // end GetSpatialJacobian()
+
+
+/**
+ * ********************* TransformPointAndGetSpatialJacobian ****************************
+ */
+
+template <class TScalar, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::TransformPointAndGetSpatialJacobian(
+  const InputPointType & ipp,
+  OutputPointType &      opp,
+  SpatialJacobianType &  sj) const
 {
   /** Convert the physical point to a continuous index, which
    * is needed for the 'Evaluate()' functions below.
@@ -267,6 +595,7 @@ RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::GetSpatialJacobia
   // we assume zero displacement and identity spatial Jacobian
   if (!this->InsideValidRegion(cindex))
   {
+    opp = ipp;
     sj.SetIdentity();
     return;
   }
@@ -315,6 +644,7 @@ RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::GetSpatialJacobia
    */
   for (unsigned int i = 0; i < SpaceDimension; ++i)
   {
+    opp[i] = ipp[i] + spatialJacobian[i];
     for (unsigned int j = 0; j < SpaceDimension; ++j)
     {
       sj(i, j) = spatialJacobian[i + (j + 1) * SpaceDimension];
@@ -330,7 +660,7 @@ RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::GetSpatialJacobia
     sj(j, j) += 1.0;
   }
 
-} // end GetSpatialJacobian()
+} // end TransformPointAndGetSpatialJacobian()
 
 
 /**
@@ -24,6 +24,10 @@
 #include <cassert>
 #include <cstring> // For memcpy.
 
+#ifdef __AVX__
+#  include <immintrin.h> // For the AVX intrinsics of the cubic B-spline kernels.
+#endif
+
 namespace itk
 {
 
@@ -623,6 +627,386 @@ private:
 };
 
 
+
+/** \class RecursiveBSplineTransformVectorizedImplementation
+ *
+ * \brief Explicitly vectorized versions of the TransformPoint() and
+ * EvaluateJacobianWithImageGradientProduct() functions of the
+ * RecursiveBSplineTransformImplementation.
+ *
+ * The generic template simply forwards to the (scalar) recursive implementation.
+ * For cubic B-splines in 2D and 3D, specializations are provided that exploit the fact
+ * that the support of a cubic B-spline contains exactly four coefficients along x, which
+ * are contiguous in memory. Such a row of the support fits in a single 256-bit AVX register
+ * (double precision coefficients) or 128-bit register (single precision coefficients), so
+ * that the weight-coefficient contraction is done for four coefficients at once, for all
+ * output dimensions. For single precision coefficients only TransformPoint() is vectorized.
+ * The specializations are only compiled when AVX is enabled (e.g. -mavx2, -march=native
+ * or /arch:AVX2); otherwise the scalar recursive implementation is used.
+ *
+ * Note that the vectorized TransformPoint() sums the contributions in a different order
+ * than the recursive implementation, and therefore agrees with it up to rounding errors.
+ * The vectorized EvaluateJacobianWithImageGradientProduct() gives identical results.
+ *
+ * \ingroup ITKTransform
+ */
+
+template <unsigned int OutputDimension, unsigned int SpaceDimension, unsigned int SplineOrder, class TScalar>
+class ITK_TEMPLATE_EXPORT RecursiveBSplineTransformVectorizedImplementation
+{
+public:
+  /** Typedef for the scalar implementation, used as the fallback. */
+  typedef RecursiveBSplineTransformImplementation<OutputDimension, SpaceDimension, SplineOrder, TScalar>
+    ScalarImplementationType;
+
+  typedef typename ScalarImplementationType::ScalarType                  ScalarType;
+  typedef typename ScalarImplementationType::InternalFloatType           InternalFloatType;
+  typedef typename ScalarImplementationType::OutputPointType             OutputPointType;
+  typedef typename ScalarImplementationType::CoefficientPointerVectorType CoefficientPointerVectorType;
+
+  /** Whether this implementation is explicitly vectorized. */
+  itkStaticConstMacro(IsVectorized, bool, false);
+
+  /** TransformPoint implementation, forwards to the recursive implementation. */
+  static inline void
+  TransformPoint(OutputPointType                    opp,
+                 const CoefficientPointerVectorType mu,
+                 const OffsetValueType *            gridOffsetTable,
+                 const double *                     weights1D)
+  {
+    ScalarImplementationType::TransformPoint(opp, mu, gridOffsetTable, weights1D);
+  } // end TransformPoint()
+
+
+  /** EvaluateJacobianWithImageGradientProduct implementation, forwards to the recursive implementation. */
+  static inline void
+  EvaluateJacobianWithImageGradientProduct(ScalarType *&             imageJacobian,
+                                           const InternalFloatType * movingImageGradient,
+                                           const double *            weights1D,
+                                           double                    value)
+  {
+    ScalarImplementationType::EvaluateJacobianWithImageGradientProduct(
+      imageJacobian, movingImageGradient, weights1D, value);
+  } // end EvaluateJacobianWithImageGradientProduct()
+};
+
+
+#ifdef __AVX__
+
+/** \class RecursiveBSplineTransformAVXHelper
+ *
+ * \brief Small helper functions shared by the AVX specializations below.
+ *
+ * \ingroup ITKTransform
+ */
+
+class RecursiveBSplineTransformAVXHelper
+{
+public:
+  /** Returns the sum of the four elements of v. */
+  static inline double
+  HorizontalSum(const __m256d v)
+  {
+    const __m128d pairSum = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(pairSum, _mm_unpackhi_pd(pairSum, pairSum)));
+  }
+
+
+  /** Returns the contraction of a row of four x-coefficients with the y-weights, for four rows. */
+  static inline __m256d
+  ContractRows(const double * mu, const OffsetValueType offsetY, const __m256d * weightsY)
+  {
+    __m256d sum = _mm256_mul_pd(_mm256_loadu_pd(mu), weightsY[0]);
+    for (unsigned int l = 1; l < 4; ++l)
+    {
+      sum = _mm256_add_pd(sum, _mm256_mul_pd(_mm256_loadu_pd(mu + l * offsetY), weightsY[l]));
+    }
+    return sum;
+  }
+
+
+  /** Returns the sum of the four elements of v, single precision version. */
+  static inline float
+  HorizontalSum(const __m128 v)
+  {
+    const __m128 pairSum = _mm_add_ps(v, _mm_movehdup_ps(v));
+    return _mm_cvtss_f32(_mm_add_ss(pairSum, _mm_movehl_ps(pairSum, pairSum)));
+  }
+
+
+  /** Returns the contraction of a row of four x-coefficients with the y-weights, single precision version. */
+  static inline __m128
+  ContractRows(const float * mu, const OffsetValueType offsetY, const __m128 * weightsY)
+  {
+    __m128 sum = _mm_mul_ps(_mm_loadu_ps(mu), weightsY[0]);
+    for (unsigned int l = 1; l < 4; ++l)
+    {
+      sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(mu + l * offsetY), weightsY[l]));
+    }
+    return sum;
+  }
+};
+
+
+/** Specialization for cubic B-splines in 2D. */
+template <>
+class RecursiveBSplineTransformVectorizedImplementation<2, 2, 3, double>
+{
+public:
+  typedef RecursiveBSplineTransformImplementation<2, 2, 3, double> ScalarImplementationType;
+
+  typedef ScalarImplementationType::ScalarType                  ScalarType;
+  typedef ScalarImplementationType::InternalFloatType           InternalFloatType;
+  typedef ScalarImplementationType::OutputPointType             OutputPointType;
+  typedef ScalarImplementationType::CoefficientPointerVectorType CoefficientPointerVectorType;
+
+  itkStaticConstMacro(IsVectorized, bool, true);
+
+  /** TransformPoint vectorized implementation.
+   * weights1D contains the four x-weights, followed by the four y-weights.
+   */
+  static inline void
+  TransformPoint(OutputPointType                    opp,
+                 const CoefficientPointerVectorType mu,
+                 const OffsetValueType *            gridOffsetTable,
+                 const double *                     weights1D)
+  {
+    /** The four x-coefficients of a row of the support are contiguous in memory. */
+    assert(gridOffsetTable[0] == 1);
+
+    const __m256d weightsX = _mm256_loadu_pd(weights1D);
+    const __m256d weightsY[4] = { _mm256_set1_pd(weights1D[4]),
+                                  _mm256_set1_pd(weights1D[5]),
+                                  _mm256_set1_pd(weights1D[6]),
+                                  _mm256_set1_pd(weights1D[7]) };
+
+    for (unsigned int j = 0; j < 2; ++j)
+    {
+      const __m256d sumY = RecursiveBSplineTransformAVXHelper::ContractRows(mu[j], gridOffsetTable[1], weightsY);
+      opp[j] = RecursiveBSplineTransformAVXHelper::HorizontalSum(_mm256_mul_pd(sumY, weightsX));
+    }
+  } // end TransformPoint()
+
+
+  /** EvaluateJacobianWithImageGradientProduct vectorized implementation. */
+  static inline void
+  EvaluateJacobianWithImageGradientProduct(ScalarType *&             imageJacobian,
+                                           const InternalFloatType * movingImageGradient,
+                                           const double *            weights1D,
+                                           double                    value)
+  {
+    const __m256d weightsX = _mm256_loadu_pd(weights1D);
+    const __m256d gradient0 = _mm256_set1_pd(movingImageGradient[0]);
+    const __m256d gradient1 = _mm256_set1_pd(movingImageGradient[1]);
+
+    /** Same multiplication order as the recursive implementation: ( value * wy ) * wx * mig. */
+    for (unsigned int l = 0; l < 4; ++l)
+    {
+      const __m256d weights = _mm256_mul_pd(_mm256_set1_pd(value * weights1D[4 + l]), weightsX);
+      _mm256_storeu_pd(imageJacobian + 4 * l, _mm256_mul_pd(weights, gradient0));
+      _mm256_storeu_pd(imageJacobian + 16 + 4 * l, _mm256_mul_pd(weights, gradient1));
+    }
+    imageJacobian += 16;
+  } // end EvaluateJacobianWithImageGradientProduct()
+};
+
+
+/** Specialization for cubic B-splines in 3D. */
+template <>
+class RecursiveBSplineTransformVectorizedImplementation<3, 3, 3, double>
+{
+public:
+  typedef RecursiveBSplineTransformImplementation<3, 3, 3, double> ScalarImplementationType;
+
+  typedef ScalarImplementationType::ScalarType                  ScalarType;
+  typedef ScalarImplementationType::InternalFloatType           InternalFloatType;
+  typedef ScalarImplementationType::OutputPointType             OutputPointType;
+  typedef ScalarImplementationType::CoefficientPointerVectorType CoefficientPointerVectorType;
+
+  itkStaticConstMacro(IsVectorized, bool, true);
+
+  /** TransformPoint vectorized implementation.
+   * weights1D contains the four x-weights, followed by the four y-weights and the four z-weights.
+   */
+  static inline void
+  TransformPoint(OutputPointType                    opp,
+                 const CoefficientPointerVectorType mu,
+                 const OffsetValueType *            gridOffsetTable,
+                 const double *                     weights1D)
+  {
+    /** The four x-coefficients of a row of the support are contiguous in memory. */
+    assert(gridOffsetTable[0] == 1);
+
+    const OffsetValueType offsetY = gridOffsetTable[1];
+    const OffsetValueType offsetZ = gridOffsetTable[2];
+
+    const __m256d weightsX = _mm256_loadu_pd(weights1D);
+    const __m256d weightsY[4] = { _mm256_set1_pd(weights1D[4]),
+                                  _mm256_set1_pd(weights1D[5]),
+                                  _mm256_set1_pd(weights1D[6]),
+                                  _mm256_set1_pd(weights1D[7]) };
+
+    for (unsigned int j = 0; j < 3; ++j)
+    {
+      const double * muSlice = mu[j];
+      __m256d        sumZ = _mm256_setzero_pd();
+      for (unsigned int k = 0; k < 4; ++k, muSlice += offsetZ)
+      {
+        const __m256d sumY = RecursiveBSplineTransformAVXHelper::ContractRows(muSlice, offsetY, weightsY);
+        sumZ = _mm256_add_pd(sumZ, _mm256_mul_pd(sumY, _mm256_set1_pd(weights1D[8 + k])));
+      }
+      opp[j] = RecursiveBSplineTransformAVXHelper::HorizontalSum(_mm256_mul_pd(sumZ, weightsX));
+    }
+  } // end TransformPoint()
+
+
+  /** EvaluateJacobianWithImageGradientProduct vectorized implementation. */
+  static inline void
+  EvaluateJacobianWithImageGradientProduct(ScalarType *&             imageJacobian,
+                                           const InternalFloatType * movingImageGradient,
+                                           const double *            weights1D,
+                                           double                    value)
+  {
+    const __m256d weightsX = _mm256_loadu_pd(weights1D);
+    const __m256d gradient0 = _mm256_set1_pd(movingImageGradient[0]);
+    const __m256d gradient1 = _mm256_set1_pd(movingImageGradient[1]);
+    const __m256d gradient2 = _mm256_set1_pd(movingImageGradient[2]);
+
+    /** Same multiplication order as the recursive implementation: ( ( value * wz ) * wy ) * wx * mig. */
+    for (unsigned int k = 0; k < 4; ++k)
+    {
+      const double valueZ = value * weights1D[8 + k];
+      for (unsigned int l = 0; l < 4; ++l)
+      {
+        const __m256d      weights = _mm256_mul_pd(_mm256_set1_pd(valueZ * weights1D[4 + l]), weightsX);
+        const unsigned int offset = 16 * k + 4 * l;
+        _mm256_storeu_pd(imageJacobian + offset, _mm256_mul_pd(weights, gradient0));
+        _mm256_storeu_pd(imageJacobian + 64 + offset, _mm256_mul_pd(weights, gradient1));
+        _mm256_storeu_pd(imageJacobian + 128 + offset, _mm256_mul_pd(weights, gradient2));
+      }
+    }
+    imageJacobian += 64;
+  } // end EvaluateJacobianWithImageGradientProduct()
+};
+
+
+/** Specialization for cubic B-splines in 2D, with single precision coefficients.
+ * A row of four x-coefficients fits in a single 128-bit register.
+ */
+template <>
+class RecursiveBSplineTransformVectorizedImplementation<2, 2, 3, float>
+{
+public:
+  typedef RecursiveBSplineTransformImplementation<2, 2, 3, float> ScalarImplementationType;
+
+  typedef ScalarImplementationType::ScalarType                  ScalarType;
+  typedef ScalarImplementationType::InternalFloatType           InternalFloatType;
+  typedef ScalarImplementationType::OutputPointType             OutputPointType;
+  typedef ScalarImplementationType::CoefficientPointerVectorType CoefficientPointerVectorType;
+
+  itkStaticConstMacro(IsVectorized, bool, true);
+
+  /** TransformPoint vectorized implementation. */
+  static inline void
+  TransformPoint(OutputPointType                    opp,
+                 const CoefficientPointerVectorType mu,
+                 const OffsetValueType *            gridOffsetTable,
+                 const double *                     weights1D)
+  {
+    /** The four x-coefficients of a row of the support are contiguous in memory. */
+    assert(gridOffsetTable[0] == 1);
+
+    const __m128 weightsX = _mm256_cvtpd_ps(_mm256_loadu_pd(weights1D));
+    const __m128 weightsY[4] = { _mm_set1_ps(static_cast<float>(weights1D[4])),
+                                 _mm_set1_ps(static_cast<float>(weights1D[5])),
+                                 _mm_set1_ps(static_cast<float>(weights1D[6])),
+                                 _mm_set1_ps(static_cast<float>(weights1D[7])) };
+
+    for (unsigned int j = 0; j < 2; ++j)
+    {
+      const __m128 sumY = RecursiveBSplineTransformAVXHelper::ContractRows(mu[j], gridOffsetTable[1], weightsY);
+      opp[j] = RecursiveBSplineTransformAVXHelper::HorizontalSum(_mm_mul_ps(sumY, weightsX));
+    }
+  } // end TransformPoint()
+
+
+  /** EvaluateJacobianWithImageGradientProduct implementation, forwards to the recursive implementation. */
+  static inline void
+  EvaluateJacobianWithImageGradientProduct(ScalarType *&             imageJacobian,
+                                           const InternalFloatType * movingImageGradient,
+                                           const double *            weights1D,
+                                           double                    value)
+  {
+    ScalarImplementationType::EvaluateJacobianWithImageGradientProduct(
+      imageJacobian, movingImageGradient, weights1D, value);
+  } // end EvaluateJacobianWithImageGradientProduct()
+};
+
+
+/** Specialization for cubic B-splines in 3D, with single precision coefficients.
+ * A row of four x-coefficients fits in a single 128-bit register.
+ */
+template <>
+class RecursiveBSplineTransformVectorizedImplementation<3, 3, 3, float>
+{
+public:
+  typedef RecursiveBSplineTransformImplementation<3, 3, 3, float> ScalarImplementationType;
+
+  typedef ScalarImplementationType::ScalarType                  ScalarType;
+  typedef ScalarImplementationType::InternalFloatType           InternalFloatType;
+  typedef ScalarImplementationType::OutputPointType             OutputPointType;
+  typedef ScalarImplementationType::CoefficientPointerVectorType CoefficientPointerVectorType;
+
+  itkStaticConstMacro(IsVectorized, bool, true);
+
+  /** TransformPoint vectorized implementation. */
+  static inline void
+  TransformPoint(OutputPointType                    opp,
+                 const CoefficientPointerVectorType mu,
+                 const OffsetValueType *            gridOffsetTable,
+                 const double *                     weights1D)
+  {
+    /** The four x-coefficients of a row of the support are contiguous in memory. */
+    assert(gridOffsetTable[0] == 1);
+
+    const OffsetValueType offsetY = gridOffsetTable[1];
+    const OffsetValueType offsetZ = gridOffsetTable[2];
+
+    const __m128 weightsX = _mm256_cvtpd_ps(_mm256_loadu_pd(weights1D));
+    const __m128 weightsY[4] = { _mm_set1_ps(static_cast<float>(weights1D[4])),
+                                 _mm_set1_ps(static_cast<float>(weights1D[5])),
+                                 _mm_set1_ps(static_cast<float>(weights1D[6])),
+                                 _mm_set1_ps(static_cast<float>(weights1D[7])) };
+
+    for (unsigned int j = 0; j < 3; ++j)
+    {
+      const float * muSlice = mu[j];
+      __m128        sumZ = _mm_setzero_ps();
+      for (unsigned int k = 0; k < 4; ++k, muSlice += offsetZ)
+      {
+        const __m128 sumY = RecursiveBSplineTransformAVXHelper::ContractRows(muSlice, offsetY, weightsY);
+        sumZ = _mm_add_ps(sumZ, _mm_mul_ps(sumY, _mm_set1_ps(static_cast<float>(weights1D[8 + k]))));
+      }
+      opp[j] = RecursiveBSplineTransformAVXHelper::HorizontalSum(_mm_mul_ps(sumZ, weightsX));
+    }
+  } // end TransformPoint()
+
+
+  /** EvaluateJacobianWithImageGradientProduct implementation, forwards to the recursive implementation. */
+  static inline void
+  EvaluateJacobianWithImageGradientProduct(ScalarType *&             imageJacobian,
+                                           const InternalFloatType * movingImageGradient,
+                                           const double *            weights1D,
+                                           double                    value)
+  {
+    ScalarImplementationType::EvaluateJacobianWithImageGradientProduct(
+      imageJacobian, movingImageGradient, weights1D, value);
+  } // end EvaluateJacobianWithImageGradientProduct()
+};
+
+#endif // __AVX__
+
+
 } // end namespace itk
 
 #endif /* itkRecursiveBSplineTransformImplementation_h */
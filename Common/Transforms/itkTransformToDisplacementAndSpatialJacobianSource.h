@@ -0,0 +1,279 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkTransformToDisplacementAndSpatialJacobianSource_h
+#define itkTransformToDisplacementAndSpatialJacobianSource_h
+
+#include "itkAdvancedTransform.h"
+#include "itkImageSource.h"
+#include "itkInterpolateImageFunction.h"
+
+namespace itk
+{
+
+/** \class TransformToDisplacementAndSpatialJacobianSource
+ * \brief Generate the displacement field, the determinant of the spatial
+ * Jacobian, the full spatial Jacobian and the resampled moving image of a
+ * transform in a single pass.
+ *
+ * This class combines the functionality of the TransformToDisplacementFieldFilter,
+ * the TransformToDeterminantOfSpatialJacobianSource, the
+ * TransformToSpatialJacobianSource and the ResampleImageFilter. The output grid
+ * is traversed only once; at every voxel the transformed point and the spatial
+ * Jacobian are evaluated by a single call of the transform, and all enabled
+ * outputs are filled from these values. This avoids evaluating an expensive
+ * transform (e.g. a B-spline) several times at the same point.
+ *
+ * The filter has four outputs:
+ * \li output 0: the displacement field T(x) - x, of type TDisplacementFieldImage;
+ * \li output 1: the determinant of the spatial Jacobian, of type TDeterminantImage;
+ * \li output 2: the spatial Jacobian matrix, of type TSpatialJacobianImage;
+ * \li output 3: the moving image resampled at T(x), of type TResultImage.
+ *
+ * Outputs that are not needed can be switched off, using
+ * GenerateDisplacementFieldOff(), GenerateDeterminantOfSpatialJacobianOff(),
+ * GenerateSpatialJacobianOff() and GenerateResultImageOff(). Their buffers are
+ * then not allocated. The result image is off by default. It requires a moving
+ * image, of type TResultImage with a scalar pixel type, and an interpolator. As
+ * in the ResampleImageFilter, the moving image is interpolated at the (double
+ * precision) transformed point, the value is clamped to the range of the pixel
+ * type, and points outside the moving image get the default pixel value.
+ *
+ * Output information (spacing, size and direction) for the output
+ * images should be set. This information has the normal defaults of
+ * unit spacing, zero origin and identity direction.
+ *
+ * This filter is implemented as a multithreaded filter.  It provides a
+ * ThreadedGenerateData() method for its implementation.
+ *
+ * \ingroup GeometricTransforms
+ */
+template <class TDisplacementFieldImage,
+          class TDeterminantImage,
+          class TSpatialJacobianImage,
+          class TResultImage,
+          class TTransformPrecisionType = double>
+class ITK_TEMPLATE_EXPORT TransformToDisplacementAndSpatialJacobianSource : public ImageSource<TDisplacementFieldImage>
+{
+public:
+  /** Standard class typedefs. */
+  typedef TransformToDisplacementAndSpatialJacobianSource Self;
+  typedef ImageSource<TDisplacementFieldImage>            Superclass;
+  typedef SmartPointer<Self>                              Pointer;
+  typedef SmartPointer<const Self>                        ConstPointer;
+
+  typedef TDisplacementFieldImage                         DisplacementFieldImageType;
+  typedef TDeterminantImage                               DeterminantImageType;
+  typedef TSpatialJacobianImage                           SpatialJacobianImageType;
+  typedef TResultImage                                    ResultImageType;
+  typedef typename DisplacementFieldImageType::Pointer    OutputImagePointer;
+  typedef typename DisplacementFieldImageType::RegionType OutputImageRegionType;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(TransformToDisplacementAndSpatialJacobianSource, ImageSource);
+
+  /** Number of dimensions. */
+  itkStaticConstMacro(ImageDimension, unsigned int, TDisplacementFieldImage::ImageDimension);
+
+  /** Typedefs for transform. */
+  typedef AdvancedTransform<TTransformPrecisionType,
+                            itkGetStaticConstMacro(ImageDimension),
+                            itkGetStaticConstMacro(ImageDimension)>
+                                                      TransformType;
+  typedef typename TransformType::ConstPointer        TransformPointerType;
+  typedef typename TransformType::OutputPointType     TransformOutputPointType;
+  typedef typename TransformType::SpatialJacobianType SpatialJacobianType;
+
+  /** Typedefs for the output images. */
+  typedef typename DisplacementFieldImageType::PixelType     DisplacementPixelType;
+  typedef typename DeterminantImageType::PixelType           DeterminantPixelType;
+  typedef typename SpatialJacobianImageType::PixelType       SpatialJacobianPixelType;
+  typedef typename ResultImageType::PixelType                ResultPixelType;
+  typedef typename DisplacementFieldImageType::RegionType    RegionType;
+  typedef typename RegionType::SizeType                      SizeType;
+  typedef typename DisplacementFieldImageType::IndexType     IndexType;
+  typedef typename DisplacementFieldImageType::PointType     PointType;
+  typedef typename DisplacementFieldImageType::SpacingType   SpacingType;
+  typedef typename DisplacementFieldImageType::PointType     OriginType;
+  typedef typename DisplacementFieldImageType::DirectionType DirectionType;
+
+  /** Typedefs for the interpolator of the moving image. */
+  typedef InterpolateImageFunction<ResultImageType, TTransformPrecisionType> InterpolatorType;
+  typedef typename InterpolatorType::Pointer                                 InterpolatorPointer;
+
+  /** Set the coordinate transformation. */
+  itkSetConstObjectMacro(Transform, TransformType);
+
+  /** Get a pointer to the coordinate transform. */
+  itkGetConstObjectMacro(Transform, TransformType);
+
+  /** Set/Get the moving image, which is resampled into the result image. */
+  itkSetConstObjectMacro(MovingImage, ResultImageType);
+  itkGetConstObjectMacro(MovingImage, ResultImageType);
+
+  /** Set/Get the interpolator of the moving image. Its input image is set to the moving image. */
+  itkSetObjectMacro(Interpolator, InterpolatorType);
+  itkGetModifiableObjectMacro(Interpolator, InterpolatorType);
+
+  /** Set/Get the value of the result image outside the moving image. Zero by default. */
+  itkSetMacro(DefaultPixelValue, ResultPixelType);
+  itkGetConstReferenceMacro(DefaultPixelValue, ResultPixelType);
+
+  /** Set the size of the output images. */
+  virtual void
+  SetOutputSize(const SizeType & size);
+
+  /** Set the start index of the output largest possible region.
+   * The default is an index of all zeros. */
+  virtual void
+  SetOutputIndex(const IndexType & index);
+
+  /** Set the region of the output images. */
+  itkSetMacro(OutputRegion, OutputImageRegionType);
+
+  /** Get the region of the output images. */
+  itkGetConstReferenceMacro(OutputRegion, OutputImageRegionType);
+
+  /** Set the output image spacing. */
+  itkSetMacro(OutputSpacing, SpacingType);
+
+  /** Get the output image spacing. */
+  itkGetConstReferenceMacro(OutputSpacing, SpacingType);
+
+  /** Set the output image origin. */
+  itkSetMacro(OutputOrigin, OriginType);
+
+  /** Get the output image origin. */
+  itkGetConstReferenceMacro(OutputOrigin, OriginType);
+
+  /** Set the output direction cosine matrix. */
+  itkSetMacro(OutputDirection, DirectionType);
+  itkGetConstReferenceMacro(OutputDirection, DirectionType);
+
+  /** Select which of the outputs are computed. By default all are, except the result image. */
+  itkSetMacro(GenerateDisplacementField, bool);
+  itkGetConstMacro(GenerateDisplacementField, bool);
+  itkBooleanMacro(GenerateDisplacementField);
+  itkSetMacro(GenerateDeterminantOfSpatialJacobian, bool);
+  itkGetConstMacro(GenerateDeterminantOfSpatialJacobian, bool);
+  itkBooleanMacro(GenerateDeterminantOfSpatialJacobian);
+  itkSetMacro(GenerateSpatialJacobian, bool);
+  itkGetConstMacro(GenerateSpatialJacobian, bool);
+  itkBooleanMacro(GenerateSpatialJacobian);
+  itkSetMacro(GenerateResultImage, bool);
+  itkGetConstMacro(GenerateResultImage, bool);
+  itkBooleanMacro(GenerateResultImage);
+
+  /** Get the displacement field output (output 0). */
+  DisplacementFieldImageType *
+  GetDisplacementFieldOutput(void)
+  {
+    return this->GetOutput();
+  }
+
+  /** Get the determinant of the spatial Jacobian output (output 1). */
+  DeterminantImageType *
+  GetDeterminantOfSpatialJacobianOutput(void)
+  {
+    return dynamic_cast<DeterminantImageType *>(this->ProcessObject::GetOutput(1));
+  }
+
+  /** Get the spatial Jacobian output (output 2). */
+  SpatialJacobianImageType *
+  GetSpatialJacobianOutput(void)
+  {
+    return dynamic_cast<SpatialJacobianImageType *>(this->ProcessObject::GetOutput(2));
+  }
+
+  /** Get the resampled moving image output (output 3). */
+  ResultImageType *
+  GetResultImageOutput(void)
+  {
+    return dynamic_cast<ResultImageType *>(this->ProcessObject::GetOutput(3));
+  }
+
+  /** Create the outputs, each with its own image type. */
+  using Superclass::MakeOutput;
+  DataObject::Pointer
+  MakeOutput(DataObjectPointerArraySizeType idx) override;
+
+  /** Copy the output information to all outputs. */
+  void
+  GenerateOutputInformation(void) override;
+
+  /** Checking if transform is set, and for the result image, the moving image and
+   * the interpolator. If a linear transformation is used, the constant spatial
+   * Jacobian is computed once here. */
+  void
+  BeforeThreadedGenerateData(void) override;
+
+  /** Compute the Modified Time based on changes to the components. */
+  ModifiedTimeType
+  GetMTime(void) const override;
+
+protected:
+  TransformToDisplacementAndSpatialJacobianSource();
+  ~TransformToDisplacementAndSpatialJacobianSource() override = default;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** Only allocate the buffers of the enabled outputs. */
+  void
+  AllocateOutputs(void) override;
+
+  /** Compute all enabled outputs for a part of the output region. */
+  void
+  ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId) override;
+
+private:
+  TransformToDisplacementAndSpatialJacobianSource(const Self &) = delete;
+  void
+  operator=(const Self &) = delete;
+
+  /** Member variables. */
+  RegionType           m_OutputRegion;    // region of the output images
+  TransformPointerType m_Transform;       // Coordinate transform to use
+  SpacingType          m_OutputSpacing;   // output image spacing
+  OriginType           m_OutputOrigin;    // output image origin
+  DirectionType        m_OutputDirection; // output image direction cosines
+
+  bool m_GenerateDisplacementField{ true };
+  bool m_GenerateDeterminantOfSpatialJacobian{ true };
+  bool m_GenerateSpatialJacobian{ true };
+  bool m_GenerateResultImage{ false };
+
+  /** The moving image, its interpolator, and the value of the result image outside the moving image. */
+  typename ResultImageType::ConstPointer m_MovingImage;
+  InterpolatorPointer                    m_Interpolator;
+  ResultPixelType                        m_DefaultPixelValue{};
+
+  /** The spatial Jacobian of a linear transform, computed once in BeforeThreadedGenerateData(). */
+  bool                m_TransformIsLinear{ false };
+  SpatialJacobianType m_LinearSpatialJacobian;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkTransformToDisplacementAndSpatialJacobianSource.hxx"
+#endif
+
+#endif // end #ifndef itkTransformToDisplacementAndSpatialJacobianSource_h
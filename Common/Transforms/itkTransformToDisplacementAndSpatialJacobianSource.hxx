@@ -0,0 +1,480 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkTransformToDisplacementAndSpatialJacobianSource_hxx
+#define itkTransformToDisplacementAndSpatialJacobianSource_hxx
+
+#include "itkTransformToDisplacementAndSpatialJacobianSource.h"
+
+#include "itkAdvancedIdentityTransform.h"
+#include "itkProgressReporter.h"
+#include "itkImageRegionIterator.h"
+#include "itkIndexRange.h"
+#include "vnl/vnl_copy.h"
+#include "vnl/vnl_det.h"
+
+#include <algorithm> // For min and max.
+
+namespace itk
+{
+
+/**
+ * Constructor
+ */
+template <class TDisplacementFieldImage,
+          class TDeterminantImage,
+          class TSpatialJacobianImage,
+          class TResultImage,
+          class TTransformPrecisionType>
+TransformToDisplacementAndSpatialJacobianSource<TDisplacementFieldImage,
+                                                TDeterminantImage,
+                                                TSpatialJacobianImage,
+                                                TResultImage,
+                                                TTransformPrecisionType>::
+  TransformToDisplacementAndSpatialJacobianSource()
+{
+  this->m_OutputSpacing.Fill(1.0);
+  this->m_OutputOrigin.Fill(0.0);
+  this->m_OutputDirection.SetIdentity();
+
+  SizeType size;
+  size.Fill(0);
+  this->m_OutputRegion.SetSize(size);
+
+  IndexType index;
+  index.Fill(0);
+  this->m_OutputRegion.SetIndex(index);
+
+  this->m_Transform = AdvancedIdentityTransform<TTransformPrecisionType, ImageDimension>::New();
+  this->m_LinearSpatialJacobian.SetIdentity();
+
+  // Check if the spatial Jacobian pixel type is valid
+  const unsigned int pixrow = SpatialJacobianPixelType::RowDimensions;
+  const unsigned int pixcol = SpatialJacobianPixelType::ColumnDimensions;
+  const unsigned int spatrow = SpatialJacobianType::RowDimensions;
+  const unsigned int spatcol = SpatialJacobianType::ColumnDimensions;
+  if ((pixrow != spatrow) || (pixcol != spatcol))
+  {
+    itkExceptionMacro("The specified spatial Jacobian image type is not allowed for this filter");
+  }
+
+  // Output 0 is created by the superclass; the others have different image types.
+  this->SetNumberOfRequiredOutputs(4);
+  this->SetNthOutput(1, this->MakeOutput(1));
+  this->SetNthOutput(2, this->MakeOutput(2));
+  this->SetNthOutput(3, this->MakeOutput(3));
+
+  // Use the classic (ITK4) threading model, to ensure ThreadedGenerateData is being called.
+  this->itk::ImageSource<TDisplacementFieldImage>::DynamicMultiThreadingOff();
+
+} // end Constructor
+
+
+/**
+ * Print out a description of self
+ */
+template <class TDisplacementFieldImage,
+          class TDeterminantImage,
+          class TSpatialJacobianImage,
+          class TResultImage,
+          class TTransformPrecisionType>
+void
+TransformToDisplacementAndSpatialJacobianSource<TDisplacementFieldImage,
+                                                TDeterminantImage,
+                                                TSpatialJacobianImage,
+                                                TResultImage,
+                                                TTransformPrecisionType>::PrintSelf(std::ostream & os,
+                                                                                    Indent         indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "OutputRegion: " << this->m_OutputRegion << std::endl;
+  os << indent << "OutputSpacing: " << this->m_OutputSpacing << std::endl;
+  os << indent << "OutputOrigin: " << this->m_OutputOrigin << std::endl;
+  os << indent << "OutputDirection: " << this->m_OutputDirection << std::endl;
+  os << indent << "Transform: " << this->m_Transform.GetPointer() << std::endl;
+  os << indent << "GenerateDisplacementField: " << this->m_GenerateDisplacementField << std::endl;
+  os << indent << "GenerateDeterminantOfSpatialJacobian: " << this->m_GenerateDeterminantOfSpatialJacobian
+     << std::endl;
+  os << indent << "GenerateSpatialJacobian: " << this->m_GenerateSpatialJacobian << std::endl;
+  os << indent << "GenerateResultImage: " << this->m_GenerateResultImage << std::endl;
+  os << indent << "MovingImage: " << this->m_MovingImage.GetPointer() << std::endl;
+  os << indent << "Interpolator: " << this->m_Interpolator.GetPointer() << std::endl;
+  os << indent << "DefaultPixelValue: " << static_cast<typename NumericTraits<ResultPixelType>::PrintType>(
+                                             this->m_DefaultPixelValue)
+     << std::endl;
+
+} // end PrintSelf()
+
+
+/**
+ * Set the output image size.
+ */
+template <class TDisplacementFieldImage,
+          class TDeterminantImage,
+          class TSpatialJacobianImage,
+          class TResultImage,
+          class TTransformPrecisionType>
+void
+TransformToDisplacementAndSpatialJacobianSource<TDisplacementFieldImage,
+                                                TDeterminantImage,
+                                                TSpatialJacobianImage,
+                                                TResultImage,
+                                                TTransformPrecisionType>::SetOutputSize(const SizeType & size)
+{
+  this->m_OutputRegion.SetSize(size);
+}
+
+
+/**
+ * Set the output image index.
+ */
+template <class TDisplacementFieldImage,
+          class TDeterminantImage,
+          class TSpatialJacobianImage,
+          class TResultImage,
+          class TTransformPrecisionType>
+void
+TransformToDisplacementAndSpatialJacobianSource<TDisplacementFieldImage,
+                                                TDeterminantImage,
+                                                TSpatialJacobianImage,
+                                                TResultImage,
+                                                TTransformPrecisionType>::SetOutputIndex(const IndexType & index)
+{
+  this->m_OutputRegion.SetIndex(index);
+}
+
+
+/**
+ * MakeOutput
+ */
+template <class TDisplacementFieldImage,
+          class TDeterminantImage,
+          class TSpatialJacobianImage,
+          class TResultImage,
+          class TTransformPrecisionType>
+DataObject::Pointer
+TransformToDisplacementAndSpatialJacobianSource<TDisplacementFieldImage,
+                                                TDeterminantImage,
+                                                TSpatialJacobianImage,
+                                                TResultImage,
+                                                TTransformPrecisionType>::MakeOutput(DataObjectPointerArraySizeType idx)
+{
+  switch (idx)
+  {
+    case 1:
+      return DeterminantImageType::New().GetPointer();
+    case 2:
+      return SpatialJacobianImageType::New().GetPointer();
+    case 3:
+      return ResultImageType::New().GetPointer();
+    default:
+      return DisplacementFieldImageType::New().GetPointer();
+  }
+
+} // end MakeOutput()
+
+
+/**
+ * Set up state of filter before multi-threading.
+ */
+template <class TDisplacementFieldImage,
+          class TDeterminantImage,
+          class TSpatialJacobianImage,
+          class TResultImage,
+          class TTransformPrecisionType>
+void
+TransformToDisplacementAndSpatialJacobianSource<TDisplacementFieldImage,
+                                                TDeterminantImage,
+                                                TSpatialJacobianImage,
+                                                TResultImage,
+                                                TTransformPrecisionType>::BeforeThreadedGenerateData(void)
+{
+  if (!this->m_Transform)
+  {
+    itkExceptionMacro(<< "Transform not set");
+  }
+
+  // The result image is interpolated from the moving image.
+  if (this->m_GenerateResultImage)
+  {
+    if (!this->m_MovingImage)
+    {
+      itkExceptionMacro(<< "Moving image not set");
+    }
+    if (!this->m_Interpolator)
+    {
+      itkExceptionMacro(<< "Interpolator not set");
+    }
+    this->m_Interpolator->SetInputImage(this->m_MovingImage);
+  }
+
+  // For linear transformation the spatial derivative is a constant,
+  // i.e. it is independent of the spatial position, so it is computed
+  // only once. The displacement still varies per voxel.
+  this->m_TransformIsLinear = this->m_Transform->IsLinear();
+  if (this->m_TransformIsLinear)
+  {
+    IndexType index;
+    index.Fill(1);
+    PointType point;
+    this->GetOutput()->TransformIndexToPhysicalPoint(index, point);
+    this->m_Transform->GetSpatialJacobian(point, this->m_LinearSpatialJacobian);
+  }
+
+} // end BeforeThreadedGenerateData()
+
+
+/**
+ * AllocateOutputs
+ */
+template <class TDisplacementFieldImage,
+          class TDeterminantImage,
+          class TSpatialJacobianImage,
+          class TResultImage,
+          class TTransformPrecisionType>
+void
+TransformToDisplacementAndSpatialJacobianSource<TDisplacementFieldImage,
+                                                TDeterminantImage,
+                                                TSpatialJacobianImage,
+                                                TResultImage,
+                                                TTransformPrecisionType>::AllocateOutputs(void)
+{
+  const auto allocate = [](ImageBase<ImageDimension> & output) {
+    output.SetBufferedRegion(output.GetRequestedRegion());
+    output.Allocate();
+  };
+
+  if (this->m_GenerateDisplacementField)
+  {
+    allocate(*this->GetDisplacementFieldOutput());
+  }
+  if (this->m_GenerateDeterminantOfSpatialJacobian)
+  {
+    allocate(*this->GetDeterminantOfSpatialJacobianOutput());
+  }
+  if (this->m_GenerateSpatialJacobian)
+  {
+    allocate(*this->GetSpatialJacobianOutput());
+  }
+  if (this->m_GenerateResultImage)
+  {
+    allocate(*this->GetResultImageOutput());
+  }
+
+} // end AllocateOutputs()
+
+
+/**
+ * ThreadedGenerateData
+ */
+template <class TDisplacementFieldImage,
+          class TDeterminantImage,
+          class TSpatialJacobianImage,
+          class TResultImage,
+          class TTransformPrecisionType>
+void
+TransformToDisplacementAndSpatialJacobianSource<TDisplacementFieldImage,
+                                                TDeterminantImage,
+                                                TSpatialJacobianImage,
+                                                TResultImage,
+                                                TTransformPrecisionType>::
+  ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId)
+{
+  const bool generateDisplacement = this->m_GenerateDisplacementField;
+  const bool generateDeterminant = this->m_GenerateDeterminantOfSpatialJacobian;
+  const bool generateSpatialJacobian = this->m_GenerateSpatialJacobian;
+  const bool generateResult = this->m_GenerateResultImage;
+  const bool evaluateSpatialJacobian = (generateDeterminant || generateSpatialJacobian) && !this->m_TransformIsLinear;
+  const bool evaluateMappedPoint = generateDisplacement || generateResult;
+
+  // The output information is shared by all outputs.
+  const DisplacementFieldImageType & geometry = *this->GetOutput();
+
+  // Create iterators that walk the output region for this thread, but only for the enabled outputs.
+  ImageRegionIterator<DisplacementFieldImageType> displacementIt;
+  ImageRegionIterator<DeterminantImageType>       determinantIt;
+  ImageRegionIterator<SpatialJacobianImageType>   spatialJacobianIt;
+  ImageRegionIterator<ResultImageType>            resultIt;
+  if (generateDisplacement)
+  {
+    displacementIt = ImageRegionIterator<DisplacementFieldImageType>(this->GetDisplacementFieldOutput(),
+                                                                     outputRegionForThread);
+  }
+  if (generateDeterminant)
+  {
+    determinantIt =
+      ImageRegionIterator<DeterminantImageType>(this->GetDeterminantOfSpatialJacobianOutput(), outputRegionForThread);
+  }
+  if (generateSpatialJacobian)
+  {
+    spatialJacobianIt =
+      ImageRegionIterator<SpatialJacobianImageType>(this->GetSpatialJacobianOutput(), outputRegionForThread);
+  }
+  if (generateResult)
+  {
+    resultIt = ImageRegionIterator<ResultImageType>(this->GetResultImageOutput(), outputRegionForThread);
+  }
+
+  // As in the ResampleImageFilter, interpolated values are clamped to the range of the result pixel type.
+  typedef typename InterpolatorType::OutputType          InterpolatorOutputType;
+  typedef typename InterpolatorType::ContinuousIndexType ContinuousIndexType;
+  const InterpolatorOutputType minimumResultValue = NumericTraits<ResultPixelType>::NonpositiveMin();
+  const InterpolatorOutputType maximumResultValue = NumericTraits<ResultPixelType>::max();
+
+  // Support for progress methods/callbacks
+  ProgressReporter progress(this, threadId, outputRegionForThread.GetNumberOfPixels());
+
+  PointType                point;
+  TransformOutputPointType mappedPoint;
+  ContinuousIndexType      movingIndex;
+  SpatialJacobianType      sj = this->m_LinearSpatialJacobian;
+  DisplacementPixelType    displacement;
+  SpatialJacobianPixelType sjOut;
+  const unsigned int       nrElements = sj.GetVnlMatrix().size();
+
+  // Walk the output region, in the same order as the region iterators.
+  for (const IndexType & index : ImageRegionIndexRange<ImageDimension>(outputRegionForThread))
+  {
+    // Determine the coordinates of the current voxel
+    geometry.TransformIndexToPhysicalPoint(index, point);
+
+    // Evaluate the transformed point and the spatial Jacobian with a single call of the transform.
+    if (evaluateSpatialJacobian && evaluateMappedPoint)
+    {
+      this->m_Transform->TransformPointAndGetSpatialJacobian(point, mappedPoint, sj);
+    }
+    else if (evaluateSpatialJacobian)
+    {
+      this->m_Transform->GetSpatialJacobian(point, sj);
+    }
+    else if (evaluateMappedPoint)
+    {
+      mappedPoint = this->m_Transform->TransformPoint(point);
+    }
+
+    if (generateDisplacement)
+    {
+      for (unsigned int i = 0; i < ImageDimension; ++i)
+      {
+        displacement[i] = static_cast<typename DisplacementPixelType::ValueType>(mappedPoint[i] - point[i]);
+      }
+      displacementIt.Set(displacement);
+      ++displacementIt;
+    }
+
+    if (generateDeterminant)
+    {
+      determinantIt.Set(static_cast<DeterminantPixelType>(vnl_det(sj.GetVnlMatrix())));
+      ++determinantIt;
+    }
+
+    if (generateSpatialJacobian)
+    {
+      // cast spatial jacobian to output pixel type
+      vnl_copy(sj.GetVnlMatrix().begin(), sjOut.GetVnlMatrix().begin(), nrElements);
+      spatialJacobianIt.Set(sjOut);
+      ++spatialJacobianIt;
+    }
+
+    if (generateResult)
+    {
+      // Interpolate the moving image at the double precision mapped point.
+      this->m_MovingImage->TransformPhysicalPointToContinuousIndex(mappedPoint, movingIndex);
+      if (this->m_Interpolator->IsInsideBuffer(movingIndex))
+      {
+        const InterpolatorOutputType value = this->m_Interpolator->EvaluateAtContinuousIndex(movingIndex);
+        resultIt.Set(static_cast<ResultPixelType>(std::min(std::max(value, minimumResultValue), maximumResultValue)));
+      }
+      else
+      {
+        resultIt.Set(this->m_DefaultPixelValue);
+      }
+      ++resultIt;
+    }
+
+    progress.CompletedPixel();
+  }
+
+} // end ThreadedGenerateData()
+
+
+/**
+ * Inform pipeline of required output region
+ */
+template <class TDisplacementFieldImage,
+          class TDeterminantImage,
+          class TSpatialJacobianImage,
+          class TResultImage,
+          class TTransformPrecisionType>
+void
+TransformToDisplacementAndSpatialJacobianSource<TDisplacementFieldImage,
+                                                TDeterminantImage,
+                                                TSpatialJacobianImage,
+                                                TResultImage,
+                                                TTransformPrecisionType>::GenerateOutputInformation(void)
+{
+  // call the superclass' implementation of this method
+  Superclass::GenerateOutputInformation();
+
+  for (unsigned int i = 0; i < this->GetNumberOfIndexedOutputs(); ++i)
+  {
+    auto * const outputPtr = dynamic_cast<ImageBase<ImageDimension> *>(this->ProcessObject::GetOutput(i));
+    if (outputPtr)
+    {
+      outputPtr->SetLargestPossibleRegion(this->m_OutputRegion);
+      outputPtr->SetSpacing(this->m_OutputSpacing);
+      outputPtr->SetOrigin(this->m_OutputOrigin);
+      outputPtr->SetDirection(this->m_OutputDirection);
+    }
+  }
+
+} // end GenerateOutputInformation()
+
+
+/**
+ * Verify if any of the components has been modified.
+ */
+template <class TDisplacementFieldImage,
+          class TDeterminantImage,
+          class TSpatialJacobianImage,
+          class TResultImage,
+          class TTransformPrecisionType>
+ModifiedTimeType
+TransformToDisplacementAndSpatialJacobianSource<TDisplacementFieldImage,
+                                                TDeterminantImage,
+                                                TSpatialJacobianImage,
+                                                TResultImage,
+                                                TTransformPrecisionType>::GetMTime(void) const
+{
+  ModifiedTimeType latestTime = Object::GetMTime();
+
+  if (this->m_Transform)
+  {
+    if (latestTime < this->m_Transform->GetMTime())
+    {
+      latestTime = this->m_Transform->GetMTime();
+    }
+  }
+
+  return latestTime;
+} // end GetMTime()
+
+
+} // end namespace itk
+
+#endif // end #ifndef itkTransformToDisplacementAndSpatialJacobianSource_hxx
@@ -22,6 +22,9 @@
 #include "itkImageRandomSamplerBase.h"
 #include "itkImageRandomCoordinateSampler.h"
 #include "itkScaledSingleValuedNonLinearOptimizer.h"
+#include "itkPlatformMultiThreader.h"
+#include <cstdint>
+#include <vector>
 
 namespace itk
 {
@@ -31,6 +34,13 @@ namespace itk
  * More specifically this class computes the Jacobian terms related to the automatic
  * parameter estimation for the adaptive stochastic gradient descent optimizer.
  * Details can be found in the paper.
+ *
+ * By default the terms are computed multi-threaded. The covariance matrix is then
+ * accumulated per thread as a list of (row, column, value) triplets, which is sorted
+ * and reduced from time to time, and finally merged into a sparse matrix that is
+ * stored in compressed sparse row (CSR) format, one block of rows per thread.
+ * The band structure estimation (MaxBandCovSize, NumberOfBandStructureSamples)
+ * is only used by the single-threaded computation.
  */
 
 template <class TFixedImage, class TTransform>
@@ -100,13 +110,33 @@ public:
   /** Get the region over which the metric will be computed. */
   itkGetConstReferenceMacro(FixedImageRegion, FixedImageRegionType);
 
+  /** Set/Get whether to use the multi-threaded computation. The default is true. */
+  itkSetMacro(UseMultiThread, bool);
+  itkGetConstMacro(UseMultiThread, bool);
+
+  /** Set the number of threads. */
+  void
+  SetNumberOfWorkUnits(ThreadIdType numberOfThreads)
+  {
+    this->m_Threader->SetNumberOfWorkUnits(numberOfThreads);
+  }
+
+
   /** The main functions that performs the computation. */
   virtual void
   Compute(double & TrC, double & TrCC, double & maxJJ, double & maxJCJ);
 
+  /** The main function that performs the single-threaded computation. */
+  virtual void
+  ComputeSingleThreaded(double & TrC, double & TrCC, double & maxJJ, double & maxJCJ);
+
 protected:
   ComputeJacobianTerms();
-  ~ComputeJacobianTerms() override = default;
+  ~ComputeJacobianTerms() override;
+
+  /** Typedefs for multi-threading. */
+  typedef itk::PlatformMultiThreader ThreaderType;
+  typedef ThreaderType::WorkUnitInfo ThreadInfoType;
 
   typename FixedImageType::ConstPointer m_FixedImage;
   FixedImageRegionType                  m_FixedImageRegion;
@@ -140,12 +170,98 @@ protected:
   typedef typename TransformType::ScalarType             CoordinateRepresentationType;
   typedef typename TransformType::NumberOfParametersType NumberOfParametersType;
 
+  /** Typedefs for the covariance matrix. A triplet stores the value of element (p,q)
+   * of the covariance matrix, with key p * NumberOfParameters + q.
+   */
+  typedef double                                        CovarianceValueType;
+  typedef Array2D<CovarianceValueType>                  CovarianceMatrixType;
+  typedef std::pair<std::uint64_t, CovarianceValueType> CovarianceTripletType;
+  typedef std::vector<CovarianceTripletType>            CovarianceTripletContainerType;
+
   /** Sample the fixed image to compute the Jacobian terms. */
   // \todo: note that this is an exact copy of itk::ComputeDisplacementDistribution
   // in the future it would be better to refactoring this part of the code.
   virtual void
   SampleFixedImageForJacobianTerms(ImageSampleContainerPointer & sampleContainer);
 
+  /** Launch the threads, which all call the given callback function. */
+  void
+  LaunchThreaderCallback(ThreadFunctionType callback) const;
+
+  /** Threader callback functions for the three stages of the multi-threaded computation. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  AccumulateCovarianceThreaderCallback(void * arg);
+
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  MergeCovarianceThreaderCallback(void * arg);
+
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  ComputeMaxTermsThreaderCallback(void * arg);
+
+  /** Accumulate the upper triangle of C = 1/n \sum_i J_i^T J_i over the samples of this thread. */
+  virtual void
+  ThreadedAccumulateCovariance(ThreadIdType threadId);
+
+  /** Merge the triplets of all threads for the block of rows of this thread, and compute its TrC and TrCC. */
+  virtual void
+  ThreadedMergeCovariance(ThreadIdType threadId);
+
+  /** Compute maxJJ and maxJCJ over the samples of this thread. */
+  virtual void
+  ThreadedComputeMaxTerms(ThreadIdType threadId);
+
+  /** Initialize some multi-threading related parameters. */
+  virtual void
+  InitializeThreadingParameters(void);
+
+  /** Add the upper triangle of jactjac / n to the triplets. */
+  void
+  AddToCovarianceTriplets(const CovarianceMatrixType &       jactjac,
+                          const NonZeroJacobianIndicesType & jacind,
+                          const double                       n,
+                          CovarianceTripletContainerType &   triplets) const;
+
+  /** Sort the triplets on their key, and sum the values of equal keys. */
+  static void
+  CompactCovarianceTriplets(CovarianceTripletContainerType & triplets);
+
+  /** To give the threads access to all member variables and functions. */
+  struct MultiThreaderParameterType
+  {
+    Self * st_Self;
+  };
+  mutable MultiThreaderParameterType m_ThreaderParameters;
+
+  struct ComputePerThreadStruct
+  {
+    /**  Used for accumulating variables. */
+    CovarianceTripletContainerType st_Triplets;
+    double                         st_MaxJJ;
+    double                         st_MaxJCJ;
+  };
+  itkPadStruct(ITK_CACHE_LINE_ALIGNMENT, ComputePerThreadStruct, PaddedComputePerThreadStruct);
+  itkAlignedTypedef(ITK_CACHE_LINE_ALIGNMENT, PaddedComputePerThreadStruct, AlignedComputePerThreadStruct);
+  AlignedComputePerThreadStruct * m_ComputePerThreadVariables;
+  ThreadIdType                    m_ComputePerThreadVariablesSize;
+
+  /** A block of consecutive rows of the upper triangle of the covariance matrix, in CSR format. */
+  struct CovarianceRowBlockType
+  {
+    std::vector<SizeValueType>       st_RowPointers;
+    std::vector<unsigned int>        st_Columns;
+    std::vector<CovarianceValueType> st_Values;
+    double                           st_TrC;
+    double                           st_TrCC;
+  };
+
+  bool                                m_UseMultiThread;
+  ThreaderType::Pointer               m_Threader;
+  ImageSampleContainerPointer         m_SampleContainer;
+  unsigned int                        m_NumberOfParameters;
+  unsigned int                        m_NumberOfRowsPerBlock;
+  std::vector<CovarianceRowBlockType> m_CovarianceRowBlocks;
+  std::vector<CovarianceValueType>    m_DiagonalCovariance;
+
 private:
   ComputeJacobianTerms(const Self &) = delete;
   void
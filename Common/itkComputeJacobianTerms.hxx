@@ -24,6 +24,7 @@
 #include "vnl/vnl_fastops.h"
 #include "vnl/vnl_diag_matrix.h"
 #include "vnl/vnl_sparse_matrix.h"
+#include <algorithm>
 
 namespace itk
 {
@@ -44,9 +45,69 @@ ComputeJacobianTerms<TFixedImage, TTransform>::ComputeJacobianTerms()
   this->m_NumberOfBandStructureSamples = 0;
   this->m_NumberOfJacobianMeasurements = 0;
 
+  /** Threading related variables. */
+  this->m_UseMultiThread = true;
+  this->m_Threader = ThreaderType::New();
+  this->m_NumberOfParameters = 0;
+  this->m_NumberOfRowsPerBlock = 0;
+
+  /** Initialize the m_ThreaderParameters. */
+  this->m_ThreaderParameters.st_Self = this;
+
+  // Multi-threading structs
+  this->m_ComputePerThreadVariables = nullptr;
+  this->m_ComputePerThreadVariablesSize = 0;
+
 } // end Constructor
 
 
+/**
+ * ************************* Destructor ************************
+ */
+
+template <class TFixedImage, class TTransform>
+ComputeJacobianTerms<TFixedImage, TTransform>::~ComputeJacobianTerms()
+{
+  delete[] this->m_ComputePerThreadVariables;
+} // end Destructor
+
+
+/**
+ * ************************* InitializeThreadingParameters ************************
+ */
+
+template <class TFixedImage, class TTransform>
+void
+ComputeJacobianTerms<TFixedImage, TTransform>::InitializeThreadingParameters(void)
+{
+  const ThreadIdType numberOfThreads = this->m_Threader->GetNumberOfWorkUnits();
+
+  /** Only resize the array of structs when needed. */
+  if (this->m_ComputePerThreadVariablesSize != numberOfThreads)
+  {
+    delete[] this->m_ComputePerThreadVariables;
+    this->m_ComputePerThreadVariables = new AlignedComputePerThreadStruct[numberOfThreads];
+    this->m_ComputePerThreadVariablesSize = numberOfThreads;
+  }
+
+  /** Some initialization. */
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    this->m_ComputePerThreadVariables[i].st_Triplets.clear();
+    this->m_ComputePerThreadVariables[i].st_MaxJJ = NumericTraits<double>::Zero;
+    this->m_ComputePerThreadVariables[i].st_MaxJCJ = NumericTraits<double>::Zero;
+  }
+
+  /** Each thread merges the covariance matrix for one block of rows. */
+  const unsigned int P = this->m_NumberOfParameters;
+  this->m_NumberOfRowsPerBlock = std::max(
+    1u, static_cast<unsigned int>(std::ceil(static_cast<double>(P) / static_cast<double>(numberOfThreads))));
+  this->m_CovarianceRowBlocks.assign(numberOfThreads, CovarianceRowBlockType());
+  this->m_DiagonalCovariance.assign(P, 0.0);
+
+} // end InitializeThreadingParameters()
+
+
 /**
  * ************************* Compute ************************
  */
@@ -55,6 +116,565 @@ template <class TFixedImage, class TTransform>
 void
 ComputeJacobianTerms<TFixedImage, TTransform>::Compute(double & TrC, double & TrCC, double & maxJJ, double & maxJCJ)
 {
+  /** Option to still use the single-threaded code. */
+  if (!this->m_UseMultiThread)
+  {
+    return this->ComputeSingleThreaded(TrC, TrCC, maxJJ, maxJCJ);
+  }
+
+  /** Initialize. */
+  TrC = TrCC = maxJJ = maxJCJ = 0.0;
+
+  /** Get samples and the number of parameters. */
+  this->SampleFixedImageForJacobianTerms(this->m_SampleContainer);
+  this->m_NumberOfParameters = static_cast<unsigned int>(this->m_Transform->GetNumberOfParameters());
+
+  /** Initialize multi-threading. */
+  this->InitializeThreadingParameters();
+  const ThreadIdType numberOfThreads = this->m_Threader->GetNumberOfWorkUnits();
+
+  /**
+   *    TERM 1 and 2
+   *
+   * Every thread accumulates C = 1/n \sum_i J_i^T J_i over its own samples.
+   * Then every thread merges the contributions of all threads for its own
+   * block of rows, and computes the TrC and TrCC of that block.
+   */
+  this->LaunchThreaderCallback(this->AccumulateCovarianceThreaderCallback);
+  this->LaunchThreaderCallback(this->MergeCovarianceThreaderCallback);
+
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    CovarianceTripletContainerType().swap(this->m_ComputePerThreadVariables[i].st_Triplets);
+    TrC += this->m_CovarianceRowBlocks[i].st_TrC;
+    TrCC += this->m_CovarianceRowBlocks[i].st_TrCC;
+  }
+
+  /**
+   *    TERM 3 and 4
+   *
+   * Every thread computes maxJJ and maxJCJ over its own samples.
+   */
+  this->LaunchThreaderCallback(this->ComputeMaxTermsThreaderCallback);
+
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    maxJJ = std::max(maxJJ, this->m_ComputePerThreadVariables[i].st_MaxJJ);
+    maxJCJ = std::max(maxJCJ, this->m_ComputePerThreadVariables[i].st_MaxJCJ);
+  }
+
+  /** Release the memory of the covariance matrix and the samples. */
+  std::vector<CovarianceRowBlockType>().swap(this->m_CovarianceRowBlocks);
+  std::vector<CovarianceValueType>().swap(this->m_DiagonalCovariance);
+  this->m_SampleContainer = nullptr;
+
+} // end Compute()
+
+
+/**
+ * *********************** LaunchThreaderCallback***************
+ */
+
+template <class TFixedImage, class TTransform>
+void
+ComputeJacobianTerms<TFixedImage, TTransform>::LaunchThreaderCallback(ThreadFunctionType callback) const
+{
+  /** Setup threader. */
+  this->m_Threader->SetSingleMethod(callback,
+                                    const_cast<void *>(static_cast<const void *>(&this->m_ThreaderParameters)));
+
+  /** Launch. */
+  this->m_Threader->SingleMethodExecute();
+
+} // end LaunchThreaderCallback()
+
+
+/**
+ * ************ AccumulateCovarianceThreaderCallback ****************************
+ */
+
+template <class TFixedImage, class TTransform>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+ComputeJacobianTerms<TFixedImage, TTransform>::AccumulateCovarianceThreaderCallback(void * arg)
+{
+  /** Get the current thread id and user data. */
+  ThreadInfoType *             infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType                 threadID = infoStruct->WorkUnitID;
+  MultiThreaderParameterType * temp = static_cast<MultiThreaderParameterType *>(infoStruct->UserData);
+
+  /** Call the real implementation. */
+  temp->st_Self->ThreadedAccumulateCovariance(threadID);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end AccumulateCovarianceThreaderCallback()
+
+
+/**
+ * ************ MergeCovarianceThreaderCallback ****************************
+ */
+
+template <class TFixedImage, class TTransform>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+ComputeJacobianTerms<TFixedImage, TTransform>::MergeCovarianceThreaderCallback(void * arg)
+{
+  /** Get the current thread id and user data. */
+  ThreadInfoType *             infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType                 threadID = infoStruct->WorkUnitID;
+  MultiThreaderParameterType * temp = static_cast<MultiThreaderParameterType *>(infoStruct->UserData);
+
+  /** Call the real implementation. */
+  temp->st_Self->ThreadedMergeCovariance(threadID);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end MergeCovarianceThreaderCallback()
+
+
+/**
+ * ************ ComputeMaxTermsThreaderCallback ****************************
+ */
+
+template <class TFixedImage, class TTransform>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+ComputeJacobianTerms<TFixedImage, TTransform>::ComputeMaxTermsThreaderCallback(void * arg)
+{
+  /** Get the current thread id and user data. */
+  ThreadInfoType *             infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType                 threadID = infoStruct->WorkUnitID;
+  MultiThreaderParameterType * temp = static_cast<MultiThreaderParameterType *>(infoStruct->UserData);
+
+  /** Call the real implementation. */
+  temp->st_Self->ThreadedComputeMaxTerms(threadID);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ComputeMaxTermsThreaderCallback()
+
+
+/**
+ * ************************* AddToCovarianceTriplets ************************
+ */
+
+template <class TFixedImage, class TTransform>
+void
+ComputeJacobianTerms<TFixedImage, TTransform>::AddToCovarianceTriplets(
+  const CovarianceMatrixType &       jactjac,
+  const NonZeroJacobianIndicesType & jacind,
+  const double                       n,
+  CovarianceTripletContainerType &   triplets) const
+{
+  const std::uint64_t P = this->m_NumberOfParameters;
+  const unsigned int  sizejacind = static_cast<unsigned int>(jacind.size());
+
+  for (unsigned int pi = 0; pi < sizejacind; ++pi)
+  {
+    const std::uint64_t p = jacind[pi];
+    for (unsigned int qi = 0; qi < sizejacind; ++qi)
+    {
+      const std::uint64_t q = jacind[qi];
+      if (q >= p)
+      {
+        const double tempval = jactjac(pi, qi) / n;
+        if (std::abs(tempval) > 1e-14)
+        {
+          triplets.push_back(CovarianceTripletType(p * P + q, tempval));
+        }
+      }
+    } // qi
+  }   // pi
+
+} // end AddToCovarianceTriplets()
+
+
+/**
+ * ************************* CompactCovarianceTriplets ************************
+ */
+
+template <class TFixedImage, class TTransform>
+void
+ComputeJacobianTerms<TFixedImage, TTransform>::CompactCovarianceTriplets(CovarianceTripletContainerType & triplets)
+{
+  if (triplets.empty())
+  {
+    return;
+  }
+
+  std::sort(triplets.begin(),
+            triplets.end(),
+            [](const CovarianceTripletType & a, const CovarianceTripletType & b) { return a.first < b.first; });
+
+  /** Sum the values of equal keys. */
+  std::size_t last = 0;
+  for (std::size_t i = 1; i < triplets.size(); ++i)
+  {
+    if (triplets[i].first == triplets[last].first)
+    {
+      triplets[last].second += triplets[i].second;
+    }
+    else
+    {
+      triplets[++last] = triplets[i];
+    }
+  }
+  triplets.resize(last + 1);
+
+} // end CompactCovarianceTriplets()
+
+
+/**
+ * ************************* ThreadedAccumulateCovariance ************************
+ */
+
+template <class TFixedImage, class TTransform>
+void
+ComputeJacobianTerms<TFixedImage, TTransform>::ThreadedAccumulateCovariance(ThreadIdType threadId)
+{
+  /** Get sample container size, number of threads, and output space dimension. */
+  const SizeValueType sampleContainerSize = this->m_SampleContainer->Size();
+  const ThreadIdType  numberOfThreads = this->m_Threader->GetNumberOfWorkUnits();
+  const unsigned int  outdim = this->m_Transform->GetOutputSpaceDimension();
+  const double        n = static_cast<double>(sampleContainerSize);
+
+  /** Get the samples for this thread. */
+  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
+    std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(numberOfThreads)));
+
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end = nrOfSamplesPerThreads * (threadId + 1);
+  pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
+  pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
+
+  /** Variables for nonzerojacobian indices and the Jacobian. */
+  const NumberOfParametersType sizejacind = this->m_Transform->GetNumberOfNonZeroJacobianIndices();
+  JacobianType                 jacj(outdim, sizejacind);
+  jacj.Fill(0.0);
+  NonZeroJacobianIndicesType jacind(sizejacind);
+  NonZeroJacobianIndicesType prevjacind(sizejacind);
+
+  /** For temporary storage of J'J, summed over consecutive samples with the same nonzero Jacobian indices. */
+  CovarianceMatrixType jactjac(sizejacind, sizejacind);
+  jactjac.Fill(0.0);
+  bool jactjacIsInitialized = false;
+
+  /** The triplets are compacted whenever their number has doubled, which bounds
+   * the memory use by about twice the number of nonzero elements of C that this
+   * thread contributes to.
+   */
+  CovarianceTripletContainerType & triplets = this->m_ComputePerThreadVariables[threadId].st_Triplets;
+  std::size_t                      compactionSize = 1 << 20;
+
+  /** Create iterator over the sample container. */
+  typename ImageSampleContainerType::ConstIterator threader_fiter;
+  typename ImageSampleContainerType::ConstIterator threader_fbegin = this->m_SampleContainer->Begin();
+  typename ImageSampleContainerType::ConstIterator threader_fend = this->m_SampleContainer->Begin();
+
+  threader_fbegin += (int)pos_begin;
+  threader_fend += (int)pos_end;
+
+  for (threader_fiter = threader_fbegin; threader_fiter != threader_fend; ++threader_fiter)
+  {
+    /** Read fixed coordinates and get Jacobian J_j. */
+    const FixedImagePointType & point = (*threader_fiter).Value().m_ImageCoordinates;
+    this->m_Transform->GetJacobian(point, jacj, jacind);
+
+    /** Skip invalid Jacobians, if any. */
+    if (sizejacind > 1)
+    {
+      if (jacind[0] == jacind[1])
+      {
+        continue;
+      }
+    }
+
+    if (jactjacIsInitialized && jacind == prevjacind)
+    {
+      /** Update sum of J_j^T J_j. */
+      vnl_fastops::inc_X_by_AtA(jactjac, jacj);
+    }
+    else
+    {
+      if (jactjacIsInitialized)
+      {
+        this->AddToCovarianceTriplets(jactjac, prevjacind, n, triplets);
+        if (triplets.size() > compactionSize)
+        {
+          CompactCovarianceTriplets(triplets);
+          compactionSize = std::max(compactionSize, 2 * triplets.size());
+        }
+      }
+
+      /** Initialize jactjac by J_j^T J_j. */
+      vnl_fastops::AtA(jactjac, jacj);
+      jactjacIsInitialized = true;
+
+      /** Remember nonzerojacobian indices. */
+      prevjacind = jacind;
+    }
+  } // end loop over sample container
+
+  /** Include the last jactjac updates. */
+  if (jactjacIsInitialized)
+  {
+    this->AddToCovarianceTriplets(jactjac, prevjacind, n, triplets);
+  }
+  CompactCovarianceTriplets(triplets);
+
+} // end ThreadedAccumulateCovariance()
+
+
+/**
+ * ************************* ThreadedMergeCovariance ************************
+ */
+
+template <class TFixedImage, class TTransform>
+void
+ComputeJacobianTerms<TFixedImage, TTransform>::ThreadedMergeCovariance(ThreadIdType threadId)
+{
+  const ThreadIdType  numberOfThreads = this->m_Threader->GetNumberOfWorkUnits();
+  const unsigned int  P = this->m_NumberOfParameters;
+  const ScalesType &  scales = this->m_Scales;
+  const std::uint64_t rowBegin =
+    std::min<std::uint64_t>(P, static_cast<std::uint64_t>(this->m_NumberOfRowsPerBlock) * threadId);
+  const std::uint64_t rowEnd = std::min<std::uint64_t>(P, rowBegin + this->m_NumberOfRowsPerBlock);
+
+  /** Collect the triplets of all threads within this block of rows.
+   * The triplets of each thread are sorted on their key, which is p * P + q.
+   */
+  const auto keyIsLess = [](const CovarianceTripletType & a, const CovarianceTripletType & b) {
+    return a.first < b.first;
+  };
+  const CovarianceTripletType    tripletBegin(rowBegin * P, 0.0);
+  const CovarianceTripletType    tripletEnd(rowEnd * P, 0.0);
+  CovarianceTripletContainerType triplets;
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    const CovarianceTripletContainerType & threadTriplets = this->m_ComputePerThreadVariables[i].st_Triplets;
+    const auto first = std::lower_bound(threadTriplets.begin(), threadTriplets.end(), tripletBegin, keyIsLess);
+    const auto last = std::lower_bound(first, threadTriplets.end(), tripletEnd, keyIsLess);
+    triplets.insert(triplets.end(), first, last);
+  }
+  CompactCovarianceTriplets(triplets);
+
+  /** Store the block in CSR format, apply the scales, and compute TrC and TrCC.
+   * As in the single-threaded code, TrCC = 2 * sum of the squared elements of the
+   * upper triangle, minus the sum of the squared diagonal elements.
+   */
+  CovarianceRowBlockType & block = this->m_CovarianceRowBlocks[threadId];
+  block.st_RowPointers.assign(rowEnd - rowBegin + 1, 0);
+  block.st_Columns.resize(triplets.size());
+  block.st_Values.resize(triplets.size());
+  block.st_TrC = 0.0;
+  block.st_TrCC = 0.0;
+
+  for (std::size_t k = 0; k < triplets.size(); ++k)
+  {
+    const unsigned int  p = static_cast<unsigned int>(triplets[k].first / P);
+    const unsigned int  q = static_cast<unsigned int>(triplets[k].first % P);
+    CovarianceValueType value = triplets[k].second;
+    if (this->m_UseScales)
+    {
+      value /= scales[p] * scales[q];
+    }
+
+    ++block.st_RowPointers[p - rowBegin + 1];
+    block.st_Columns[k] = q;
+    block.st_Values[k] = value;
+
+    block.st_TrCC += 2.0 * vnl_math::sqr(value);
+    if (p == q)
+    {
+      block.st_TrC += value;
+      block.st_TrCC -= vnl_math::sqr(value);
+      this->m_DiagonalCovariance[p] = value;
+    }
+  }
+
+  /** Convert the number of elements per row to row pointers. */
+  for (std::size_t r = 1; r < block.st_RowPointers.size(); ++r)
+  {
+    block.st_RowPointers[r] += block.st_RowPointers[r - 1];
+  }
+
+} // end ThreadedMergeCovariance()
+
+
+/**
+ * ************************* ThreadedComputeMaxTerms ************************
+ */
+
+template <class TFixedImage, class TTransform>
+void
+ComputeJacobianTerms<TFixedImage, TTransform>::ThreadedComputeMaxTerms(ThreadIdType threadId)
+{
+  typedef vnl_diag_matrix<CovarianceValueType> DiagCovarianceMatrixType;
+
+  /** Get sample container size, number of threads, and output space dimension. */
+  const SizeValueType sampleContainerSize = this->m_SampleContainer->Size();
+  const ThreadIdType  numberOfThreads = this->m_Threader->GetNumberOfWorkUnits();
+  const unsigned int  outdim = this->m_Transform->GetOutputSpaceDimension();
+  const unsigned int  P = this->m_NumberOfParameters;
+  const unsigned int  rowsPerBlock = this->m_NumberOfRowsPerBlock;
+  const ScalesType &  scales = this->m_Scales;
+
+  /** Get the samples for this thread. */
+  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
+    std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(numberOfThreads)));
+
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end = nrOfSamplesPerThreads * (threadId + 1);
+  pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
+  pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
+
+  /** Variables for nonzerojacobian indices and the Jacobian. */
+  const NumberOfParametersType sizejacind = this->m_Transform->GetNumberOfNonZeroJacobianIndices();
+  JacobianType                 jacj(outdim, sizejacind);
+  jacj.Fill(0.0);
+  NonZeroJacobianIndicesType jacind(sizejacind);
+
+  /** Temporaries. */
+  const double             sqrt2 = std::sqrt(static_cast<double>(2.0));
+  JacobianType             jacjjacj(outdim, outdim);
+  JacobianType             jacjcov(outdim, sizejacind);
+  DiagCovarianceMatrixType diagcovsparse(sizejacind);
+  JacobianType             jacjdiagcov(outdim, sizejacind);
+  JacobianType             jacjdiagcovjacj(outdim, outdim);
+  JacobianType             jacjcovjacj(outdim, outdim);
+  double                   maxJJ = 0.0;
+  double                   maxJCJ = 0.0;
+
+  /** Maps a parameter number to its position in jacind, or to sizejacind if it is not in there.
+   * Only the elements that are set for a sample are reset afterwards.
+   */
+  std::vector<unsigned int> jacindExpanded(P, static_cast<unsigned int>(sizejacind));
+
+  /** Create iterator over the sample container. */
+  typename ImageSampleContainerType::ConstIterator threader_fiter;
+  typename ImageSampleContainerType::ConstIterator threader_fbegin = this->m_SampleContainer->Begin();
+  typename ImageSampleContainerType::ConstIterator threader_fend = this->m_SampleContainer->Begin();
+
+  threader_fbegin += (int)pos_begin;
+  threader_fend += (int)pos_end;
+
+  for (threader_fiter = threader_fbegin; threader_fiter != threader_fend; ++threader_fiter)
+  {
+    /** Read fixed coordinates and get Jacobian. */
+    const FixedImagePointType & point = (*threader_fiter).Value().m_ImageCoordinates;
+    this->m_Transform->GetJacobian(point, jacj, jacind);
+
+    /** Apply scales, if necessary. */
+    if (this->m_UseScales)
+    {
+      for (unsigned int pi = 0; pi < sizejacind; ++pi)
+      {
+        const unsigned int p = jacind[pi];
+        jacj.scale_column(pi, 1.0 / scales[p]);
+      }
+    }
+
+    /** Compute 1st part of JJ: ||J_j||_F^2. */
+    double JJ_j = vnl_math::sqr(jacj.frobenius_norm());
+
+    /** Compute 2nd part of JJ: 2\sqrt{2} || J_j J_j^T ||_F. */
+    vnl_fastops::ABt(jacjjacj, jacj, jacj);
+    JJ_j += 2.0 * sqrt2 * jacjjacj.frobenius_norm();
+
+    /** Max_j [JJ_j]. */
+    maxJJ = std::max(maxJJ, JJ_j);
+
+    /** Compute JCJ_j. */
+    double JCJ_j = 0.0;
+
+    /** J_j C = jacjC. */
+    jacjcov.Fill(0.0);
+
+    /** Store the nonzero Jacobian indices in a different format
+     * and create the sparse diagcov.
+     */
+    for (unsigned int pi = 0; pi < sizejacind; ++pi)
+    {
+      const unsigned int p = jacind[pi];
+      jacindExpanded[p] = pi;
+      diagcovsparse[pi] = this->m_DiagonalCovariance[p];
+    }
+
+    /** We below calculate jacjC = J_j cov^T, but later we will correct
+     * for this using:
+     * J C J' = J (cov + cov' - diag(cov')) J'.
+     * (NB: cov contains only the upper triangular part of C)
+     */
+    for (unsigned int pi = 0; pi < sizejacind; ++pi)
+    {
+      const unsigned int             p = jacind[pi];
+      const CovarianceRowBlockType & block = this->m_CovarianceRowBlocks[p / rowsPerBlock];
+      const unsigned int             row = p % rowsPerBlock;
+
+      /** Loop over row p of the sparse cov matrix. */
+      for (SizeValueType k = block.st_RowPointers[row]; k < block.st_RowPointers[row + 1]; ++k)
+      {
+        const unsigned int qi = jacindExpanded[block.st_Columns[k]];
+
+        if (qi < sizejacind)
+        {
+          /** If found, update the jacjC matrix. */
+          const CovarianceValueType covElement = block.st_Values[k];
+          for (unsigned int dx = 0; dx < outdim; ++dx)
+          {
+            jacjcov[dx][pi] += jacj[dx][qi] * covElement;
+          } // dx
+        }   // if qi < sizejacind
+      }     // for covrow
+    }       // pi
+
+    /** Reset the expanded nonzero Jacobian indices. */
+    for (unsigned int pi = 0; pi < sizejacind; ++pi)
+    {
+      jacindExpanded[jacind[pi]] = static_cast<unsigned int>(sizejacind);
+    }
+
+    /** J_j C J_j^T  = jacjCjacj.
+     * But note that we actually compute J_j cov' J_j^T
+     */
+    vnl_fastops::ABt(jacjcovjacj, jacjcov, jacj);
+
+    /** jacjCjacj = jacjCjacj+ jacjCjacj' - jacjdiagcovjacj */
+    jacjdiagcov = jacj * diagcovsparse;
+    vnl_fastops::ABt(jacjdiagcovjacj, jacjdiagcov, jacj);
+    jacjcovjacj += jacjcovjacj.transpose();
+    jacjcovjacj -= jacjdiagcovjacj;
+
+    /** Compute 1st part of JCJ: Tr( J_j C J_j^T ). */
+    for (unsigned int d = 0; d < outdim; ++d)
+    {
+      JCJ_j += jacjcovjacj[d][d];
+    }
+
+    /** Compute 2nd part of JCJ_j: 2 \sqrt{2} || J_j C J_j^T ||_F. */
+    JCJ_j += 2.0 * sqrt2 * jacjcovjacj.frobenius_norm();
+
+    /** Max_j [JCJ_j]. */
+    maxJCJ = std::max(maxJCJ, JCJ_j);
+
+  } // end loop over sample container
+
+  this->m_ComputePerThreadVariables[threadId].st_MaxJJ = maxJJ;
+  this->m_ComputePerThreadVariables[threadId].st_MaxJCJ = maxJCJ;
+
+} // end ThreadedComputeMaxTerms()
+
+
+/**
+ * ************************* ComputeSingleThreaded ************************
+ */
+
+template <class TFixedImage, class TTransform>
+void
+ComputeJacobianTerms<TFixedImage, TTransform>::ComputeSingleThreaded(double & TrC,
+                                                                     double & TrCC,
+                                                                     double & maxJJ,
+                                                                     double & maxJCJ)
+{
+
   /** This function computes four terms needed for the automatic parameter
    * estimation. The equation number refers to the IJCV paper.
    * Term 1: TrC, which is the trace of the covariance matrix, needed in (34):
@@ -71,8 +691,6 @@ ComputeJacobianTerms<TFixedImage, TTransform>::Compute(double & TrC, double & Tr
    * Term 4: maxJCJ, see (54)
    */
 
-  typedef double                                 CovarianceValueType;
-  typedef itk::Array2D<CovarianceValueType>      CovarianceMatrixType;
   typedef vnl_sparse_matrix<CovarianceValueType> SparseCovarianceMatrixType;
   typedef SparseCovarianceMatrixType::row        SparseRowType;
   typedef itk::Array<SizeValueType>              NonZeroJacobianIndicesExpandedType;
@@ -515,7 +1133,7 @@ ComputeJacobianTerms<TFixedImage, TTransform>::Compute(double & TrC, double & Tr
   /** Finalize progress information. */
   // progressObserver->PrintProgress( 1.0 );
 
-} // end Compute()
+} // end ComputeSingleThreaded()
 
 
 /**
@@ -104,6 +104,9 @@ private:
     localInputImage->Graft(static_cast<const ScalarInputImageType *>(inputImage));
 
     caster->SetInput(localInputImage);
+
+    /** Only cast the buffered region, which is a part of the image when the writing is streamed. */
+    caster->GetOutput()->SetRequestedRegion(localInputImage->GetBufferedRegion());
     caster->Update();
 
     /** return the pixel buffer of the casted image */
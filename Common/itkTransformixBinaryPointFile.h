@@ -0,0 +1,259 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef itkTransformixBinaryPointFile_h
+#define itkTransformixBinaryPointFile_h
+
+#include "itkMacro.h"
+
+#include <algorithm> // For min.
+#include <cstdint>
+#include <cstring> // For memcmp and memcpy.
+#include <istream>
+#include <ostream>
+#include <type_traits> // For is_same.
+#include <vector>
+
+namespace itk
+{
+
+/** \class TransformixBinaryPointFile
+ *
+ * \brief Reads and writes the binary point files of transformix.
+ *
+ * A binary point file stores a point set as a raw array of numbers, so that
+ * large point sets (e.g. the vertices of a surface mesh) can be read and written
+ * without parsing or formatting any text. The file starts with a header of 32 bytes:
+ *
+ * \li 8 characters: "ELXPOINT";
+ * \li uint32: the version of the format, currently 1;
+ * \li uint32: the dimension of the points;
+ * \li uint32: the number of bytes per coordinate: 4 (float) or 8 (double);
+ * \li uint32: 1 if the points are image indices, 0 if they are in world coordinates;
+ * \li uint64: the number of points.
+ *
+ * The header is followed by the coordinates of the points, point by point.
+ * All numbers are stored in the byte order of the machine. The version field
+ * is used to detect a file written with a different byte order.
+ */
+
+class TransformixBinaryPointFile
+{
+public:
+  /** The header of a binary point file. */
+  struct HeaderType
+  {
+    char          Magic[8];
+    std::uint32_t Version;
+    std::uint32_t Dimension;
+    std::uint32_t BytesPerValue;
+    std::uint32_t PointsAreIndices;
+    std::uint64_t NumberOfPoints;
+  };
+
+  /** Creates the header of a file with the specified points, stored as double. */
+  static HeaderType
+  CreateHeader(const unsigned int dimension, const std::uint64_t numberOfPoints, const bool pointsAreIndices)
+  {
+    HeaderType header;
+    std::memcpy(header.Magic, GetMagic(), sizeof(header.Magic));
+    header.Version = 1;
+    header.Dimension = dimension;
+    header.BytesPerValue = sizeof(double);
+    header.PointsAreIndices = pointsAreIndices ? 1 : 0;
+    header.NumberOfPoints = numberOfPoints;
+    return header;
+  }
+
+
+  /** Reads the header at the current position of the stream. Returns false, and
+   * restores the position of the stream, when the stream does not start with the
+   * header of a binary point file. Throws an exception when the header is invalid,
+   * or when the rest of the stream is too small for the specified number of points.
+   */
+  static bool
+  ReadHeader(std::istream & stream, HeaderType & header)
+  {
+    const auto position = stream.tellg();
+    stream.read(header.Magic, sizeof(header.Magic));
+    if (!stream || std::memcmp(header.Magic, GetMagic(), sizeof(header.Magic)) != 0)
+    {
+      stream.clear();
+      stream.seekg(position);
+      return false;
+    }
+
+    stream.read(reinterpret_cast<char *>(&header.Version), sizeof(header.Version));
+    stream.read(reinterpret_cast<char *>(&header.Dimension), sizeof(header.Dimension));
+    stream.read(reinterpret_cast<char *>(&header.BytesPerValue), sizeof(header.BytesPerValue));
+    stream.read(reinterpret_cast<char *>(&header.PointsAreIndices), sizeof(header.PointsAreIndices));
+    stream.read(reinterpret_cast<char *>(&header.NumberOfPoints), sizeof(header.NumberOfPoints));
+
+    if (!stream)
+    {
+      itkGenericExceptionMacro(<< "The header of the binary point file is incomplete.");
+    }
+    if (header.Version != 1)
+    {
+      itkGenericExceptionMacro(<< "Unsupported version (" << header.Version << ") of the binary point file. "
+                               << "The file may have been written with a different byte order.");
+    }
+    if (header.BytesPerValue != sizeof(float) && header.BytesPerValue != sizeof(double))
+    {
+      itkGenericExceptionMacro(<< "Unsupported number of bytes per coordinate (" << header.BytesPerValue
+                               << ") in the binary point file.");
+    }
+    if (header.Dimension == 0)
+    {
+      itkGenericExceptionMacro(<< "The dimension of the points in the binary point file is zero.");
+    }
+
+    /** Check the number of points against the size of the file, before anyone
+     * allocates memory for them. Divides instead of multiplies, to avoid overflow.
+     */
+    const std::uint64_t numberOfBytesPerPoint = static_cast<std::uint64_t>(header.Dimension) * header.BytesPerValue;
+    const auto          dataPosition = stream.tellg();
+    stream.seekg(0, std::ios::end);
+    const auto endPosition = stream.tellg();
+    stream.seekg(dataPosition);
+    if (!stream || dataPosition < 0 || endPosition < dataPosition)
+    {
+      itkGenericExceptionMacro(<< "Failed to determine the size of the binary point file.");
+    }
+    const auto numberOfDataBytes = static_cast<std::uint64_t>(endPosition - dataPosition);
+    if (header.NumberOfPoints > numberOfDataBytes / numberOfBytesPerPoint)
+    {
+      itkGenericExceptionMacro(<< "The binary point file is not large enough for " << header.NumberOfPoints
+                               << " points.");
+    }
+    return true;
+  }
+
+
+  /** Writes the header to the stream. */
+  static void
+  WriteHeader(std::ostream & stream, const HeaderType & header)
+  {
+    stream.write(header.Magic, sizeof(header.Magic));
+    stream.write(reinterpret_cast<const char *>(&header.Version), sizeof(header.Version));
+    stream.write(reinterpret_cast<const char *>(&header.Dimension), sizeof(header.Dimension));
+    stream.write(reinterpret_cast<const char *>(&header.BytesPerValue), sizeof(header.BytesPerValue));
+    stream.write(reinterpret_cast<const char *>(&header.PointsAreIndices), sizeof(header.PointsAreIndices));
+    stream.write(reinterpret_cast<const char *>(&header.NumberOfPoints), sizeof(header.NumberOfPoints));
+  }
+
+
+  /** Reads the points that follow the header into the specified array, which
+   * must have room for header.NumberOfPoints points. When the coordinates are
+   * stored with the value type of the points, they are read directly into the
+   * array, with a single read operation.
+   */
+  template <class TPoint>
+  static void
+  ReadPoints(std::istream & stream, const HeaderType & header, TPoint * const points)
+  {
+    typedef typename TPoint::ValueType ValueType;
+
+    if (header.Dimension != TPoint::PointDimension)
+    {
+      itkGenericExceptionMacro(<< "The dimension of the binary point file (" << header.Dimension
+                               << ") does not match the expected dimension (" << TPoint::PointDimension << ").");
+    }
+
+    if (header.BytesPerValue == sizeof(ValueType) && sizeof(TPoint) == sizeof(ValueType) * TPoint::PointDimension)
+    {
+      stream.read(reinterpret_cast<char *>(points),
+                  static_cast<std::streamsize>(header.NumberOfPoints * sizeof(TPoint)));
+    }
+    else if (header.BytesPerValue == sizeof(float))
+    {
+      ReadAndConvertPoints<float>(stream, header.NumberOfPoints, points);
+    }
+    else
+    {
+      ReadAndConvertPoints<double>(stream, header.NumberOfPoints, points);
+    }
+
+    if (!stream)
+    {
+      itkGenericExceptionMacro(<< "The binary point file is not large enough for " << header.NumberOfPoints
+                               << " points.");
+    }
+  }
+
+
+  /** Writes the coordinates of the points to the stream, as double. */
+  template <class TPoint>
+  static void
+  WritePoints(std::ostream & stream, const TPoint * const points, const std::uint64_t numberOfPoints)
+  {
+    typedef typename TPoint::ValueType ValueType;
+
+    if (std::is_same<ValueType, double>::value && sizeof(TPoint) == sizeof(double) * TPoint::PointDimension)
+    {
+      stream.write(reinterpret_cast<const char *>(points),
+                   static_cast<std::streamsize>(numberOfPoints * sizeof(TPoint)));
+      return;
+    }
+
+    std::vector<double> buffer;
+    buffer.reserve(TPoint::PointDimension);
+    for (std::uint64_t i = 0; i < numberOfPoints; ++i)
+    {
+      buffer.assign(points[i].Begin(), points[i].End());
+      stream.write(reinterpret_cast<const char *>(buffer.data()),
+                   static_cast<std::streamsize>(buffer.size() * sizeof(double)));
+    }
+  }
+
+private:
+  static const char *
+  GetMagic()
+  {
+    return "ELXPOINT";
+  }
+
+
+  /** Reads coordinates of type TValue in blocks, and converts them to the value type of the points. */
+  template <class TValue, class TPoint>
+  static void
+  ReadAndConvertPoints(std::istream & stream, const std::uint64_t numberOfPoints, TPoint * const points)
+  {
+    const std::uint64_t pointsPerBlock = 4096;
+    std::vector<TValue> buffer(pointsPerBlock * TPoint::PointDimension);
+
+    for (std::uint64_t begin = 0; begin < numberOfPoints && stream; begin += pointsPerBlock)
+    {
+      const std::uint64_t numberOfPointsInBlock = std::min(pointsPerBlock, numberOfPoints - begin);
+      stream.read(reinterpret_cast<char *>(buffer.data()),
+                  static_cast<std::streamsize>(numberOfPointsInBlock * TPoint::PointDimension * sizeof(TValue)));
+
+      for (std::uint64_t i = 0; i < numberOfPointsInBlock; ++i)
+      {
+        for (unsigned int d = 0; d < TPoint::PointDimension; ++d)
+        {
+          points[begin + i][d] = static_cast<typename TPoint::ValueType>(buffer[i * TPoint::PointDimension + d]);
+        }
+      }
+    }
+  }
+};
+
+} // end namespace itk
+
+#endif
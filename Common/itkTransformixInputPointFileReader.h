@@ -20,6 +20,7 @@
 #define itkTransformixInputPointFileReader_h
 
 #include "itkMeshFileReaderBase.h"
+#include "itkTransformixBinaryPointFile.h"
 
 #include <fstream>
 
@@ -40,6 +41,10 @@ namespace itk
  *
  * The second word in the text file represents the number of points that
  * should be read.
+ *
+ * Alternatively, the file may be a binary point file, as described by
+ * TransformixBinaryPointFile. The reader recognizes such a file by its header,
+ * and reads its coordinates without any text parsing.
  **/
 
 template <class TOutputMesh>
@@ -79,7 +84,10 @@ public:
    * MeshReaderBase class and inheriting classes, so somehow it
    * seems logic to store this kind of data in the inheriting reader classes.
    */
-  itkGetConstMacro(NumberOfPoints, unsigned long);
+  itkGetConstMacro(NumberOfPoints, std::size_t);
+
+  /** Get whether the file is a binary point file. */
+  itkGetConstMacro(FileIsBinary, bool);
 
   /** Prepare the allocation of the output mesh during the first back
    * propagation of the pipeline. Updates the PointsAreIndices and NumberOfPoints.
@@ -95,8 +103,12 @@ protected:
   void
   GenerateData(void) override;
 
-  unsigned long m_NumberOfPoints;
-  bool          m_PointsAreIndices;
+  std::size_t m_NumberOfPoints;
+  bool        m_PointsAreIndices;
+  bool        m_FileIsBinary;
+
+  /** The header of a binary point file. */
+  TransformixBinaryPointFile::HeaderType m_BinaryHeader;
 
   std::ifstream m_Reader;
 
@@ -21,6 +21,8 @@
 
 #include "itkTransformixInputPointFileReader.h"
 
+#include <algorithm> // For max.
+
 namespace itk
 {
 
@@ -33,6 +35,7 @@ TransformixInputPointFileReader<TOutputMesh>::TransformixInputPointFileReader()
 {
   this->m_NumberOfPoints = 0;
   this->m_PointsAreIndices = false;
+  this->m_FileIsBinary = false;
 } // end constructor
 
 
@@ -66,7 +69,38 @@ TransformixInputPointFileReader<TOutputMesh>::GenerateOutputInformation(void)
   {
     this->m_Reader.close();
   }
-  this->m_Reader.open(this->m_FileName.c_str());
+  this->m_Reader.open(this->m_FileName.c_str(), std::ios::binary);
+
+  /** A binary point file specifies everything in its header. */
+  try
+  {
+    this->m_FileIsBinary = TransformixBinaryPointFile::ReadHeader(this->m_Reader, this->m_BinaryHeader);
+  }
+  catch (ExceptionObject & excp)
+  {
+    std::ostringstream msg;
+    msg << excp.GetDescription() << std::endl << "Filename: " << this->m_FileName << std::endl;
+    MeshFileReaderException e(__FILE__, __LINE__, msg.str().c_str(), ITK_LOCATION);
+    throw e;
+  }
+  if (this->m_FileIsBinary)
+  {
+    /** The 64-bit number of points must fit in the point container, also where its
+     * size type has only 32 bits. */
+    typedef typename OutputMeshType::PointsContainer::STLContainerType PointsSTLContainerType;
+    if (this->m_BinaryHeader.NumberOfPoints > PointsSTLContainerType().max_size())
+    {
+      std::ostringstream msg;
+      msg << "The number of points in the binary point file (" << this->m_BinaryHeader.NumberOfPoints
+          << ") is too large for this platform." << std::endl
+          << "Filename: " << this->m_FileName << std::endl;
+      MeshFileReaderException e(__FILE__, __LINE__, msg.str().c_str(), ITK_LOCATION);
+      throw e;
+    }
+    this->m_PointsAreIndices = (this->m_BinaryHeader.PointsAreIndices != 0);
+    this->m_NumberOfPoints = static_cast<std::size_t>(this->m_BinaryHeader.NumberOfPoints);
+    return;
+  }
 
   /** Read the first entry */
   std::string indexOrPoint;
@@ -89,7 +123,7 @@ TransformixInputPointFileReader<TOutputMesh>::GenerateOutputInformation(void)
   {
     /** Input points are assumed to be specified as image indices. */
     this->m_PointsAreIndices = true;
-    this->m_NumberOfPoints = atoi(indexOrPoint.c_str());
+    this->m_NumberOfPoints = static_cast<std::size_t>(std::max(0, atoi(indexOrPoint.c_str())));
   }
 
   /** Leave the file open for the generate data method */
@@ -114,9 +148,25 @@ TransformixInputPointFileReader<TOutputMesh>::GenerateData(void)
   PointsContainerPointer points = PointsContainerType::New();
 
   /** Read the file */
-  if (this->m_Reader.is_open())
+  if (this->m_Reader.is_open() && this->m_FileIsBinary)
+  {
+    /** Read all coordinates at once, directly into the point container. */
+    points->CastToSTLContainer().resize(this->m_NumberOfPoints);
+    try
+    {
+      TransformixBinaryPointFile::ReadPoints(this->m_Reader, this->m_BinaryHeader, points->CastToSTLContainer().data());
+    }
+    catch (ExceptionObject & excp)
+    {
+      std::ostringstream msg;
+      msg << excp.GetDescription() << std::endl << "Filename: " << this->m_FileName << std::endl;
+      MeshFileReaderException e(__FILE__, __LINE__, msg.str().c_str(), ITK_LOCATION);
+      throw e;
+    }
+  }
+  else if (this->m_Reader.is_open())
   {
-    for (unsigned int i = 0; i < this->m_NumberOfPoints; ++i)
+    for (std::size_t i = 0; i < this->m_NumberOfPoints; ++i)
     {
       // read point from textfile
       PointType point;
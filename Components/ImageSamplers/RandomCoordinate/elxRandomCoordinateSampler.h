@@ -39,6 +39,9 @@ namespace elastix
  *
  * This sampler is suitable to used in combination with the
  * NewSamplesEveryIteration parameter (defined in the elx::OptimizerBase).
+ * When multi-threaded samplers are enabled (command line option -mts), also the
+ * search for samples within the mask is done in parallel. The selected samples
+ * then only depend on the RandomSeed, and not on the number of threads.
  *
  * The parameters used in this class are:
  * \parameter ImageSampler: Select this image sampler as follows:\n
@@ -67,7 +70,9 @@ namespace elastix
  *    with fixedImageSize in mm. So, approximately 1/3 of the fixed image size.
  * \parameter FixedImageBSplineInterpolationOrder: When using a RandomCoordinate sampler,
  *    the fixed image needs to be interpolated. This is done using a B-spline interpolator.
- *    With this option you can specify the order of interpolation.\n
+ *    With this option you can specify the order of interpolation. Order 1 selects a
+ *    (cheap) linear interpolator. For higher orders the B-spline coefficients are
+ *    computed once per resolution, and reused when new samples are selected.\n
  *    example: <tt>(FixedImageBSplineInterpolationOrder 0 0 1)</tt>\n
  *    Default value: 1. The parameter can be specified for each resolution.
  *
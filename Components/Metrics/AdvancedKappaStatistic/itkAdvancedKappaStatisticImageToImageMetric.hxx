@@ -35,6 +35,7 @@ AdvancedKappaStatisticImageToImageMetric<TFixedImage, TMovingImage>::AdvancedKap
   this->SetUseImageSampler(true);
   this->SetUseFixedImageLimiter(false);
   this->SetUseMovingImageLimiter(false);
+  this->SetSupportsConcurrentGetValueAndDerivative(true);
 
   this->m_UseForegroundValue = true; // for backwards compatibility
   this->m_ForegroundValue = 1.0;
@@ -206,6 +206,8 @@ protected:
   typedef typename Superclass::CentralDifferenceGradientFilterType CentralDifferenceGradientFilterType;
   typedef typename Superclass::MovingImageDerivativeType           MovingImageDerivativeType;
   typedef typename Superclass::NonZeroJacobianIndicesType          NonZeroJacobianIndicesType;
+  typedef typename Superclass::AdvancedTransformType               AdvancedTransformType;
+  typedef typename AdvancedTransformType::MovingImageGradientType  MovingImageGradientType;
 
   /** Protected typedefs for SelfHessian */
   typedef SmoothingRecursiveGaussianImageFilter<FixedImageType, FixedImageType>         SmootherType;
@@ -22,6 +22,8 @@
 #include "vnl/algo/vnl_matrix_update.h"
 #include "itkMersenneTwisterRandomVariateGenerator.h"
 #include "itkComputeImageExtremaFilter.h"
+#include <algorithm>
+#include <vector>
 
 #ifdef ELASTIX_USE_OPENMP
 #  include <omp.h>
@@ -40,6 +42,7 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::AdvancedMeanSq
   this->SetUseImageSampler(true);
   this->SetUseFixedImageLimiter(false);
   this->SetUseMovingImageLimiter(false);
+  this->SetSupportsConcurrentGetValueAndDerivative(true);
 
   this->m_UseNormalization = false;
   this->m_NormalizationFactor = 1.0;
@@ -617,10 +620,20 @@ template <class TFixedImage, class TMovingImage>
 void
 AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetValueAndDerivative(ThreadIdType threadId)
 {
-  /** Initialize array that stores dM(x)/dmu, and the sparse Jacobian + indices. */
+  /** The samples are processed in blocks, such that the transform maps all points of a
+   * block in one call, and computes the products of the transform Jacobian dT/dmu and the
+   * moving image gradient dM/dx for all valid samples of a block in one call.
+   */
+  const unsigned int           blockSize = 32;
   const NumberOfParametersType nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
-  NonZeroJacobianIndicesType   nzji = NonZeroJacobianIndicesType(nnzji);
-  DerivativeType               imageJacobian(nnzji);
+
+  std::vector<FixedImagePointType>        fixedPoints(blockSize);
+  std::vector<MovingImagePointType>       mappedPoints(blockSize);
+  std::vector<RealType>                   fixedImageValues(blockSize);
+  std::vector<RealType>                   movingImageValues(blockSize);
+  std::vector<MovingImageGradientType>    movingImageDerivatives(blockSize);
+  std::vector<DerivativeType>             imageJacobians(blockSize, DerivativeType(nnzji));
+  std::vector<NonZeroJacobianIndicesType> nzjis(blockSize, NonZeroJacobianIndicesType(nnzji));
 
   /** Get a handle to the pre-allocated derivative for the current thread.
    * The initialization is performed at the beginning of each resolution in
@@ -642,68 +655,61 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetVal
   pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
   pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
 
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator threader_fiter;
-  typename ImageSampleContainerType::ConstIterator threader_fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator threader_fend = sampleContainer->Begin();
-
-  threader_fbegin += (int)pos_begin;
-  threader_fend += (int)pos_end;
-
   /** Create variables to store intermediate results. circumvent false sharing */
   unsigned long numberOfPixelsCounted = 0;
   MeasureType   measure = NumericTraits<MeasureType>::Zero;
 
   /** Loop over the fixed image to calculate the mean squares. */
-  for (threader_fiter = threader_fbegin; threader_fiter != threader_fend; ++threader_fiter)
+  for (unsigned long block_begin = pos_begin; block_begin < pos_end; block_begin += blockSize)
   {
-    /** Read fixed coordinates and initialize some variables. */
-    const FixedImagePointType & fixedPoint = (*threader_fiter).Value().m_ImageCoordinates;
-    RealType                    movingImageValue;
-    MovingImagePointType        mappedPoint;
-    MovingImageDerivativeType   movingImageDerivative;
+    const unsigned int numberOfPoints =
+      static_cast<unsigned int>(std::min<unsigned long>(blockSize, pos_end - block_begin));
 
-    /** Transform point and check if it is inside the B-spline support region. */
-    bool sampleOk = this->TransformPoint(fixedPoint, mappedPoint);
-
-    /** Check if point is inside mask. */
-    if (sampleOk)
+    /** Read the fixed coordinates and transform them. */
+    for (unsigned int i = 0; i < numberOfPoints; ++i)
     {
-      sampleOk = this->IsInsideMovingMask(mappedPoint); // thread-safe?
+      fixedPoints[i] = sampleContainer->ElementAt(block_begin + i).m_ImageCoordinates;
     }
+    this->m_AdvancedTransform->TransformPoints(fixedPoints.data(), mappedPoints.data(), numberOfPoints);
 
-    /** Compute the moving image value M(T(x)) and derivative dM/dx and check if
-     * the point is inside the moving image buffer.
+    /** Compute the moving image value M(T(x)) and derivative dM/dx of the samples that are
+     * inside the moving mask and the moving image buffer, and move them to the front.
      */
-    if (sampleOk)
-    {
-      sampleOk = this->EvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, &movingImageDerivative);
-    }
-
-    if (sampleOk)
+    unsigned int numberOfValidPoints = 0;
+    for (unsigned int i = 0; i < numberOfPoints; ++i)
     {
-      numberOfPixelsCounted++;
-
-      /** Get the fixed image value. */
-      const RealType & fixedImageValue = static_cast<RealType>((*threader_fiter).Value().m_ImageValue);
+      RealType                  movingImageValue;
+      MovingImageDerivativeType movingImageDerivative;
 
-#if 0
-      /** Get the TransformJacobian dT/dmu. */
-      this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
+      bool sampleOk = this->IsInsideMovingMask(mappedPoints[i]);
+      if (sampleOk)
+      {
+        sampleOk =
+          this->EvaluateMovingImageValueAndDerivative(mappedPoints[i], movingImageValue, &movingImageDerivative);
+      }
 
-      /** Compute the inner products (dM/dx)^T (dT/dmu). */
-      this->EvaluateTransformJacobianInnerProduct(
-        jacobian, movingImageDerivative, imageJacobian );
-#else
-      /** Compute the inner product of the transform Jacobian dT/dmu and the moving image gradient dM/dx. */
-      this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProduct(
-        fixedPoint, movingImageDerivative, imageJacobian, nzji);
-#endif
+      if (sampleOk)
+      {
+        fixedPoints[numberOfValidPoints] = fixedPoints[i];
+        fixedImageValues[numberOfValidPoints] =
+          static_cast<RealType>(sampleContainer->ElementAt(block_begin + i).m_ImageValue);
+        movingImageValues[numberOfValidPoints] = movingImageValue;
+        movingImageDerivatives[numberOfValidPoints] = movingImageDerivative;
+        ++numberOfValidPoints;
+      }
+    }
 
-      /** Compute this pixel's contribution to the measure and derivatives. */
-      this->UpdateValueAndDerivativeTerms(fixedImageValue, movingImageValue, imageJacobian, nzji, measure, derivative);
+    /** Compute the inner products of the transform Jacobian dT/dmu and the moving image gradient dM/dx. */
+    this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProducts(
+      fixedPoints.data(), movingImageDerivatives.data(), imageJacobians.data(), nzjis.data(), numberOfValidPoints);
 
-    } // end if sampleOk
+    /** Compute the contributions to the measure and derivatives, in the order of the samples. */
+    for (unsigned int i = 0; i < numberOfValidPoints; ++i)
+    {
+      this->UpdateValueAndDerivativeTerms(
+        fixedImageValues[i], movingImageValues[i], imageJacobians[i], nzjis[i], measure, derivative);
+    }
+    numberOfPixelsCounted += numberOfValidPoints;
 
   } // end for loop over the image sample container
 
@@ -19,6 +19,7 @@
 #define itkAdvancedNormalizedCorrelationImageToImageMetric_h
 
 #include "itkAdvancedImageToImageMetric.h"
+#include "itkCompensatedSummation.h"
 
 namespace itk
 {
@@ -81,6 +82,21 @@ namespace itk
  *
  * where Af and Am are the average of f and m, respectively.
  *
+ * Only the term \f$\sum_x \mathtt{differential}\f$ depends on SubtractMean. If SubtractMean
+ * is false, the multi-threaded implementation therefore accumulates only two derivative
+ * vectors, \f$\sum_x f(x) * \mathtt{differential}\f$ and
+ * \f$\sum_x m(x+u(x,p)) * \mathtt{differential}\f$, instead of three. Note that the
+ * elastix AdvancedNormalizedCorrelation metric sets SubtractMean to true by default.
+ *
+ * The multi-threaded implementation divides the samples into chunks of a fixed number
+ * of samples, and gives each thread a contiguous range of chunks. The sums sff, smm,
+ * sfm, sf and sm are stored per chunk, and added in chunk order, using compensated
+ * (Kahan) summation, so that the value does not depend on the number of threads.
+ * The derivative vectors are accumulated per thread instead, so that the memory they
+ * take grows with the number of threads, not with the number of samples. The
+ * reduction over the threads also uses compensated summation, but the derivative may
+ * still differ in the last bits when the number of threads changes.
+ *
  *
  * \ingroup RegistrationMetrics
  * \ingroup Metrics
@@ -214,6 +230,17 @@ protected:
                         DerivativeType &                   derivativeM,
                         DerivativeType &                   differential) const;
 
+  /** Compute a pixel's contribution to the derivative terms, except the differential,
+   * which is only needed when SubtractMean is true.
+   */
+  void
+  UpdateDerivativeTerms(const RealType &                   fixedImageValue,
+                        const RealType &                   movingImageValue,
+                        const DerivativeType &             imageJacobian,
+                        const NonZeroJacobianIndicesType & nzji,
+                        DerivativeType &                   derivativeF,
+                        DerivativeType &                   derivativeM) const;
+
   /** Initialize some multi-threading related parameters.
    * Overrides function in AdvancedImageToImageMetric, because
    * here we use other parameters.
@@ -225,6 +252,10 @@ protected:
   inline void
   ThreadedGetValueAndDerivative(ThreadIdType threadID) override;
 
+  /** Get value and derivatives for the samples of one chunk, processed by the given thread. */
+  void
+  ThreadedGetValueAndDerivativeOfChunk(const SizeValueType chunk, const ThreadIdType threadId);
+
   /** Gather the values and derivatives from all threads */
   inline void
   AfterThreadedGetValueAndDerivative(MeasureType & value, DerivativeType & derivative) const override;
@@ -233,6 +264,10 @@ protected:
   static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
   AccumulateDerivativesThreaderCallback(void * arg);
 
+  /** Divide the samples into chunks, and initialize the variables of the chunks and threads. */
+  void
+  InitializeChunks(void) const;
+
 private:
   AdvancedNormalizedCorrelationImageToImageMetric(const Self &) = delete;
   void
@@ -241,6 +276,7 @@ private:
   mutable bool m_SubtractMean;
 
   typedef typename NumericTraits<MeasureType>::AccumulateType AccumulateType;
+  typedef CompensatedSummation<AccumulateType>                CompensatedSummationType;
 
   /** Helper structs that multi-threads the computation of
    * the metric derivative using ITK threads.
@@ -256,7 +292,9 @@ private:
     DerivativeValueType * st_DerivativePointer;
   };
 
-  struct CorrelationGetValueAndDerivativePerThreadStruct
+  /** The sums over the samples of a chunk. Each chunk is written only once, at the end
+   * of the chunk, so these are not padded to the cache line size. */
+  struct CorrelationGetValuePerChunkStruct
   {
     SizeValueType  st_NumberOfPixelsCounted;
     AccumulateType st_Sff;
@@ -264,18 +302,27 @@ private:
     AccumulateType st_Sfm;
     AccumulateType st_Sf;
     AccumulateType st_Sm;
+  };
+  mutable std::vector<CorrelationGetValuePerChunkStruct> m_CorrelationGetValuePerChunkVariables;
+
+  /** The derivative terms of a thread, summed over all its chunks. */
+  struct CorrelationGetDerivativePerThreadStruct
+  {
     DerivativeType st_DerivativeF;
     DerivativeType st_DerivativeM;
     DerivativeType st_Differential;
   };
   itkPadStruct(ITK_CACHE_LINE_ALIGNMENT,
-               CorrelationGetValueAndDerivativePerThreadStruct,
-               PaddedCorrelationGetValueAndDerivativePerThreadStruct);
+               CorrelationGetDerivativePerThreadStruct,
+               PaddedCorrelationGetDerivativePerThreadStruct);
   itkAlignedTypedef(ITK_CACHE_LINE_ALIGNMENT,
-                    PaddedCorrelationGetValueAndDerivativePerThreadStruct,
-                    AlignedCorrelationGetValueAndDerivativePerThreadStruct);
-  mutable AlignedCorrelationGetValueAndDerivativePerThreadStruct * m_CorrelationGetValueAndDerivativePerThreadVariables;
-  mutable ThreadIdType m_CorrelationGetValueAndDerivativePerThreadVariablesSize;
+                    PaddedCorrelationGetDerivativePerThreadStruct,
+                    AlignedCorrelationGetDerivativePerThreadStruct);
+  mutable AlignedCorrelationGetDerivativePerThreadStruct * m_CorrelationGetDerivativePerThreadVariables;
+  mutable ThreadIdType                                     m_CorrelationGetDerivativePerThreadVariablesSize;
+
+  /** The number of samples of a chunk. Only the last chunk may have fewer samples. */
+  static const unsigned int NumberOfSamplesPerChunk = 256;
 };
 
 } // end namespace itk
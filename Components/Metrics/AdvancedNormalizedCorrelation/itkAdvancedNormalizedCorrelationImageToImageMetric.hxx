@@ -20,6 +20,8 @@
 
 #include "itkAdvancedNormalizedCorrelationImageToImageMetric.h"
 
+#include <algorithm> // For min and max.
+
 #ifdef ELASTIX_USE_OPENMP
 #  include <omp.h>
 #endif
@@ -40,10 +42,11 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage,
   this->SetUseImageSampler(true);
   this->SetUseFixedImageLimiter(false);
   this->SetUseMovingImageLimiter(false);
+  this->SetSupportsConcurrentGetValueAndDerivative(true);
 
   // Multi-threading structs
-  this->m_CorrelationGetValueAndDerivativePerThreadVariables = nullptr;
-  this->m_CorrelationGetValueAndDerivativePerThreadVariablesSize = 0;
+  this->m_CorrelationGetDerivativePerThreadVariables = nullptr;
+  this->m_CorrelationGetDerivativePerThreadVariablesSize = 0;
 
 } // end Constructor
 
@@ -56,7 +59,7 @@ template <class TFixedImage, class TMovingImage>
 AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage,
                                                 TMovingImage>::~AdvancedNormalizedCorrelationImageToImageMetric()
 {
-  delete[] this->m_CorrelationGetValueAndDerivativePerThreadVariables;
+  delete[] this->m_CorrelationGetDerivativePerThreadVariables;
 } // end Destructor
 
 
@@ -70,46 +73,70 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::Init
 {
   const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
 
-  /** Resize and initialize the threading related parameters.
-   * The SetSize() functions do not resize the data when this is not
-   * needed, which saves valuable re-allocation time.
-   * Filling the potentially large vectors is performed later, in each thread,
-   * which has performance benefits for larger vector sizes.
-   */
-
   /** Only resize the array of structs when needed. */
-  if (this->m_CorrelationGetValueAndDerivativePerThreadVariablesSize != numberOfThreads)
+  if (this->m_CorrelationGetDerivativePerThreadVariablesSize != numberOfThreads)
   {
-    delete[] this->m_CorrelationGetValueAndDerivativePerThreadVariables;
-    this->m_CorrelationGetValueAndDerivativePerThreadVariables =
-      new AlignedCorrelationGetValueAndDerivativePerThreadStruct[numberOfThreads];
-    this->m_CorrelationGetValueAndDerivativePerThreadVariablesSize = numberOfThreads;
+    delete[] this->m_CorrelationGetDerivativePerThreadVariables;
+    this->m_CorrelationGetDerivativePerThreadVariables =
+      new AlignedCorrelationGetDerivativePerThreadStruct[numberOfThreads];
+    this->m_CorrelationGetDerivativePerThreadVariablesSize = numberOfThreads;
   }
 
-  /** Some initialization. */
-  const AccumulateType      zero1 = NumericTraits<AccumulateType>::Zero;
-  const DerivativeValueType zero2 = NumericTraits<DerivativeValueType>::Zero;
+  /** Release the derivative terms. They are allocated and filled on their next use, by
+   * InitializeChunks(), since the number of parameters may have changed.
+   */
   for (ThreadIdType i = 0; i < numberOfThreads; ++i)
   {
-    this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted =
-      NumericTraits<SizeValueType>::Zero;
-    this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_Sff = zero1;
-    this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_Smm = zero1;
-    this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_Sfm = zero1;
-    this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_Sf = zero1;
-    this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_Sm = zero1;
-    this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_DerivativeF.SetSize(this->GetNumberOfParameters());
-    this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_DerivativeM.SetSize(this->GetNumberOfParameters());
-    this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_Differential.SetSize(
-      this->GetNumberOfParameters());
-    this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_DerivativeF.Fill(zero2);
-    this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_DerivativeM.Fill(zero2);
-    this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_Differential.Fill(zero2);
+    this->m_CorrelationGetDerivativePerThreadVariables[i].st_DerivativeF.SetSize(0);
+    this->m_CorrelationGetDerivativePerThreadVariables[i].st_DerivativeM.SetSize(0);
+    this->m_CorrelationGetDerivativePerThreadVariables[i].st_Differential.SetSize(0);
   }
 
 } // end InitializeThreadingParameters()
 
 
+/**
+ * ******************* InitializeChunks *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::InitializeChunks(void) const
+{
+  /** Divide the samples into chunks. The chunks only depend on the number of samples,
+   * not on the number of threads. The sums of each chunk are overwritten in each iteration.
+   */
+  const SizeValueType numberOfSamples = this->GetImageSampler()->GetOutput()->Size();
+  const SizeValueType numberOfChunks = (numberOfSamples + NumberOfSamplesPerChunk - 1) / NumberOfSamplesPerChunk;
+  this->m_CorrelationGetValuePerChunkVariables.resize(numberOfChunks);
+
+  /** Allocate the derivative terms of the threads that are used for the first time.
+   * Filling the potentially large vectors is done only once; afterwards they are
+   * reset by the accumulate functions. The differential is only needed when
+   * SubtractMean is true.
+   */
+  const DerivativeValueType    zero = NumericTraits<DerivativeValueType>::Zero;
+  const NumberOfParametersType numberOfParameters = this->GetNumberOfParameters();
+  for (ThreadIdType i = 0; i < this->m_CorrelationGetDerivativePerThreadVariablesSize; ++i)
+  {
+    AlignedCorrelationGetDerivativePerThreadStruct & thread = this->m_CorrelationGetDerivativePerThreadVariables[i];
+    if (thread.st_DerivativeF.GetSize() != numberOfParameters)
+    {
+      thread.st_DerivativeF.SetSize(numberOfParameters);
+      thread.st_DerivativeM.SetSize(numberOfParameters);
+      thread.st_DerivativeF.Fill(zero);
+      thread.st_DerivativeM.Fill(zero);
+    }
+    if (this->m_SubtractMean && thread.st_Differential.GetSize() != numberOfParameters)
+    {
+      thread.st_Differential.SetSize(numberOfParameters);
+      thread.st_Differential.Fill(zero);
+    }
+  }
+
+} // end InitializeChunks()
+
+
 /**
  * ******************* PrintSelf *******************
  */
@@ -176,6 +203,52 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::Upda
 } // end UpdateValueAndDerivativeTerms()
 
 
+/**
+ * *************** UpdateDerivativeTerms ***************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::UpdateDerivativeTerms(
+  const RealType &                   fixedImageValue,
+  const RealType &                   movingImageValue,
+  const DerivativeType &             imageJacobian,
+  const NonZeroJacobianIndicesType & nzji,
+  DerivativeType &                   derivativeF,
+  DerivativeType &                   derivativeM) const
+{
+  /** Calculate the contributions to the derivatives with respect to each parameter. */
+  if (nzji.size() == this->GetNumberOfParameters())
+  {
+    /** Loop over all Jacobians. */
+    typename DerivativeType::const_iterator imjacit = imageJacobian.begin();
+    typename DerivativeType::iterator       derivativeFit = derivativeF.begin();
+    typename DerivativeType::iterator       derivativeMit = derivativeM.begin();
+
+    for (unsigned int mu = 0; mu < this->GetNumberOfParameters(); ++mu)
+    {
+      (*derivativeFit) += fixedImageValue * (*imjacit);
+      (*derivativeMit) += movingImageValue * (*imjacit);
+      ++imjacit;
+      ++derivativeFit;
+      ++derivativeMit;
+    }
+  }
+  else
+  {
+    /** Only pick the nonzero Jacobians. */
+    for (unsigned int i = 0; i < imageJacobian.GetSize(); ++i)
+    {
+      const unsigned int index = nzji[i];
+      const RealType     differentialtmp = imageJacobian[i];
+      derivativeF[index] += fixedImageValue * differentialtmp;
+      derivativeM[index] += movingImageValue * differentialtmp;
+    }
+  }
+
+} // end UpdateDerivativeTerms()
+
+
 /**
  * ******************* GetValue *******************
  */
@@ -506,6 +579,9 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::GetV
    */
   this->BeforeThreadedGetValueAndDerivative(parameters);
 
+  /** Divide the samples into chunks. */
+  this->InitializeChunks();
+
   /** launch multithreading metric */
   this->LaunchGetValueAndDerivativeThreaderCallback();
 
@@ -523,6 +599,29 @@ template <class TFixedImage, class TMovingImage>
 void
 AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetValueAndDerivative(
   ThreadIdType threadId)
+{
+  /** Process a contiguous range of chunks, so that the threads get a nearly equal number of samples. */
+  const SizeValueType numberOfThreads = Self::GetNumberOfWorkUnits();
+  const SizeValueType numberOfChunks = this->m_CorrelationGetValuePerChunkVariables.size();
+  const SizeValueType chunkBegin = numberOfChunks * threadId / numberOfThreads;
+  const SizeValueType chunkEnd = numberOfChunks * (threadId + 1) / numberOfThreads;
+  for (SizeValueType chunk = chunkBegin; chunk < chunkEnd; ++chunk)
+  {
+    this->ThreadedGetValueAndDerivativeOfChunk(chunk, threadId);
+  }
+
+} // end ThreadedGetValueAndDerivative()
+
+
+/**
+ * ******************* ThreadedGetValueAndDerivativeOfChunk *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetValueAndDerivativeOfChunk(
+  const SizeValueType chunk,
+  const ThreadIdType  threadId)
 {
   /** Initialize array that stores dM(x)/dmu, and the sparse Jacobian + indices. */
   const NumberOfParametersType nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
@@ -530,26 +629,20 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::Thre
   DerivativeType               imageJacobian(nzji.size());
 
   /** Get handles to the pre-allocated derivatives for the current thread.
-   * The initialization is performed at the beginning of each resolution in
-   * InitializeThreadingParameters(), and at the end of each iteration in
-   * AfterThreadedGetValueAndDerivative() and the accumulate functions.
+   * The initialization is performed in InitializeChunks(), and at the end of
+   * each iteration in AfterThreadedGetValueAndDerivative() and the accumulate functions.
    */
-  DerivativeType & derivativeF = this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_DerivativeF;
-  DerivativeType & derivativeM = this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_DerivativeM;
-  DerivativeType & differential = this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_Differential;
+  DerivativeType & derivativeF = this->m_CorrelationGetDerivativePerThreadVariables[threadId].st_DerivativeF;
+  DerivativeType & derivativeM = this->m_CorrelationGetDerivativePerThreadVariables[threadId].st_DerivativeM;
+  DerivativeType & differential = this->m_CorrelationGetDerivativePerThreadVariables[threadId].st_Differential;
 
   /** Get a handle to the sample container. */
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
   const unsigned long         sampleContainerSize = sampleContainer->Size();
 
-  /** Get the samples for this thread. */
-  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
-    std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(Self::GetNumberOfWorkUnits())));
-
-  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
-  unsigned long pos_end = nrOfSamplesPerThreads * (threadId + 1);
-  pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
-  pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
+  /** Get the samples of this chunk. */
+  const unsigned long pos_begin = chunk * NumberOfSamplesPerChunk;
+  const unsigned long pos_end = std::min<unsigned long>(pos_begin + NumberOfSamplesPerChunk, sampleContainerSize);
 
   /** Create iterator over the sample container. */
   typename ImageSampleContainerType::ConstIterator threader_fiter;
@@ -560,12 +653,12 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::Thre
   threader_fend += (int)pos_end;
 
   /** Create variables to store intermediate results. */
-  AccumulateType sff = NumericTraits<AccumulateType>::Zero;
-  AccumulateType smm = NumericTraits<AccumulateType>::Zero;
-  AccumulateType sfm = NumericTraits<AccumulateType>::Zero;
-  AccumulateType sf = NumericTraits<AccumulateType>::Zero;
-  AccumulateType sm = NumericTraits<AccumulateType>::Zero;
-  unsigned long  numberOfPixelsCounted = 0;
+  CompensatedSummationType sff;
+  CompensatedSummationType smm;
+  CompensatedSummationType sfm;
+  CompensatedSummationType sf;
+  CompensatedSummationType sm;
+  unsigned long            numberOfPixelsCounted = 0;
 
   /** Loop over the fixed image to calculate the mean squares. */
   for (threader_fiter = threader_fbegin; threader_fiter != threader_fend; ++threader_fiter)
@@ -620,23 +713,33 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::Thre
       sf += fixedImageValue;  // Only needed when m_SubtractMean == true
       sm += movingImageValue; // Only needed when m_SubtractMean == true
 
-      /** Compute this voxel's contribution to the derivative terms. */
-      this->UpdateDerivativeTerms(
-        fixedImageValue, movingImageValue, imageJacobian, nzji, derivativeF, derivativeM, differential);
+      /** Compute this voxel's contribution to the derivative terms.
+       * The differential is only needed when SubtractMean is true.
+       */
+      if (this->m_SubtractMean)
+      {
+        this->UpdateDerivativeTerms(
+          fixedImageValue, movingImageValue, imageJacobian, nzji, derivativeF, derivativeM, differential);
+      }
+      else
+      {
+        this->UpdateDerivativeTerms(fixedImageValue, movingImageValue, imageJacobian, nzji, derivativeF, derivativeM);
+      }
 
     } // end if sampleOk
 
   } // end for loop over the image sample container
 
   /** Only update these variables at the end to prevent unnecessary "false sharing". */
-  this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_NumberOfPixelsCounted = numberOfPixelsCounted;
-  this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_Sff = sff;
-  this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_Smm = smm;
-  this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_Sfm = sfm;
-  this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_Sf = sf;
-  this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_Sm = sm;
+  CorrelationGetValuePerChunkStruct & chunkVariables = this->m_CorrelationGetValuePerChunkVariables[chunk];
+  chunkVariables.st_NumberOfPixelsCounted = numberOfPixelsCounted;
+  chunkVariables.st_Sff = sff.GetSum();
+  chunkVariables.st_Smm = smm.GetSum();
+  chunkVariables.st_Sfm = sfm.GetSum();
+  chunkVariables.st_Sf = sf.GetSum();
+  chunkVariables.st_Sm = sm.GetSum();
 
-} // end ThreadedGetValueAndDerivative()
+} // end ThreadedGetValueAndDerivativeOfChunk()
 
 
 /**
@@ -649,46 +752,38 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::Afte
   MeasureType &    value,
   DerivativeType & derivative) const
 {
-  const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
-
-  /** Accumulate the number of pixels. */
-  this->m_NumberOfPixelsCounted =
-    this->m_CorrelationGetValueAndDerivativePerThreadVariables[0].st_NumberOfPixelsCounted;
-  for (ThreadIdType i = 1; i < numberOfThreads; ++i)
+  /** Accumulate the number of pixels. The sums of all chunks are overwritten in each
+   * iteration, so they do not need to be reset.
+   */
+  this->m_NumberOfPixelsCounted = 0;
+  for (const CorrelationGetValuePerChunkStruct & chunk : this->m_CorrelationGetValuePerChunkVariables)
   {
-    this->m_NumberOfPixelsCounted +=
-      this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted;
-
-    /** Reset this variable for the next iteration. */
-    this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted = 0;
+    this->m_NumberOfPixelsCounted += chunk.st_NumberOfPixelsCounted;
   }
 
   /** Check if enough samples were valid. */
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
   this->CheckNumberOfSamples(sampleContainer->Size(), this->m_NumberOfPixelsCounted);
 
-  /** Accumulate values. */
-  const AccumulateType zero = NumericTraits<AccumulateType>::Zero;
-  AccumulateType       sff = this->m_CorrelationGetValueAndDerivativePerThreadVariables[0].st_Sff;
-  AccumulateType       smm = this->m_CorrelationGetValueAndDerivativePerThreadVariables[0].st_Smm;
-  AccumulateType       sfm = this->m_CorrelationGetValueAndDerivativePerThreadVariables[0].st_Sfm;
-  AccumulateType       sf = this->m_CorrelationGetValueAndDerivativePerThreadVariables[0].st_Sf;
-  AccumulateType       sm = this->m_CorrelationGetValueAndDerivativePerThreadVariables[0].st_Sm;
-  for (ThreadIdType i = 1; i < numberOfThreads; ++i)
+  /** Accumulate values, in chunk order. */
+  CompensatedSummationType sffSum;
+  CompensatedSummationType smmSum;
+  CompensatedSummationType sfmSum;
+  CompensatedSummationType sfSum;
+  CompensatedSummationType smSum;
+  for (const CorrelationGetValuePerChunkStruct & chunk : this->m_CorrelationGetValuePerChunkVariables)
   {
-    sff += this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_Sff;
-    smm += this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_Smm;
-    sfm += this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_Sfm;
-    sf += this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_Sf;
-    sm += this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_Sm;
-
-    /** Reset these variables for the next iteration. */
-    this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_Sff = zero;
-    this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_Smm = zero;
-    this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_Sfm = zero;
-    this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_Sf = zero;
-    this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_Sm = zero;
+    sffSum += chunk.st_Sff;
+    smmSum += chunk.st_Smm;
+    sfmSum += chunk.st_Sfm;
+    sfSum += chunk.st_Sf;
+    smSum += chunk.st_Sm;
   }
+  AccumulateType       sff = sffSum.GetSum();
+  AccumulateType       smm = smmSum.GetSum();
+  AccumulateType       sfm = sfmSum.GetSum();
+  const AccumulateType sf = sfSum.GetSum();
+  const AccumulateType sm = smSum.GetSum();
 
   /** If SubtractMean, then subtract things from sff, smm and sfm. */
   const RealType N = static_cast<RealType>(this->m_NumberOfPixelsCounted);
@@ -707,6 +802,15 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::Afte
   {
     value = NumericTraits<MeasureType>::Zero;
     derivative.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
+
+    /** Reset the derivative terms of the threads for the next iteration. */
+    const DerivativeValueType zero = NumericTraits<DerivativeValueType>::Zero;
+    for (ThreadIdType i = 0; i < this->m_CorrelationGetDerivativePerThreadVariablesSize; ++i)
+    {
+      this->m_CorrelationGetDerivativePerThreadVariables[i].st_DerivativeF.Fill(zero);
+      this->m_CorrelationGetDerivativePerThreadVariables[i].st_DerivativeM.Fill(zero);
+      this->m_CorrelationGetDerivativePerThreadVariables[i].st_Differential.Fill(zero);
+    }
     return;
   }
 
@@ -717,15 +821,15 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::Afte
   // single-threaded
   if (!this->m_UseMultiThread && false) // force multi-threaded
   {
-    DerivativeType & derivativeF = this->m_CorrelationGetValueAndDerivativePerThreadVariables[0].st_DerivativeF;
-    DerivativeType & derivativeM = this->m_CorrelationGetValueAndDerivativePerThreadVariables[0].st_DerivativeM;
-    DerivativeType & differential = this->m_CorrelationGetValueAndDerivativePerThreadVariables[0].st_Differential;
+    DerivativeType & derivativeF = this->m_CorrelationGetDerivativePerThreadVariables[0].st_DerivativeF;
+    DerivativeType & derivativeM = this->m_CorrelationGetDerivativePerThreadVariables[0].st_DerivativeM;
+    DerivativeType & differential = this->m_CorrelationGetDerivativePerThreadVariables[0].st_Differential;
 
-    for (ThreadIdType i = 1; i < numberOfThreads; ++i)
+    for (ThreadIdType i = 1; i < this->m_CorrelationGetDerivativePerThreadVariablesSize; ++i)
     {
-      derivativeF += this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_DerivativeF;
-      derivativeM += this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_DerivativeM;
-      differential += this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_Differential;
+      derivativeF += this->m_CorrelationGetDerivativePerThreadVariables[i].st_DerivativeF;
+      derivativeM += this->m_CorrelationGetDerivativePerThreadVariables[i].st_DerivativeM;
+      differential += this->m_CorrelationGetDerivativePerThreadVariables[i].st_Differential;
     }
 
     /** If SubtractMean, then subtract things from  derivativeF and derivativeM. */
@@ -776,20 +880,22 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::Afte
 #  pragma omp parallel for
     for (int j = 0; j < spaceDimension; ++j)
     {
-      DerivativeValueType derivativeF = this->m_CorrelationGetValueAndDerivativePerThreadVariables[0].st_DerivativeF[j];
-      DerivativeValueType derivativeM = this->m_CorrelationGetValueAndDerivativePerThreadVariables[0].st_DerivativeM[j];
-      DerivativeValueType differential =
-        this->m_CorrelationGetValueAndDerivativePerThreadVariables[0].st_Differential[j];
-
-      for (ThreadIdType i = 1; i < numberOfThreads; ++i)
+      DerivativeValueType derivativeF = this->m_CorrelationGetDerivativePerThreadVariables[0].st_DerivativeF[j];
+      DerivativeValueType derivativeM = this->m_CorrelationGetDerivativePerThreadVariables[0].st_DerivativeM[j];
+      for (ThreadIdType i = 1; i < this->m_CorrelationGetDerivativePerThreadVariablesSize; ++i)
       {
-        derivativeF += this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_DerivativeF[j];
-        derivativeM += this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_DerivativeM[j];
-        differential += this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_Differential[j];
+        derivativeF += this->m_CorrelationGetDerivativePerThreadVariables[i].st_DerivativeF[j];
+        derivativeM += this->m_CorrelationGetDerivativePerThreadVariables[i].st_DerivativeM[j];
       }
 
+      /** The differential is only allocated when SubtractMean is true. */
       if (this->m_SubtractMean)
       {
+        DerivativeValueType differential = this->m_CorrelationGetDerivativePerThreadVariables[0].st_Differential[j];
+        for (ThreadIdType i = 1; i < this->m_CorrelationGetDerivativePerThreadVariablesSize; ++i)
+        {
+          differential += this->m_CorrelationGetDerivativePerThreadVariables[i].st_Differential[j];
+        }
         derivativeF -= sf_N * differential;
         derivativeM -= sm_N * differential;
       }
@@ -823,6 +929,7 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::Accu
   const AccumulateType sfm_smm = temp->st_sfm_smm;
   const RealType       invertedDenominator = temp->st_InvertedDenominator;
   const bool           subtractMean = temp->st_Metric->m_SubtractMean;
+  const ThreadIdType   numberOfThreads = temp->st_Metric->m_CorrelationGetDerivativePerThreadVariablesSize;
 
   const unsigned int numPar = temp->st_Metric->GetNumberOfParameters();
   const unsigned int subSize =
@@ -831,30 +938,41 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::Accu
   unsigned int jmax = (threadId + 1) * subSize;
   jmax = (jmax > numPar) ? numPar : jmax;
 
-  const DerivativeValueType zero = NumericTraits<DerivativeValueType>::Zero;
-  DerivativeValueType       derivativeF, derivativeM, differential;
+  /** Sum the derivative terms over the threads, in thread order, using compensated summation.
+   * The differential is only accumulated when SubtractMean is true.
+   */
+  const DerivativeValueType                 zero = NumericTraits<DerivativeValueType>::Zero;
+  CompensatedSummation<DerivativeValueType> derivativeF, derivativeM, differential;
   for (unsigned int j = jmin; j < jmax; ++j)
   {
-    derivativeF = derivativeM = differential = zero;
-    for (ThreadIdType i = 0; i < nrOfThreads; ++i)
+    derivativeF.ResetToZero();
+    derivativeM.ResetToZero();
+    differential.ResetToZero();
+    for (ThreadIdType i = 0; i < numberOfThreads; ++i)
     {
-      derivativeF += temp->st_Metric->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_DerivativeF[j];
-      derivativeM += temp->st_Metric->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_DerivativeM[j];
-      differential += temp->st_Metric->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_Differential[j];
+      derivativeF += temp->st_Metric->m_CorrelationGetDerivativePerThreadVariables[i].st_DerivativeF[j];
+      derivativeM += temp->st_Metric->m_CorrelationGetDerivativePerThreadVariables[i].st_DerivativeM[j];
 
       /** Reset these variables for the next iteration. */
-      temp->st_Metric->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_DerivativeF[j] = zero;
-      temp->st_Metric->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_DerivativeM[j] = zero;
-      temp->st_Metric->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_Differential[j] = zero;
+      temp->st_Metric->m_CorrelationGetDerivativePerThreadVariables[i].st_DerivativeF[j] = zero;
+      temp->st_Metric->m_CorrelationGetDerivativePerThreadVariables[i].st_DerivativeM[j] = zero;
+
+      if (subtractMean)
+      {
+        differential += temp->st_Metric->m_CorrelationGetDerivativePerThreadVariables[i].st_Differential[j];
+        temp->st_Metric->m_CorrelationGetDerivativePerThreadVariables[i].st_Differential[j] = zero;
+      }
     }
 
+    DerivativeValueType derF = derivativeF.GetSum();
+    DerivativeValueType derM = derivativeM.GetSum();
     if (subtractMean)
     {
-      derivativeF -= sf_N * differential;
-      derivativeM -= sm_N * differential;
+      derF -= sf_N * differential.GetSum();
+      derM -= sm_N * differential.GetSum();
     }
 
-    temp->st_DerivativePointer[j] = (derivativeF - sfm_smm * derivativeM) * invertedDenominator;
+    temp->st_DerivativePointer[j] = (derF - sfm_smm * derM) * invertedDenominator;
   }
 
   return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
@@ -39,6 +39,13 @@ namespace elastix
  * The parameters used in this class are:
  * \parameter Metric: Select this metric as follows:\n
  *    <tt>(Metric "TransformBendingEnergyPenalty")</tt>
+ * \parameter UseAnalyticBendingEnergy: Whether the bending energy of a third order B-spline
+ *    transform is computed exactly from the B-spline coefficients, instead of from the samples.
+ *    The cost per iteration then depends on the number of coefficients only. The energy is
+ *    integrated over the fixed image region. It is not used with masks, or when the B-spline
+ *    grid is not aligned with the axes of the fixed image. \n
+ *    example: <tt>(UseAnalyticBendingEnergy "false" "true")</tt> \n
+ *    The default is "false".
  *
  * \ingroup Metrics
  *
@@ -133,6 +140,7 @@ public:
   /**
    * Do some things before each resolution:
    * \li Set options for SelfHessian
+   * \li Set the use of the analytic bending energy
    */
   void
   BeforeEachResolution(void) override;
@@ -39,6 +39,14 @@ TransformBendingEnergyPenalty<TElastix>::Initialize(void)
   elxout << "Initialization of TransformBendingEnergy metric took: " << static_cast<long>(timer.GetMean() * 1000)
          << " ms." << std::endl;
 
+  if (this->GetUseAnalyticBendingEnergy() && !this->GetAnalyticBendingEnergyIsAvailable())
+  {
+    xl::xout["warning"] << "WARNING: UseAnalyticBendingEnergy is only supported for a third order B-spline transform, "
+                        << "without an initial transform that is composed with it, without masks, "
+                        << "and with a grid that is aligned with the fixed image.\n"
+                        << "  The bending energy is computed from the samples instead." << std::endl;
+  }
+
 } // end Initialize()
 
 
@@ -59,6 +67,12 @@ TransformBendingEnergyPenalty<TElastix>::BeforeEachResolution(void)
     numberOfSamplesForSelfHessian, "NumberOfSamplesForSelfHessian", this->GetComponentLabel(), level, 0);
   this->SetNumberOfSamplesForSelfHessian(numberOfSamplesForSelfHessian);
 
+  /** Compute the bending energy from the B-spline coefficients or from the samples. */
+  bool useAnalyticBendingEnergy = false;
+  this->GetConfiguration()->ReadParameter(
+    useAnalyticBendingEnergy, "UseAnalyticBendingEnergy", this->GetComponentLabel(), level, 0);
+  this->SetUseAnalyticBendingEnergy(useAnalyticBendingEnergy);
+
 } // end BeforeEachResolution()
 
 
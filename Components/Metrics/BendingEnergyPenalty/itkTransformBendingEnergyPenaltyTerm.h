@@ -20,6 +20,7 @@
 
 #include "itkTransformPenaltyTerm.h"
 #include "itkImageGridSampler.h"
+#include "itkCyclicBSplineDeformableTransform.h"
 
 namespace itk
 {
@@ -43,6 +44,16 @@ namespace itk
  *      "Itk::Transforms supporting spatial derivatives"",
  *      Insight Journal, http://hdl.handle.net/10380/3215.
  *
+ * For a third order B-spline transform the bending energy is a quadratic form
+ * in the B-spline coefficients. With SetUseAnalyticBendingEnergy( true ) the
+ * banded matrix of this quadratic form is precomputed in Initialize(), once per
+ * resolution, and the value and derivative are computed as a sparse
+ * matrix-vector product over the coefficients, independent of the number of
+ * samples. The bending energy is then integrated exactly over the fixed image
+ * region, instead of averaged over the samples. The sample-based computation is
+ * used instead for other transforms, when a fixed or moving image mask is set, and
+ * when the axes of the fixed image are not aligned with those of the B-spline grid.
+ *
  * \ingroup Metrics
  */
 
@@ -123,6 +134,10 @@ public:
   /** Define the dimension. */
   itkStaticConstMacro(FixedImageDimension, unsigned int, FixedImageType::ImageDimension);
 
+  /** Initialize the penalty term. If requested, the analytic bending energy is set up here. */
+  void
+  Initialize(void) override;
+
   /** Get the penalty term value. */
   MeasureType
   GetValue(const ParametersType & parameters) const override;
@@ -158,6 +173,19 @@ public:
   itkSetMacro(NumberOfSamplesForSelfHessian, unsigned int);
   itkGetConstMacro(NumberOfSamplesForSelfHessian, unsigned int);
 
+  /** Compute the bending energy of a third order B-spline transform analytically,
+   * from the B-spline coefficients, instead of from the samples. Default: false.
+   */
+  itkSetMacro(UseAnalyticBendingEnergy, bool);
+  itkGetConstMacro(UseAnalyticBendingEnergy, bool);
+  itkBooleanMacro(UseAnalyticBendingEnergy);
+
+  /** Whether the analytic bending energy is actually used. This is only
+   * possible for a third order B-spline transform, without masks, whose grid is
+   * aligned with the fixed image. It is determined in Initialize().
+   */
+  itkGetConstMacro(AnalyticBendingEnergyIsAvailable, bool);
+
 protected:
   /** Typedefs for indices and points. */
   typedef typename Superclass::FixedImageIndexType            FixedImageIndexType;
@@ -171,6 +199,11 @@ protected:
   /** Typedefs for SelfHessian */
   typedef ImageGridSampler<FixedImageType> SelfHessianSamplerType;
 
+  /** Typedefs for the analytic bending energy. */
+  typedef CyclicBSplineDeformableTransform<ScalarType, FixedImageDimension, 3> CyclicBSplineTransformType;
+  typedef typename ParametersType::ValueType                                   ParametersValueType;
+  typedef typename BSplineOrder3TransformType::SizeType                        GridSizeType;
+
   /** The constructor. */
   TransformBendingEnergyPenaltyTerm();
 
@@ -184,7 +217,57 @@ private:
   void
   operator=(const Self &) = delete;
 
+  /** One term of the bending energy: the squared second order derivative
+   * d^2/dx_i dx_j, as the derivative orders of the B-spline per dimension.
+   */
+  struct AnalyticBendingEnergyTermType
+  {
+    FixedArray<unsigned int, FixedImageDimension> m_DerivativeOrders;
+    DerivativeValueType                           m_Weight;
+  };
+
+  /** Data of the analytic bending energy, shared by all threads.
+   * m_BandMatrices[ 3 * d + order ] contains, for every B-spline coefficient along
+   * dimension d, the 7 integrals of the product of its order'th derivative basis
+   * function with that of the coefficients at offsets -3 to 3.
+   */
+  struct AnalyticBendingEnergyParameterType
+  {
+    const ParametersValueType *                   m_Coefficients;
+    DerivativeValueType *                         m_Derivative;
+    GridSizeType                                  m_GridSize;
+    std::vector<std::vector<DerivativeValueType>> m_BandMatrices;
+    std::vector<AnalyticBendingEnergyTermType>    m_Terms;
+    std::vector<DerivativeValueType>              m_ThreadValues;
+  };
+
+  /** Precompute the banded bending energy matrix of the B-spline grid. */
+  void
+  InitializeAnalyticBendingEnergy(void);
+
+  /** Compute the value and derivative of the analytic bending energy. */
+  void
+  GetValueAndDerivativeAnalytic(const ParametersType & parameters,
+                                MeasureType &          value,
+                                DerivativeType &       derivative) const;
+
+  /** Compute the derivative for the slices [sliceBegin, sliceEnd) along the
+   * last dimension, and return the inner product with the coefficients there.
+   */
+  static DerivativeValueType
+  ThreadedGetValueAndDerivativeAnalytic(const AnalyticBendingEnergyParameterType & parameters,
+                                        const SizeValueType                        sliceBegin,
+                                        const SizeValueType                        sliceEnd);
+
+  /** Helper function to launch the threads of the analytic bending energy. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  GetValueAndDerivativeAnalyticThreaderCallback(void * arg);
+
   unsigned int m_NumberOfSamplesForSelfHessian;
+  bool         m_UseAnalyticBendingEnergy;
+  bool         m_AnalyticBendingEnergyIsAvailable;
+
+  mutable AnalyticBendingEnergyParameterType m_AnalyticBendingEnergyParameters;
 };
 
 } // end namespace itk
@@ -19,6 +19,11 @@
 #define itkTransformBendingEnergyPenaltyTerm_hxx
 
 #include "itkTransformBendingEnergyPenaltyTerm.h"
+#include "itkBSplineKernelFunction2.h"
+#include "itkBSplineDerivativeKernelFunction2.h"
+#include "itkBSplineSecondOrderDerivativeKernelFunction2.h"
+#include <algorithm>
+#include <cmath>
 
 #ifdef ELASTIX_USE_OPENMP
 #  include <omp.h>
@@ -38,12 +43,257 @@ TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::TransformBendingEne
 
   /** Turn on the sampler functionality. */
   this->SetUseImageSampler(true);
+  this->SetSupportsConcurrentGetValueAndDerivative(true);
 
   this->m_NumberOfSamplesForSelfHessian = 100000;
+  this->m_UseAnalyticBendingEnergy = false;
+  this->m_AnalyticBendingEnergyIsAvailable = false;
 
 } // end Constructor
 
 
+/**
+ * ****************** Initialize *******************************
+ */
+
+template <class TFixedImage, class TScalarType>
+void
+TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::Initialize(void)
+{
+  /** Call the superclass' implementation. */
+  this->Superclass::Initialize();
+
+  /** Precompute the bending energy matrix, once per resolution. */
+  this->InitializeAnalyticBendingEnergy();
+
+} // end Initialize()
+
+
+/**
+ * ****************** InitializeAnalyticBendingEnergy *******************************
+ */
+
+template <class TFixedImage, class TScalarType>
+void
+TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::InitializeAnalyticBendingEnergy(void)
+{
+  this->m_AnalyticBendingEnergyIsAvailable = false;
+  AnalyticBendingEnergyParameterType & parameters = this->m_AnalyticBendingEnergyParameters;
+  parameters.m_BandMatrices.clear();
+  parameters.m_Terms.clear();
+  if (!this->m_UseAnalyticBendingEnergy)
+  {
+    return;
+  }
+
+  /** The bending energy is only a fixed quadratic form in the coefficients of a
+   * third order B-spline transform, and the cyclic B-spline has other basis functions.
+   */
+  BSplineOrder3TransformPointer bspline;
+  if (!this->CheckForBSplineTransform2(bspline) || bspline.IsNull() ||
+      dynamic_cast<CyclicBSplineTransformType *>(bspline.GetPointer()) != nullptr ||
+      bspline->GetNumberOfParameters() != this->GetNumberOfParameters())
+  {
+    return;
+  }
+
+  /** An initial transform does not change the spatial Hessian only when it is added,
+   * and has no spatial Hessian itself, such as an affine transform.
+   */
+  const CombinationTransformType * combination =
+    dynamic_cast<const CombinationTransformType *>(this->m_AdvancedTransform.GetPointer());
+  if (combination != nullptr && combination->GetInitialTransform() != nullptr &&
+      (!combination->GetUseAddition() || combination->GetInitialTransform()->GetHasNonZeroSpatialHessian()))
+  {
+    return;
+  }
+
+  /** The samples are restricted by a mask, whereas the analytic energy is integrated
+   * over the whole fixed image region.
+   */
+  if (this->GetFixedImageMask() != nullptr || this->GetMovingImageMask() != nullptr)
+  {
+    return;
+  }
+
+  /** Compute the bounding box of the fixed image region in continuous grid
+   * indices, and restrict it to the region where the B-spline is valid.
+   */
+  typedef typename BSplineOrder3TransformType::DirectionType GridDirectionType;
+  typedef typename BSplineOrder3TransformType::SpacingType   GridSpacingType;
+  typedef typename BSplineOrder3TransformType::OriginType    GridOriginType;
+  typedef typename BSplineOrder3TransformType::RegionType    GridRegionType;
+  typedef ContinuousIndex<double, FixedImageDimension>       FixedImageContinuousIndexType;
+
+  const FixedImageRegionType & fixedImageRegion = this->GetFixedImageRegion();
+  const GridDirectionType      gridDirection = bspline->GetGridDirection();
+  const GridSpacingType        gridSpacing = bspline->GetGridSpacing();
+  const GridOriginType         gridOrigin = bspline->GetGridOrigin();
+  const GridRegionType         gridRegion = bspline->GetGridRegion();
+
+  GridDirectionType scale;
+  scale.SetIdentity();
+  for (unsigned int d = 0; d < FixedImageDimension; ++d)
+  {
+    scale[d][d] = gridSpacing[d];
+  }
+  const GridDirectionType pointToIndex((gridDirection * scale).GetInverse());
+
+  /** The fixed image region only maps onto its bounding box in grid indices when
+   * the axes of the fixed image are aligned with those of the B-spline grid. Each
+   * image axis must then map onto a single grid axis.
+   */
+  const typename FixedImageType::DirectionType & fixedDirection = this->GetFixedImage()->GetDirection();
+  const typename FixedImageType::SpacingType &   fixedSpacing = this->GetFixedImage()->GetSpacing();
+  for (unsigned int d = 0; d < FixedImageDimension; ++d)
+  {
+    double indexToGridIndex[FixedImageDimension];
+    double maximum = 0.0;
+    for (unsigned int e = 0; e < FixedImageDimension; ++e)
+    {
+      indexToGridIndex[e] = 0.0;
+      for (unsigned int f = 0; f < FixedImageDimension; ++f)
+      {
+        indexToGridIndex[e] += pointToIndex[d][f] * fixedDirection[f][e] * fixedSpacing[e];
+      }
+      maximum = std::max(maximum, std::abs(indexToGridIndex[e]));
+    }
+    unsigned int numberOfNonZeros = 0;
+    for (unsigned int e = 0; e < FixedImageDimension; ++e)
+    {
+      numberOfNonZeros += (std::abs(indexToGridIndex[e]) > 1e-6 * maximum) ? 1 : 0;
+    }
+    if (numberOfNonZeros != 1)
+    {
+      return;
+    }
+  }
+
+  double domainBegin[FixedImageDimension];
+  double domainEnd[FixedImageDimension];
+  std::fill_n(domainBegin, FixedImageDimension, NumericTraits<double>::max());
+  std::fill_n(domainEnd, FixedImageDimension, NumericTraits<double>::NonpositiveMin());
+  for (unsigned int corner = 0; corner < (1u << FixedImageDimension); ++corner)
+  {
+    FixedImageContinuousIndexType cindex;
+    for (unsigned int d = 0; d < FixedImageDimension; ++d)
+    {
+      const FixedImageIndexValueType offset =
+        (corner >> d) & 1u ? static_cast<FixedImageIndexValueType>(fixedImageRegion.GetSize()[d]) : 0;
+      cindex[d] = static_cast<double>(fixedImageRegion.GetIndex()[d] + offset) - 0.5;
+    }
+    FixedImagePointType point;
+    this->GetFixedImage()->TransformContinuousIndexToPhysicalPoint(cindex, point);
+
+    for (unsigned int d = 0; d < FixedImageDimension; ++d)
+    {
+      double u = 0.0;
+      for (unsigned int e = 0; e < FixedImageDimension; ++e)
+      {
+        u += pointToIndex[d][e] * (point[e] - gridOrigin[e]);
+      }
+      domainBegin[d] = std::min(domainBegin[d], u);
+      domainEnd[d] = std::max(domainEnd[d], u);
+    }
+  }
+
+  double volume = 1.0;
+  for (unsigned int d = 0; d < FixedImageDimension; ++d)
+  {
+    const double gridBegin = static_cast<double>(gridRegion.GetIndex()[d]);
+    domainBegin[d] = std::max(domainBegin[d], gridBegin + 1.0);
+    domainEnd[d] = std::min(domainEnd[d], gridBegin + static_cast<double>(gridRegion.GetSize()[d]) - 2.0);
+    if (!(domainEnd[d] > domainBegin[d]))
+    {
+      return;
+    }
+    volume *= domainEnd[d] - domainBegin[d];
+  }
+
+  /** The 1D band matrices are exact integrals of piecewise polynomials of at most
+   * degree 6 between the knots, computed with 4-point Gauss-Legendre quadrature.
+   */
+  const double nodes[4] = { 0.5 - 0.5 * 0.8611363115940526,
+                            0.5 - 0.5 * 0.3399810435848563,
+                            0.5 + 0.5 * 0.3399810435848563,
+                            0.5 + 0.5 * 0.8611363115940526 };
+  const double weights[4] = {
+    0.5 * 0.3478548451374538, 0.5 * 0.6521451548625461, 0.5 * 0.6521451548625461, 0.5 * 0.3478548451374538
+  };
+
+  KernelFunctionBase2<double>::Pointer kernels[3];
+  kernels[0] = BSplineKernelFunction2<3>::New();
+  kernels[1] = BSplineDerivativeKernelFunction2<3>::New();
+  kernels[2] = BSplineSecondOrderDerivativeKernelFunction2<3>::New();
+
+  parameters.m_GridSize = gridRegion.GetSize();
+  parameters.m_BandMatrices.resize(3 * FixedImageDimension);
+  for (unsigned int d = 0; d < FixedImageDimension; ++d)
+  {
+    const SizeValueType n = parameters.m_GridSize[d];
+    const double        gridBegin = static_cast<double>(gridRegion.GetIndex()[d]);
+    for (unsigned int order = 0; order < 3; ++order)
+    {
+      const KernelFunctionBase2<double> & kernel = *kernels[order];
+      std::vector<DerivativeValueType> &  band = parameters.m_BandMatrices[3 * d + order];
+      band.assign(7 * n, NumericTraits<DerivativeValueType>::ZeroValue());
+
+      for (SizeValueType c = 0; c < n; ++c)
+      {
+        const double knot1 = gridBegin + static_cast<double>(c);
+        for (int offset = -3; offset <= 3; ++offset)
+        {
+          const double knot2 = knot1 + offset;
+          if (knot2 < gridBegin || knot2 > gridBegin + static_cast<double>(n - 1))
+          {
+            continue;
+          }
+
+          /** Integrate over the common support, within the domain, interval by interval. */
+          const double begin = std::max(domainBegin[d], std::max(knot1, knot2) - 2.0);
+          const double end = std::min(domainEnd[d], std::min(knot1, knot2) + 2.0);
+          double       integral = 0.0;
+          for (double knot = std::floor(begin); knot < end; knot += 1.0)
+          {
+            const double intervalBegin = std::max(begin, knot);
+            const double length = std::min(end, knot + 1.0) - intervalBegin;
+            for (unsigned int q = 0; length > 0.0 && q < 4; ++q)
+            {
+              const double u = intervalBegin + length * nodes[q];
+              integral += length * weights[q] * kernel.Evaluate(u - knot1) * kernel.Evaluate(u - knot2);
+            }
+          }
+          band[7 * c + offset + 3] = static_cast<DerivativeValueType>(integral);
+        }
+      }
+    }
+  }
+
+  /** The squared Frobenius norm of the spatial Hessian in physical space equals
+   * sum_ij ( d^2T/du_i du_j )^2 / ( h_i^2 h_j^2 ), with u the continuous grid index
+   * and h the grid spacing, since the grid direction is orthonormal. The weights
+   * contain the normalization by the volume of the domain, and the factor 2 of the
+   * derivative of the quadratic form.
+   */
+  for (unsigned int i = 0; i < FixedImageDimension; ++i)
+  {
+    for (unsigned int j = i; j < FixedImageDimension; ++j)
+    {
+      AnalyticBendingEnergyTermType term;
+      term.m_DerivativeOrders.Fill(0);
+      term.m_DerivativeOrders[i] += 1;
+      term.m_DerivativeOrders[j] += 1;
+      const double h2 = gridSpacing[i] * gridSpacing[i] * gridSpacing[j] * gridSpacing[j];
+      term.m_Weight = static_cast<DerivativeValueType>((i == j ? 2.0 : 4.0) / (h2 * volume));
+      parameters.m_Terms.push_back(term);
+    }
+  }
+
+  this->m_AnalyticBendingEnergyIsAvailable = true;
+
+} // end InitializeAnalyticBendingEnergy()
+
+
 /**
  * ****************** GetValue *******************************
  */
@@ -63,6 +313,15 @@ TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::GetValue(const Para
     return static_cast<MeasureType>(measure);
   }
 
+  /** Compute the bending energy from the B-spline coefficients, if possible. */
+  if (this->m_AnalyticBendingEnergyIsAvailable)
+  {
+    MeasureType    value = NumericTraits<MeasureType>::Zero;
+    DerivativeType derivative;
+    this->GetValueAndDerivativeAnalytic(parameters, value, derivative);
+    return value;
+  }
+
   /** Call non-thread-safe stuff, such as:
    *   this->SetTransformParameters( parameters );
    *   this->GetImageSampler()->Update();
@@ -354,6 +613,12 @@ TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivati
                                                                                    MeasureType &          value,
                                                                                    DerivativeType & derivative) const
 {
+  /** Compute the bending energy from the B-spline coefficients, if possible. */
+  if (this->m_AnalyticBendingEnergyIsAvailable)
+  {
+    return this->GetValueAndDerivativeAnalytic(parameters, value, derivative);
+  }
+
   /** Option for now to still use the single threaded code. */
   if (!this->m_UseMultiThread)
   {
@@ -645,6 +910,191 @@ TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::AfterThreadedGetVal
 } // end AfterThreadedGetValueAndDerivative()
 
 
+/**
+ * ******************* GetValueAndDerivativeAnalytic *******************
+ */
+
+template <class TFixedImage, class TScalarType>
+void
+TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivativeAnalytic(
+  const ParametersType & parameters,
+  MeasureType &          value,
+  DerivativeType &       derivative) const
+{
+  /** Only the transform parameters are needed, not the samples. */
+  if (this->m_UseMetricSingleThreaded)
+  {
+    this->SetTransformParameters(parameters);
+  }
+
+  derivative = DerivativeType(this->GetNumberOfParameters());
+
+  AnalyticBendingEnergyParameterType & analyticParameters = this->m_AnalyticBendingEnergyParameters;
+  analyticParameters.m_Coefficients = parameters.data_block();
+  analyticParameters.m_Derivative = derivative.data_block();
+
+  /** The energy is the quadratic form 1/2 mu^T Q mu, and the derivative is Q mu. */
+  const SizeValueType numberOfSlices = analyticParameters.m_GridSize[FixedImageDimension - 1];
+  DerivativeValueType innerProduct = NumericTraits<DerivativeValueType>::ZeroValue();
+  if (!this->m_UseMultiThread)
+  {
+    innerProduct = Self::ThreadedGetValueAndDerivativeAnalytic(analyticParameters, 0, numberOfSlices);
+  }
+  else
+  {
+    analyticParameters.m_ThreadValues.assign(this->m_Threader->GetNumberOfWorkUnits(),
+                                             NumericTraits<DerivativeValueType>::ZeroValue());
+
+    this->m_Threader->SetSingleMethod(this->GetValueAndDerivativeAnalyticThreaderCallback,
+                                      const_cast<void *>(static_cast<const void *>(&analyticParameters)));
+    this->m_Threader->SingleMethodExecute();
+
+    for (const DerivativeValueType threadValue : analyticParameters.m_ThreadValues)
+    {
+      innerProduct += threadValue;
+    }
+  }
+
+  value = static_cast<MeasureType>(0.5 * innerProduct);
+
+} // end GetValueAndDerivativeAnalytic()
+
+
+/**
+ * ******************* ThreadedGetValueAndDerivativeAnalytic *******************
+ */
+
+template <class TFixedImage, class TScalarType>
+typename TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::DerivativeValueType
+TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::ThreadedGetValueAndDerivativeAnalytic(
+  const AnalyticBendingEnergyParameterType & parameters,
+  const SizeValueType                        sliceBegin,
+  const SizeValueType                        sliceEnd)
+{
+  const unsigned int lastDim = FixedImageDimension - 1;
+
+  /** The coefficient images are stored one after the other, with the first dimension running fastest. */
+  SizeValueType stride[FixedImageDimension];
+  stride[0] = 1;
+  for (unsigned int d = 1; d < FixedImageDimension; ++d)
+  {
+    stride[d] = stride[d - 1] * parameters.m_GridSize[d - 1];
+  }
+  const SizeValueType sliceSize = stride[lastDim];
+  const SizeValueType numberOfSlices = parameters.m_GridSize[lastDim];
+  const SizeValueType numberOfCoefficients = sliceSize * numberOfSlices;
+  if (sliceBegin >= sliceEnd)
+  {
+    return NumericTraits<DerivativeValueType>::ZeroValue();
+  }
+
+  /** The band matrices couple coefficients at most 3 apart, so the passes within
+   * the slices are done on a halo of 3 slices on both sides.
+   */
+  const SizeValueType haloBegin = sliceBegin > 3 ? sliceBegin - 3 : 0;
+  const SizeValueType haloEnd = std::min(sliceEnd + 3, numberOfSlices);
+  const SizeValueType bufferSize = (haloEnd - haloBegin) * sliceSize;
+
+  std::vector<DerivativeValueType> coefficients(bufferSize);
+  std::vector<DerivativeValueType> buffers[2] = { std::vector<DerivativeValueType>(bufferSize),
+                                                  std::vector<DerivativeValueType>(bufferSize) };
+
+  DerivativeValueType innerProduct = NumericTraits<DerivativeValueType>::ZeroValue();
+  for (unsigned int k = 0; k < FixedImageDimension; ++k)
+  {
+    const ParametersValueType * input = parameters.m_Coefficients + k * numberOfCoefficients;
+    DerivativeValueType *       output = parameters.m_Derivative + k * numberOfCoefficients;
+    std::copy(input + haloBegin * sliceSize, input + haloEnd * sliceSize, coefficients.begin());
+    std::fill(output + sliceBegin * sliceSize, output + sliceEnd * sliceSize, DerivativeValueType(0));
+
+    for (const AnalyticBendingEnergyTermType & term : parameters.m_Terms)
+    {
+      /** Do the band matrix products along the dimensions within a slice. */
+      const DerivativeValueType * in = coefficients.data();
+      for (unsigned int d = 0; d < lastDim; ++d)
+      {
+        const SizeValueType         n = parameters.m_GridSize[d];
+        const SizeValueType         s = stride[d];
+        const DerivativeValueType * band = parameters.m_BandMatrices[3 * d + term.m_DerivativeOrders[d]].data();
+        DerivativeValueType *       out = buffers[d % 2].data();
+
+        for (SizeValueType outer = 0; outer < bufferSize; outer += n * s)
+        {
+          for (SizeValueType c = 0; c < n; ++c)
+          {
+            DerivativeValueType * current = out + outer + c * s;
+            std::fill(current, current + s, DerivativeValueType(0));
+            for (SizeValueType c2 = c > 3 ? c - 3 : 0; c2 < std::min(c + 4, n); ++c2)
+            {
+              const DerivativeValueType   weight = band[7 * c + 3 + c2 - c];
+              const DerivativeValueType * neighbor = in + outer + c2 * s;
+              for (SizeValueType inner = 0; inner < s; ++inner)
+              {
+                current[inner] += weight * neighbor[inner];
+              }
+            }
+          }
+        }
+        in = out;
+      }
+
+      /** Do the product along the last dimension, directly into the derivative. */
+      const DerivativeValueType * band =
+        parameters.m_BandMatrices[3 * lastDim + term.m_DerivativeOrders[lastDim]].data();
+      for (SizeValueType z = sliceBegin; z < sliceEnd; ++z)
+      {
+        DerivativeValueType * current = output + z * sliceSize;
+        for (SizeValueType z2 = z > 3 ? z - 3 : 0; z2 < std::min(z + 4, numberOfSlices); ++z2)
+        {
+          const DerivativeValueType   weight = term.m_Weight * band[7 * z + 3 + z2 - z];
+          const DerivativeValueType * neighbor = in + (z2 - haloBegin) * sliceSize;
+          for (SizeValueType i = 0; i < sliceSize; ++i)
+          {
+            current[i] += weight * neighbor[i];
+          }
+        }
+      }
+    }
+
+    for (SizeValueType i = sliceBegin * sliceSize; i < sliceEnd * sliceSize; ++i)
+    {
+      innerProduct += input[i] * output[i];
+    }
+  }
+
+  return innerProduct;
+
+} // end ThreadedGetValueAndDerivativeAnalytic()
+
+
+/**
+ * ******************* GetValueAndDerivativeAnalyticThreaderCallback *******************
+ */
+
+template <class TFixedImage, class TScalarType>
+ITK_THREAD_RETURN_TYPE
+TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivativeAnalyticThreaderCallback(void * arg)
+{
+  ThreadInfoType *   infoStruct = static_cast<ThreadInfoType *>(arg);
+  const ThreadIdType threadId = infoStruct->WorkUnitID;
+  const ThreadIdType numberOfThreads = infoStruct->NumberOfWorkUnits;
+
+  AnalyticBendingEnergyParameterType & parameters =
+    *static_cast<AnalyticBendingEnergyParameterType *>(infoStruct->UserData);
+
+  /** Divide the slices along the last dimension over the threads. */
+  const SizeValueType numberOfSlices = parameters.m_GridSize[FixedImageDimension - 1];
+  const SizeValueType slicesPerThread = (numberOfSlices + numberOfThreads - 1) / numberOfThreads;
+  const SizeValueType sliceBegin = std::min<SizeValueType>(slicesPerThread * threadId, numberOfSlices);
+  const SizeValueType sliceEnd = std::min<SizeValueType>(slicesPerThread * (threadId + 1), numberOfSlices);
+
+  parameters.m_ThreadValues[threadId] = Self::ThreadedGetValueAndDerivativeAnalytic(parameters, sliceBegin, sliceEnd);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end GetValueAndDerivativeAnalyticThreaderCallback()
+
+
 /**
  * ******************* GetSelfHessian *******************
  */
@@ -29,8 +29,10 @@ namespace itk
 
 template <class TFixedPointSet, class TMovingPointSet>
 CorrespondingPointsEuclideanDistancePointMetric<TFixedPointSet,
-                                                TMovingPointSet>::CorrespondingPointsEuclideanDistancePointMetric() =
-  default; // end Constructor
+                                                TMovingPointSet>::CorrespondingPointsEuclideanDistancePointMetric()
+{
+  this->SetSupportsConcurrentGetValueAndDerivative(true);
+} // end Constructor
 
 /**
  * ******************* GetValue *******************
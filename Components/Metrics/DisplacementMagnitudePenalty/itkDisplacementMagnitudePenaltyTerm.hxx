@@ -35,6 +35,7 @@ DisplacementMagnitudePenaltyTerm<TFixedImage, TScalarType>::DisplacementMagnitud
 
   /** Turn on the sampler functionality */
   this->SetUseImageSampler(true);
+  this->SetSupportsConcurrentGetValueAndDerivative(true);
 
 } // end constructor
 
@@ -158,6 +158,10 @@ public:
   void
   GetDerivative(const ParametersType & parameters, DerivativeType & derivative) const override;
 
+  /** Contains calls from GetValueAndDerivative that are thread-unsafe. */
+  void
+  BeforeThreadedGetValueAndDerivative(const TransformParametersType & parameters) const override;
+
   /** The GetValueAndDerivative()-method returns the rigid penalty value and its derivative. */
   void
   GetValueAndDerivative(const ParametersType & parameters,
@@ -47,6 +47,7 @@ DistancePreservingRigidityPenaltyTerm<TFixedImage, TScalarType>::DistancePreserv
 
   /** We don't use an image sampler for this advanced metric. */
   this->SetUseImageSampler(false);
+  this->SetSupportsConcurrentGetValueAndDerivative(true);
 
 } // end Constructor
 
@@ -289,6 +290,24 @@ DistancePreservingRigidityPenaltyTerm<TFixedImage, TScalarType>::GetDerivative(c
 } // end GetDerivative()
 
 
+/**
+ * *********************** BeforeThreadedGetValueAndDerivative ***********************
+ */
+
+template <class TFixedImage, class TScalarType>
+void
+DistancePreservingRigidityPenaltyTerm<TFixedImage, TScalarType>::BeforeThreadedGetValueAndDerivative(
+  const TransformParametersType & parameters) const
+{
+  /** In this function do all stuff that cannot be multi-threaded. */
+  if (this->m_UseMetricSingleThreaded)
+  {
+    this->m_BSplineTransform->SetParameters(parameters);
+  }
+
+} // end BeforeThreadedGetValueAndDerivative()
+
+
 /**
  * *********************** GetValueAndDerivative ****************
  */
@@ -308,7 +327,8 @@ DistancePreservingRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDeri
   derivative = DerivativeType(this->GetNumberOfParameters());
   derivative.Fill(NumericTraits<MeasureType>::ZeroValue());
 
-  this->m_BSplineTransform->SetParameters(parameters);
+  /** Make sure the transform parameters are up to date. */
+  this->BeforeThreadedGetValueAndDerivative(parameters);
 
   /** Distance-preserving penalty */
   MeasureType penaltyTermBuffer = 0.0;
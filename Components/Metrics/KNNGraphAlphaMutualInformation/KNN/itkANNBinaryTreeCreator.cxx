@@ -22,6 +22,7 @@ namespace itk
 {
 
 unsigned int ANNBinaryTreeCreator::m_NumberOfANNBinaryTrees = 0;
+std::mutex   ANNBinaryTreeCreator::m_NumberOfANNBinaryTreesMutex;
 
 /**
  * ************************ CreateANNkDTree *************************
@@ -103,6 +104,7 @@ ANNBinaryTreeCreator::DeleteANNBruteForceTree(ANNBruteForceTreeType *& tree)
 void
 ANNBinaryTreeCreator::IncreaseReferenceCount(void)
 {
+  const std::lock_guard<std::mutex> lock(m_NumberOfANNBinaryTreesMutex);
   m_NumberOfANNBinaryTrees++;
 } // end IncreaseReferenceCount
 
@@ -114,6 +116,7 @@ ANNBinaryTreeCreator::IncreaseReferenceCount(void)
 void
 ANNBinaryTreeCreator::DecreaseReferenceCount(void)
 {
+  const std::lock_guard<std::mutex> lock(m_NumberOfANNBinaryTreesMutex);
   m_NumberOfANNBinaryTrees--;
   if (m_NumberOfANNBinaryTrees == 0)
   {
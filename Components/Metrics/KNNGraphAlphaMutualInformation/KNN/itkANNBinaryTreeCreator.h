@@ -23,6 +23,8 @@
 #include "itkObjectFactory.h"
 #include "ANN/ANN.h"
 
+#include <mutex>
+
 namespace itk
 {
 
@@ -64,6 +66,8 @@ public:
    * of any sort exist, we can call annClose(). This little
    * function is cause of going through the trouble of creating
    * this class with static creating functions.
+   * The reference count is guarded by a mutex, so that trees
+   * may be created and deleted from several threads at once.
    */
 
   /** Static function to create an ANN kDTree. */
@@ -110,6 +114,7 @@ private:
 
   /** Member variables. */
   static unsigned int m_NumberOfANNBinaryTrees;
+  static std::mutex   m_NumberOfANNBinaryTreesMutex;
 };
 
 } // end namespace itk
@@ -67,7 +67,10 @@ public:
   itkSetMacro(KNearestNeighbors, unsigned int);
   itkGetConstMacro(KNearestNeighbors, unsigned int);
 
-  /** Search the nearest neighbours of a query point qp. */
+  /** Search the nearest neighbours of a query point qp.
+   * Once the binary tree is set, this function may be called
+   * concurrently from several threads.
+   */
   virtual void
   Search(const MeasurementVectorType & qp, IndexArrayType & ind, DistanceArrayType & dists) = 0;
 
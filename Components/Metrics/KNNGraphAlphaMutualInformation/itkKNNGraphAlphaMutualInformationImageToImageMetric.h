@@ -167,6 +167,10 @@ public:
   typedef typename DerivativeType::ValueType        DerivativeValueType;
   typedef typename TransformJacobianType::ValueType TransformJacobianValueType;
 
+  /** Typedefs for multi-threading. */
+  typedef typename Superclass::ThreaderType   ThreaderType;
+  typedef typename Superclass::ThreadInfoType ThreadInfoType;
+
   /**
    * *** Set trees: ***
    * Currently kd, bd, and brute force trees are supported.
@@ -291,6 +295,25 @@ private:
   typedef Array2D<double>                         SpatialDerivativeType;
   typedef std::vector<SpatialDerivativeType>      SpatialDerivativeContainerType;
 
+  /** Typedef for the sum of the graph lengths. */
+  typedef typename NumericTraits<MeasureType>::AccumulateType AccumulateType;
+
+  /** To give the threads access to all member variables and functions. */
+  struct KNNGraphAlphaMIMultiThreaderParameterType
+  {
+    const Self *                                  st_Metric;
+    const ListSampleType *                        st_ListSampleFixed;
+    const ListSampleType *                        st_ListSampleMoving;
+    const ListSampleType *                        st_ListSampleJoint;
+    bool                                          st_DoDerivative;
+    const TransformJacobianContainerType *        st_Jacobians;
+    const TransformJacobianIndicesContainerType * st_JacobiansIndices;
+    const SpatialDerivativeContainerType *        st_SpatialDerivatives;
+    std::vector<AccumulateType>                   st_SumG;
+    std::vector<DerivativeType>                   st_Contribution;
+  };
+  mutable KNNGraphAlphaMIMultiThreaderParameterType m_KNNGraphAlphaMIThreaderParameters;
+
   /** This function takes the fixed image samples from the ImageSampler
    * and puts them in the listSampleFixed, together with the fixed feature
    * image samples. Also the corresponding moving image values and moving
@@ -339,6 +362,41 @@ private:
                            const MeasureType &                distance_J,
                            DerivativeType &                   dGamma_M,
                            DerivativeType &                   dGamma_J) const;
+
+  /** Set the list samples in the three trees, generate the trees and connect
+   * them to the searchers. When multi-threading is enabled, the three trees
+   * are generated concurrently.
+   */
+  void
+  GenerateTreesAndConnectSearchers(const ListSamplePointer & listSampleFixed,
+                                   const ListSamplePointer & listSampleMoving,
+                                   const ListSamplePointer & listSampleJoint) const;
+
+  /** Generate the trees multi-threaded; each thread generates one of the three trees. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  GenerateTreesThreaderCallback(void * arg);
+
+  /** Search the k nearest neighbours of the query points (samples) in the
+   * range [ begin, end [, and add their contribution to the sum of the
+   * graph lengths sumG and, if requested, to the derivative contribution.
+   * The tree searchers may be called concurrently from several threads.
+   */
+  void
+  ComputeContributionOfQueryPoints(const KNNGraphAlphaMIMultiThreaderParameterType & parameters,
+                                   const unsigned long                               begin,
+                                   const unsigned long                               end,
+                                   AccumulateType &                                  sumG,
+                                   DerivativeType &                                  contribution) const;
+
+  /** Compute the contribution of all query points, multi-threaded when
+   * enabled, and sum the results of all threads.
+   */
+  void
+  LaunchComputeContributionOfQueryPoints(AccumulateType & sumG, DerivativeType & contribution) const;
+
+  /** Multi-threaded version of ComputeContributionOfQueryPoints(). */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  ComputeContributionOfQueryPointsThreaderCallback(void * arg);
 };
 
 } // end namespace itk
@@ -20,6 +20,9 @@
 
 #include "itkKNNGraphAlphaMutualInformationImageToImageMetric.h"
 
+#include <algorithm> // For min.
+#include <cmath>     // For ceil, pow and sqrt.
+
 namespace itk
 {
 
@@ -44,6 +47,15 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage,
   this->m_BinaryKNNTreeSearcherMoving = nullptr;
   this->m_BinaryKNNTreeSearcherJoint = nullptr;
 
+  this->m_KNNGraphAlphaMIThreaderParameters.st_Metric = this;
+  this->m_KNNGraphAlphaMIThreaderParameters.st_ListSampleFixed = nullptr;
+  this->m_KNNGraphAlphaMIThreaderParameters.st_ListSampleMoving = nullptr;
+  this->m_KNNGraphAlphaMIThreaderParameters.st_ListSampleJoint = nullptr;
+  this->m_KNNGraphAlphaMIThreaderParameters.st_DoDerivative = false;
+  this->m_KNNGraphAlphaMIThreaderParameters.st_Jacobians = nullptr;
+  this->m_KNNGraphAlphaMIThreaderParameters.st_JacobiansIndices = nullptr;
+  this->m_KNNGraphAlphaMIThreaderParameters.st_SpatialDerivatives = nullptr;
+
 } // end Constructor()
 
 
@@ -325,22 +337,7 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Get
    * and connect them to the searchers.
    */
 
-  /** Generate the tree for the fixed image samples. */
-  this->m_BinaryKNNTreeFixed->SetSample(listSampleFixed);
-  this->m_BinaryKNNTreeFixed->GenerateTree();
-
-  /** Generate the tree for the moving image samples. */
-  this->m_BinaryKNNTreeMoving->SetSample(listSampleMoving);
-  this->m_BinaryKNNTreeMoving->GenerateTree();
-
-  /** Generate the tree for the joint image samples. */
-  this->m_BinaryKNNTreeJoint->SetSample(listSampleJoint);
-  this->m_BinaryKNNTreeJoint->GenerateTree();
-
-  /** Initialize tree searchers. */
-  this->m_BinaryKNNTreeSearcherFixed->SetBinaryTree(this->m_BinaryKNNTreeFixed);
-  this->m_BinaryKNNTreeSearcherMoving->SetBinaryTree(this->m_BinaryKNNTreeMoving);
-  this->m_BinaryKNNTreeSearcherJoint->SetBinaryTree(this->m_BinaryKNNTreeJoint);
+  this->GenerateTreesAndConnectSearchers(listSampleFixed, listSampleMoving, listSampleJoint);
 
   /**
    * *************** Estimate the \alpha MI ******************
@@ -375,77 +372,20 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Get
    * where d1 and d2 are the possibly different dimensions of the two feature sets.
    */
 
-  /** Temporary variables. */
-  typedef typename NumericTraits<MeasureType>::AccumulateType AccumulateType;
-  MeasurementVectorType                                       z_F, z_M, z_J;
-  IndexArrayType                                              indices_F, indices_M, indices_J;
-  DistanceArrayType                                           distances_F, distances_M, distances_J;
-
-  MeasureType    H, G;
+  /** Setup the threader parameters. */
+  KNNGraphAlphaMIMultiThreaderParameterType & threaderParameters = this->m_KNNGraphAlphaMIThreaderParameters;
+  threaderParameters.st_ListSampleFixed = listSampleFixed.GetPointer();
+  threaderParameters.st_ListSampleMoving = listSampleMoving.GetPointer();
+  threaderParameters.st_ListSampleJoint = listSampleJoint.GetPointer();
+  threaderParameters.st_DoDerivative = false;
+  threaderParameters.st_Jacobians = nullptr;
+  threaderParameters.st_JacobiansIndices = nullptr;
+  threaderParameters.st_SpatialDerivatives = nullptr;
+
+  /** Search the neighbours of all query points, i.e. all samples, and sum the graph lengths. */
   AccumulateType sumG = NumericTraits<AccumulateType>::Zero;
-
-  /** Get the size of the feature vectors. */
-  unsigned int fixedSize = this->GetNumberOfFixedImages();
-  unsigned int movingSize = this->GetNumberOfMovingImages();
-  unsigned int jointSize = fixedSize + movingSize;
-
-  /** Get the number of neighbours and \gamma. */
-  unsigned int k = this->m_BinaryKNNTreeSearcherFixed->GetKNearestNeighbors();
-  double       twoGamma = jointSize * (1.0 - this->m_Alpha);
-
-  /** Loop over all query points, i.e. all samples. */
-  for (unsigned long i = 0; i < this->m_NumberOfPixelsCounted; i++)
-  {
-    /** Get the i-th query point. */
-    listSampleFixed->GetMeasurementVector(i, z_F);
-    listSampleMoving->GetMeasurementVector(i, z_M);
-    listSampleJoint->GetMeasurementVector(i, z_J);
-
-    /** Search for the K nearest neighbours of the current query point. */
-    this->m_BinaryKNNTreeSearcherFixed->Search(z_F, indices_F, distances_F);
-    this->m_BinaryKNNTreeSearcherMoving->Search(z_M, indices_M, distances_M);
-    this->m_BinaryKNNTreeSearcherJoint->Search(z_J, indices_J, distances_J);
-
-    /** Add the distances between the points to get the total graph length.
-     * The outcommented implementation calculates: sum J/sqrt(F*M)
-     *
-    for ( unsigned int j = 0; j < K; j++ )
-    {
-    enumerator = std::sqrt( distsJ[ j ] );
-    denominator = std::sqrt( std::sqrt( distsF[ j ] ) * std::sqrt( distsM[ j ] ) );
-    if ( denominator > 1e-14 )
-    {
-    contribution += std::pow( enumerator / denominator, twoGamma );
-    }
-    }*/
-
-    /** Add the distances of all neighbours of the query point,
-     * for the three graphs:
-     * sum M / sqrt( sum F * sum M)
-     */
-
-    /** Variables to compute the measure. */
-    AccumulateType Gamma_F = NumericTraits<AccumulateType>::Zero;
-    AccumulateType Gamma_M = NumericTraits<AccumulateType>::Zero;
-    AccumulateType Gamma_J = NumericTraits<AccumulateType>::Zero;
-
-    /** Loop over the neighbours. */
-    for (unsigned int p = 0; p < k; p++)
-    {
-      Gamma_F += std::sqrt(distances_F[p]);
-      Gamma_M += std::sqrt(distances_M[p]);
-      Gamma_J += std::sqrt(distances_J[p]);
-    } // end loop over the k neighbours
-
-    /** Calculate the contribution of this query point. */
-    H = std::sqrt(Gamma_F * Gamma_M);
-    if (H > this->m_AvoidDivisionBy)
-    {
-      /** Compute some sums. */
-      G = Gamma_J / H;
-      sumG += std::pow(G, twoGamma);
-    }
-  } // end looping over all query points
+  DerivativeType dummyContribution;
+  this->LaunchComputeContributionOfQueryPoints(sumG, dummyContribution);
 
   /**
    * *************** Finally, calculate the metric value \alpha MI ******************
@@ -549,22 +489,7 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Get
    * and connect them to the searchers.
    */
 
-  /** Generate the tree for the fixed image samples. */
-  this->m_BinaryKNNTreeFixed->SetSample(listSampleFixed);
-  this->m_BinaryKNNTreeFixed->GenerateTree();
-
-  /** Generate the tree for the moving image samples. */
-  this->m_BinaryKNNTreeMoving->SetSample(listSampleMoving);
-  this->m_BinaryKNNTreeMoving->GenerateTree();
-
-  /** Generate the tree for the joint image samples. */
-  this->m_BinaryKNNTreeJoint->SetSample(listSampleJoint);
-  this->m_BinaryKNNTreeJoint->GenerateTree();
-
-  /** Initialize tree searchers. */
-  this->m_BinaryKNNTreeSearcherFixed->SetBinaryTree(this->m_BinaryKNNTreeFixed);
-  this->m_BinaryKNNTreeSearcherMoving->SetBinaryTree(this->m_BinaryKNNTreeMoving);
-  this->m_BinaryKNNTreeSearcherJoint->SetBinaryTree(this->m_BinaryKNNTreeJoint);
+  this->GenerateTreesAndConnectSearchers(listSampleFixed, listSampleMoving, listSampleJoint);
 
   /**
    * *************** Estimate the \alpha MI and its derivatives ******************
@@ -599,109 +524,26 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Get
    * where d1 and d2 are the possibly different dimensions of the two feature sets.
    */
 
-  /** Temporary variables. */
-  typedef typename NumericTraits<MeasureType>::AccumulateType AccumulateType;
-  MeasurementVectorType                                       z_F, z_M, z_J, z_M_ip, z_J_ip, diff_M, diff_J;
-  IndexArrayType                                              indices_F, indices_M, indices_J;
-  DistanceArrayType                                           distances_F, distances_M, distances_J;
-  MeasureType                                                 distance_F, distance_M, distance_J;
-
-  MeasureType    H, G, Gpow;
+  /** Setup the threader parameters. */
+  KNNGraphAlphaMIMultiThreaderParameterType & threaderParameters = this->m_KNNGraphAlphaMIThreaderParameters;
+  threaderParameters.st_ListSampleFixed = listSampleFixed.GetPointer();
+  threaderParameters.st_ListSampleMoving = listSampleMoving.GetPointer();
+  threaderParameters.st_ListSampleJoint = listSampleJoint.GetPointer();
+  threaderParameters.st_DoDerivative = true;
+  threaderParameters.st_Jacobians = &jacobianContainer;
+  threaderParameters.st_JacobiansIndices = &jacobianIndicesContainer;
+  threaderParameters.st_SpatialDerivatives = &spatialDerivativesContainer;
+
+  /** Search the neighbours of all query points, i.e. all samples, and sum
+   * the graph lengths and their derivatives.
+   */
   AccumulateType sumG = NumericTraits<AccumulateType>::Zero;
-
   DerivativeType contribution(this->GetNumberOfParameters());
   contribution.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
-  DerivativeType dGamma_M(this->GetNumberOfParameters());
-  DerivativeType dGamma_J(this->GetNumberOfParameters());
+  this->LaunchComputeContributionOfQueryPoints(sumG, contribution);
 
   /** Get the size of the feature vectors. */
-  unsigned int fixedSize = this->GetNumberOfFixedImages();
-  unsigned int movingSize = this->GetNumberOfMovingImages();
-  unsigned int jointSize = fixedSize + movingSize;
-
-  /** Get the number of neighbours and \gamma. */
-  unsigned int k = this->m_BinaryKNNTreeSearcherFixed->GetKNearestNeighbors();
-  double       twoGamma = jointSize * (1.0 - this->m_Alpha);
-
-  /** Loop over all query points, i.e. all samples. */
-  for (unsigned long i = 0; i < this->m_NumberOfPixelsCounted; i++)
-  {
-    /** Get the i-th query point. */
-    listSampleFixed->GetMeasurementVector(i, z_F);
-    listSampleMoving->GetMeasurementVector(i, z_M);
-    listSampleJoint->GetMeasurementVector(i, z_J);
-
-    /** Search for the k nearest neighbours of the current query point. */
-    this->m_BinaryKNNTreeSearcherFixed->Search(z_F, indices_F, distances_F);
-    this->m_BinaryKNNTreeSearcherMoving->Search(z_M, indices_M, distances_M);
-    this->m_BinaryKNNTreeSearcherJoint->Search(z_J, indices_J, distances_J);
-
-    /** Variables to compute the measure and its derivative. */
-    AccumulateType Gamma_F = NumericTraits<AccumulateType>::Zero;
-    AccumulateType Gamma_M = NumericTraits<AccumulateType>::Zero;
-    AccumulateType Gamma_J = NumericTraits<AccumulateType>::Zero;
-
-    SpatialDerivativeType D1sparse, D2sparse_M, D2sparse_J;
-    D1sparse = spatialDerivativesContainer[i] * jacobianContainer[i];
-
-    dGamma_M.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
-    dGamma_J.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
-
-    /** Loop over the neighbours. */
-    for (unsigned int p = 0; p < k; p++)
-    {
-      /** Get the neighbour point z_ip^M. */
-      listSampleMoving->GetMeasurementVector(indices_M[p], z_M_ip);
-      listSampleMoving->GetMeasurementVector(indices_J[p], z_J_ip);
-
-      /** Get the distances. */
-      distance_F = std::sqrt(distances_F[p]);
-      distance_M = std::sqrt(distances_M[p]);
-      distance_J = std::sqrt(distances_J[p]);
-
-      /** Compute Gamma's. */
-      Gamma_F += distance_F;
-      Gamma_M += distance_M;
-      Gamma_J += distance_J;
-
-      /** Get the difference of z_ip^M with z_i^M. */
-      diff_M = z_M - z_M_ip;
-      diff_J = z_M - z_J_ip;
-
-      /** Compute derivatives. */
-      D2sparse_M = spatialDerivativesContainer[indices_M[p]] * jacobianContainer[indices_M[p]];
-      D2sparse_J = spatialDerivativesContainer[indices_J[p]] * jacobianContainer[indices_J[p]];
-
-      /** Update the dGamma's. */
-      this->UpdateDerivativeOfGammas(D1sparse,
-                                     D2sparse_M,
-                                     D2sparse_J,
-                                     jacobianIndicesContainer[i],
-                                     jacobianIndicesContainer[indices_M[p]],
-                                     jacobianIndicesContainer[indices_J[p]],
-                                     diff_M,
-                                     diff_J,
-                                     distance_M,
-                                     distance_J,
-                                     dGamma_M,
-                                     dGamma_J);
-
-    } // end loop over the k neighbours
-
-    /** Compute contributions. */
-    H = std::sqrt(Gamma_F * Gamma_M);
-    if (H > this->m_AvoidDivisionBy)
-    {
-      /** Compute some sums. */
-      G = Gamma_J / H;
-      sumG += std::pow(G, twoGamma);
-
-      /** Compute the contribution to the derivative. */
-      Gpow = std::pow(G, twoGamma - 1.0);
-      contribution += (Gpow / H) * (dGamma_J - (0.5 * Gamma_J / Gamma_M) * dGamma_M);
-    }
-
-  } // end looping over all query points
+  const unsigned int jointSize = this->GetNumberOfFixedImages() + this->GetNumberOfMovingImages();
 
   /**
    * *************** Finally, calculate the metric value and derivative ******************
@@ -1038,6 +880,293 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Upd
 } // end UpdateDerivativeOfGammas()
 
 
+/**
+ * ************************ GenerateTreesAndConnectSearchers *************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::GenerateTreesAndConnectSearchers(
+  const ListSamplePointer & listSampleFixed,
+  const ListSamplePointer & listSampleMoving,
+  const ListSamplePointer & listSampleJoint) const
+{
+  /** Set the samples of the fixed, moving and joint trees. */
+  this->m_BinaryKNNTreeFixed->SetSample(listSampleFixed);
+  this->m_BinaryKNNTreeMoving->SetSample(listSampleMoving);
+  this->m_BinaryKNNTreeJoint->SetSample(listSampleJoint);
+
+  /** Generate the three trees. They are independent, so they can be generated concurrently. */
+  if (!this->m_UseMultiThread)
+  {
+    this->m_BinaryKNNTreeFixed->GenerateTree();
+    this->m_BinaryKNNTreeMoving->GenerateTree();
+    this->m_BinaryKNNTreeJoint->GenerateTree();
+  }
+  else
+  {
+    this->m_Threader->SetSingleMethod(
+      this->GenerateTreesThreaderCallback,
+      const_cast<void *>(static_cast<const void *>(&this->m_KNNGraphAlphaMIThreaderParameters)));
+    this->m_Threader->SingleMethodExecute();
+  }
+
+  /** Initialize tree searchers. */
+  this->m_BinaryKNNTreeSearcherFixed->SetBinaryTree(this->m_BinaryKNNTreeFixed);
+  this->m_BinaryKNNTreeSearcherMoving->SetBinaryTree(this->m_BinaryKNNTreeMoving);
+  this->m_BinaryKNNTreeSearcherJoint->SetBinaryTree(this->m_BinaryKNNTreeJoint);
+
+} // end GenerateTreesAndConnectSearchers()
+
+
+/**
+ * ************************ GenerateTreesThreaderCallback *************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::GenerateTreesThreaderCallback(void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType     threadID = infoStruct->WorkUnitID;
+  ThreadIdType     nrOfThreads = infoStruct->NumberOfWorkUnits;
+
+  KNNGraphAlphaMIMultiThreaderParameterType * temp =
+    static_cast<KNNGraphAlphaMIMultiThreaderParameterType *>(infoStruct->UserData);
+
+  /** Each thread generates one of the trees; threads beyond the third have nothing to do. */
+  BinaryKNNTreeType * trees[3] = { temp->st_Metric->m_BinaryKNNTreeFixed.GetPointer(),
+                                   temp->st_Metric->m_BinaryKNNTreeMoving.GetPointer(),
+                                   temp->st_Metric->m_BinaryKNNTreeJoint.GetPointer() };
+  for (ThreadIdType i = threadID; i < 3; i += nrOfThreads)
+  {
+    trees[i]->GenerateTree();
+  }
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end GenerateTreesThreaderCallback()
+
+
+/**
+ * ************************ ComputeContributionOfQueryPoints *************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::ComputeContributionOfQueryPoints(
+  const KNNGraphAlphaMIMultiThreaderParameterType & parameters,
+  const unsigned long                               begin,
+  const unsigned long                               end,
+  AccumulateType &                                  sumG,
+  DerivativeType &                                  contribution) const
+{
+  /** Temporary variables. */
+  MeasurementVectorType z_F, z_M, z_J, z_M_ip, z_J_ip, diff_M, diff_J;
+  IndexArrayType        indices_F, indices_M, indices_J;
+  DistanceArrayType     distances_F, distances_M, distances_J;
+  MeasureType           distance_F, distance_M, distance_J;
+  MeasureType           H, G, Gpow;
+
+  const ListSampleType & listSampleFixed = *parameters.st_ListSampleFixed;
+  const ListSampleType & listSampleMoving = *parameters.st_ListSampleMoving;
+  const ListSampleType & listSampleJoint = *parameters.st_ListSampleJoint;
+
+  /** The derivatives of the graph lengths are only needed when computing the derivative. */
+  const bool     doDerivative = parameters.st_DoDerivative;
+  DerivativeType dGamma_M;
+  DerivativeType dGamma_J;
+  if (doDerivative)
+  {
+    dGamma_M.SetSize(this->GetNumberOfParameters());
+    dGamma_J.SetSize(this->GetNumberOfParameters());
+  }
+
+  /** Get the size of the feature vectors. */
+  const unsigned int jointSize = this->GetNumberOfFixedImages() + this->GetNumberOfMovingImages();
+
+  /** Get the number of neighbours and \gamma. */
+  const unsigned int k = this->m_BinaryKNNTreeSearcherFixed->GetKNearestNeighbors();
+  const double       twoGamma = jointSize * (1.0 - this->m_Alpha);
+
+  /** Loop over the query points in the range [ begin, end [. */
+  for (unsigned long i = begin; i < end; i++)
+  {
+    /** Get the i-th query point. */
+    listSampleFixed.GetMeasurementVector(i, z_F);
+    listSampleMoving.GetMeasurementVector(i, z_M);
+    listSampleJoint.GetMeasurementVector(i, z_J);
+
+    /** Search for the k nearest neighbours of the current query point. */
+    this->m_BinaryKNNTreeSearcherFixed->Search(z_F, indices_F, distances_F);
+    this->m_BinaryKNNTreeSearcherMoving->Search(z_M, indices_M, distances_M);
+    this->m_BinaryKNNTreeSearcherJoint->Search(z_J, indices_J, distances_J);
+
+    /** Variables to compute the measure and its derivative. */
+    AccumulateType Gamma_F = NumericTraits<AccumulateType>::Zero;
+    AccumulateType Gamma_M = NumericTraits<AccumulateType>::Zero;
+    AccumulateType Gamma_J = NumericTraits<AccumulateType>::Zero;
+
+    SpatialDerivativeType D1sparse, D2sparse_M, D2sparse_J;
+    if (doDerivative)
+    {
+      D1sparse = (*parameters.st_SpatialDerivatives)[i] * (*parameters.st_Jacobians)[i];
+      dGamma_M.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
+      dGamma_J.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
+    }
+
+    /** Loop over the neighbours. */
+    for (unsigned int p = 0; p < k; p++)
+    {
+      /** Get the distances. */
+      distance_F = std::sqrt(distances_F[p]);
+      distance_M = std::sqrt(distances_M[p]);
+      distance_J = std::sqrt(distances_J[p]);
+
+      /** Compute Gamma's. */
+      Gamma_F += distance_F;
+      Gamma_M += distance_M;
+      Gamma_J += distance_J;
+
+      if (!doDerivative)
+      {
+        continue;
+      }
+
+      /** Get the neighbour point z_ip^M. */
+      listSampleMoving.GetMeasurementVector(indices_M[p], z_M_ip);
+      listSampleMoving.GetMeasurementVector(indices_J[p], z_J_ip);
+
+      /** Get the difference of z_ip^M with z_i^M. */
+      diff_M = z_M - z_M_ip;
+      diff_J = z_M - z_J_ip;
+
+      /** Compute derivatives. */
+      const SpatialDerivativeContainerType & spatialDerivatives = *parameters.st_SpatialDerivatives;
+      const TransformJacobianContainerType & jacobians = *parameters.st_Jacobians;
+      D2sparse_M = spatialDerivatives[indices_M[p]] * jacobians[indices_M[p]];
+      D2sparse_J = spatialDerivatives[indices_J[p]] * jacobians[indices_J[p]];
+
+      /** Update the dGamma's. */
+      const TransformJacobianIndicesContainerType & jacobiansIndices = *parameters.st_JacobiansIndices;
+      this->UpdateDerivativeOfGammas(D1sparse,
+                                     D2sparse_M,
+                                     D2sparse_J,
+                                     jacobiansIndices[i],
+                                     jacobiansIndices[indices_M[p]],
+                                     jacobiansIndices[indices_J[p]],
+                                     diff_M,
+                                     diff_J,
+                                     distance_M,
+                                     distance_J,
+                                     dGamma_M,
+                                     dGamma_J);
+
+    } // end loop over the k neighbours
+
+    /** Compute contributions. */
+    H = std::sqrt(Gamma_F * Gamma_M);
+    if (H > this->m_AvoidDivisionBy)
+    {
+      /** Compute some sums. */
+      G = Gamma_J / H;
+      sumG += std::pow(G, twoGamma);
+
+      /** Compute the contribution to the derivative. */
+      if (doDerivative)
+      {
+        Gpow = std::pow(G, twoGamma - 1.0);
+        contribution += (Gpow / H) * (dGamma_J - (0.5 * Gamma_J / Gamma_M) * dGamma_M);
+      }
+    }
+
+  } // end looping over the query points
+
+} // end ComputeContributionOfQueryPoints()
+
+
+/**
+ * ************************ LaunchComputeContributionOfQueryPoints *************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::LaunchComputeContributionOfQueryPoints(
+  AccumulateType & sumG,
+  DerivativeType & contribution) const
+{
+  KNNGraphAlphaMIMultiThreaderParameterType & threaderParameters = this->m_KNNGraphAlphaMIThreaderParameters;
+
+  /** Single-threaded: compute the contribution of all query points at once. */
+  if (!this->m_UseMultiThread)
+  {
+    this->ComputeContributionOfQueryPoints(threaderParameters, 0, this->m_NumberOfPixelsCounted, sumG, contribution);
+    return;
+  }
+
+  /** Initialize the per thread sums. */
+  const ThreadIdType numberOfThreads = this->m_Threader->GetNumberOfWorkUnits();
+  threaderParameters.st_SumG.assign(numberOfThreads, NumericTraits<AccumulateType>::Zero);
+  threaderParameters.st_Contribution.resize(numberOfThreads);
+  if (threaderParameters.st_DoDerivative)
+  {
+    for (DerivativeType & threadContribution : threaderParameters.st_Contribution)
+    {
+      threadContribution.SetSize(this->GetNumberOfParameters());
+      threadContribution.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
+    }
+  }
+
+  /** Launch. */
+  this->m_Threader->SetSingleMethod(this->ComputeContributionOfQueryPointsThreaderCallback,
+                                    const_cast<void *>(static_cast<const void *>(&threaderParameters)));
+  this->m_Threader->SingleMethodExecute();
+
+  /** Sum the results of all threads, in a fixed order. */
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    sumG += threaderParameters.st_SumG[i];
+    if (threaderParameters.st_DoDerivative)
+    {
+      contribution += threaderParameters.st_Contribution[i];
+    }
+  }
+
+} // end LaunchComputeContributionOfQueryPoints()
+
+
+/**
+ * ************************ ComputeContributionOfQueryPointsThreaderCallback *************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::
+  ComputeContributionOfQueryPointsThreaderCallback(void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType     threadID = infoStruct->WorkUnitID;
+  ThreadIdType     nrOfThreads = infoStruct->NumberOfWorkUnits;
+
+  KNNGraphAlphaMIMultiThreaderParameterType * temp =
+    static_cast<KNNGraphAlphaMIMultiThreaderParameterType *>(infoStruct->UserData);
+
+  /** Each thread handles a contiguous range of query points. */
+  const unsigned long numberOfQueryPoints = temp->st_Metric->m_NumberOfPixelsCounted;
+  const unsigned long subSize = static_cast<unsigned long>(
+    std::ceil(static_cast<double>(numberOfQueryPoints) / static_cast<double>(nrOfThreads)));
+  const unsigned long begin = std::min(threadID * subSize, numberOfQueryPoints);
+  const unsigned long end = std::min((threadID + 1) * subSize, numberOfQueryPoints);
+
+  temp->st_Metric->ComputeContributionOfQueryPoints(
+    *temp, begin, end, temp->st_SumG[threadID], temp->st_Contribution[threadID]);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ComputeContributionOfQueryPointsThreaderCallback()
+
+
+
 /**
  * ************************ PrintSelf *************************
  */
@@ -32,6 +32,7 @@ template <class TFixedPointSet, class TMovingPointSet>
 MissingVolumeMeshPenalty<TFixedPointSet, TMovingPointSet>::MissingVolumeMeshPenalty()
 {
   this->m_MappedMeshContainer = MappedMeshContainerType::New();
+  this->SetSupportsConcurrentGetValueAndDerivative(true);
 } // end Constructor
 
 
@@ -165,8 +166,9 @@ MissingVolumeMeshPenalty<TFixedPointSet, TMovingPointSet>::GetValueAndDerivative
   /** Initialize some variables */
   value = NumericTraits<MeasureType>::Zero;
 
-  /** Make sure the transform parameters are up to date. */
-  this->SetTransformParameters(parameters);
+  /** Make sure the transform parameters are up to date. When this metric is part of a
+   * combination metric, this was already done in BeforeThreadedGetValueAndDerivative(). */
+  this->BeforeThreadedGetValueAndDerivative(parameters);
 
   derivative = DerivativeType(this->GetNumberOfParameters());
   derivative.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
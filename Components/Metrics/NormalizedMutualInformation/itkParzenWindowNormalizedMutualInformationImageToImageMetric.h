@@ -20,6 +20,7 @@
 #define itkParzenWindowNormalizedMutualInformationImageToImageMetric_h
 
 #include "itkParzenWindowHistogramImageToImageMetric.h"
+#include "itkArray2D.h"
 
 namespace itk
 {
@@ -113,6 +114,8 @@ public:
   typedef typename Superclass::MovingImageMaskPointer          MovingImageMaskPointer;
   typedef typename Superclass::MeasureType                     MeasureType;
   typedef typename Superclass::DerivativeType                  DerivativeType;
+  typedef typename Superclass::DerivativeValueType             DerivativeValueType;
+  typedef typename Superclass::NumberOfParametersType          NumberOfParametersType;
   typedef typename Superclass::ParametersType                  ParametersType;
   typedef typename Superclass::FixedImagePixelType             FixedImagePixelType;
   typedef typename Superclass::MovingImageRegionType           MovingImageRegionType;
@@ -125,6 +128,8 @@ public:
   typedef typename Superclass::FixedImageLimiterOutputType     FixedImageLimiterOutputType;
   typedef typename Superclass::MovingImageLimiterOutputType    MovingImageLimiterOutputType;
   typedef typename Superclass::MovingImageDerivativeScalesType MovingImageDerivativeScalesType;
+  typedef typename Superclass::ThreaderType                    ThreaderType;
+  typedef typename Superclass::ThreadInfoType                  ThreadInfoType;
 
   /** The fixed image dimension. */
   itkStaticConstMacro(FixedImageDimension, unsigned int, FixedImageType::ImageDimension);
@@ -144,7 +149,7 @@ public:
 
 protected:
   /** The constructor. */
-  ParzenWindowNormalizedMutualInformationImageToImageMetric() = default;
+  ParzenWindowNormalizedMutualInformationImageToImageMetric();
 
   /** The destructor. */
   ~ParzenWindowNormalizedMutualInformationImageToImageMetric() override = default;
@@ -166,6 +171,7 @@ protected:
   typedef typename Superclass::CentralDifferenceGradientFilterType CentralDifferenceGradientFilterType;
   typedef typename Superclass::MovingImageDerivativeType           MovingImageDerivativeType;
   typedef typename Superclass::PDFValueType                        PDFValueType;
+  typedef typename Superclass::PDFDerivativeValueType              PDFDerivativeValueType;
   typedef typename Superclass::MarginalPDFType                     MarginalPDFType;
   typedef typename Superclass::JointPDFType                        JointPDFType;
   typedef typename Superclass::JointPDFDerivativesType             JointPDFDerivativesType;
@@ -194,12 +200,82 @@ protected:
   virtual MeasureType
   ComputeNormalizedMutualInformation(MeasureType & jointEntropy) const;
 
+  /** Some initialization functions, called by Initialize. */
+  void
+  InitializeHistograms(void) override;
+
+  /** Get the value and analytic derivative.
+   * Called by GetValueAndDerivative if UseExplicitPDFDerivatives == false.
+   *
+   * Implements a version that avoids the large memory allocation of the
+   * explicit joint histogram derivative, analogous to the low memory variant
+   * of ParzenWindowMutualInformationImageToImageMetric. The joint histogram
+   * is computed by the (multi-threaded) ComputePDFs(), after which a second
+   * loop over the samples computes the derivative. Both loops over the samples
+   * run multi-threadedly when m_UseMultiThread == true.
+   */
+  virtual void
+  GetValueAndAnalyticDerivativeLowMemory(const ParametersType & parameters,
+                                         MeasureType &          value,
+                                         DerivativeType &       derivative) const;
+
+  /** Threading related parameters. */
+  struct ParzenWindowNormalizedMutualInformationMultiThreaderParameterType
+  {
+    Self * m_Metric;
+  };
+  ParzenWindowNormalizedMutualInformationMultiThreaderParameterType
+    m_ParzenWindowNormalizedMutualInformationThreaderParameters;
+
+  /** Multi-threaded version of the ComputeDerivativeLowMemory function. */
+  inline void
+  ThreadedComputeDerivativeLowMemory(ThreadIdType threadId);
+
+  /** Accumulate the per-thread derivatives, using a multi-threaded reduction. */
+  inline void
+  AfterThreadedComputeDerivativeLowMemory(DerivativeType & derivative) const;
+
+  /** Helper function to launch the threads. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  ComputeDerivativeLowMemoryThreaderCallback(void * arg);
+
+  /** Helper function to launch the threads. */
+  void
+  LaunchComputeDerivativeLowMemoryThreaderCallback(void) const;
+
 private:
   /** The deleted copy constructor. */
   ParzenWindowNormalizedMutualInformationImageToImageMetric(const Self &) = delete;
   /** The deleted assignment operator. */
   void
   operator=(const Self &) = delete;
+
+  /** Helper array for storing the values of the JointPDF ratios. */
+  typedef double              PRatioType;
+  typedef Array2D<PRatioType> PRatioArrayType;
+  mutable PRatioArrayType     m_PRatioArray;
+
+  /** Helper function to compute the derivative for the low memory variant. */
+  void
+  ComputeDerivativeLowMemorySingleThreaded(DerivativeType & derivative) const;
+
+  void
+  ComputeDerivativeLowMemory(DerivativeType & derivative) const;
+
+  /** Helper function to update the derivative for the low memory variant. */
+  void
+  UpdateDerivativeLowMemory(const RealType &                   fixedImageValue,
+                            const RealType &                   movingImageValue,
+                            const DerivativeType &             imageJacobian,
+                            const NonZeroJacobianIndicesType & nzji,
+                            DerivativeType &                   derivative) const;
+
+  /** Helper function to compute m_PRatioArray in case of low memory consumption.
+   * Assumes the marginal pdfs are already log'ed, and that the normalized
+   * mutual information and joint entropy have been computed.
+   */
+  void
+  ComputePRatioArray(const MeasureType & nMI, const MeasureType & jointEntropy) const;
 };
 
 } // end namespace itk
@@ -47,6 +47,7 @@ PCAMetric<TFixedImage, TMovingImage>::PCAMetric()
   this->SetUseImageSampler(true);
   this->SetUseFixedImageLimiter(false);
   this->SetUseMovingImageLimiter(false);
+  this->SetSupportsConcurrentGetValueAndDerivative(true);
 } // end constructor
 
 
@@ -429,11 +430,12 @@ PCAMetric<TFixedImage, TMovingImage>::GetValueAndDerivative(const TransformParam
   derivative = DerivativeType(P);
   derivative.Fill(NumericTraits<DerivativeValueType>::Zero);
 
-  /** Make sure the transform parameters are up to date. */
-  this->SetTransformParameters(parameters);
+  /** Make sure the transform parameters and the image sampler are up to date. When this
+   * metric is part of a combination metric, this was already done in
+   * BeforeThreadedGetValueAndDerivative(). */
+  this->BeforeThreadedGetValueAndDerivative(parameters);
 
-  /** Update the imageSampler and get a handle to the sample container. */
-  this->GetImageSampler()->Update();
+  /** Get a handle to the sample container. */
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
 
   /** Create iterator over the sample container. */
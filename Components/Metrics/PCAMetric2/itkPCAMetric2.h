@@ -92,6 +92,12 @@ public:
   typedef typename Superclass::FixedImageLimiterOutputType     FixedImageLimiterOutputType;
   typedef typename Superclass::MovingImageLimiterOutputType    MovingImageLimiterOutputType;
   typedef typename Superclass::MovingImageDerivativeScalesType MovingImageDerivativeScalesType;
+  typedef typename DerivativeType::ValueType                   DerivativeValueType;
+  typedef typename Superclass::ThreaderType                    ThreaderType;
+  typedef typename Superclass::ThreadInfoType                  ThreadInfoType;
+
+  typedef vnl_matrix<RealType>            MatrixType;
+  typedef vnl_matrix<DerivativeValueType> DerivativeMatrixType;
 
   /** The fixed image dimension. */
   itkStaticConstMacro(FixedImageDimension, unsigned int, FixedImageType::ImageDimension);
@@ -108,6 +114,11 @@ public:
   GetDerivative(const TransformParametersType & parameters, DerivativeType & derivative) const override;
 
   /** Get value and derivatives for multiple valued optimizers. */
+  void
+  GetValueAndDerivativeSingleThreaded(const TransformParametersType & parameters,
+                                      MeasureType &                   Value,
+                                      DerivativeType &                Derivative) const;
+
   void
   GetValueAndDerivative(const TransformParametersType & parameters,
                         MeasureType &                   Value,
@@ -122,7 +133,7 @@ public:
 
 protected:
   PCAMetric2();
-  ~PCAMetric2() override = default;
+  ~PCAMetric2() override;
   void
   PrintSelf(std::ostream & os, Indent indent) const override;
 
@@ -151,6 +162,78 @@ protected:
                                         const MovingImageDerivativeType & movingImageDerivative,
                                         DerivativeType &                  imageJacobian) const override;
 
+  struct PCAMetric2MultiThreaderParameterType
+  {
+    Self *           m_Metric;
+    DerivativeType * m_Derivative;
+  };
+
+  mutable PCAMetric2MultiThreaderParameterType m_PCAMetric2ThreaderParameters;
+
+  struct PCAMetric2GetSamplesPerThreadStruct
+  {
+    SizeValueType                    st_NumberOfPixelsCounted;
+    MatrixType                       st_DataBlock;
+    std::vector<FixedImagePointType> st_ApprovedSamples;
+    DerivativeType                   st_Derivative;
+  };
+
+  itkPadStruct(ITK_CACHE_LINE_ALIGNMENT,
+               PCAMetric2GetSamplesPerThreadStruct,
+               PaddedPCAMetric2GetSamplesPerThreadStruct);
+
+  itkAlignedTypedef(ITK_CACHE_LINE_ALIGNMENT,
+                    PaddedPCAMetric2GetSamplesPerThreadStruct,
+                    AlignedPCAMetric2GetSamplesPerThreadStruct);
+
+  mutable AlignedPCAMetric2GetSamplesPerThreadStruct * m_PCAMetric2GetSamplesPerThreadVariables;
+  mutable ThreadIdType                                 m_PCAMetric2GetSamplesPerThreadVariablesSize;
+
+  /** Get the samples and the derivative contributions for each thread. */
+  inline void
+  ThreadedGetSamples(ThreadIdType threadID);
+
+  inline void
+  ThreadedComputeDerivative(ThreadIdType threadID);
+
+  /** Gather the samples and the derivatives from all threads. */
+  inline void
+  AfterThreadedGetSamples(MeasureType & value) const;
+
+  inline void
+  AfterThreadedComputeDerivative(DerivativeType & derivative) const;
+
+  /** Helper function to launch the threads. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  GetSamplesThreaderCallback(void * arg);
+
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  ComputeDerivativeThreaderCallback(void * arg);
+
+  /** Helper functions to launch the threads. */
+  void
+  LaunchGetSamplesThreaderCallback(void) const;
+
+  void
+  LaunchComputeDerivativeThreaderCallback(void) const;
+
+  /** Initialize some multi-threading related parameters. */
+  void
+  InitializeThreadingParameters(void) const override;
+
+  /** Whether the derivative is computed per range of time points instead of
+   * per range of samples. This is done for a stack transform with at least as
+   * many time points as threads: the parameters of time point t then only
+   * belong to sub-transform t, so that each thread writes its own blocks of the
+   * derivative directly, without locks and without a reduction afterwards.
+   */
+  bool
+  GetComputeDerivativePerTimePoint(void) const;
+
+  /** Subtract the mean from the derivative elements, per dimension or per control point. */
+  void
+  SubtractMeanFromDerivative(DerivativeType & derivative) const;
+
 private:
   PCAMetric2(const Self &) = delete;
   void
@@ -172,6 +255,18 @@ private:
 
   /** Bool to indicate if the transform used is a stacktransform. Set by elx files. */
   bool m_TransformIsStackTransform;
+
+  /** Size and index of the slowest varying dimension, set in Initialize(). */
+  unsigned int m_G;
+  unsigned int m_LastDimIndex;
+
+  /** Matrices, needed for the multi-threaded derivative calculation. */
+  mutable std::vector<unsigned int> m_PixelStartIndex;
+  mutable MatrixType                m_Atmm;
+  mutable DerivativeMatrixType      m_vSAtmm;
+  mutable DerivativeMatrixType      m_CSv;
+  mutable DerivativeMatrixType      m_Sv;
+  mutable DerivativeMatrixType      m_vdSdmu_part1;
 };
 
 } // end namespace itk
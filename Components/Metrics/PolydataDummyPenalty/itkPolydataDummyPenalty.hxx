@@ -31,6 +31,7 @@ template <class TFixedPointSet, class TMovingPointSet>
 MeshPenalty<TFixedPointSet, TMovingPointSet>::MeshPenalty()
 {
   this->m_MappedMeshContainer = MappedMeshContainerType::New();
+  this->SetSupportsConcurrentGetValueAndDerivative(true);
 } // end Constructor
 
 
@@ -184,8 +185,9 @@ MeshPenalty<TFixedPointSet, TMovingPointSet>::GetValueAndDerivative(const Transf
   /** Initialize some variables */
   value = NumericTraits<MeasureType>::Zero;
 
-  /** Make sure the transform parameters are up to date. */
-  this->SetTransformParameters(parameters);
+  /** Make sure the transform parameters are up to date. When this metric is part of a
+   * combination metric, this was already done in BeforeThreadedGetValueAndDerivative(). */
+  this->BeforeThreadedGetValueAndDerivative(parameters);
 
   derivative = DerivativeType(this->GetNumberOfParameters());
   derivative.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
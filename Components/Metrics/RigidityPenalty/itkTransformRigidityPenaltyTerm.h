@@ -119,6 +119,8 @@ public:
   typedef typename Superclass::ImageSampleContainerType     ImageSampleContainerType;
   typedef typename Superclass::ImageSampleContainerPointer  ImageSampleContainerPointer;
   typedef typename Superclass::ScalarType                   ScalarType;
+  typedef typename Superclass::ThreaderType                 ThreaderType;
+  typedef typename Superclass::ThreadInfoType               ThreadInfoType;
 
   /** Typedef's for the B-spline transform. */
   typedef typename Superclass::CombinationTransformType      CombinationTransformType;
@@ -297,6 +299,50 @@ protected:
   void
   PrintSelf(std::ostream & os, Indent indent) const override;
 
+  /** One 1D pass of the fused separable filtering: a 3-tap kernel along one
+   * dimension, applied to the buffer m_Source of the previous pass.
+   */
+  struct SeparablePassType
+  {
+    unsigned int m_Source;
+    ScalarType   m_Kernel[3];
+  };
+
+  /** Data of the fused separable filtering, shared by all threads.
+   * m_Passes[ d ] contains the distinct passes along dimension d. The passes
+   * along the last dimension correspond one-to-one with m_Outputs.
+   */
+  struct FilterSeparableFusedParameterType
+  {
+    const ScalarType *                          m_Input;
+    std::vector<ScalarType *>                   m_Outputs;
+    typename CoefficientImageType::SizeType     m_Size;
+    std::vector<std::vector<SeparablePassType>> m_Passes;
+  };
+
+  /** Function used for the filtering. It performs 1D separable filtering for a
+   * list of operator sets, each consisting of a 3-tap operator per dimension, see
+   * Create1DOperator(). The results are the same as those of a pipeline of
+   * NeighborhoodOperatorImageFilters per operator set, but the image is filtered
+   * in a single sweep: 1D passes that operator sets have in common are computed
+   * once, and the image is processed in blocks of slices along the last dimension,
+   * which are divided over the threads when m_UseMultiThread is true.
+   */
+  void
+  FilterSeparableFused(const CoefficientImageType *                       image,
+                       const std::vector<std::vector<NeighborhoodType>> & operatorSets,
+                       std::vector<CoefficientImagePointer> &             outputs) const;
+
+  /** Fused separable filtering of the slices [sliceBegin, sliceEnd) along the last dimension. */
+  static void
+  ThreadedFilterSeparableFused(const FilterSeparableFusedParameterType & parameters,
+                               const SizeValueType                       sliceBegin,
+                               const SizeValueType                       sliceEnd);
+
+  /** Helper function to launch the threads of the fused separable filtering. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  FilterSeparableFusedThreaderCallback(void * arg);
+
 private:
   /** The deleted copy constructor. */
   TransformRigidityPenaltyTerm(const Self &) = delete;
@@ -319,10 +365,6 @@ private:
   void
   CreateNDOperator(NeighborhoodType & F, const std::string & whichF, const CoefficientImageSpacingType & spacing) const;
 
-  /** Private function used for the filtering. It performs 1D separable filtering. */
-  CoefficientImagePointer
-  FilterSeparable(const CoefficientImageType *, const std::vector<NeighborhoodType> & Operators) const;
-
   /** Member variables. */
   BSplineTransformPointer m_BSplineTransform;
   ScalarType              m_LinearityConditionWeight;
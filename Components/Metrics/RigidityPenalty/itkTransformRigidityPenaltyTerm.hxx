@@ -22,6 +22,8 @@
 
 #include "itkZeroFluxNeumannBoundaryCondition.h"
 
+#include <algorithm>
+
 namespace itk
 {
 
@@ -83,6 +85,7 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::TransformRigidityPenalty
 
   /** We don't use an image sampler for this advanced metric. */
   this->SetUseImageSampler(false);
+  this->SetSupportsConcurrentGetValueAndDerivative(true);
 
   this->m_BSplineTransform = nullptr;
 
@@ -335,8 +338,12 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::FillRigidityCoefficientI
     return;
   }
 
-  /** Make sure that the transform is up to date. */
-  this->m_Transform->SetParameters(parameters);
+  /** Make sure that the transform is up to date. When this metric is part of a
+   * combination metric, this was already done in BeforeThreadedGetValueAndDerivative(). */
+  if (this->m_UseMetricSingleThreaded)
+  {
+    this->m_Transform->SetParameters(parameters);
+  }
 
   /** Create and reset an iterator over m_RigidityCoefficientImage. */
   RigidityImageIteratorType it(this->m_RigidityCoefficientImage,
@@ -572,20 +579,34 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValue(const Parameter
    *
    ************************************************************************* */
 
-  /** Filter the inputImages. */
+  /** Filter the inputImages. All filterings of an input image are done in a
+   * single sweep, see FilterSeparableFused().
+   */
+  std::vector<std::vector<NeighborhoodType>> operatorSets{
+    Operators_A, Operators_B, Operators_D, Operators_E, Operators_G
+  };
+  if (ImageDimension == 3)
+  {
+    operatorSets.push_back(Operators_C);
+    operatorSets.push_back(Operators_F);
+    operatorSets.push_back(Operators_H);
+    operatorSets.push_back(Operators_I);
+  }
+  std::vector<CoefficientImagePointer> filteredImages;
   for (unsigned int i = 0; i < ImageDimension; i++)
   {
-    ui_FA[i] = this->FilterSeparable(inputImages[i], Operators_A);
-    ui_FB[i] = this->FilterSeparable(inputImages[i], Operators_B);
-    ui_FD[i] = this->FilterSeparable(inputImages[i], Operators_D);
-    ui_FE[i] = this->FilterSeparable(inputImages[i], Operators_E);
-    ui_FG[i] = this->FilterSeparable(inputImages[i], Operators_G);
+    this->FilterSeparableFused(inputImages[i], operatorSets, filteredImages);
+    ui_FA[i] = filteredImages[0];
+    ui_FB[i] = filteredImages[1];
+    ui_FD[i] = filteredImages[2];
+    ui_FE[i] = filteredImages[3];
+    ui_FG[i] = filteredImages[4];
     if (ImageDimension == 3)
     {
-      ui_FC[i] = this->FilterSeparable(inputImages[i], Operators_C);
-      ui_FF[i] = this->FilterSeparable(inputImages[i], Operators_F);
-      ui_FH[i] = this->FilterSeparable(inputImages[i], Operators_H);
-      ui_FI[i] = this->FilterSeparable(inputImages[i], Operators_I);
+      ui_FC[i] = filteredImages[5];
+      ui_FF[i] = filteredImages[6];
+      ui_FH[i] = filteredImages[7];
+      ui_FI[i] = filteredImages[8];
     }
   }
 
@@ -876,6 +897,10 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::BeforeThreadedGetValueAn
   if (this->m_UseMetricSingleThreaded)
   {
     this->m_BSplineTransform->SetParameters(parameters);
+    if (this->m_UseMovingRigidityImage)
+    {
+      this->m_Transform->SetParameters(parameters);
+    }
   }
 
 } // end BeforeThreadedGetValueAndDerivative()
@@ -1015,20 +1040,34 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
    *
    ************************************************************************* */
 
-  /** Filter the inputImages. */
+  /** Filter the inputImages. All filterings of an input image are done in a
+   * single sweep, see FilterSeparableFused().
+   */
+  std::vector<std::vector<NeighborhoodType>> operatorSets{
+    Operators_A, Operators_B, Operators_D, Operators_E, Operators_G
+  };
+  if (ImageDimension == 3)
+  {
+    operatorSets.push_back(Operators_C);
+    operatorSets.push_back(Operators_F);
+    operatorSets.push_back(Operators_H);
+    operatorSets.push_back(Operators_I);
+  }
+  std::vector<CoefficientImagePointer> filteredImages;
   for (unsigned int i = 0; i < ImageDimension; i++)
   {
-    ui_FA[i] = this->FilterSeparable(inputImages[i], Operators_A);
-    ui_FB[i] = this->FilterSeparable(inputImages[i], Operators_B);
-    ui_FD[i] = this->FilterSeparable(inputImages[i], Operators_D);
-    ui_FE[i] = this->FilterSeparable(inputImages[i], Operators_E);
-    ui_FG[i] = this->FilterSeparable(inputImages[i], Operators_G);
+    this->FilterSeparableFused(inputImages[i], operatorSets, filteredImages);
+    ui_FA[i] = filteredImages[0];
+    ui_FB[i] = filteredImages[1];
+    ui_FD[i] = filteredImages[2];
+    ui_FE[i] = filteredImages[3];
+    ui_FG[i] = filteredImages[4];
     if (ImageDimension == 3)
     {
-      ui_FC[i] = this->FilterSeparable(inputImages[i], Operators_C);
-      ui_FF[i] = this->FilterSeparable(inputImages[i], Operators_F);
-      ui_FH[i] = this->FilterSeparable(inputImages[i], Operators_H);
-      ui_FI[i] = this->FilterSeparable(inputImages[i], Operators_I);
+      ui_FC[i] = filteredImages[5];
+      ui_FF[i] = filteredImages[6];
+      ui_FH[i] = filteredImages[7];
+      ui_FI[i] = filteredImages[8];
     }
   }
 
@@ -2158,37 +2197,216 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::Create1DOperator(
 
 
 /**
- * ************************** FilterSeparable ********************
+ * ************************** FilterSeparableFused ********************
  */
 
 template <class TFixedImage, class TScalarType>
-typename TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::CoefficientImagePointer
-TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::FilterSeparable(
-  const CoefficientImageType *          image,
-  const std::vector<NeighborhoodType> & Operators) const
+void
+TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::FilterSeparableFused(
+  const CoefficientImageType *                       image,
+  const std::vector<std::vector<NeighborhoodType>> & operatorSets,
+  std::vector<CoefficientImagePointer> &             outputs) const
 {
-  /** Create filters, supply them with boundary conditions and operators. */
-  std::vector<typename NOIFType::Pointer> filters(ImageDimension);
-  for (unsigned int i = 0; i < ImageDimension; i++)
+  const unsigned int numberOfOutputs = operatorSets.size();
+
+  FilterSeparableFusedParameterType parameters;
+  parameters.m_Input = image->GetBufferPointer();
+  parameters.m_Size = image->GetBufferedRegion().GetSize();
+  parameters.m_Passes.resize(ImageDimension);
+
+  /** Create the 1D passes per dimension. A pass is shared by all operator sets
+   * that have the same operators up to and including that dimension.
+   */
+  std::vector<unsigned int> source(numberOfOutputs, 0);
+  for (unsigned int d = 0; d < ImageDimension; ++d)
+  {
+    std::vector<SeparablePassType> & passes = parameters.m_Passes[d];
+    for (unsigned int m = 0; m < numberOfOutputs; ++m)
+    {
+      /** The operator along dimension d is a 3-tap neighborhood, see Create1DOperator(). */
+      const NeighborhoodType & F = operatorSets[m][d];
+      SeparablePassType        pass;
+      pass.m_Source = source[m];
+      pass.m_Kernel[0] = F[0];
+      pass.m_Kernel[1] = F[1];
+      pass.m_Kernel[2] = F[2];
+
+      /** Look for an identical pass. Along the last dimension there is one pass per output. */
+      unsigned int index = passes.size();
+      if (d < ImageDimension - 1)
+      {
+        for (unsigned int j = 0; j < passes.size(); ++j)
+        {
+          if (passes[j].m_Source == pass.m_Source && passes[j].m_Kernel[0] == pass.m_Kernel[0] &&
+              passes[j].m_Kernel[1] == pass.m_Kernel[1] && passes[j].m_Kernel[2] == pass.m_Kernel[2])
+          {
+            index = j;
+            break;
+          }
+        }
+      }
+      if (index == passes.size())
+      {
+        passes.push_back(pass);
+      }
+      source[m] = index;
+    }
+  }
+
+  /** Create the output images. */
+  outputs.resize(numberOfOutputs);
+  parameters.m_Outputs.resize(numberOfOutputs);
+  for (unsigned int m = 0; m < numberOfOutputs; ++m)
   {
-    filters[i] = NOIFType::New();
-    filters[i]->SetOperator(Operators[i]);
+    outputs[m] = CoefficientImageType::New();
+    outputs[m]->CopyInformation(image);
+    outputs[m]->SetRegions(image->GetBufferedRegion());
+    outputs[m]->Allocate();
+    parameters.m_Outputs[m] = outputs[m]->GetBufferPointer();
   }
 
-  /** Set up the mini-pipline. */
-  filters[0]->SetInput(image);
-  for (unsigned int i = 1; i < ImageDimension; i++)
+  /** Do the filtering, single-threaded or divided over the threads. */
+  if (!this->m_UseMultiThread)
   {
-    filters[i]->SetInput(filters[i - 1]->GetOutput());
+    Self::ThreadedFilterSeparableFused(parameters, 0, parameters.m_Size[ImageDimension - 1]);
+    return;
   }
 
-  /** Execute the mini-pipeline. */
-  filters[ImageDimension - 1]->Update();
+  this->m_Threader->SetSingleMethod(this->FilterSeparableFusedThreaderCallback,
+                                    const_cast<void *>(static_cast<const void *>(&parameters)));
+  this->m_Threader->SingleMethodExecute();
+
+} // end FilterSeparableFused()
+
+
+/**
+ * ************************** ThreadedFilterSeparableFused ********************
+ */
+
+template <class TFixedImage, class TScalarType>
+void
+TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::ThreadedFilterSeparableFused(
+  const FilterSeparableFusedParameterType & parameters,
+  const SizeValueType                       sliceBegin,
+  const SizeValueType                       sliceEnd)
+{
+  const unsigned int  lastDim = ImageDimension - 1;
+  const SizeValueType numberOfSlices = parameters.m_Size[lastDim];
+
+  /** Get the number of pixels of a slice, and the strides within a slice. */
+  SizeValueType sliceSize = 1;
+  SizeValueType stride[ImageDimension];
+  SizeValueType numberOfBuffers = 0;
+  for (unsigned int d = 0; d < lastDim; ++d)
+  {
+    stride[d] = sliceSize;
+    sliceSize *= parameters.m_Size[d];
+    numberOfBuffers += parameters.m_Passes[d].size();
+  }
+
+  /** Process the slices in blocks, such that the intermediate results of a
+   * block take in the order of a megabyte, and thus stay in the cache.
+   */
+  const SizeValueType blockSize =
+    std::max<SizeValueType>(4, (SizeValueType(1) << 17) / std::max<SizeValueType>(1, sliceSize * numberOfBuffers));
+
+  /** The intermediate results of the passes within the slices of a block,
+   * including a halo slice on both sides for the pass along the last dimension.
+   */
+  std::vector<std::vector<std::vector<ScalarType>>> buffers(lastDim);
+  for (unsigned int d = 0; d < lastDim; ++d)
+  {
+    buffers[d].resize(parameters.m_Passes[d].size());
+  }
+
+  for (SizeValueType blockBegin = sliceBegin; blockBegin < sliceEnd; blockBegin += blockSize)
+  {
+    const SizeValueType blockEnd = std::min(blockBegin + blockSize, sliceEnd);
+    const SizeValueType haloBegin = blockBegin > 0 ? blockBegin - 1 : 0;
+    const SizeValueType haloEnd = std::min(blockEnd + 1, numberOfSlices);
+    const SizeValueType bufferSize = (haloEnd - haloBegin) * sliceSize;
+
+    /** Do the passes along the dimensions within a slice. The boundary condition
+     * is zero flux Neumann, as in the NeighborhoodOperatorImageFilter, and the
+     * operations are done in the same order, so that the results are identical.
+     */
+    for (unsigned int d = 0; d < lastDim; ++d)
+    {
+      const SizeValueType n = parameters.m_Size[d];
+      const SizeValueType s = stride[d];
+      for (unsigned int j = 0; j < parameters.m_Passes[d].size(); ++j)
+      {
+        const SeparablePassType & pass = parameters.m_Passes[d][j];
+        const ScalarType *        in =
+          d == 0 ? parameters.m_Input + haloBegin * sliceSize : buffers[d - 1][pass.m_Source].data();
+        buffers[d][j].resize(bufferSize);
+        ScalarType * out = buffers[d][j].data();
+
+        for (SizeValueType outer = 0; outer < bufferSize; outer += n * s)
+        {
+          for (SizeValueType c = 0; c < n; ++c)
+          {
+            const SizeValueType current = outer + c * s;
+            const SizeValueType previous = c > 0 ? current - s : current;
+            const SizeValueType next = c + 1 < n ? current + s : current;
+            for (SizeValueType inner = 0; inner < s; ++inner)
+            {
+              out[current + inner] = pass.m_Kernel[0] * in[previous + inner] + pass.m_Kernel[1] * in[current + inner] +
+                                     pass.m_Kernel[2] * in[next + inner];
+            }
+          }
+        }
+      }
+    }
+
+    /** Do the pass along the last dimension, directly into the outputs. */
+    for (unsigned int m = 0; m < parameters.m_Outputs.size(); ++m)
+    {
+      const SeparablePassType & pass = parameters.m_Passes[lastDim][m];
+      const ScalarType *        in = buffers[lastDim - 1][pass.m_Source].data();
+      for (SizeValueType z = blockBegin; z < blockEnd; ++z)
+      {
+        const ScalarType * current = in + (z - haloBegin) * sliceSize;
+        const ScalarType * previous = z > 0 ? current - sliceSize : current;
+        const ScalarType * next = z + 1 < numberOfSlices ? current + sliceSize : current;
+        ScalarType *       out = parameters.m_Outputs[m] + z * sliceSize;
+        for (SizeValueType i = 0; i < sliceSize; ++i)
+        {
+          out[i] = pass.m_Kernel[0] * previous[i] + pass.m_Kernel[1] * current[i] + pass.m_Kernel[2] * next[i];
+        }
+      }
+    }
+  } // end loop over blocks
+
+} // end ThreadedFilterSeparableFused()
+
+
+/**
+ * ******************* FilterSeparableFusedThreaderCallback *******************
+ */
+
+template <class TFixedImage, class TScalarType>
+ITK_THREAD_RETURN_TYPE
+TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::FilterSeparableFusedThreaderCallback(void * arg)
+{
+  ThreadInfoType *   infoStruct = static_cast<ThreadInfoType *>(arg);
+  const ThreadIdType threadId = infoStruct->WorkUnitID;
+  const ThreadIdType numberOfThreads = infoStruct->NumberOfWorkUnits;
+
+  const FilterSeparableFusedParameterType & parameters =
+    *static_cast<const FilterSeparableFusedParameterType *>(infoStruct->UserData);
+
+  /** Divide the slices along the last dimension over the threads. */
+  const SizeValueType numberOfSlices = parameters.m_Size[ImageDimension - 1];
+  const SizeValueType slicesPerThread = (numberOfSlices + numberOfThreads - 1) / numberOfThreads;
+  const SizeValueType sliceBegin = std::min<SizeValueType>(slicesPerThread * threadId, numberOfSlices);
+  const SizeValueType sliceEnd = std::min<SizeValueType>(slicesPerThread * (threadId + 1), numberOfSlices);
+
+  Self::ThreadedFilterSeparableFused(parameters, sliceBegin, sliceEnd);
 
-  /** Return the filtered image. */
-  return filters[ImageDimension - 1]->GetOutput();
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
 
-} // end FilterSeparable()
+} // end FilterSeparableFusedThreaderCallback()
 
 
 /**
@@ -41,6 +41,8 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::StatisticalShapeP
   this->m_BaseVarianceNeedsUpdate = true;
   this->m_VariancesNeedsUpdate = true;
 
+  this->SetSupportsConcurrentGetValueAndDerivative(true);
+
 } // end Constructor
 
 
@@ -462,8 +464,9 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::GetValueAndDeriva
   // InputPointType movingPoint;
   OutputPointType fixedPoint;
 
-  /** Make sure the transform parameters are up to date. */
-  this->SetTransformParameters(parameters);
+  /** Make sure the transform parameters are up to date. When this metric is part of a
+   * combination metric, this was already done in BeforeThreadedGetValueAndDerivative(). */
+  this->BeforeThreadedGetValueAndDerivative(parameters);
 
   const unsigned int shapeLength = Self::FixedPointSetDimension * fixedPointSet->GetNumberOfPoints();
 
@@ -24,6 +24,7 @@
 #include "itkImageRandomCoordinateSampler.h"
 #include "itkNearestNeighborInterpolateImageFunction.h"
 #include "itkExtractImageFilter.h"
+#include "vnl/vnl_diag_matrix.h"
 
 namespace itk
 {
@@ -92,6 +93,12 @@ public:
   typedef typename Superclass::FixedImageLimiterOutputType     FixedImageLimiterOutputType;
   typedef typename Superclass::MovingImageLimiterOutputType    MovingImageLimiterOutputType;
   typedef typename Superclass::MovingImageDerivativeScalesType MovingImageDerivativeScalesType;
+  typedef typename DerivativeType::ValueType                   DerivativeValueType;
+  typedef typename Superclass::ThreaderType                    ThreaderType;
+  typedef typename Superclass::ThreadInfoType                  ThreadInfoType;
+
+  typedef vnl_matrix<RealType>            MatrixType;
+  typedef vnl_matrix<DerivativeValueType> DerivativeMatrixType;
 
   /** The fixed image dimension. */
   itkStaticConstMacro(FixedImageDimension, unsigned int, FixedImageType::ImageDimension);
@@ -108,6 +115,11 @@ public:
   GetDerivative(const TransformParametersType & parameters, DerivativeType & derivative) const override;
 
   /** Get value and derivatives for multiple valued optimizers. */
+  void
+  GetValueAndDerivativeSingleThreaded(const TransformParametersType & parameters,
+                                      MeasureType &                   Value,
+                                      DerivativeType &                Derivative) const;
+
   void
   GetValueAndDerivative(const TransformParametersType & parameters,
                         MeasureType &                   Value,
@@ -122,7 +134,7 @@ public:
 
 protected:
   SumOfPairwiseCorrelationCoefficientsMetric();
-  ~SumOfPairwiseCorrelationCoefficientsMetric() override = default;
+  ~SumOfPairwiseCorrelationCoefficientsMetric() override;
   void
   PrintSelf(std::ostream & os, Indent indent) const override;
 
@@ -150,6 +162,75 @@ protected:
                                         const MovingImageDerivativeType & movingImageDerivative,
                                         DerivativeType &                  imageJacobian) const override;
 
+  struct SumOfPairwiseCorrelationCoefficientsMultiThreaderParameterType
+  {
+    Self *           m_Metric;
+    DerivativeType * m_Derivative;
+  };
+
+  mutable SumOfPairwiseCorrelationCoefficientsMultiThreaderParameterType m_SumOfPairwiseCorrelationThreaderParameters;
+
+  struct SumOfPairwiseCorrelationPerThreadStruct
+  {
+    SizeValueType                    st_NumberOfPixelsCounted;
+    MatrixType                       st_DataBlock;
+    std::vector<FixedImagePointType> st_ApprovedSamples;
+    DerivativeType                   st_Derivative;
+  };
+
+  itkPadStruct(ITK_CACHE_LINE_ALIGNMENT,
+               SumOfPairwiseCorrelationPerThreadStruct,
+               PaddedSumOfPairwiseCorrelationPerThreadStruct);
+
+  itkAlignedTypedef(ITK_CACHE_LINE_ALIGNMENT,
+                    PaddedSumOfPairwiseCorrelationPerThreadStruct,
+                    AlignedSumOfPairwiseCorrelationPerThreadStruct);
+
+  mutable AlignedSumOfPairwiseCorrelationPerThreadStruct * m_SumOfPairwiseCorrelationPerThreadVariables;
+  mutable ThreadIdType                                     m_SumOfPairwiseCorrelationPerThreadVariablesSize;
+
+  /** Get the samples and the derivative contributions for each thread. */
+  inline void
+  ThreadedGetSamples(ThreadIdType threadID);
+
+  inline void
+  ThreadedComputeDerivative(ThreadIdType threadID);
+
+  /** Gather the samples and the derivatives from all threads. */
+  inline void
+  AfterThreadedGetSamples(MeasureType & value) const;
+
+  inline void
+  AfterThreadedComputeDerivative(DerivativeType & derivative) const;
+
+  /** Helper function to launch the threads. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  GetSamplesThreaderCallback(void * arg);
+
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  ComputeDerivativeThreaderCallback(void * arg);
+
+  /** Helper functions to launch the threads. */
+  void
+  LaunchGetSamplesThreaderCallback(void) const;
+
+  void
+  LaunchComputeDerivativeThreaderCallback(void) const;
+
+  /** Initialize some multi-threading related parameters. */
+  void
+  InitializeThreadingParameters(void) const override;
+
+  /** Whether the derivative is computed per range of time points instead of
+   * per range of samples, see PCAMetric2::GetComputeDerivativePerTimePoint().
+   */
+  bool
+  GetComputeDerivativePerTimePoint(void) const;
+
+  /** Subtract the mean from the derivative elements, per dimension or per control point. */
+  void
+  SubtractMeanFromDerivative(DerivativeType & derivative) const;
+
 private:
   SumOfPairwiseCorrelationCoefficientsMetric(const Self &) = delete;
   void
@@ -171,6 +252,19 @@ private:
 
   /** Bool to indicate if the transform used is a stacktransform. Set by elx files. */
   bool m_TransformIsStackTransform;
+
+  /** Size and index of the slowest varying dimension, set in Initialize(). */
+  unsigned int m_G;
+  unsigned int m_LastDimIndex;
+
+  /** Intermediate results, needed for the multi-threaded derivative calculation. */
+  mutable std::vector<unsigned int>            m_PixelStartIndex;
+  mutable MatrixType                           m_Atmm;
+  mutable DerivativeMatrixType                 m_KAtZscore;
+  mutable DerivativeMatrixType                 m_KAtZscoreAmm;
+  mutable vnl_diag_matrix<RealType>            m_S;
+  mutable vnl_diag_matrix<DerivativeValueType> m_dSdmu_part1;
+  mutable RealType                             m_NormK;
 };
 
 } // end namespace itk
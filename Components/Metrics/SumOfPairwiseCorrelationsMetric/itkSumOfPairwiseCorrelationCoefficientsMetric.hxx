@@ -24,6 +24,8 @@
 #include "vnl/algo/vnl_matrix_update.h"
 #include "itkImage.h"
 #include <numeric>
+#include <algorithm>
+#include <cmath>
 
 namespace itk
 {
@@ -35,13 +37,36 @@ template <class TFixedImage, class TMovingImage>
 SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::SumOfPairwiseCorrelationCoefficientsMetric()
   : m_SubtractMean(true)
   , m_TransformIsStackTransform(true)
+  , m_G(0)
+  , m_LastDimIndex(0)
+  , m_NormK(0.0)
 {
   this->SetUseImageSampler(true);
   this->SetUseFixedImageLimiter(false);
   this->SetUseMovingImageLimiter(false);
+  this->SetSupportsConcurrentGetValueAndDerivative(true);
+
+  // Multi-threading structs
+  this->m_SumOfPairwiseCorrelationPerThreadVariables = nullptr;
+  this->m_SumOfPairwiseCorrelationPerThreadVariablesSize = 0;
+
+  /** Initialize the m_SumOfPairwiseCorrelationThreaderParameters. */
+  this->m_SumOfPairwiseCorrelationThreaderParameters.m_Metric = this;
+  this->m_SumOfPairwiseCorrelationThreaderParameters.m_Derivative = nullptr;
 } // end constructor
 
 
+/**
+ * ******************* Destructor *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::~SumOfPairwiseCorrelationCoefficientsMetric()
+{
+  delete[] this->m_SumOfPairwiseCorrelationPerThreadVariables;
+} // end Destructor
+
+
 /**
  * ******************* Initialize *******************
  */
@@ -52,6 +77,10 @@ SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::Initializ
 {
   /** Initialize transform, interpolator, etc. */
   Superclass::Initialize();
+
+  /** Retrieve slowest varying dimension and its size. */
+  this->m_LastDimIndex = this->GetFixedImage()->GetImageDimension() - 1;
+  this->m_G = this->GetFixedImage()->GetLargestPossibleRegion().GetSize(this->m_LastDimIndex);
 } // end Initialize()
 
 
@@ -67,6 +96,56 @@ SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::PrintSelf
 } // end PrintSelf()
 
 
+/**
+ * ********************* InitializeThreadingParameters ****************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::InitializeThreadingParameters(void) const
+{
+  const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
+
+  /** Only resize the array of structs when needed. */
+  if (this->m_SumOfPairwiseCorrelationPerThreadVariablesSize != numberOfThreads)
+  {
+    delete[] this->m_SumOfPairwiseCorrelationPerThreadVariables;
+    this->m_SumOfPairwiseCorrelationPerThreadVariables =
+      new AlignedSumOfPairwiseCorrelationPerThreadStruct[numberOfThreads];
+    this->m_SumOfPairwiseCorrelationPerThreadVariablesSize = numberOfThreads;
+  }
+
+  /** Some initialization. The per-thread derivatives are only needed when the
+   * threads do not own disjoint blocks of the derivative.
+   */
+  const bool perTimePoint = this->GetComputeDerivativePerTimePoint();
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    this->m_SumOfPairwiseCorrelationPerThreadVariables[i].st_NumberOfPixelsCounted = NumericTraits<SizeValueType>::Zero;
+    if (!perTimePoint)
+    {
+      this->m_SumOfPairwiseCorrelationPerThreadVariables[i].st_Derivative.SetSize(this->GetNumberOfParameters());
+    }
+  }
+
+  this->m_PixelStartIndex.resize(numberOfThreads);
+
+} // end InitializeThreadingParameters()
+
+
+/**
+ * ******************* GetComputeDerivativePerTimePoint *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+bool
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::GetComputeDerivativePerTimePoint(void) const
+{
+  return this->m_TransformIsStackTransform && this->m_G >= Self::GetNumberOfWorkUnits() &&
+         this->GetNumberOfParameters() % this->m_G == 0;
+} // end GetComputeDerivativePerTimePoint()
+
+
 /**
  * ******************* SampleRandom *******************
  */
@@ -166,8 +245,6 @@ SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::GetValue(
   const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
   const unsigned int G = this->GetFixedImage()->GetLargestPossibleRegion().GetSize(lastDim);
 
-  typedef vnl_matrix<RealType> MatrixType;
-
   /** The rows of the ImageSampleMatrix contain the samples of the images of the stack */
   unsigned int NumberOfSamples = sampleContainer->Size();
   MatrixType   datablock(NumberOfSamples, G);
@@ -305,22 +382,18 @@ SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::GetDeriva
 
 
 /**
- * ******************* GetValueAndDerivative *******************
+ * ******************* GetValueAndDerivativeSingleThreaded *******************
  */
 
 template <class TFixedImage, class TMovingImage>
 void
-SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::GetValueAndDerivative(
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::GetValueAndDerivativeSingleThreaded(
   const TransformParametersType & parameters,
   MeasureType &                   value,
   DerivativeType &                derivative) const
 {
   itkDebugMacro("GetValueAndDerivative( " << parameters << " ) ");
 
-  /** Define derivative and Jacobian types. */
-  typedef typename DerivativeType::ValueType DerivativeValueType;
-  // typedef typename TransformJacobianType::ValueType TransformJacobianValueType;
-
   /** Initialize some variables */
   const unsigned int P = this->GetNumberOfParameters();
   this->m_NumberOfPixelsCounted = 0;
@@ -328,11 +401,12 @@ SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::GetValueA
   derivative = DerivativeType(P);
   derivative.Fill(NumericTraits<DerivativeValueType>::Zero);
 
-  /** Make sure the transform parameters are up to date. */
-  this->SetTransformParameters(parameters);
+  /** Make sure the transform parameters and the image sampler are up to date. When this
+   * metric is part of a combination metric, this was already done in
+   * BeforeThreadedGetValueAndDerivative(). */
+  this->BeforeThreadedGetValueAndDerivative(parameters);
 
-  /** Update the imageSampler and get a handle to the sample container. */
-  this->GetImageSampler()->Update();
+  /** Get a handle to the sample container. */
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
 
   /** Create iterator over the sample container. */
@@ -344,9 +418,6 @@ SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::GetValueA
   const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
   const unsigned int G = this->GetFixedImage()->GetLargestPossibleRegion().GetSize(lastDim);
 
-  typedef vnl_matrix<RealType>            MatrixType;
-  typedef vnl_matrix<DerivativeValueType> DerivativeMatrixType;
-
   std::vector<FixedImagePointType> SamplesOK;
 
   /** The rows of the ImageSampleMatrix contain the samples of the images of the stack */
@@ -534,78 +605,533 @@ SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::GetValueA
   measure = RealType(1.0 - (K.fro_norm() / RealType(G)));
 
   /** Subtract mean from derivative elements. */
-  if (this->m_SubtractMean)
+  this->SubtractMeanFromDerivative(derivative);
+
+  /** Return the measure value. */
+  value = measure;
+
+} // end GetValueAndDerivativeSingleThreaded()
+
+
+/**
+ * ******************* GetValueAndDerivative *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::GetValueAndDerivative(
+  const TransformParametersType & parameters,
+  MeasureType &                   value,
+  DerivativeType &                derivative) const
+{
+  /** Option for now to still use the single threaded code. */
+  if (!this->m_UseMultiThread)
+  {
+    return this->GetValueAndDerivativeSingleThreaded(parameters, value, derivative);
+  }
+
+  /** Call non-thread-safe stuff, such as:
+   *   this->SetTransformParameters( parameters );
+   *   this->GetImageSampler()->Update();
+   */
+  this->BeforeThreadedGetValueAndDerivative(parameters);
+
+  this->InitializeThreadingParameters();
+
+  /** Launch multi-threading GetSamples */
+  this->LaunchGetSamplesThreaderCallback();
+
+  /** Get the metric value contributions from all threads. */
+  this->AfterThreadedGetSamples(value);
+
+  /** Launch multi-threading ComputeDerivative */
+  derivative.SetSize(this->GetNumberOfParameters());
+  derivative.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
+  this->m_SumOfPairwiseCorrelationThreaderParameters.m_Derivative = &derivative;
+  this->LaunchComputeDerivativeThreaderCallback();
+
+  /** Sum derivative contributions from all threads */
+  this->AfterThreadedComputeDerivative(derivative);
+
+} // end GetValueAndDerivative()
+
+
+/**
+ * ******************* ThreadedGetSamples *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::ThreadedGetSamples(ThreadIdType threadId)
+{
+  /** Get a handle to the sample container. */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  const unsigned long         sampleContainerSize = sampleContainer->Size();
+
+  /** Get the samples for this thread. */
+  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
+    std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(Self::GetNumberOfWorkUnits())));
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end = nrOfSamplesPerThreads * (threadId + 1);
+  pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
+  pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
+
+  /** Create iterator over the sample container. */
+  typename ImageSampleContainerType::ConstIterator threader_fiter;
+  typename ImageSampleContainerType::ConstIterator threader_fbegin = sampleContainer->Begin();
+  typename ImageSampleContainerType::ConstIterator threader_fend = sampleContainer->Begin();
+  threader_fbegin += (int)pos_begin;
+  threader_fend += (int)pos_end;
+
+  std::vector<FixedImagePointType> SamplesOK;
+  MatrixType                       datablock(pos_end - pos_begin, this->m_G);
+
+  unsigned int pixelIndex = 0;
+  for (threader_fiter = threader_fbegin; threader_fiter != threader_fend; ++threader_fiter)
   {
-    if (!this->m_TransformIsStackTransform)
+    /** Read fixed coordinates. */
+    FixedImagePointType fixedPoint = (*threader_fiter).Value().m_ImageCoordinates;
+
+    /** Transform sampled point to voxel coordinates. */
+    FixedImageContinuousIndexType voxelCoord;
+    this->GetFixedImage()->TransformPhysicalPointToContinuousIndex(fixedPoint, voxelCoord);
+
+    unsigned int numSamplesOk = 0;
+
+    /** Loop over t */
+    for (unsigned int d = 0; d < this->m_G; ++d)
     {
-      /** Update derivative per dimension.
-       * Parameters are ordered xxxxxxx yyyyyyy zzzzzzz ttttttt and
-       * per dimension xyz.
-       */
-      const unsigned int lastDimGridSize = this->m_GridSize[lastDim];
-      const unsigned int numParametersPerDimension =
-        this->GetNumberOfParameters() / this->GetMovingImage()->GetImageDimension();
-      const unsigned int numControlPointsPerDimension = numParametersPerDimension / lastDimGridSize;
-      DerivativeType     mean(numControlPointsPerDimension);
-      for (unsigned int d = 0; d < this->GetMovingImage()->GetImageDimension(); ++d)
+      /** Initialize some variables. */
+      RealType             movingImageValue;
+      MovingImagePointType mappedPoint;
+
+      /** Set fixed point's last dimension to lastDimPosition. */
+      voxelCoord[this->m_LastDimIndex] = d;
+
+      /** Transform sampled point back to world coordinates. */
+      this->GetFixedImage()->TransformContinuousIndexToPhysicalPoint(voxelCoord, fixedPoint);
+
+      /** Transform point and check if it is inside the B-spline support region. */
+      bool sampleOk = this->TransformPoint(fixedPoint, mappedPoint);
+
+      /** Check if point is inside mask. */
+      if (sampleOk)
       {
-        /** Compute mean per dimension. */
-        mean.Fill(0.0);
-        const unsigned int starti = numParametersPerDimension * d;
-        for (unsigned int i = starti; i < starti + numParametersPerDimension; ++i)
-        {
-          const unsigned int index = i % numControlPointsPerDimension;
-          mean[index] += derivative[i];
-        }
-        mean /= static_cast<double>(lastDimGridSize);
+        sampleOk = this->IsInsideMovingMask(mappedPoint);
+      }
 
-        /** Update derivative for every control point per dimension. */
-        for (unsigned int i = starti; i < starti + numParametersPerDimension; ++i)
-        {
-          const unsigned int index = i % numControlPointsPerDimension;
-          derivative[i] -= mean[index];
-        }
+      if (sampleOk)
+      {
+        sampleOk = this->EvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, nullptr);
       }
+
+      if (sampleOk)
+      {
+        numSamplesOk++;
+        datablock(pixelIndex, d) = movingImageValue;
+      } // end if sampleOk
+
+    } // end loop over t
+    if (numSamplesOk == this->m_G)
+    {
+      SamplesOK.push_back(fixedPoint);
+      pixelIndex++;
     }
-    else
+
+  } /** end first loop over image sample container */
+
+  /** Only update these variables at the end to prevent unnecessary "false sharing". */
+  this->m_SumOfPairwiseCorrelationPerThreadVariables[threadId].st_NumberOfPixelsCounted = pixelIndex;
+  this->m_SumOfPairwiseCorrelationPerThreadVariables[threadId].st_DataBlock = datablock.extract(pixelIndex, this->m_G);
+  this->m_SumOfPairwiseCorrelationPerThreadVariables[threadId].st_ApprovedSamples.swap(SamplesOK);
+
+} // end ThreadedGetSamples()
+
+
+/**
+ * ******************* AfterThreadedGetSamples *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::AfterThreadedGetSamples(
+  MeasureType & value) const
+{
+  const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
+  const unsigned int G = this->m_G;
+
+  /** Accumulate the number of pixels. */
+  this->m_NumberOfPixelsCounted = this->m_SumOfPairwiseCorrelationPerThreadVariables[0].st_NumberOfPixelsCounted;
+  for (ThreadIdType i = 1; i < numberOfThreads; ++i)
+  {
+    this->m_NumberOfPixelsCounted += this->m_SumOfPairwiseCorrelationPerThreadVariables[i].st_NumberOfPixelsCounted;
+  }
+
+  /** Check if enough samples were valid. */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  this->CheckNumberOfSamples(sampleContainer->Size(), this->m_NumberOfPixelsCounted);
+  const unsigned int N = this->m_NumberOfPixelsCounted;
+
+  /** Concatenate the data blocks of all threads, in thread order. */
+  MatrixType   A(N, G);
+  unsigned int row_start = 0;
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    A.update(this->m_SumOfPairwiseCorrelationPerThreadVariables[i].st_DataBlock, row_start, 0);
+    this->m_PixelStartIndex[i] = row_start;
+    row_start += this->m_SumOfPairwiseCorrelationPerThreadVariables[i].st_DataBlock.rows();
+  }
+
+  /** Calculate mean of columns */
+  vnl_vector<RealType> mean(G);
+  mean.fill(NumericTraits<RealType>::Zero);
+  for (unsigned int i = 0; i < N; i++)
+  {
+    for (unsigned int j = 0; j < G; j++)
     {
-      /** Update derivative per dimension.
-       * Parameters are ordered x0x0x0y0y0y0z0z0z0x1x1x1y1y1y1z1z1z1 with
-       * the number the time point index.
-       */
-      const unsigned int numParametersPerLastDimension = this->GetNumberOfParameters() / G;
-      DerivativeType     mean(numParametersPerLastDimension);
-      mean.Fill(0.0);
+      mean(j) += A(i, j);
+    }
+  }
+  mean /= RealType(N);
+
+  /** Subtract the mean from the columns */
+  MatrixType Amm(N, G);
+  for (unsigned int i = 0; i < N; i++)
+  {
+    for (unsigned int j = 0; j < G; j++)
+    {
+      Amm(i, j) = A(i, j) - mean(j);
+    }
+  }
+
+  /** Compute covariance matrix C */
+  this->m_Atmm = Amm.transpose();
+  MatrixType C(this->m_Atmm * Amm);
+  C /= static_cast<RealType>(RealType(N) - 1.0);
+
+  vnl_diag_matrix<RealType> S(G);
+  S.fill(NumericTraits<RealType>::Zero);
+  for (unsigned int j = 0; j < G; j++)
+  {
+    S(j, j) = 1.0 / sqrt(C(j, j));
+  }
+
+  /** Compute correlation matrix K */
+  DerivativeMatrixType K(S * C * S);
+  const RealType       normK = K.fro_norm();
+
+  /** Sub components of metric derivative */
+  this->m_dSdmu_part1.set_size(G);
+  for (unsigned int d = 0; d < G; d++)
+  {
+    double S_sqr = S(d, d) * S(d, d);
+    double S_qub = S_sqr * S(d, d);
+    this->m_dSdmu_part1(d, d) = -S_qub / (DerivativeValueType(N) - 1.0);
+  }
+
+  this->m_S = S;
+  this->m_KAtZscore = K * (Amm * S).transpose();
+  this->m_KAtZscoreAmm = this->m_KAtZscore * Amm;
+  this->m_NormK = normK;
+
+  value = RealType(1.0 - (normK / RealType(G)));
+
+} // end AfterThreadedGetSamples()
+
+
+/**
+ * **************** GetSamplesThreaderCallback *******
+ */
+
+template <class TFixedImage, class TMovingImage>
+ITK_THREAD_RETURN_TYPE
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::GetSamplesThreaderCallback(void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType     threadId = infoStruct->WorkUnitID;
+
+  SumOfPairwiseCorrelationCoefficientsMultiThreaderParameterType * temp =
+    static_cast<SumOfPairwiseCorrelationCoefficientsMultiThreaderParameterType *>(infoStruct->UserData);
+
+  temp->m_Metric->ThreadedGetSamples(threadId);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end GetSamplesThreaderCallback()
+
+
+/**
+ * *********************** LaunchGetSamplesThreaderCallback ***************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::LaunchGetSamplesThreaderCallback(void) const
+{
+  /** Setup threader. */
+  this->m_Threader->SetSingleMethod(
+    this->GetSamplesThreaderCallback,
+    const_cast<void *>(static_cast<const void *>(&this->m_SumOfPairwiseCorrelationThreaderParameters)));
+
+  /** Launch. */
+  this->m_Threader->SingleMethodExecute();
+
+} // end LaunchGetSamplesThreaderCallback()
+
+
+/**
+ * ******************* ThreadedComputeDerivative *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::ThreadedComputeDerivative(ThreadIdType threadId)
+{
+  const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
+  const unsigned int G = this->m_G;
+
+  /** Either this thread handles its own samples for all time points, and
+   * accumulates in its own derivative, or it handles the samples of all threads
+   * for its own range of time points, and writes in the final derivative.
+   */
+  const bool   perTimePoint = this->GetComputeDerivativePerTimePoint();
+  ThreadIdType threadBegin = threadId;
+  ThreadIdType threadEnd = threadId + 1;
+  unsigned int d_begin = 0;
+  unsigned int d_end = G;
+  if (perTimePoint)
+  {
+    const unsigned int nrOfTimePointsPerThread =
+      static_cast<unsigned int>(std::ceil(static_cast<double>(G) / static_cast<double>(numberOfThreads)));
+    threadBegin = 0;
+    threadEnd = numberOfThreads;
+    d_begin = std::min(nrOfTimePointsPerThread * threadId, G);
+    d_end = std::min(nrOfTimePointsPerThread * (threadId + 1), G);
+  }
+
+  DerivativeType & derivative =
+    perTimePoint ? *(this->m_SumOfPairwiseCorrelationThreaderParameters.m_Derivative)
+                 : this->m_SumOfPairwiseCorrelationPerThreadVariables[threadId].st_Derivative;
+  if (!perTimePoint)
+  {
+    derivative.Fill(0.0);
+  }
 
-      /** Compute mean per control point. */
-      for (unsigned int t = 0; t < G; ++t)
+  /** Initialize some variables. */
+  RealType                  movingImageValue;
+  MovingImagePointType      mappedPoint;
+  MovingImageDerivativeType movingImageDerivative;
+
+  TransformJacobianType      jacobian;
+  DerivativeType             imageJacobian(this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices());
+  NonZeroJacobianIndicesType nzjis(this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices());
+
+  /** Second loop over fixed image samples. */
+  for (ThreadIdType t = threadBegin; t < threadEnd; ++t)
+  {
+    const std::vector<FixedImagePointType> & approvedSamples =
+      this->m_SumOfPairwiseCorrelationPerThreadVariables[t].st_ApprovedSamples;
+
+    for (unsigned int j = 0; j < approvedSamples.size(); ++j)
+    {
+      const unsigned int pixelIndex = this->m_PixelStartIndex[t] + j;
+
+      /** Read fixed coordinates. */
+      FixedImagePointType fixedPoint = approvedSamples[j];
+
+      /** Transform sampled point to voxel coordinates. */
+      FixedImageContinuousIndexType voxelCoord;
+      this->GetFixedImage()->TransformPhysicalPointToContinuousIndex(fixedPoint, voxelCoord);
+
+      for (unsigned int d = d_begin; d < d_end; ++d)
       {
-        const unsigned int startc = numParametersPerLastDimension * t;
-        for (unsigned int c = startc; c < startc + numParametersPerLastDimension; ++c)
+        /** Set fixed point's last dimension to lastDimPosition. */
+        voxelCoord[this->m_LastDimIndex] = d;
+
+        /** Transform sampled point back to world coordinates. */
+        this->GetFixedImage()->TransformContinuousIndexToPhysicalPoint(voxelCoord, fixedPoint);
+        this->TransformPoint(fixedPoint, mappedPoint);
+
+        this->EvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, &movingImageDerivative);
+
+        /** Get the TransformJacobian dT/dmu */
+        this->EvaluateTransformJacobian(fixedPoint, jacobian, nzjis);
+
+        /** Compute the innerproduct (dM/dx)^T (dT/dmu). */
+        this->EvaluateTransformJacobianInnerProduct(jacobian, movingImageDerivative, imageJacobian);
+
+        /** The weight of this sample does not depend on the parameter index. */
+        const DerivativeValueType weight =
+          this->m_KAtZscore[d][pixelIndex] * this->m_S(d, d) +
+          this->m_dSdmu_part1(d, d) * this->m_Atmm[d][pixelIndex] * this->m_KAtZscoreAmm[d][d];
+
+        /** build metric derivative components */
+        for (unsigned int p = 0; p < nzjis.size(); ++p)
         {
-          const unsigned int index = c % numParametersPerLastDimension;
-          mean[index] += derivative[c];
-        }
+          derivative[nzjis[p]] += weight * imageJacobian[p];
+        } // end loop over non-zero jacobian indices
+
+      } // end loop over last dimension
+
+    } // end loop over approved samples
+
+  } // end second for loop over sample container
+
+} // end ThreadedComputeDerivative()
+
+
+/**
+ * ******************* AfterThreadedComputeDerivative *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::AfterThreadedComputeDerivative(
+  DerivativeType & derivative) const
+{
+  /** Sum the per-thread derivatives, unless the threads already wrote their
+   * own time points of the derivative directly.
+   */
+  if (!this->GetComputeDerivativePerTimePoint())
+  {
+    const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
+
+    derivative = this->m_SumOfPairwiseCorrelationPerThreadVariables[0].st_Derivative;
+    for (ThreadIdType i = 1; i < numberOfThreads; ++i)
+    {
+      derivative += this->m_SumOfPairwiseCorrelationPerThreadVariables[i].st_Derivative;
+    }
+  }
+
+  const DerivativeValueType N = static_cast<DerivativeValueType>(this->m_NumberOfPixelsCounted);
+  derivative *= -static_cast<DerivativeValueType>(2.0) /
+                ((N - static_cast<DerivativeValueType>(1.0)) * (this->m_NormK * RealType(this->m_G))); // normalize
+
+  /** Subtract mean from derivative elements. */
+  this->SubtractMeanFromDerivative(derivative);
+
+} // end AfterThreadedComputeDerivative()
+
+
+/**
+ * **************** ComputeDerivativeThreaderCallback *******
+ */
+
+template <class TFixedImage, class TMovingImage>
+ITK_THREAD_RETURN_TYPE
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::ComputeDerivativeThreaderCallback(void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType     threadId = infoStruct->WorkUnitID;
+
+  SumOfPairwiseCorrelationCoefficientsMultiThreaderParameterType * temp =
+    static_cast<SumOfPairwiseCorrelationCoefficientsMultiThreaderParameterType *>(infoStruct->UserData);
+
+  temp->m_Metric->ThreadedComputeDerivative(threadId);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ComputeDerivativeThreaderCallback()
+
+
+/**
+ * ************** LaunchComputeDerivativeThreaderCallback **********
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::LaunchComputeDerivativeThreaderCallback() const
+{
+  /** Setup threader. */
+  this->m_Threader->SetSingleMethod(
+    this->ComputeDerivativeThreaderCallback,
+    const_cast<void *>(static_cast<const void *>(&this->m_SumOfPairwiseCorrelationThreaderParameters)));
+
+  /** Launch. */
+  this->m_Threader->SingleMethodExecute();
+
+} // end LaunchComputeDerivativeThreaderCallback()
+
+
+/**
+ * ******************* SubtractMeanFromDerivative *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::SubtractMeanFromDerivative(
+  DerivativeType & derivative) const
+{
+  if (!this->m_SubtractMean)
+  {
+    return;
+  }
+
+  if (!this->m_TransformIsStackTransform)
+  {
+    /** Update derivative per dimension.
+     * Parameters are ordered xxxxxxx yyyyyyy zzzzzzz ttttttt and
+     * per dimension xyz.
+     */
+    const unsigned int lastDimGridSize = this->m_GridSize[this->m_LastDimIndex];
+    const unsigned int numParametersPerDimension =
+      this->GetNumberOfParameters() / this->GetMovingImage()->GetImageDimension();
+    const unsigned int numControlPointsPerDimension = numParametersPerDimension / lastDimGridSize;
+    DerivativeType     mean(numControlPointsPerDimension);
+    for (unsigned int d = 0; d < this->GetMovingImage()->GetImageDimension(); ++d)
+    {
+      /** Compute mean per dimension. */
+      mean.Fill(0.0);
+      const unsigned int starti = numParametersPerDimension * d;
+      for (unsigned int i = starti; i < starti + numParametersPerDimension; ++i)
+      {
+        const unsigned int index = i % numControlPointsPerDimension;
+        mean[index] += derivative[i];
       }
-      mean /= static_cast<double>(G);
+      mean /= static_cast<double>(lastDimGridSize);
 
-      /** Update derivative per control point. */
-      for (unsigned int t = 0; t < G; ++t)
+      /** Update derivative for every control point per dimension. */
+      for (unsigned int i = starti; i < starti + numParametersPerDimension; ++i)
       {
-        const unsigned int startc = numParametersPerLastDimension * t;
-        for (unsigned int c = startc; c < startc + numParametersPerLastDimension; ++c)
-        {
-          const unsigned int index = c % numParametersPerLastDimension;
-          derivative[c] -= mean[index];
-        }
+        const unsigned int index = i % numControlPointsPerDimension;
+        derivative[i] -= mean[index];
       }
     }
   }
+  else
+  {
+    /** Update derivative per dimension.
+     * Parameters are ordered x0x0x0y0y0y0z0z0z0x1x1x1y1y1y1z1z1z1 with
+     * the number the time point index.
+     */
+    const unsigned int numParametersPerLastDimension = this->GetNumberOfParameters() / this->m_G;
+    DerivativeType     mean(numParametersPerLastDimension);
+    mean.Fill(0.0);
+
+    /** Compute mean per control point. */
+    for (unsigned int t = 0; t < this->m_G; ++t)
+    {
+      const unsigned int startc = numParametersPerLastDimension * t;
+      for (unsigned int c = startc; c < startc + numParametersPerLastDimension; ++c)
+      {
+        const unsigned int index = c % numParametersPerLastDimension;
+        mean[index] += derivative[c];
+      }
+    }
+    mean /= static_cast<double>(this->m_G);
 
-  /** Return the measure value. */
-  value = measure;
-
-} // end GetValueAndDerivative()
+    /** Update derivative per control point. */
+    for (unsigned int t = 0; t < this->m_G; ++t)
+    {
+      const unsigned int startc = numParametersPerLastDimension * t;
+      for (unsigned int c = startc; c < startc + numParametersPerLastDimension; ++c)
+      {
+        const unsigned int index = c % numParametersPerLastDimension;
+        derivative[c] -= mean[index];
+      }
+    }
+  }
+} // end SubtractMeanFromDerivative()
 
 
 } // end namespace itk
@@ -735,44 +735,51 @@ CMAEvolutionStrategyOptimizer::UpdateC(void)
   const double       mu_cov = this->m_CovarianceMatrixAdaptationWeight;
   const double       sigma = this->m_CurrentSigma;
 
-  /** Multiply old m_C with some factor */
+  /** The factor with which the old m_C is multiplied */
   double oldCfactor = 1.0 - c_cov;
   if (!this->m_Heaviside)
   {
     oldCfactor += (c_cov * c_c * (2.0 - c_c) / mu_cov);
   }
-  this->m_C *= oldCfactor;
 
-  /** Do rank-one update */
-  const double rankonefactor = c_cov / mu_cov;
-  for (unsigned int i = 0; i < N; ++i)
-  {
-    const double evolutionPath_i = this->m_EvolutionPath[i];
-    for (unsigned int j = 0; j < N; ++j)
-    {
-      const double update = rankonefactor * evolutionPath_i * this->m_EvolutionPath[j];
-      this->m_C[i][j] += update;
-    }
-  }
+  /** Collect the vectors of the rank-one update and the rank-mu update,
+   * such that: C = oldCfactor * C + sum_m factor_m * y_m * y_m'. */
+  std::vector<const double *> updateVectors;
+  std::vector<double>         updateFactors;
+  updateVectors.push_back(this->m_EvolutionPath.data_block());
+  updateFactors.push_back(c_cov / mu_cov);
 
-  /** Do rank-mu update */
   const double rankmufactor = c_cov * (1.0 - 1.0 / mu_cov);
   for (unsigned int m = 0; m < mu; ++m)
   {
     const unsigned int lam = this->m_CostFunctionValues[m].second;
-    const double       sqrtweight = std::sqrt(this->m_RecombinationWeights[m]);
-    ParametersType     weightedSearchDir = this->m_SearchDirs[lam];
-    weightedSearchDir *= (sqrtweight / sigma);
-    for (unsigned int i = 0; i < N; ++i)
+    updateVectors.push_back(this->m_SearchDirs[lam].data_block());
+    updateFactors.push_back(rankmufactor * this->m_RecombinationWeights[m] / (sigma * sigma));
+  }
+
+  /** Do the scaling, the rank-one update and the rank-mu update in one sweep over
+   * the upper triangle of C, with contiguous inner loops, and mirror the result. */
+  for (unsigned int i = 0; i < N; ++i)
+  {
+    double * C_i = this->m_C[i];
+    for (unsigned int j = i; j < N; ++j)
+    {
+      C_i[j] *= oldCfactor;
+    }
+    for (std::size_t m = 0; m < updateVectors.size(); ++m)
     {
-      const double weightedSearchDir_i = weightedSearchDir[i];
-      for (unsigned int j = 0; j < N; ++j)
+      const double * y = updateVectors[m];
+      const double   factor_i = updateFactors[m] * y[i];
+      for (unsigned int j = i; j < N; ++j)
       {
-        const double update = rankmufactor * weightedSearchDir_i * weightedSearchDir[j];
-        this->m_C[i][j] += update;
+        C_i[j] += factor_i * y[j];
       }
     }
-  } // end for m
+    for (unsigned int j = 0; j < i; ++j)
+    {
+      C_i[j] = this->m_C[j][i];
+    }
+  }
 
 } // end UpdateC
 
@@ -87,6 +87,11 @@ namespace elastix
  *    example: <tt>(Metric0Use "false" "true")</tt> \n
  *    example: <tt>(Metric1Use "true" "false")</tt> \n
  *    The default is "true".
+ * \parameter UseConcurrentMetrics: Whether the metrics are computed concurrently,
+ *    each metric in its own thread, instead of one after the other. This may speed up
+ *    registrations that combine several metrics that do not scale well over all threads. \n
+ *    example: <tt>(UseConcurrentMetrics "false" "true")</tt> \n
+ *    The default is "false".
  *
  * \ingroup Registrations
  */
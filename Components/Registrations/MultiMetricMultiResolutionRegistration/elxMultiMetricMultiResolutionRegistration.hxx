@@ -192,6 +192,11 @@ MultiMetricMultiResolutionRegistration<TElastix>::BeforeEachResolution(void)
   this->GetConfiguration()->ReadParameter(useRelativeWeights, "UseRelativeWeights", 0);
   this->GetCombinationMetric()->SetUseRelativeWeights(useRelativeWeights);
 
+  /** Set the concurrent computation of the metrics. */
+  bool useConcurrentMetrics = false;
+  this->GetConfiguration()->ReadParameter(useConcurrentMetrics, "UseConcurrentMetrics", "", level, 0);
+  this->GetCombinationMetric()->SetUseConcurrentMetrics(useConcurrentMetrics);
+
   /** Set the metric weights. The default metric weight is 1.0 / nrOfMetrics. */
   if (!useRelativeWeights)
   {
@@ -21,6 +21,9 @@
 #include "itkAdvancedImageToImageMetric.h"
 #include "itkSingleValuedPointSetToPointSetMetric.h"
 
+#include <atomic>
+#include <exception>
+
 namespace itk
 {
 
@@ -50,6 +53,15 @@ namespace itk
  * why we chose to reimplement the Get{Transform,Interpolator}()
  * methods.
  *
+ * Note: By default the sub metrics are computed one after the other in
+ * GetValueAndDerivative(). With SetUseConcurrentMetrics( true ), they are
+ * computed as concurrent tasks on the threader of this metric, and the
+ * weighted sum of their derivatives is computed in parallel as well. This
+ * relies on the BeforeThreadedGetValueAndDerivative() mechanism of the
+ * sub metrics, so only sub metrics that opt in, i.e. for which
+ * GetSupportsConcurrentGetValueAndDerivative() returns true, are run
+ * concurrently; any other sub metric is still computed in the calling thread.
+ *
  *
  * \ingroup RegistrationMetrics
  *
@@ -234,6 +246,11 @@ public:
   double
   GetMetricComputationTime(unsigned int pos) const;
 
+  /** Set and Get whether the sub metrics are computed concurrently in GetValueAndDerivative(). */
+  itkSetMacro(UseConcurrentMetrics, bool);
+  itkGetConstMacro(UseConcurrentMetrics, bool);
+  itkBooleanMacro(UseConcurrentMetrics);
+
   /**
    * Set/Get functions for the metric components
    */
@@ -456,6 +473,7 @@ protected:
   mutable std::vector<DerivativeType>          m_MetricDerivatives;
   mutable std::vector<double>                  m_MetricDerivativesMagnitude;
   mutable std::vector<double>                  m_MetricComputationTime;
+  bool                                         m_UseConcurrentMetrics;
 
   /** Dummy image region and derivatives. */
   FixedImageRegionType m_NullFixedImageRegion;
@@ -478,6 +496,41 @@ private:
    */
   double
   GetFinalMetricWeight(unsigned int pos) const;
+
+  /** Compute the value and derivative of metric pos, and store them together
+   * with the derivative magnitude and the computation time.
+   */
+  void
+  ComputeMetricValueAndDerivative(const ParametersType & parameters, const unsigned int pos) const;
+
+  /** Compute the values and derivatives of all metrics concurrently. */
+  void
+  LaunchConcurrentGetValueAndDerivative(const ParametersType & parameters) const;
+
+  /** Compute the weighted sum of the metric derivatives in parallel. */
+  void
+  LaunchCombineDerivatives(DerivativeType & derivative) const;
+
+  /** ConcurrentGetValueAndDerivative threader callback function. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  ConcurrentGetValueAndDerivativeThreaderCallback(void * arg);
+
+  /** CombineDerivatives threader callback function. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  CombineDerivativesThreaderCallback(void * arg);
+
+  /** Helper struct to pass the concurrent tasks to the threads. */
+  struct CombinationThreaderParameterType
+  {
+    const Self *                    st_Metric;
+    const ParametersType *          st_Parameters;
+    std::vector<unsigned int>       st_ConcurrentMetrics;
+    std::atomic<unsigned int>       st_NextConcurrentMetric;
+    std::vector<std::exception_ptr> st_Exceptions;
+    std::vector<double>             st_FinalMetricWeights;
+    DerivativeValueType *           st_DerivativePointer;
+  };
+  mutable CombinationThreaderParameterType m_CombinationThreaderParameters;
 };
 
 } // end namespace itk
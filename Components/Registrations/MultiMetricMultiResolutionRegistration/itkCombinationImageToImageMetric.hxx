@@ -22,6 +22,9 @@
 #include "itkTimeProbe.h"
 #include "itkMath.h"
 
+#include <algorithm> // For min.
+#include <cmath>     // For ceil.
+
 /** Macros to reduce some copy-paste work.
  * These macros provide the implementation of
  * all Set/GetFixedImage, Set/GetInterpolator etc methods
@@ -146,8 +149,14 @@ CombinationImageToImageMetric<TFixedImage, TMovingImage>::CombinationImageToImag
 {
   this->m_NumberOfMetrics = 0;
   this->m_UseRelativeWeights = false;
+  this->m_UseConcurrentMetrics = false;
   this->ComputeGradientOff();
 
+  this->m_CombinationThreaderParameters.st_Metric = this;
+  this->m_CombinationThreaderParameters.st_Parameters = nullptr;
+  this->m_CombinationThreaderParameters.st_NextConcurrentMetric = 0;
+  this->m_CombinationThreaderParameters.st_DerivativePointer = nullptr;
+
 } // end Constructor
 
 
@@ -164,6 +173,7 @@ CombinationImageToImageMetric<TFixedImage, TMovingImage>::PrintSelf(std::ostream
 
   /** Add debugging information. */
   os << "NumberOfMetrics: " << this->m_NumberOfMetrics << std::endl;
+  os << "UseConcurrentMetrics: " << (this->m_UseConcurrentMetrics ? "true" : "false") << std::endl;
   for (unsigned int i = 0; i < this->m_NumberOfMetrics; i++)
   {
     os << "Metric " << i << ":\n";
@@ -780,9 +790,6 @@ CombinationImageToImageMetric<TFixedImage, TMovingImage>::GetValueAndDerivative(
                                                                                 MeasureType &          value,
                                                                                 DerivativeType &       derivative) const
 {
-  /** Declare timer. */
-  itk::TimeProbe timer;
-
   /** This function must be called before the multi-threaded code.
    * It calls all the non thread-safe stuff.
    */
@@ -807,23 +814,17 @@ CombinationImageToImageMetric<TFixedImage, TMovingImage>::GetValueAndDerivative(
   /** Initialize some threading related parameters. */
   this->InitializeThreadingParameters();
 
-  /** Compute all metric values and derivatives. */
-  for (unsigned int i = 0; i < this->m_NumberOfMetrics; i++)
+  /** Compute all metric values and derivatives, and the derivative magnitudes. */
+  if (this->m_UseConcurrentMetrics && this->m_NumberOfMetrics > 1)
   {
-    /** Compute ... */
-    timer.Reset();
-    timer.Start();
-    this->m_Metrics[i]->GetValueAndDerivative(parameters, this->m_MetricValues[i], this->m_MetricDerivatives[i]);
-    timer.Stop();
-
-    /** Store computation time. */
-    this->m_MetricComputationTime[i] = timer.GetMean() * 1000.0;
+    this->LaunchConcurrentGetValueAndDerivative(parameters);
   }
-
-  /** Compute the derivative magnitude. */
-  for (unsigned int i = 0; i < this->m_NumberOfMetrics; i++)
+  else
   {
-    this->m_MetricDerivativesMagnitude[i] = this->m_MetricDerivatives[i].magnitude();
+    for (unsigned int i = 0; i < this->m_NumberOfMetrics; i++)
+    {
+      this->ComputeMetricValueAndDerivative(parameters, i);
+    }
   }
 
   /** Combine the metric values. */
@@ -837,6 +838,13 @@ CombinationImageToImageMetric<TFixedImage, TMovingImage>::GetValueAndDerivative(
     }
   }
 
+  /** Combine the metric derivatives in parallel. */
+  if (this->m_UseConcurrentMetrics)
+  {
+    this->LaunchCombineDerivatives(derivative);
+    return;
+  }
+
   /** Combine the metric derivatives. First, the first derivative. */
   if (this->m_UseMetric[0])
   {
@@ -861,6 +869,199 @@ CombinationImageToImageMetric<TFixedImage, TMovingImage>::GetValueAndDerivative(
 } // end GetValueAndDerivative()
 
 
+/**
+ * ********************* ComputeMetricValueAndDerivative ****************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+CombinationImageToImageMetric<TFixedImage, TMovingImage>::ComputeMetricValueAndDerivative(
+  const ParametersType & parameters,
+  const unsigned int     pos) const
+{
+  /** Compute the value and derivative of this metric, and time it. */
+  itk::TimeProbe timer;
+  timer.Start();
+  this->m_Metrics[pos]->GetValueAndDerivative(parameters, this->m_MetricValues[pos], this->m_MetricDerivatives[pos]);
+  timer.Stop();
+
+  /** Store computation time. */
+  this->m_MetricComputationTime[pos] = timer.GetMean() * 1000.0;
+
+  /** Compute the derivative magnitude. */
+  this->m_MetricDerivativesMagnitude[pos] = this->m_MetricDerivatives[pos].magnitude();
+
+} // end ComputeMetricValueAndDerivative()
+
+
+/**
+ * ********************* LaunchConcurrentGetValueAndDerivative ****************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+CombinationImageToImageMetric<TFixedImage, TMovingImage>::LaunchConcurrentGetValueAndDerivative(
+  const ParametersType & parameters) const
+{
+  /** Only the metrics that state that all their thread-unsafe work is done in
+   * BeforeThreadedGetValueAndDerivative() can be computed concurrently. The others
+   * may still change shared state, like the transform parameters, so they are
+   * computed first, in this thread.
+   */
+  CombinationThreaderParameterType & threaderParameters = this->m_CombinationThreaderParameters;
+  threaderParameters.st_ConcurrentMetrics.clear();
+  for (unsigned int i = 0; i < this->m_NumberOfMetrics; i++)
+  {
+    const ImageMetricType *    imageMetric = dynamic_cast<const ImageMetricType *>(this->GetMetric(i));
+    const PointSetMetricType * pointSetMetric = dynamic_cast<const PointSetMetricType *>(this->GetMetric(i));
+    if ((imageMetric && imageMetric->GetSupportsConcurrentGetValueAndDerivative()) ||
+        (pointSetMetric && pointSetMetric->GetSupportsConcurrentGetValueAndDerivative()))
+    {
+      threaderParameters.st_ConcurrentMetrics.push_back(i);
+    }
+    else
+    {
+      this->ComputeMetricValueAndDerivative(parameters, i);
+    }
+  }
+
+  const unsigned int numberOfConcurrentMetrics = threaderParameters.st_ConcurrentMetrics.size();
+  if (numberOfConcurrentMetrics == 0)
+  {
+    return;
+  }
+
+  /** Setup the threader: one task per metric, and at most one thread per task. */
+  threaderParameters.st_Parameters = &parameters;
+  threaderParameters.st_NextConcurrentMetric = 0;
+  threaderParameters.st_Exceptions.assign(this->m_NumberOfMetrics, nullptr);
+
+  const ThreadIdType numberOfWorkUnits = this->m_Threader->GetNumberOfWorkUnits();
+  this->m_Threader->SetNumberOfWorkUnits(std::min<ThreadIdType>(numberOfWorkUnits, numberOfConcurrentMetrics));
+  this->m_Threader->SetSingleMethod(this->ConcurrentGetValueAndDerivativeThreaderCallback,
+                                    const_cast<void *>(static_cast<const void *>(&threaderParameters)));
+
+  /** Launch. */
+  this->m_Threader->SingleMethodExecute();
+  this->m_Threader->SetNumberOfWorkUnits(numberOfWorkUnits);
+
+  /** Rethrow the exception of the first metric that failed, if any. */
+  for (const std::exception_ptr & exception : threaderParameters.st_Exceptions)
+  {
+    if (exception)
+    {
+      std::rethrow_exception(exception);
+    }
+  }
+
+} // end LaunchConcurrentGetValueAndDerivative()
+
+
+/**
+ * **************** ConcurrentGetValueAndDerivativeThreaderCallback *******
+ */
+
+template <class TFixedImage, class TMovingImage>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+CombinationImageToImageMetric<TFixedImage, TMovingImage>::ConcurrentGetValueAndDerivativeThreaderCallback(void * arg)
+{
+  ThreadInfoType *                   infoStruct = static_cast<ThreadInfoType *>(arg);
+  CombinationThreaderParameterType * temp = static_cast<CombinationThreaderParameterType *>(infoStruct->UserData);
+
+  /** Each thread takes the next metric that is not yet computed, until all are done. */
+  const unsigned int numberOfConcurrentMetrics = temp->st_ConcurrentMetrics.size();
+  for (unsigned int task = temp->st_NextConcurrentMetric++; task < numberOfConcurrentMetrics;
+       task = temp->st_NextConcurrentMetric++)
+  {
+    const unsigned int pos = temp->st_ConcurrentMetrics[task];
+    try
+    {
+      temp->st_Metric->ComputeMetricValueAndDerivative(*temp->st_Parameters, pos);
+    }
+    catch (...)
+    {
+      temp->st_Exceptions[pos] = std::current_exception();
+    }
+  }
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ConcurrentGetValueAndDerivativeThreaderCallback()
+
+
+/**
+ * ********************* LaunchCombineDerivatives ****************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+CombinationImageToImageMetric<TFixedImage, TMovingImage>::LaunchCombineDerivatives(DerivativeType & derivative) const
+{
+  /** The final weights are zero for the metrics that are not used. */
+  CombinationThreaderParameterType & threaderParameters = this->m_CombinationThreaderParameters;
+  threaderParameters.st_FinalMetricWeights.resize(this->m_NumberOfMetrics);
+  for (unsigned int i = 0; i < this->m_NumberOfMetrics; i++)
+  {
+    threaderParameters.st_FinalMetricWeights[i] = this->m_UseMetric[i] ? this->GetFinalMetricWeight(i) : 0.0;
+  }
+
+  derivative.SetSize(this->GetNumberOfParameters());
+  threaderParameters.st_DerivativePointer = derivative.begin();
+
+  /** Setup threader and launch. */
+  this->m_Threader->SetSingleMethod(this->CombineDerivativesThreaderCallback,
+                                    const_cast<void *>(static_cast<const void *>(&threaderParameters)));
+  this->m_Threader->SingleMethodExecute();
+
+} // end LaunchCombineDerivatives()
+
+
+/**
+ * **************** CombineDerivativesThreaderCallback *******
+ */
+
+template <class TFixedImage, class TMovingImage>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+CombinationImageToImageMetric<TFixedImage, TMovingImage>::CombineDerivativesThreaderCallback(void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType     threadID = infoStruct->WorkUnitID;
+  ThreadIdType     nrOfThreads = infoStruct->NumberOfWorkUnits;
+
+  CombinationThreaderParameterType * temp = static_cast<CombinationThreaderParameterType *>(infoStruct->UserData);
+
+  const Self &       metric = *(temp->st_Metric);
+  const unsigned int numPar = metric.GetNumberOfParameters();
+  const unsigned int subSize =
+    static_cast<unsigned int>(std::ceil(static_cast<double>(numPar) / static_cast<double>(nrOfThreads)));
+  const unsigned int jmin = threadID * subSize;
+  unsigned int       jmax = (threadID + 1) * subSize;
+  jmax = (jmax > numPar) ? numPar : jmax;
+
+  /** This thread computes the weighted sum of the metric derivatives for the
+   * range [ jmin, jmax [, in the same order as the serial implementation.
+   */
+  const std::vector<double> & weights = temp->st_FinalMetricWeights;
+  for (unsigned int j = jmin; j < jmax; ++j)
+  {
+    DerivativeValueType tmp =
+      metric.m_UseMetric[0] ? weights[0] * metric.m_MetricDerivatives[0][j] : NumericTraits<DerivativeValueType>::Zero;
+    for (unsigned int i = 1; i < metric.m_NumberOfMetrics; ++i)
+    {
+      if (metric.m_UseMetric[i])
+      {
+        tmp += weights[i] * metric.m_MetricDerivatives[i][j];
+      }
+    }
+    temp->st_DerivativePointer[j] = tmp;
+  }
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end CombineDerivativesThreaderCallback()
+
+
+
 /**
  * ********************* GetSelfHessian ****************************
  */
@@ -86,7 +86,16 @@ public:
   typedef typename Superclass2::RegistrationPointer  RegistrationPointer;
   typedef typename Superclass2::ITKBaseType          ITKBaseType;
 
-  /* Nothing to add. In the baseclass already everything is done what should be done. */
+  /** The result image is generated by the itk::ResampleImageFilter, which only interpolates
+   * the input image. Therefore it may also be computed in a single pass with the other
+   * spatial outputs of transformix. */
+  bool
+  ResamplesByInterpolationOnly(void) const override
+  {
+    return true;
+  }
+
+  /* Nothing else to add. In the baseclass already everything is done what should be done. */
 
 protected:
   /** The constructor. */
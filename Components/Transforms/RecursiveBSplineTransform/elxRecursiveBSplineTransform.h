@@ -76,6 +76,14 @@ namespace elastix
  *   <em>Nonrigid registration of dynamic medical imaging data using nD+t B-splines and a
  *   groupwise optimization approach</em>, C.T. Metz, S. Klein, M. Schaap, T. van Walsum and
  *   W.J. Niessen, Medical Image Analysis, in press.
+ * \parameter UseSinglePrecisionBSplineCoefficients: evaluate the B-spline transformation of
+ *   points with a single precision (float) copy of the B-spline coefficients. This halves the
+ *   memory traffic of the coefficient lookups, which is beneficial for large images and dense
+ *   grids, at the cost of single precision accuracy of the displacements. The optimizer, the
+ *   transform parameters and the derivatives of the transform remain in double precision.
+ *   Not supported in combination with UseCyclicTransform, which then gives an error. \n
+ *   example: <tt>(UseSinglePrecisionBSplineCoefficients "true")</tt> \n
+ *   Default: "false".
  *
  *
  * The transform parameters necessary for transformix, additionally defined by this class, are:
@@ -99,6 +107,10 @@ namespace elastix
  *   <em>Nonrigid registration of dynamic medical imaging data using nD+t B-splines and a
  *   groupwise optimization approach</em>, C.T. Metz, S. Klein, M. Schaap, T. van Walsum and
  *   W.J. Niessen, Medical Image Analysis, in press.
+ * \transformparameter UseSinglePrecisionBSplineCoefficients: whether the B-spline transformation of
+ *   points is evaluated with a single precision copy of the B-spline coefficients. \n
+ *   example: <tt>(UseSinglePrecisionBSplineCoefficients "true")</tt> \n
+ *   Default: "false".
  *
  * \todo It is unsure what happens when one of the image dimensions has length 1.
  *
@@ -312,9 +324,10 @@ private:
   GridScheduleComputerPointer m_GridScheduleComputer;
   GridUpsamplerPointer        m_GridUpsampler;
 
-  /** Variables to remember order and periodicity of B-spline transform. */
+  /** Variables to remember order, periodicity and precision of B-spline transform. */
   unsigned int m_SplineOrder;
   bool         m_Cyclic;
+  bool         m_UseSinglePrecisionCoefficients{ false };
 
   /** Initialize the right B-spline transform based on the spline order and periodicity. */
   unsigned int
@@ -45,6 +45,13 @@ RecursiveBSplineTransform<TElastix>::InitializeBSplineTransform(void)
   /** Initialize the right BSplineTransform and GridScheduleComputer. */
   if (this->m_Cyclic)
   {
+    /** The cyclic transform has no single precision copy of its coefficients. */
+    if (this->m_UseSinglePrecisionCoefficients)
+    {
+      itkExceptionMacro(<< "ERROR: UseSinglePrecisionBSplineCoefficients is not supported in combination with "
+                        << "UseCyclicTransform.");
+    }
+
     this->m_GridScheduleComputer = CyclicGridScheduleComputerType::New();
     this->m_GridScheduleComputer->SetBSplineOrder(this->m_SplineOrder);
 
@@ -73,15 +80,21 @@ RecursiveBSplineTransform<TElastix>::InitializeBSplineTransform(void)
 
     if (this->m_SplineOrder == 1)
     {
-      this->m_BSplineTransform = BSplineTransformLinearType::New();
+      typename BSplineTransformLinearType::Pointer bsplineTransform = BSplineTransformLinearType::New();
+      bsplineTransform->SetUseSinglePrecisionCoefficients(this->m_UseSinglePrecisionCoefficients);
+      this->m_BSplineTransform = bsplineTransform;
     }
     else if (this->m_SplineOrder == 2)
     {
-      this->m_BSplineTransform = BSplineTransformQuadraticType::New();
+      typename BSplineTransformQuadraticType::Pointer bsplineTransform = BSplineTransformQuadraticType::New();
+      bsplineTransform->SetUseSinglePrecisionCoefficients(this->m_UseSinglePrecisionCoefficients);
+      this->m_BSplineTransform = bsplineTransform;
     }
     else if (this->m_SplineOrder == 3)
     {
-      this->m_BSplineTransform = BSplineTransformCubicType::New();
+      typename BSplineTransformCubicType::Pointer bsplineTransform = BSplineTransformCubicType::New();
+      bsplineTransform->SetUseSinglePrecisionCoefficients(this->m_UseSinglePrecisionCoefficients);
+      this->m_BSplineTransform = bsplineTransform;
     }
     else
     {
@@ -112,6 +125,13 @@ RecursiveBSplineTransform<TElastix>::BeforeAll(void)
     this->m_SplineOrder, "BSplineTransformSplineOrder", this->GetComponentLabel(), 0, 0, true);
   this->m_Cyclic = false;
   this->GetConfiguration()->ReadParameter(this->m_Cyclic, "UseCyclicTransform", this->GetComponentLabel(), 0, 0, true);
+  this->m_UseSinglePrecisionCoefficients = false;
+  this->GetConfiguration()->ReadParameter(this->m_UseSinglePrecisionCoefficients,
+                                          "UseSinglePrecisionBSplineCoefficients",
+                                          this->GetComponentLabel(),
+                                          0,
+                                          0,
+                                          true);
 
   return this->InitializeBSplineTransform();
 } // end BeforeAll()
@@ -460,6 +480,9 @@ RecursiveBSplineTransform<TElastix>::ReadFromFile(void)
     m_SplineOrder, "BSplineTransformSplineOrder", this->GetComponentLabel(), 0, 0);
   m_Cyclic = false;
   this->GetConfiguration()->ReadParameter(m_Cyclic, "UseCyclicTransform", this->GetComponentLabel(), 0, 0);
+  m_UseSinglePrecisionCoefficients = false;
+  this->GetConfiguration()->ReadParameter(
+    m_UseSinglePrecisionCoefficients, "UseSinglePrecisionBSplineCoefficients", this->GetComponentLabel(), 0, 0);
   InitializeBSplineTransform();
 
   /** Read and Set the Grid: this is a BSplineTransform specific task. */
@@ -526,7 +549,9 @@ RecursiveBSplineTransform<TElastix>::CreateDerivedTransformParametersMap(void) c
            { "GridOrigin", Conversion::ToVectorOfStrings(m_BSplineTransform->GetGridOrigin()) },
            { "GridDirection", Conversion::ToVectorOfStrings(m_BSplineTransform->GetGridDirection()) },
            { "BSplineTransformSplineOrder", { Conversion::ToString(m_SplineOrder) } },
-           { "UseCyclicTransform", { Conversion::ToString(this->m_Cyclic) } } };
+           { "UseCyclicTransform", { Conversion::ToString(this->m_Cyclic) } },
+           { "UseSinglePrecisionBSplineCoefficients",
+             { Conversion::ToString(this->m_UseSinglePrecisionCoefficients) } } };
 
 } // end CreateDerivedTransformParametersMap()
 
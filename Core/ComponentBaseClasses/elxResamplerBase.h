@@ -64,6 +64,15 @@ namespace elastix
  *    of the written image is desired.\n
  *    example: <tt>(CompressResultImage "true")</tt> \n
  *    The default is "false".
+ * \parameter ResultImageMemoryBudget: the approximate amount of memory, in megabytes,
+ *    that may be used for resampling, casting and writing the result image. If the result
+ *    image would need more, it is resampled, cast and written in slabs along the last
+ *    dimension, each of which is resampled multi-threaded. Streamed writing requires an
+ *    image format that supports it, such as uncompressed "mhd" or "nrrd"; otherwise the
+ *    image is written at once. In elastix as a library, only the cast result image is
+ *    kept in memory, in full.\n
+ *    example: <tt>(ResultImageMemoryBudget 1024)</tt> \n
+ *    The default is 0, which means that the result image is resampled at once.
  *
  * \ingroup Resamplers
  * \ingroup ComponentBaseClasses
@@ -185,14 +194,46 @@ public:
   virtual void
   ResampleAndWriteResultImage(const char * filename, const bool & showProgress = true);
 
-  /** Function to write the result output image to a file. */
+  /** Function to write the result output image to a file. If the number of stream divisions is
+   * larger than one, the image is requested from its pipeline, and written, slab by slab. */
   virtual void
-  WriteResultImage(OutputImageType * imageimage, const char * filename, const bool & showProgress = true);
+  WriteResultImage(OutputImageType *  imageimage,
+                   const char *       filename,
+                   const bool &       showProgress = true,
+                   const unsigned int numberOfStreamDivisions = 1);
 
   /** Function to create the result image in the format of an itk::Image. */
   virtual void
   CreateItkResultImage(void);
 
+  /** Function to create the result image in the format of an itk::Image, from an image
+   * that is already resampled. If the number of stream divisions is larger than one,
+   * the image is requested from its pipeline, and cast, slab by slab. */
+  void
+  CreateItkResultImage(OutputImageType * image, const unsigned int numberOfStreamDivisions = 1);
+
+  /** Returns true when there is an input image, and the result image can be computed
+   * by interpolating it at the transformed points, together with the other spatial
+   * outputs of transformix, see TransformBase::ComputeDeformationFieldAndSpatialJacobians().
+   * That is not the case for a resampler that generates the result image in its own way,
+   * see ResamplesByInterpolationOnly(), nor for a ray cast interpolator, which has its
+   * own transform, nor for a result image that is streamed, because of the
+   * ResultImageMemoryBudget parameter.
+   */
+  bool
+  CanComputeResultImageInSinglePass(void) const;
+
+  /** Returns true when the resampler does nothing but interpolate the input image at
+   * the transformed points, as the itk::ResampleImageFilter does. Only then may the
+   * result image be computed without the resampler. Resamplers that override the
+   * generation of the result image, like the OpenCLResampler, must keep the default.
+   */
+  virtual bool
+  ResamplesByInterpolationOnly(void) const
+  {
+    return false;
+  }
+
 protected:
   /** The constructor. */
   ResamplerBase();
@@ -222,6 +263,17 @@ private:
   /** Release memory. */
   void
   ReleaseMemory(void);
+
+  /** Get the number of slabs in which the result image is resampled, cast and
+   * written, based on the ResultImageMemoryBudget parameter. */
+  unsigned int
+  GetNumberOfResultImageStreamDivisions(void) const;
+
+  /** Cast the image to the result pixel type, and return the cast image. If the number
+   * of stream divisions is larger than one, the image is requested and cast slab by slab. */
+  template <class TResultPixel>
+  static itk::DataObject::Pointer
+  CastResultImage(OutputImageType * image, const unsigned int numberOfStreamDivisions);
 };
 
 } // end namespace elastix
@@ -23,8 +23,10 @@
 
 #include "itkImageFileCastWriter.h"
 #include "itkChangeInformationImageFilter.h"
+#include "itkStreamingImageFilter.h"
 #include "itkAdvancedRayCastInterpolateImageFunction.h"
 #include "itkTimeProbe.h"
+#include <algorithm>
 
 namespace elastix
 {
@@ -308,25 +310,30 @@ ResamplerBase<TElastix>::ResampleAndWriteResultImage(const char * filename, cons
     progressObserver->SetEndString("%");
   }
 
-  /** Do the resampling. */
-  try
-  {
-    this->GetAsITKBaseType()->Update();
-  }
-  catch (itk::ExceptionObject & excp)
+  /** Do the resampling, unless it is streamed, in which case the writer
+   * requests the resampled image slab by slab. */
+  const unsigned int numberOfStreamDivisions = this->GetNumberOfResultImageStreamDivisions();
+  if (numberOfStreamDivisions <= 1)
   {
-    /** Add information to the exception. */
-    excp.SetLocation("ResamplerBase - WriteResultImage()");
-    std::string err_str = excp.GetDescription();
-    err_str += "\nError occurred while resampling the image.\n";
-    excp.SetDescription(err_str);
-
-    /** Pass the exception to an higher level. */
-    throw excp;
+    try
+    {
+      this->GetAsITKBaseType()->Update();
+    }
+    catch (itk::ExceptionObject & excp)
+    {
+      /** Add information to the exception. */
+      excp.SetLocation("ResamplerBase - WriteResultImage()");
+      std::string err_str = excp.GetDescription();
+      err_str += "\nError occurred while resampling the image.\n";
+      excp.SetDescription(err_str);
+
+      /** Pass the exception to an higher level. */
+      throw excp;
+    }
   }
 
   /** Perform the writing. */
-  this->WriteResultImage(this->GetAsITKBaseType()->GetOutput(), filename, showProgress);
+  this->WriteResultImage(this->GetAsITKBaseType()->GetOutput(), filename, showProgress, numberOfStreamDivisions);
 
   /** Disconnect from the resampler. */
   if (showProgress && (progressObserver != nullptr))
@@ -343,7 +350,10 @@ ResamplerBase<TElastix>::ResampleAndWriteResultImage(const char * filename, cons
 
 template <class TElastix>
 void
-ResamplerBase<TElastix>::WriteResultImage(OutputImageType * image, const char * filename, const bool & showProgress)
+ResamplerBase<TElastix>::WriteResultImage(OutputImageType *  image,
+                                          const char *       filename,
+                                          const bool &       showProgress,
+                                          const unsigned int numberOfStreamDivisions)
 {
   /** Check if ResampleInterpolator is the RayCastResampleInterpolator  */
   typedef itk::AdvancedRayCastInterpolateImageFunction<InputImageType, CoordRepType> RayCastInterpolatorType;
@@ -397,6 +407,7 @@ ResamplerBase<TElastix>::WriteResultImage(OutputImageType * image, const char *
   writer->SetFileName(filename);
   writer->SetOutputComponentType(resultImagePixelType.c_str());
   writer->SetUseCompression(doCompression);
+  writer->SetNumberOfStreamDivisions(numberOfStreamDivisions);
 
   /** Do the writing. */
   if (showProgress)
@@ -431,29 +442,32 @@ template <class TElastix>
 void
 ResamplerBase<TElastix>::CreateItkResultImage(void)
 {
-  itk::DataObject::Pointer resultImage;
-
   /** Make sure the resampler is updated. */
   this->GetAsITKBaseType()->Modified();
 
   const auto progressObserver =
     BaseComponent::IsElastixLibrary() ? nullptr : ProgressCommandType::CreateAndConnect(*(this->GetAsITKBaseType()));
 
-  /** Do the resampling. */
-  try
+  /** Do the resampling, unless it is streamed, in which case the
+   * resampled image is requested slab by slab when it is cast. */
+  const unsigned int numberOfStreamDivisions = this->GetNumberOfResultImageStreamDivisions();
+  if (numberOfStreamDivisions <= 1)
   {
-    this->GetAsITKBaseType()->Update();
-  }
-  catch (itk::ExceptionObject & excp)
-  {
-    /** Add information to the exception. */
-    excp.SetLocation("ResamplerBase - WriteResultImage()");
-    std::string err_str = excp.GetDescription();
-    err_str += "\nError occurred while resampling the image.\n";
-    excp.SetDescription(err_str);
-
-    /** Pass the exception to an higher level. */
-    throw excp;
+    try
+    {
+      this->GetAsITKBaseType()->Update();
+    }
+    catch (itk::ExceptionObject & excp)
+    {
+      /** Add information to the exception. */
+      excp.SetLocation("ResamplerBase - WriteResultImage()");
+      std::string err_str = excp.GetDescription();
+      err_str += "\nError occurred while resampling the image.\n";
+      excp.SetDescription(err_str);
+
+      /** Pass the exception to an higher level. */
+      throw excp;
+    }
   }
 
   /** Check if ResampleInterpolator is the RayCastResampleInterpolator */
@@ -470,6 +484,27 @@ ResamplerBase<TElastix>::CreateItkResultImage(void)
     this->GetAsITKBaseType()->SetTransform((const_cast<RayCastInterpolatorType *>(testptr))->GetTransform());
   }
 
+  /** Cast the resampled image, and put it in the result image container. */
+  this->CreateItkResultImage(this->GetAsITKBaseType()->GetOutput(), numberOfStreamDivisions);
+
+  if (progressObserver != nullptr)
+  {
+    /** Disconnect from the resampler. */
+    progressObserver->DisconnectObserver(this->GetAsITKBaseType());
+  }
+} // end CreateItkResultImage()
+
+
+/*
+ * ******************* CreateItkResultImage ********************
+ */
+
+template <class TElastix>
+void
+ResamplerBase<TElastix>::CreateItkResultImage(OutputImageType * image, const unsigned int numberOfStreamDivisions)
+{
+  itk::DataObject::Pointer resultImage;
+
   /** Read output pixeltype from parameter the file. Replace possible " " with "_". */
   std::string resultImagePixelType = "short";
   this->m_Configuration->ReadParameter(resultImagePixelType, "ResultImagePixelType", 0, false);
@@ -486,93 +521,50 @@ ResamplerBase<TElastix>::CreateItkResultImage(void)
   bool                                   retdc = this->GetElastix()->GetOriginalFixedImageDirection(originalDirection);
   infoChanger->SetOutputDirection(originalDirection);
   infoChanger->SetChangeDirection(retdc & !this->GetElastix()->GetUseDirectionCosines());
-  infoChanger->SetInput(this->GetAsITKBaseType()->GetOutput());
-
-  typedef itk::CastImageFilter<InputImageType, itk::Image<char, InputImageType::ImageDimension>> CastFilterChar;
-  typedef itk::CastImageFilter<InputImageType, itk::Image<unsigned char, InputImageType::ImageDimension>>
-                                                                                                  CastFilterUChar;
-  typedef itk::CastImageFilter<InputImageType, itk::Image<short, InputImageType::ImageDimension>> CastFilterShort;
-  typedef itk::CastImageFilter<InputImageType, itk::Image<unsigned short, InputImageType::ImageDimension>>
-                                                                                                         CastFilterUShort;
-  typedef itk::CastImageFilter<InputImageType, itk::Image<int, InputImageType::ImageDimension>>          CastFilterInt;
-  typedef itk::CastImageFilter<InputImageType, itk::Image<unsigned int, InputImageType::ImageDimension>> CastFilterUInt;
-  typedef itk::CastImageFilter<InputImageType, itk::Image<long, InputImageType::ImageDimension>>         CastFilterLong;
-  typedef itk::CastImageFilter<InputImageType, itk::Image<unsigned long, InputImageType::ImageDimension>>
-                                                                                                   CastFilterULong;
-  typedef itk::CastImageFilter<InputImageType, itk::Image<float, InputImageType::ImageDimension>>  CastFilterFloat;
-  typedef itk::CastImageFilter<InputImageType, itk::Image<double, InputImageType::ImageDimension>> CastFilterDouble;
+  infoChanger->SetInput(image);
 
   /** cast the image to the correct output image Type */
+  OutputImageType * infoChangerOutput = infoChanger->GetOutput();
   if (resultImagePixelType.compare("char") == 0)
   {
-    typename CastFilterChar::Pointer castFilter = CastFilterChar::New();
-    castFilter->SetInput(infoChanger->GetOutput());
-    castFilter->Update();
-    resultImage = castFilter->GetOutput();
+    resultImage = CastResultImage<char>(infoChangerOutput, numberOfStreamDivisions);
   }
   if (resultImagePixelType.compare("unsigned char") == 0)
   {
-    typename CastFilterUChar::Pointer castFilter = CastFilterUChar::New();
-    castFilter->SetInput(infoChanger->GetOutput());
-    castFilter->Update();
-    resultImage = castFilter->GetOutput();
+    resultImage = CastResultImage<unsigned char>(infoChangerOutput, numberOfStreamDivisions);
   }
   else if (resultImagePixelType.compare("short") == 0)
   {
-    typename CastFilterShort::Pointer castFilter = CastFilterShort::New();
-    castFilter->SetInput(infoChanger->GetOutput());
-    castFilter->Update();
-    resultImage = castFilter->GetOutput();
+    resultImage = CastResultImage<short>(infoChangerOutput, numberOfStreamDivisions);
   }
   else if (resultImagePixelType.compare("ushort") == 0 ||
            resultImagePixelType.compare("unsigned short") == 0) // <-- ushort for backwards compatibility
   {
-    typename CastFilterUShort::Pointer castFilter = CastFilterUShort::New();
-    castFilter->SetInput(infoChanger->GetOutput());
-    castFilter->Update();
-    resultImage = castFilter->GetOutput();
+    resultImage = CastResultImage<unsigned short>(infoChangerOutput, numberOfStreamDivisions);
   }
   else if (resultImagePixelType.compare("int") == 0)
   {
-    typename CastFilterInt::Pointer castFilter = CastFilterInt::New();
-    castFilter->SetInput(infoChanger->GetOutput());
-    castFilter->Update();
-    resultImage = castFilter->GetOutput();
+    resultImage = CastResultImage<int>(infoChangerOutput, numberOfStreamDivisions);
   }
   else if (resultImagePixelType.compare("unsigned int") == 0)
   {
-    typename CastFilterUInt::Pointer castFilter = CastFilterUInt::New();
-    castFilter->SetInput(infoChanger->GetOutput());
-    castFilter->Update();
-    resultImage = castFilter->GetOutput();
+    resultImage = CastResultImage<unsigned int>(infoChangerOutput, numberOfStreamDivisions);
   }
   else if (resultImagePixelType.compare("long") == 0)
   {
-    typename CastFilterLong::Pointer castFilter = CastFilterLong::New();
-    castFilter->SetInput(infoChanger->GetOutput());
-    castFilter->Update();
-    resultImage = castFilter->GetOutput();
+    resultImage = CastResultImage<long>(infoChangerOutput, numberOfStreamDivisions);
   }
   else if (resultImagePixelType.compare("unsigned long") == 0)
   {
-    typename CastFilterULong::Pointer castFilter = CastFilterULong::New();
-    castFilter->SetInput(infoChanger->GetOutput());
-    castFilter->Update();
-    resultImage = castFilter->GetOutput();
+    resultImage = CastResultImage<unsigned long>(infoChangerOutput, numberOfStreamDivisions);
   }
   else if (resultImagePixelType.compare("float") == 0)
   {
-    typename CastFilterFloat::Pointer castFilter = CastFilterFloat::New();
-    castFilter->SetInput(infoChanger->GetOutput());
-    castFilter->Update();
-    resultImage = castFilter->GetOutput();
+    resultImage = CastResultImage<float>(infoChangerOutput, numberOfStreamDivisions);
   }
   else if (resultImagePixelType.compare("double") == 0)
   {
-    typename CastFilterDouble::Pointer castFilter = CastFilterDouble::New();
-    castFilter->SetInput(infoChanger->GetOutput());
-    castFilter->Update();
-    resultImage = castFilter->GetOutput();
+    resultImage = CastResultImage<double>(infoChangerOutput, numberOfStreamDivisions);
   }
 
   if (resultImage.IsNull())
@@ -586,12 +578,77 @@ ResamplerBase<TElastix>::CreateItkResultImage(void)
   // put image in container
   this->m_Elastix->SetResultImage(resultImage);
 
-  if (progressObserver != nullptr)
+} // end CreateItkResultImage()
+
+
+/*
+ * ************************* CanComputeResultImageInSinglePass ***********************
+ */
+
+template <class TElastix>
+bool
+ResamplerBase<TElastix>::CanComputeResultImageInSinglePass(void) const
+{
+  typedef itk::AdvancedRayCastInterpolateImageFunction<InputImageType, CoordRepType> RayCastInterpolatorType;
+
+  return this->ResamplesByInterpolationOnly() && (this->GetAsITKBaseType()->GetInput() != nullptr) &&
+         (dynamic_cast<const RayCastInterpolatorType *>(this->GetAsITKBaseType()->GetInterpolator()) == nullptr) &&
+         (this->GetNumberOfResultImageStreamDivisions() <= 1);
+
+} // end CanComputeResultImageInSinglePass()
+
+
+/*
+ * ************************* GetNumberOfResultImageStreamDivisions ***********************
+ */
+
+template <class TElastix>
+unsigned int
+ResamplerBase<TElastix>::GetNumberOfResultImageStreamDivisions(void) const
+{
+  /** Read the memory budget, in megabytes. By default, the result image is not streamed. */
+  double memoryBudget = 0.0;
+  this->m_Configuration->ReadParameter(memoryBudget, "ResultImageMemoryBudget", 0, false);
+
+  /** Each voxel of a slab is in memory twice: resampled, and cast to the result
+   * pixel type, whose size is at most that of a double.
+   */
+  return Conversion::MemoryBudgetToNumberOfStreamDivisions(
+    this->GetAsITKBaseType()->GetSize(), static_cast<double>(sizeof(OutputPixelType) + sizeof(double)), memoryBudget);
+
+} // end GetNumberOfResultImageStreamDivisions()
+
+
+/*
+ * ************************* CastResultImage ***********************
+ */
+
+template <class TElastix>
+template <class TResultPixel>
+itk::DataObject::Pointer
+ResamplerBase<TElastix>::CastResultImage(OutputImageType * image, const unsigned int numberOfStreamDivisions)
+{
+  typedef itk::Image<TResultPixel, ImageDimension>                    ResultImageType;
+  typedef itk::CastImageFilter<OutputImageType, ResultImageType>      CastFilterType;
+  typedef itk::StreamingImageFilter<ResultImageType, ResultImageType> StreamerType;
+
+  typename CastFilterType::Pointer castFilter = CastFilterType::New();
+  castFilter->SetInput(image);
+
+  if (numberOfStreamDivisions <= 1)
   {
-    /** Disconnect from the resampler. */
-    progressObserver->DisconnectObserver(this->GetAsITKBaseType());
+    castFilter->Update();
+    return castFilter->GetOutput();
   }
-} // end CreateItkResultImage()
+
+  /** Request the cast image slab by slab, so that only the result image is in memory in full. */
+  typename StreamerType::Pointer streamer = StreamerType::New();
+  streamer->SetInput(castFilter->GetOutput());
+  streamer->SetNumberOfStreamDivisions(numberOfStreamDivisions);
+  streamer->Update();
+  return streamer->GetOutput();
+
+} // end CastResultImage()
 
 
 /*
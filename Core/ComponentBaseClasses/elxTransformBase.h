@@ -29,10 +29,17 @@
 #include "elxProgressCommand.h"
 
 // ITK header files:
+#include <itkDefaultStaticMeshTraits.h>
 #include <itkImage.h>
 #include <itkOptimizerParameters.h>
+#include <itkPlatformMultiThreader.h>
+#include <itkPointSet.h>
+#include <itkTransformToDisplacementFieldFilter.h>
 
-#include <memory> // For unique_ptr.
+#include <exception> // For exception_ptr.
+#include <memory>    // For unique_ptr.
+#include <string>
+#include <vector>
 
 namespace elastix
 {
@@ -55,6 +62,15 @@ namespace elastix
  *   "Compose" by composition: \f$T(x) = T_1 ( T_0(x) )\f$.\n
  *   example: <tt>(HowToCombineTransforms "Add")</tt>\n
  *   Default: "Add".
+ * \parameter DeformationFieldMemoryBudget: the approximate amount of memory, in megabytes,
+ *   that may be used for the deformation field of transformix (<tt>-def all</tt>). If the
+ *   deformation field would need more, it is generated and written in slabs along the last
+ *   dimension, each of which is generated multi-threaded. Streamed writing requires an image
+ *   format that supports it, such as uncompressed "mhd" or "nrrd"; otherwise the deformation
+ *   field is written at once. In elastix as a library, the deformation field is always
+ *   generated in full.\n
+ *   example: <tt>(DeformationFieldMemoryBudget 1024)</tt>\n
+ *   The default is 0, which means that the deformation field is generated at once.
  *
  * \transformparameter UseDirectionCosines: Controls whether to use or ignore the
  * direction cosines (world matrix, transform matrix) set in the images.
@@ -185,9 +201,16 @@ public:
   typedef typename ITKBaseType::InputPointType  InputPointType;
   typedef typename ITKBaseType::OutputPointType OutputPointType;
 
+  /** Typedef's for the point sets that are transformed by TransformPoints. */
+  typedef itk::DefaultStaticMeshTraits<unsigned char, FixedImageDimension, FixedImageDimension, CoordRepType>
+                                                                                PointSetTraitsType;
+  typedef itk::PointSet<unsigned char, FixedImageDimension, PointSetTraitsType> PointSetType;
+
   /** Typedef's for TransformPointsAllPoints. */
   typedef itk::Vector<float, FixedImageDimension>          VectorPixelType;
   typedef itk::Image<VectorPixelType, FixedImageDimension> DeformationFieldImageType;
+  typedef itk::TransformToDisplacementFieldFilter<DeformationFieldImageType, CoordRepType>
+                                                           DeformationFieldGeneratorType;
 
   /** Typedefs needed for AutomaticScalesEstimation function */
   typedef typename RegistrationType::ITKBaseType      ITKRegistrationType;
@@ -264,6 +287,26 @@ public:
   void
   ComputeSpatialJacobian(void) const;
 
+  /** Returns true when at least two of "-def all", "-jac all", "-jacmat all" and
+   * the result image are requested. These outputs are then generated together by
+   * ComputeDeformationFieldAndSpatialJacobians(), and, if that succeeded, skipped by
+   * TransformPoints(), ComputeDeterminantOfSpatialJacobian() and
+   * ComputeSpatialJacobian(). A deformation field that is streamed, because of
+   * the DeformationFieldMemoryBudget parameter, is not part of the single pass.
+   * Neither is a result image that the resampler cannot compute in a single pass.
+   */
+  bool
+  UseSinglePassForSpatialOutputs(void) const;
+
+  /** Function to compute the deformation field, the determinant of the spatial
+   * Jacobian, the full spatial Jacobian and the result image, as far as requested,
+   * in a single pass over the output grid. The transformed point and the spatial
+   * Jacobian are evaluated by a single call of the transform per voxel. Returns the
+   * result image, which is not yet written, or nullptr when it is not part of the pass.
+   */
+  typename MovingImageType::Pointer
+  ComputeDeformationFieldAndSpatialJacobians(void) const;
+
   /** Makes sure that the final parameters from the registration components
    * are copied, set, and stored.
    */
@@ -336,6 +379,59 @@ private:
   void
   TransformPointsSomePoints(const std::string & filename) const;
 
+  /** Function to transform the points of the input point set of the elastix object,
+   * and to store the result as its result point set.
+   */
+  void
+  TransformPointsInMemory(void) const;
+
+  /** Makes a temporary image with the region info of the resampler output,
+   * which can be used to convert between points and indices.
+   */
+  typename FixedImageType::Pointer
+  CreatePointConversionImage(void) const;
+
+  /** Typedefs for the multi-threaded transformation of input points. */
+  typedef itk::PlatformMultiThreader ThreaderType;
+  typedef ThreaderType::WorkUnitInfo ThreadInfoType;
+
+  /** The struct that is passed to the threads of TransformPointsMultiThreaded(). Each
+   * work unit transforms a contiguous range of the points in [st_BeginPoint, st_EndPoint).
+   * When st_OutputPoints is specified, the output points are stored there. Otherwise,
+   * the results are formatted as lines of "outputpoints.txt" into its own text buffer.
+   */
+  struct TransformPointsThreaderParameterType
+  {
+    const Self *                      st_Self;
+    const FixedImageType *            st_FixedImage;
+    const MovingImageType *           st_MovingImage;
+    const InputPointType *            st_InputPoints;
+    OutputPointType *                 st_OutputPoints;
+    bool                              st_PointsAreIndices;
+    std::size_t                       st_BeginPoint;
+    std::size_t                       st_EndPoint;
+    std::vector<std::string> *        st_TextBuffers;
+    std::vector<std::exception_ptr> * st_Exceptions;
+  };
+
+  /** Transforms the specified input points in batches, using multiple threads. The
+   * formatted results are written to the output file, unless st_OutputPoints is specified.
+   */
+  void
+  TransformPointsMultiThreaded(TransformPointsThreaderParameterType & parameters,
+                               const std::size_t                      numberOfPoints,
+                               std::ostream * const                   outputPointsFile) const;
+
+  /** The threader callback of TransformPointsMultiThreaded(). */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  TransformPointsThreaderCallback(void * arg);
+
+  /** Transforms and formats the points of one work unit. */
+  void
+  ThreadedTransformPoints(const itk::ThreadIdType                      workUnitID,
+                          const itk::ThreadIdType                      numberOfWorkUnits,
+                          const TransformPointsThreaderParameterType & parameters) const;
+
   /** Function to transform coordinates from fixed to moving image, given as VTK file. */
   void
   TransformPointsSomePointsVTK(const std::string & filename) const;
@@ -351,12 +447,49 @@ private:
   typename DeformationFieldImageType::Pointer
   GenerateDeformationFieldImage(void) const;
 
-  void WriteDeformationFieldImage(typename DeformationFieldImageType::Pointer) const;
+  /** Function to write the deformation field to a file. If the number of stream divisions is
+   * larger than one, the deformation field is requested from its pipeline, and written, slab by slab. */
+  void
+  WriteDeformationFieldImage(typename DeformationFieldImageType::Pointer deformationfield,
+                             const unsigned int                          numberOfStreamDivisions = 1) const;
+
+  /** Get the number of slabs in which the deformation field is generated and written,
+   * based on the DeformationFieldMemoryBudget parameter. */
+  unsigned int
+  GetNumberOfDeformationFieldStreamDivisions(void) const;
+
+  /** Creates the generator of the deformation field, on the output grid of the resampler. */
+  typename DeformationFieldGeneratorType::Pointer
+  CreateDeformationFieldGenerator(void) const;
+
+  /** Generates the deformation field and writes it to disk, slab by slab, without
+   * keeping the whole deformation field in memory. */
+  void
+  StreamDeformationFieldImage(const unsigned int numberOfStreamDivisions) const;
 
   /** Legacy function that calls GenerateDeformationFieldImage and WriteDeformationFieldImage. */
   void
   TransformPointsAllPoints(void) const;
 
+  /** Reads which of the outputs "-def all", "-jac all", "-jacmat all" and the result image
+   * are requested, to be generated in a single pass. A streamed deformation field is excluded,
+   * and so is a result image that the resampler cannot compute in a single pass. */
+  void
+  GetRequestedSpatialOutputs(bool & deformationField,
+                             bool & determinant,
+                             bool & spatialJacobian,
+                             bool & resultImage) const;
+
+  /** Possibly changes the direction cosines of an output image to their original value. */
+  template <class TImage>
+  typename TImage::Pointer
+  RestoreOriginalDirection(TImage & image) const;
+
+  /** Writes an output of ComputeDeformationFieldAndSpatialJacobians() to disk. */
+  template <class TImage>
+  void
+  WriteSpatialJacobianImage(TImage & image, const std::string & baseName, const bool isMatrixImage) const;
+
   std::string
   GetInitialTransformParametersFileName(void) const
   {
@@ -387,6 +520,10 @@ private:
 
   /** Boolean to decide whether or not the transform parameters are written in binary format. */
   bool m_UseBinaryFormatForTransformationParameters{};
+
+  /** Whether the last call of ComputeDeformationFieldAndSpatialJacobians() succeeded. If not,
+   * the spatial outputs are computed by their dedicated functions after all. */
+  mutable bool m_SpatialOutputsComputedInSinglePass{ false };
 };
 
 } // end namespace elastix
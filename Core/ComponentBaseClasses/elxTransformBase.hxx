@@ -27,11 +27,13 @@
 #include "itkPointSet.h"
 #include "itkDefaultStaticMeshTraits.h"
 #include "itkTransformixInputPointFileReader.h"
+#include "itkTransformixBinaryPointFile.h"
 #include <itksys/SystemTools.hxx>
 #include "itkVector.h"
 #include "itkTransformToDisplacementFieldFilter.h"
 #include "itkTransformToDeterminantOfSpatialJacobianSource.h"
 #include "itkTransformToSpatialJacobianSource.h"
+#include "itkTransformToDisplacementAndSpatialJacobianSource.h"
 #include "itkImageFileWriter.h"
 #include "itkImageGridSampler.h"
 #include "itkContinuousIndex.h"
@@ -42,7 +44,9 @@
 #include "itkTransformMeshFilter.h"
 #include "itkCommonEnums.h"
 
+#include <algorithm> // For min.
 #include <cassert>
+#include <cmath> // For ceil.
 #include <fstream>
 #include <iomanip> // For setprecision.
 
@@ -704,6 +708,17 @@ TransformBase<TElastix>::TransformPoints(void) const
     def = ipp;
   }
 
+  /** If there is an input point set, given by the user of the elastix library? */
+  if (this->m_Elastix->GetInputPointSet() != nullptr)
+  {
+    elxout << "  The transform is evaluated on the points of the input point set." << std::endl;
+    this->TransformPointsInMemory();
+    if (def == "")
+    {
+      return;
+    }
+  }
+
   /** If there is an input point-file? */
   if (def != "" && def != "all")
   {
@@ -721,6 +736,11 @@ TransformBase<TElastix>::TransformPoints(void) const
       this->TransformPointsSomePoints(def);
     }
   }
+  else if (def == "all" && this->UseSinglePassForSpatialOutputs() && this->m_SpatialOutputsComputedInSinglePass &&
+           this->GetNumberOfDeformationFieldStreamDivisions() <= 1)
+  {
+    elxout << "  The deformation field is computed together with the other spatial outputs." << std::endl;
+  }
   else if (def == "all")
   {
     elxout << "  The transform is evaluated on all points. "
@@ -755,20 +775,7 @@ void
 TransformBase<TElastix>::TransformPointsSomePoints(const std::string & filename) const
 {
   /** Typedef's. */
-  typedef typename FixedImageType::RegionType                FixedImageRegionType;
-  typedef typename FixedImageType::IndexType                 FixedImageIndexType;
-  typedef typename FixedImageIndexType::IndexValueType       FixedImageIndexValueType;
-  typedef typename MovingImageType::IndexType                MovingImageIndexType;
-  typedef typename MovingImageIndexType::IndexValueType      MovingImageIndexValueType;
-  typedef itk::ContinuousIndex<double, FixedImageDimension>  FixedImageContinuousIndexType;
-  typedef itk::ContinuousIndex<double, MovingImageDimension> MovingImageContinuousIndexType;
-
-  typedef unsigned char DummyIPPPixelType;
-  typedef itk::DefaultStaticMeshTraits<DummyIPPPixelType, FixedImageDimension, FixedImageDimension, CoordRepType>
-                                                                                MeshTraitsType;
-  typedef itk::PointSet<DummyIPPPixelType, FixedImageDimension, MeshTraitsType> PointSetType;
-  typedef itk::TransformixInputPointFileReader<PointSetType>                    IPPReaderType;
-  typedef itk::Vector<float, FixedImageDimension>                               DeformationVectorType;
+  typedef itk::TransformixInputPointFileReader<PointSetType> IPPReaderType;
 
   /** Construct an ipp-file reader. */
   const auto ippReader = IPPReaderType::New();
@@ -795,172 +802,402 @@ TransformBase<TElastix>::TransformPointsSomePoints(const std::string & filename)
   {
     elxout << "  Input points are specified in world coordinates." << std::endl;
   }
-  unsigned int nrofpoints = ippReader->GetNumberOfPoints();
-  elxout << "  Number of specified input points: " << nrofpoints << std::endl;
+  elxout << "  Number of specified input points: " << ippReader->GetNumberOfPoints() << std::endl;
 
-  /** Get the set of input points. */
+  /** Get the set of input points. Only the points that are actually read are
+   * transformed, which are fewer than specified when reading failed. */
   typename PointSetType::Pointer inputPointSet = ippReader->GetOutput();
-
-  /** Create the storage classes. */
-  std::vector<FixedImageIndexType>   inputindexvec(nrofpoints);
-  std::vector<InputPointType>        inputpointvec(nrofpoints);
-  std::vector<OutputPointType>       outputpointvec(nrofpoints);
-  std::vector<FixedImageIndexType>   outputindexfixedvec(nrofpoints);
-  std::vector<MovingImageIndexType>  outputindexmovingvec(nrofpoints);
-  std::vector<DeformationVectorType> deformationvec(nrofpoints);
+  const std::size_t              nrofpoints = inputPointSet->GetNumberOfPoints();
 
   /** Make a temporary image with the right region info,
-   * which we can use to convert between points and indices.
-   * By taking the image from the resampler output, the UseDirectionCosines
+   * which we can use to convert between points and indices. */
+  const auto dummyImage = this->CreatePointConversionImage();
+
+  TransformPointsThreaderParameterType parameters;
+  parameters.st_Self = this;
+  parameters.st_FixedImage = dummyImage.GetPointer();
+  parameters.st_MovingImage = this->GetElastix()->GetMovingImage();
+  parameters.st_InputPoints =
+    (nrofpoints > 0) ? inputPointSet->GetPoints()->CastToSTLConstContainer().data() : nullptr;
+  parameters.st_OutputPoints = nullptr;
+  parameters.st_PointsAreIndices = ippReader->GetPointsAreIndices();
+
+  /** The points of a binary input point file are transformed into a binary output
+   * point file, which contains only the output points, in world coordinates. */
+  if (ippReader->GetFileIsBinary())
+  {
+    std::string outputPointsFileName = this->m_Configuration->GetCommandLineArgument("-out");
+    outputPointsFileName += "outputpoints.bin";
+    std::ofstream outputPointsFile(outputPointsFileName, std::ios::binary);
+    elxout << "  The transformed points are saved in: " << outputPointsFileName << std::endl;
+
+    std::vector<OutputPointType> outputPoints(nrofpoints);
+    parameters.st_OutputPoints = outputPoints.data();
+
+    elxout << "  The input points are transformed." << std::endl;
+    this->TransformPointsMultiThreaded(parameters, nrofpoints, nullptr);
+
+    itk::TransformixBinaryPointFile::WriteHeader(
+      outputPointsFile, itk::TransformixBinaryPointFile::CreateHeader(FixedImageDimension, nrofpoints, false));
+    itk::TransformixBinaryPointFile::WritePoints(outputPointsFile, outputPoints.data(), nrofpoints);
+    return;
+  }
+
+  /** Create filename and file stream. */
+  std::string outputPointsFileName = this->m_Configuration->GetCommandLineArgument("-out");
+  outputPointsFileName += "outputpoints.txt";
+  std::ofstream outputPointsFile(outputPointsFileName);
+  elxout << "  The transformed points are saved in: " << outputPointsFileName << std::endl;
+
+  /** Apply the transform. */
+  elxout << "  The input points are transformed." << std::endl;
+  this->TransformPointsMultiThreaded(parameters, nrofpoints, &outputPointsFile);
+
+} // end TransformPointsSomePoints()
+
+
+/**
+ * ************** TransformPointsInMemory *********************
+ *
+ * This function transforms the points of the input point set,
+ * which are specified in world coordinates, and stores the
+ * transformed points as the result point set.
+ */
+
+template <class TElastix>
+void
+TransformBase<TElastix>::TransformPointsInMemory(void) const
+{
+  const auto * const inputPointSet = dynamic_cast<const PointSetType *>(this->m_Elastix->GetInputPointSet());
+  if (inputPointSet == nullptr)
+  {
+    itkExceptionMacro(<< "ERROR: The input point set should be an itk::PointSet of dimension " << FixedImageDimension
+                      << ", with double precision coordinates and the default static mesh traits.");
+  }
+
+  /** The output points are stored directly in the container of the result point set. */
+  const auto outputPoints = PointSetType::PointsContainer::New();
+  const auto inputPoints = inputPointSet->GetPoints();
+  if (inputPoints != nullptr)
+  {
+    outputPoints->CastToSTLContainer().resize(inputPoints->Size());
+  }
+  const std::size_t nrofpoints = outputPoints->Size();
+  elxout << "  Number of specified input points: " << nrofpoints << std::endl;
+
+  const auto dummyImage = this->CreatePointConversionImage();
+
+  TransformPointsThreaderParameterType parameters;
+  parameters.st_Self = this;
+  parameters.st_FixedImage = dummyImage.GetPointer();
+  parameters.st_MovingImage = this->GetElastix()->GetMovingImage();
+  parameters.st_InputPoints = (nrofpoints > 0) ? inputPoints->CastToSTLConstContainer().data() : nullptr;
+  parameters.st_OutputPoints = outputPoints->CastToSTLContainer().data();
+  parameters.st_PointsAreIndices = false;
+
+  this->TransformPointsMultiThreaded(parameters, nrofpoints, nullptr);
+
+  const auto resultPointSet = PointSetType::New();
+  resultPointSet->SetPoints(outputPoints);
+  this->m_Elastix->SetResultPointSet(resultPointSet);
+
+} // end TransformPointsInMemory()
+
+
+/**
+ * ************** CreatePointConversionImage *********************
+ */
+
+template <class TElastix>
+typename TransformBase<TElastix>::FixedImageType::Pointer
+TransformBase<TElastix>::CreatePointConversionImage(void) const
+{
+  /** By taking the image from the resampler output, the UseDirectionCosines
    * parameter is automatically taken into account. */
-  FixedImageRegionType region;
-  const auto           origin = this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputOrigin();
-  const auto           spacing = this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputSpacing();
-  const auto           direction = this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputDirection();
-  region.SetIndex(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputStartIndex());
-  region.SetSize(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetSize());
+  const auto & resampler = *this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType();
+
+  typename FixedImageType::RegionType region;
+  region.SetIndex(resampler.GetOutputStartIndex());
+  region.SetSize(resampler.GetSize());
 
   const auto dummyImage = FixedImageType::New();
   dummyImage->SetRegions(region);
-  dummyImage->SetOrigin(origin);
-  dummyImage->SetSpacing(spacing);
-  dummyImage->SetDirection(direction);
+  dummyImage->SetOrigin(resampler.GetOutputOrigin());
+  dummyImage->SetSpacing(resampler.GetOutputSpacing());
+  dummyImage->SetDirection(resampler.GetOutputDirection());
+  return dummyImage;
 
-  /** Temp vars */
-  FixedImageContinuousIndexType  fixedcindex;
-  MovingImageContinuousIndexType movingcindex;
+} // end CreatePointConversionImage()
 
-  /** Also output moving image indices if a moving image was supplied. */
-  bool                              alsoMovingIndices = false;
-  typename MovingImageType::Pointer movingImage = this->GetElastix()->GetMovingImage();
-  if (movingImage.IsNotNull())
-  {
-    alsoMovingIndices = true;
-  }
 
-  /** Read the input points, as index or as point. */
-  if (!(ippReader->GetPointsAreIndices()))
+/**
+ * ************** TransformPointsMultiThreaded *********************
+ */
+
+template <class TElastix>
+void
+TransformBase<TElastix>::TransformPointsMultiThreaded(TransformPointsThreaderParameterType & parameters,
+                                                      const std::size_t                      numberOfPoints,
+                                                      std::ostream * const                   outputPointsFile) const
+{
+  /** The points are transformed in batches, using multiple threads. Within a batch,
+   * each work unit transforms a contiguous range of points and formats the results
+   * into its own text buffer. The buffers are then written in order, so that the
+   * output file does not depend on the number of threads. The batches bound the
+   * amount of memory used by the text buffers.
+   */
+  const std::size_t minimumNumberOfPointsPerWorkUnit = 1024;
+  const std::size_t numberOfPointsPerBatch = 64 * minimumNumberOfPointsPerWorkUnit;
+
+  const auto threader = ThreaderType::New();
+  const auto maximumNumberOfWorkUnits = threader->GetNumberOfWorkUnits();
+
+  std::vector<std::string>        textBuffers(maximumNumberOfWorkUnits);
+  std::vector<std::exception_ptr> exceptions(maximumNumberOfWorkUnits);
+
+  parameters.st_TextBuffers = &textBuffers;
+  parameters.st_Exceptions = &exceptions;
+
+  for (std::size_t beginPoint = 0; beginPoint < numberOfPoints; beginPoint += numberOfPointsPerBatch)
   {
-    for (unsigned int j = 0; j < nrofpoints; j++)
+    parameters.st_BeginPoint = beginPoint;
+    parameters.st_EndPoint = std::min<std::size_t>(beginPoint + numberOfPointsPerBatch, numberOfPoints);
+
+    /** Do not start more work units than are useful for the number of points. */
+    const std::size_t numberOfPointsInBatch = parameters.st_EndPoint - parameters.st_BeginPoint;
+    const auto        numberOfWorkUnits = static_cast<itk::ThreadIdType>(std::min<std::size_t>(
+      maximumNumberOfWorkUnits,
+      (numberOfPointsInBatch + minimumNumberOfPointsPerWorkUnit - 1) / minimumNumberOfPointsPerWorkUnit));
+
+    threader->SetNumberOfWorkUnits(numberOfWorkUnits);
+    threader->SetSingleMethod(TransformPointsThreaderCallback, &parameters);
+    threader->SingleMethodExecute();
+
+    /** Pass an exception from any of the work units to a higher level. */
+    for (const auto & exception : exceptions)
     {
-      /** Compute index of nearest voxel in fixed image. */
-      InputPointType point;
-      point.Fill(0.0f);
-      inputPointSet->GetPoint(j, &point);
-      inputpointvec[j] = point;
-      dummyImage->TransformPhysicalPointToContinuousIndex(point, fixedcindex);
-      for (unsigned int i = 0; i < FixedImageDimension; i++)
+      if (exception)
       {
-        inputindexvec[j][i] = static_cast<FixedImageIndexValueType>(itk::Math::Round<double>(fixedcindex[i]));
+        std::rethrow_exception(exception);
       }
     }
-  }
-  else // so: inputasindex
-  {
-    for (unsigned int j = 0; j < nrofpoints; j++)
+
+    /** Print the results. */
+    if (outputPointsFile != nullptr)
     {
-      /** The read point from the inutPointSet is actually an index
-       * Cast to the proper type.
-       */
-      InputPointType point;
-      point.Fill(0.0f);
-      inputPointSet->GetPoint(j, &point);
-      for (unsigned int i = 0; i < FixedImageDimension; i++)
+      for (itk::ThreadIdType i = 0; i < threader->GetNumberOfWorkUnits(); ++i)
       {
-        inputindexvec[j][i] = static_cast<FixedImageIndexValueType>(itk::Math::Round<double>(point[i]));
+        outputPointsFile->write(textBuffers[i].data(), static_cast<std::streamsize>(textBuffers[i].size()));
       }
-      /** Compute the input point in physical coordinates. */
-      dummyImage->TransformIndexToPhysicalPoint(inputindexvec[j], inputpointvec[j]);
     }
   }
 
-  /** Apply the transform. */
-  elxout << "  The input points are transformed." << std::endl;
-  for (unsigned int j = 0; j < nrofpoints; j++)
+} // end TransformPointsMultiThreaded()
+
+
+/**
+ * ************** TransformPointsThreaderCallback *********************
+ */
+
+template <class TElastix>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+TransformBase<TElastix>::TransformPointsThreaderCallback(void * arg)
+{
+  /** Get the current thread id and user data. */
+  const auto * const infoStruct = static_cast<ThreadInfoType *>(arg);
+  const auto &       parameters = *static_cast<TransformPointsThreaderParameterType *>(infoStruct->UserData);
+
+  /** Call the real implementation. Exceptions may not leave the thread. */
+  try
+  {
+    parameters.st_Self->ThreadedTransformPoints(infoStruct->WorkUnitID, infoStruct->NumberOfWorkUnits, parameters);
+  }
+  catch (...)
   {
-    /** Call TransformPoint. */
-    outputpointvec[j] = this->GetAsITKBaseType()->TransformPoint(inputpointvec[j]);
+    (*parameters.st_Exceptions)[infoStruct->WorkUnitID] = std::current_exception();
+  }
 
-    /** Transform back to index in fixed image domain. */
-    dummyImage->TransformPhysicalPointToContinuousIndex(outputpointvec[j], fixedcindex);
-    for (unsigned int i = 0; i < FixedImageDimension; i++)
-    {
-      outputindexfixedvec[j][i] = static_cast<FixedImageIndexValueType>(itk::Math::Round<double>(fixedcindex[i]));
-    }
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end TransformPointsThreaderCallback()
+
+
+/**
+ * ************** ThreadedTransformPoints *********************
+ *
+ * Transforms the points of one work unit, converts them to indices
+ * in the fixed and moving image, and formats the results.
+ */
 
-    if (alsoMovingIndices)
+template <class TElastix>
+void
+TransformBase<TElastix>::ThreadedTransformPoints(const itk::ThreadIdType                      workUnitID,
+                                                 const itk::ThreadIdType                      numberOfWorkUnits,
+                                                 const TransformPointsThreaderParameterType & parameters) const
+{
+  /** Typedef's. */
+  typedef typename FixedImageType::IndexType                 FixedImageIndexType;
+  typedef typename FixedImageIndexType::IndexValueType       FixedImageIndexValueType;
+  typedef typename MovingImageType::IndexType                MovingImageIndexType;
+  typedef typename MovingImageIndexType::IndexValueType      MovingImageIndexValueType;
+  typedef itk::ContinuousIndex<double, FixedImageDimension>  FixedImageContinuousIndexType;
+  typedef itk::ContinuousIndex<double, MovingImageDimension> MovingImageContinuousIndexType;
+
+  /** Compute the range of points for this work unit. */
+  const std::size_t numberOfPoints = parameters.st_EndPoint - parameters.st_BeginPoint;
+  const std::size_t beginPoint = parameters.st_BeginPoint + (numberOfPoints * workUnitID) / numberOfWorkUnits;
+  const std::size_t endPoint = parameters.st_BeginPoint + (numberOfPoints * (workUnitID + 1)) / numberOfWorkUnits;
+
+  const FixedImageType &  fixedImage = *parameters.st_FixedImage;
+  const MovingImageType * movingImage = parameters.st_MovingImage;
+  const ITKBaseType &     transform = *this->GetAsITKBaseType();
+
+  /** The scratch state of this work unit. The text buffer keeps its capacity between batches. */
+  std::string & text = (*parameters.st_TextBuffers)[workUnitID];
+  text.clear();
+
+  /** Get the input points of this work unit in physical coordinates. */
+  const std::size_t           numberOfWorkUnitPoints = endPoint - beginPoint;
+  const InputPointType *      inputPoints = parameters.st_InputPoints + beginPoint;
+  std::vector<InputPointType> convertedInputPoints;
+  FixedImageIndexType         inputIndex;
+  if (parameters.st_PointsAreIndices)
+  {
+    /** The read points are actually indices. Compute the input points in physical coordinates. */
+    convertedInputPoints.resize(numberOfWorkUnitPoints);
+    for (std::size_t k = 0; k < numberOfWorkUnitPoints; ++k)
     {
-      /** Transform back to index in moving image domain. */
-      movingImage->TransformPhysicalPointToContinuousIndex(outputpointvec[j], movingcindex);
-      for (unsigned int i = 0; i < MovingImageDimension; i++)
+      for (unsigned int i = 0; i < FixedImageDimension; ++i)
       {
-        outputindexmovingvec[j][i] = static_cast<MovingImageIndexValueType>(itk::Math::Round<double>(movingcindex[i]));
+        inputIndex[i] = static_cast<FixedImageIndexValueType>(itk::Math::Round<double>(inputPoints[k][i]));
       }
+      fixedImage.TransformIndexToPhysicalPoint(inputIndex, convertedInputPoints[k]);
     }
+    inputPoints = convertedInputPoints.data();
+  }
+
+  /** Transform all points of this work unit with one call, directly into st_OutputPoints, if specified. */
+  std::vector<OutputPointType> workUnitOutputPoints;
+  OutputPointType *            outputPoints = nullptr;
+  if (parameters.st_OutputPoints != nullptr)
+  {
+    outputPoints = parameters.st_OutputPoints + beginPoint;
+  }
+  else
+  {
+    workUnitOutputPoints.resize(numberOfWorkUnitPoints);
+    outputPoints = workUnitOutputPoints.data();
+  }
+  transform.TransformPoints(inputPoints, outputPoints, numberOfWorkUnitPoints);
 
-    /** Compute displacement. */
-    deformationvec[j].CastFrom(outputpointvec[j] - inputpointvec[j]);
+  /** Only store the output points, when no text output is requested. */
+  if (parameters.st_OutputPoints != nullptr)
+  {
+    return;
   }
 
-  /** Create filename and file stream. */
-  std::string outputPointsFileName = this->m_Configuration->GetCommandLineArgument("-out");
-  outputPointsFileName += "outputpoints.txt";
-  std::ofstream outputPointsFile(outputPointsFileName);
-  outputPointsFile << std::showpoint << std::fixed;
-  elxout << "  The transformed points are saved in: " << outputPointsFileName << std::endl;
+  FixedImageIndexType            outputIndexFixed;
+  MovingImageIndexType           outputIndexMoving;
+  FixedImageContinuousIndexType  fixedcindex;
+  MovingImageContinuousIndexType movingcindex;
 
-  /** Print the results. */
-  for (unsigned int j = 0; j < nrofpoints; j++)
+  for (std::size_t k = 0; k < numberOfWorkUnitPoints; ++k)
   {
+    const std::size_t       j = beginPoint + k;
+    const InputPointType &  inputPoint = inputPoints[k];
+    const OutputPointType & outputPoint = outputPoints[k];
+
+    if (parameters.st_PointsAreIndices)
+    {
+      /** The read point is actually an index. Cast to the proper type. */
+      for (unsigned int i = 0; i < FixedImageDimension; ++i)
+      {
+        inputIndex[i] =
+          static_cast<FixedImageIndexValueType>(itk::Math::Round<double>(parameters.st_InputPoints[j][i]));
+      }
+    }
+    else
+    {
+      /** Compute index of nearest voxel in fixed image. */
+      fixedImage.TransformPhysicalPointToContinuousIndex(inputPoint, fixedcindex);
+      for (unsigned int i = 0; i < FixedImageDimension; ++i)
+      {
+        inputIndex[i] = static_cast<FixedImageIndexValueType>(itk::Math::Round<double>(fixedcindex[i]));
+      }
+    }
+
+    /** Transform back to index in fixed image domain. */
+    fixedImage.TransformPhysicalPointToContinuousIndex(outputPoint, fixedcindex);
+    for (unsigned int i = 0; i < FixedImageDimension; ++i)
+    {
+      outputIndexFixed[i] = static_cast<FixedImageIndexValueType>(itk::Math::Round<double>(fixedcindex[i]));
+    }
+
     /** The input index. */
-    outputPointsFile << "Point\t" << j << "\t; InputIndex = [ ";
-    for (unsigned int i = 0; i < FixedImageDimension; i++)
+    text += "Point\t";
+    Conversion::AppendIntegerToString(text, static_cast<long long>(j));
+    text += "\t; InputIndex = [ ";
+    for (unsigned int i = 0; i < FixedImageDimension; ++i)
     {
-      outputPointsFile << inputindexvec[j][i] << " ";
+      Conversion::AppendIntegerToString(text, inputIndex[i]);
+      text += ' ';
     }
 
     /** The input point. */
-    outputPointsFile << "]\t; InputPoint = [ ";
-    for (unsigned int i = 0; i < FixedImageDimension; i++)
+    text += "]\t; InputPoint = [ ";
+    for (unsigned int i = 0; i < FixedImageDimension; ++i)
     {
-      outputPointsFile << inputpointvec[j][i] << " ";
+      Conversion::AppendFixedPointToString(text, inputPoint[i]);
+      text += ' ';
     }
 
     /** The output index in fixed image. */
-    outputPointsFile << "]\t; OutputIndexFixed = [ ";
-    for (unsigned int i = 0; i < FixedImageDimension; i++)
+    text += "]\t; OutputIndexFixed = [ ";
+    for (unsigned int i = 0; i < FixedImageDimension; ++i)
     {
-      outputPointsFile << outputindexfixedvec[j][i] << " ";
+      Conversion::AppendIntegerToString(text, outputIndexFixed[i]);
+      text += ' ';
     }
 
     /** The output point. */
-    outputPointsFile << "]\t; OutputPoint = [ ";
-    for (unsigned int i = 0; i < FixedImageDimension; i++)
+    text += "]\t; OutputPoint = [ ";
+    for (unsigned int i = 0; i < FixedImageDimension; ++i)
     {
-      outputPointsFile << outputpointvec[j][i] << " ";
+      Conversion::AppendFixedPointToString(text, outputPoint[i]);
+      text += ' ';
     }
 
-    /** The output point minus the input point. */
-    outputPointsFile << "]\t; Deformation = [ ";
-    for (unsigned int i = 0; i < MovingImageDimension; i++)
+    /** The output point minus the input point, as single precision. */
+    text += "]\t; Deformation = [ ";
+    for (unsigned int i = 0; i < MovingImageDimension; ++i)
     {
-      outputPointsFile << deformationvec[j][i] << " ";
+      Conversion::AppendFixedPointToString(text, static_cast<float>(outputPoint[i] - inputPoint[i]));
+      text += ' ';
     }
 
-    if (alsoMovingIndices)
+    /** Also output moving image indices if a moving image was supplied. */
+    if (movingImage != nullptr)
     {
+      /** Transform back to index in moving image domain. */
+      movingImage->TransformPhysicalPointToContinuousIndex(outputPoint, movingcindex);
+      for (unsigned int i = 0; i < MovingImageDimension; ++i)
+      {
+        outputIndexMoving[i] = static_cast<MovingImageIndexValueType>(itk::Math::Round<double>(movingcindex[i]));
+      }
+
       /** The output index in moving image. */
-      outputPointsFile << "]\t; OutputIndexMoving = [ ";
-      for (unsigned int i = 0; i < MovingImageDimension; i++)
+      text += "]\t; OutputIndexMoving = [ ";
+      for (unsigned int i = 0; i < MovingImageDimension; ++i)
       {
-        outputPointsFile << outputindexmovingvec[j][i] << " ";
+        Conversion::AppendIntegerToString(text, outputIndexMoving[i]);
+        text += ' ';
       }
     }
 
-    outputPointsFile << "]" << std::endl;
-  } // end for nrofpoints
+    text += "]\n";
+  }
 
-} // end TransformPointsSomePoints()
+} // end ThreadedTransformPoints()
 
 
 /**
@@ -1003,7 +1240,7 @@ TransformBase<TElastix>::TransformPointsSomePointsVTK(const std::string & filena
 
   /** Some user-feedback. */
   elxout << "  Input points are specified in world coordinates." << std::endl;
-  unsigned long nrofpoints = meshReader->GetOutput()->GetNumberOfPoints();
+  const std::size_t nrofpoints = meshReader->GetOutput()->GetNumberOfPoints();
   elxout << "  Number of specified input points: " << nrofpoints << std::endl;
 
   /** Apply the transform. */
@@ -1054,6 +1291,15 @@ template <class TElastix>
 void
 TransformBase<TElastix>::TransformPointsAllPoints(void) const
 {
+  /** When a memory budget is specified, the deformation field is generated
+   * and written slab by slab, and it is not kept in memory. */
+  const unsigned int numberOfStreamDivisions = this->GetNumberOfDeformationFieldStreamDivisions();
+  if (numberOfStreamDivisions > 1)
+  {
+    this->StreamDeformationFieldImage(numberOfStreamDivisions);
+    return;
+  }
+
   typename DeformationFieldImageType::Pointer deformationfield = this->GenerateDeformationFieldImage();
   // put deformation field in container
   this->m_Elastix->SetResultDeformationField(deformationfield.GetPointer());
@@ -1079,19 +1325,11 @@ typename TransformBase<TElastix>::DeformationFieldImageType::Pointer
 TransformBase<TElastix>::GenerateDeformationFieldImage(void) const
 {
   /** Typedef's. */
-  typedef typename FixedImageType::DirectionType FixedImageDirectionType;
-  typedef itk::TransformToDisplacementFieldFilter<DeformationFieldImageType, CoordRepType>
-                                                                       DeformationFieldGeneratorType;
+  typedef typename FixedImageType::DirectionType                       FixedImageDirectionType;
   typedef itk::ChangeInformationImageFilter<DeformationFieldImageType> ChangeInfoFilterType;
 
   /** Create an setup deformation field generator. */
-  const auto defGenerator = DeformationFieldGeneratorType::New();
-  defGenerator->SetSize(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetSize());
-  defGenerator->SetOutputSpacing(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputSpacing());
-  defGenerator->SetOutputOrigin(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputOrigin());
-  defGenerator->SetOutputStartIndex(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputStartIndex());
-  defGenerator->SetOutputDirection(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputDirection());
-  defGenerator->SetTransform(const_cast<const ITKBaseType *>(this->GetAsITKBaseType()));
+  const auto defGenerator = this->CreateDeformationFieldGenerator();
 
   /** Possibly change direction cosines to their original value, as specified
    * in the tp-file, or by the fixed image. This is only necessary when
@@ -1127,6 +1365,86 @@ TransformBase<TElastix>::GenerateDeformationFieldImage(void) const
 } // end GenerateDeformationFieldImage()
 
 
+/**
+ * ************** CreateDeformationFieldGenerator **********************
+ */
+
+template <class TElastix>
+typename TransformBase<TElastix>::DeformationFieldGeneratorType::Pointer
+TransformBase<TElastix>::CreateDeformationFieldGenerator(void) const
+{
+  const auto & resampler = *this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType();
+
+  const auto defGenerator = DeformationFieldGeneratorType::New();
+  defGenerator->SetSize(resampler.GetSize());
+  defGenerator->SetOutputSpacing(resampler.GetOutputSpacing());
+  defGenerator->SetOutputOrigin(resampler.GetOutputOrigin());
+  defGenerator->SetOutputStartIndex(resampler.GetOutputStartIndex());
+  defGenerator->SetOutputDirection(resampler.GetOutputDirection());
+  defGenerator->SetTransform(const_cast<const ITKBaseType *>(this->GetAsITKBaseType()));
+  return defGenerator;
+
+} // end CreateDeformationFieldGenerator()
+
+
+/**
+ * ************** StreamDeformationFieldImage **********************
+ *
+ * The deformation field generator and the writer are connected into
+ * a pipeline. The writer requests, and writes, one slab at a time.
+ */
+
+template <class TElastix>
+void
+TransformBase<TElastix>::StreamDeformationFieldImage(const unsigned int numberOfStreamDivisions) const
+{
+  /** Typedef's. */
+  typedef typename FixedImageType::DirectionType                       FixedImageDirectionType;
+  typedef itk::ChangeInformationImageFilter<DeformationFieldImageType> ChangeInfoFilterType;
+
+  const auto defGenerator = this->CreateDeformationFieldGenerator();
+
+  /** Possibly change direction cosines to their original value. The filter
+   * only changes the meta data, so it passes the requested slabs through. */
+  const auto              infoChanger = ChangeInfoFilterType::New();
+  FixedImageDirectionType originalDirection;
+  bool                    retdc = this->GetElastix()->GetOriginalFixedImageDirection(originalDirection);
+  infoChanger->SetOutputDirection(originalDirection);
+  infoChanger->SetChangeDirection(retdc & !this->GetElastix()->GetUseDirectionCosines());
+  infoChanger->SetInput(defGenerator->GetOutput());
+
+  elxout << "  The deformation field is generated and written in " << numberOfStreamDivisions << " slabs."
+         << std::endl;
+  this->WriteDeformationFieldImage(infoChanger->GetOutput(), numberOfStreamDivisions);
+
+} // end StreamDeformationFieldImage()
+
+
+/**
+ * ************** GetNumberOfDeformationFieldStreamDivisions **********************
+ */
+
+template <class TElastix>
+unsigned int
+TransformBase<TElastix>::GetNumberOfDeformationFieldStreamDivisions(void) const
+{
+  /** In elastix as a library, the deformation field is returned to the user, in full. */
+  if (BaseComponent::IsElastixLibrary())
+  {
+    return 1;
+  }
+
+  /** Read the memory budget, in megabytes. By default, the deformation field is not streamed. */
+  double memoryBudget = 0.0;
+  this->m_Configuration->ReadParameter(memoryBudget, "DeformationFieldMemoryBudget", 0, false);
+  return Conversion::MemoryBudgetToNumberOfStreamDivisions(
+    this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetSize(),
+    static_cast<double>(sizeof(VectorPixelType)),
+    memoryBudget);
+
+} // end GetNumberOfDeformationFieldStreamDivisions()
+
+
 /**
  * ************** WriteDeformationFieldImage **********************
  */
@@ -1134,7 +1452,8 @@ TransformBase<TElastix>::GenerateDeformationFieldImage(void) const
 template <class TElastix>
 void
 TransformBase<TElastix>::WriteDeformationFieldImage(
-  typename TransformBase<TElastix>::DeformationFieldImageType::Pointer deformationfield) const
+  typename TransformBase<TElastix>::DeformationFieldImageType::Pointer deformationfield,
+  const unsigned int                                                   numberOfStreamDivisions) const
 {
   typedef itk::ImageFileWriter<DeformationFieldImageType> DeformationFieldWriterType;
 
@@ -1148,6 +1467,12 @@ TransformBase<TElastix>::WriteDeformationFieldImage(
   const auto defWriter = DeformationFieldWriterType::New();
   defWriter->SetInput(deformationfield);
   defWriter->SetFileName(makeFileName.str().c_str());
+  defWriter->SetNumberOfStreamDivisions(numberOfStreamDivisions);
+
+  /** When streamed, the deformation field is generated while it is written. */
+  const auto progressObserver = (numberOfStreamDivisions <= 1 || BaseComponent::IsElastixLibrary())
+                                  ? nullptr
+                                  : ProgressCommandType::CreateAndConnect(*defWriter);
 
   /** Do the writing. */
   elxout << "  Computing and writing the deformation field ..." << std::endl;
@@ -1194,6 +1519,11 @@ TransformBase<TElastix>::ComputeDeterminantOfSpatialJacobian(void) const
            << "    Therefore det(dT/dx) is not computed." << std::endl;
     return;
   }
+  else if (this->UseSinglePassForSpatialOutputs() && this->m_SpatialOutputsComputedInSinglePass)
+  {
+    elxout << "  det(dT/dx) is computed together with the other spatial outputs." << std::endl;
+    return;
+  }
 
   /** Typedef's. */
   typedef itk::Image<float, FixedImageDimension>                                              JacobianImageType;
@@ -1277,6 +1607,11 @@ TransformBase<TElastix>::ComputeSpatialJacobian(void) const
            << "so no dT/dx computed." << std::endl;
     return;
   }
+  else if (this->UseSinglePassForSpatialOutputs() && this->m_SpatialOutputsComputedInSinglePass)
+  {
+    elxout << "  dT/dx is computed together with the other spatial outputs." << std::endl;
+    return;
+  }
 
   /** Typedef's. */
   typedef float SpatialJacobianComponentType;
@@ -1352,6 +1687,242 @@ TransformBase<TElastix>::ComputeSpatialJacobian(void) const
 } // end ComputeSpatialJacobian()
 
 
+/**
+ * ************** GetRequestedSpatialOutputs **********************
+ */
+
+template <class TElastix>
+void
+TransformBase<TElastix>::GetRequestedSpatialOutputs(bool & deformationField,
+                                                    bool & determinant,
+                                                    bool & spatialJacobian,
+                                                    bool & resultImage) const
+{
+  /** "-ipp" is the deprecated form of "-def". Using both is an error, reported by TransformPoints(). */
+  const std::string ipp = this->GetConfiguration()->GetCommandLineArgument("-ipp");
+  const std::string def = this->GetConfiguration()->GetCommandLineArgument("-def");
+
+  deformationField = (def == "all" && ipp == "") || (def == "" && ipp == "all");
+
+  /** A streamed deformation field is generated by its own pipeline, in TransformPoints(). */
+  deformationField = deformationField && (this->GetNumberOfDeformationFieldStreamDivisions() <= 1);
+  determinant = this->GetConfiguration()->GetCommandLineArgument("-jac") == "all";
+  spatialJacobian = this->GetConfiguration()->GetCommandLineArgument("-jacmat") == "all";
+
+  /** The result image is resampled from the moving image, if there is one. */
+  resultImage = this->m_Elastix->GetElxResamplerBase()->CanComputeResultImageInSinglePass();
+
+} // end GetRequestedSpatialOutputs()
+
+
+/**
+ * ************** UseSinglePassForSpatialOutputs **********************
+ */
+
+template <class TElastix>
+bool
+TransformBase<TElastix>::UseSinglePassForSpatialOutputs(void) const
+{
+  bool deformationField, determinant, spatialJacobian, resultImage;
+  this->GetRequestedSpatialOutputs(deformationField, determinant, spatialJacobian, resultImage);
+
+  /** A single output is computed by its own dedicated function. */
+  return (int(deformationField) + int(determinant) + int(spatialJacobian) + int(resultImage)) >= 2;
+
+} // end UseSinglePassForSpatialOutputs()
+
+
+/**
+ * ************** ComputeDeformationFieldAndSpatialJacobians **********************
+ */
+
+template <class TElastix>
+typename TransformBase<TElastix>::MovingImageType::Pointer
+TransformBase<TElastix>::ComputeDeformationFieldAndSpatialJacobians(void) const
+{
+  this->m_SpatialOutputsComputedInSinglePass = false;
+
+  bool deformationField, determinant, spatialJacobian, resultImage;
+  this->GetRequestedSpatialOutputs(deformationField, determinant, spatialJacobian, resultImage);
+  if (!deformationField && !determinant && !spatialJacobian && !resultImage)
+  {
+    return nullptr;
+  }
+
+  /** Typedef's. */
+  typedef itk::Image<float, FixedImageDimension>                        JacobianImageType;
+  typedef itk::Matrix<float, MovingImageDimension, FixedImageDimension> OutputSpatialJacobianType;
+  typedef itk::Image<OutputSpatialJacobianType, FixedImageDimension>    SpatialJacobianImageType;
+
+  typedef itk::TransformToDisplacementAndSpatialJacobianSource<DeformationFieldImageType,
+                                                               JacobianImageType,
+                                                               SpatialJacobianImageType,
+                                                               MovingImageType,
+                                                               CoordRepType>
+    SpatialOutputsGeneratorType;
+  typedef typename SpatialOutputsGeneratorType::InterpolatorType ResampleInterpolatorType;
+
+  /** Create and setup the generator, for the requested outputs only. */
+  const auto generator = SpatialOutputsGeneratorType::New();
+  generator->SetTransform(const_cast<const ITKBaseType *>(this->GetAsITKBaseType()));
+  generator->SetOutputSize(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetSize());
+  generator->SetOutputSpacing(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputSpacing());
+  generator->SetOutputOrigin(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputOrigin());
+  generator->SetOutputIndex(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputStartIndex());
+  generator->SetOutputDirection(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputDirection());
+  generator->SetGenerateDisplacementField(deformationField);
+  generator->SetGenerateDeterminantOfSpatialJacobian(determinant);
+  generator->SetGenerateSpatialJacobian(spatialJacobian);
+
+  /** The result image is interpolated from the moving image, as by the resampler. */
+  generator->SetGenerateResultImage(resultImage);
+  if (resultImage)
+  {
+    generator->SetMovingImage(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetInput());
+    generator->SetInterpolator(
+      dynamic_cast<ResampleInterpolatorType *>(this->m_Elastix->GetElxResampleInterpolatorBase()));
+    generator->SetDefaultPixelValue(
+      this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetDefaultPixelValue());
+  }
+
+  /** Track the progress of the single pass. */
+  const auto progressObserver =
+    BaseComponent::IsElastixLibrary() ? nullptr : ProgressCommandType::CreateAndConnect(*generator);
+
+  elxout << "  Computing the spatial outputs in a single pass ..." << std::endl;
+  try
+  {
+    generator->Update();
+  }
+  catch (itk::ExceptionObject & excp)
+  {
+    /** Add information to the exception. */
+    excp.SetLocation("TransformBase - ComputeDeformationFieldAndSpatialJacobians()");
+    std::string err_str = excp.GetDescription();
+    err_str += "\nError occurred while generating the deformation field and spatial Jacobian images.\n";
+    excp.SetDescription(err_str);
+
+    /** Pass the exception to an higher level. */
+    throw excp;
+  }
+
+  /** Hand the outputs over to their writers. */
+  if (deformationField)
+  {
+    const typename DeformationFieldImageType::Pointer deformationfield =
+      this->RestoreOriginalDirection(*generator->GetDisplacementFieldOutput());
+    this->m_Elastix->SetResultDeformationField(deformationfield.GetPointer());
+
+    if (!BaseComponent::IsElastixLibrary())
+    {
+      this->WriteDeformationFieldImage(deformationfield);
+    }
+  }
+  if (determinant)
+  {
+    this->WriteSpatialJacobianImage(
+      *this->RestoreOriginalDirection(*generator->GetDeterminantOfSpatialJacobianOutput()), "spatialJacobian", false);
+  }
+  if (spatialJacobian)
+  {
+    this->WriteSpatialJacobianImage(
+      *this->RestoreOriginalDirection(*generator->GetSpatialJacobianOutput()), "fullSpatialJacobian", true);
+  }
+
+  this->m_SpatialOutputsComputedInSinglePass = true;
+
+  /** The result image is written by the resampler. */
+  if (resultImage)
+  {
+    return generator->GetResultImageOutput();
+  }
+  return nullptr;
+
+} // end ComputeDeformationFieldAndSpatialJacobians()
+
+
+/**
+ * ************** RestoreOriginalDirection **********************
+ *
+ * Possibly change direction cosines to their original value, as specified
+ * in the tp-file, or by the fixed image. This is only necessary when
+ * the UseDirectionCosines flag was set to false.
+ */
+
+template <class TElastix>
+template <class TImage>
+typename TImage::Pointer
+TransformBase<TElastix>::RestoreOriginalDirection(TImage & image) const
+{
+  typedef itk::ChangeInformationImageFilter<TImage> ChangeInfoFilterType;
+  typedef typename FixedImageType::DirectionType    FixedImageDirectionType;
+
+  const auto              infoChanger = ChangeInfoFilterType::New();
+  FixedImageDirectionType originalDirection;
+  bool                    retdc = this->GetElastix()->GetOriginalFixedImageDirection(originalDirection);
+  infoChanger->SetOutputDirection(originalDirection);
+  infoChanger->SetChangeDirection(retdc & !this->GetElastix()->GetUseDirectionCosines());
+  infoChanger->SetInput(&image);
+  infoChanger->Update();
+
+  return infoChanger->GetOutput();
+
+} // end RestoreOriginalDirection()
+
+
+/**
+ * ************** WriteSpatialJacobianImage **********************
+ */
+
+template <class TElastix>
+template <class TImage>
+void
+TransformBase<TElastix>::WriteSpatialJacobianImage(TImage &            image,
+                                                   const std::string & baseName,
+                                                   const bool          isMatrixImage) const
+{
+  typedef itk::ImageFileWriter<TImage>                    JacobianWriterType;
+  typedef itk::PixelTypeChangeCommand<JacobianWriterType> PixelTypeChangeCommandType;
+
+  /** Create a name for the spatial Jacobian file. */
+  std::string resultImageFormat = "mhd";
+  this->m_Configuration->ReadParameter(resultImageFormat, "ResultImageFormat", 0, false);
+  std::ostringstream makeFileName("");
+  makeFileName << this->m_Configuration->GetCommandLineArgument("-out") << baseName << "." << resultImageFormat;
+
+  /** Write outputImage to disk. */
+  const auto jacWriter = JacobianWriterType::New();
+  jacWriter->SetInput(&image);
+  jacWriter->SetFileName(makeFileName.str().c_str());
+  /** Hack to change the pixel type to vector. Not necessary for mhd. */
+  const auto jacStartWriteCommand = PixelTypeChangeCommandType::New();
+  if (isMatrixImage && resultImageFormat != "mhd")
+  {
+    jacWriter->AddObserver(itk::StartEvent(), jacStartWriteCommand);
+  }
+
+  /** Do the writing. */
+  elxout << "  Writing the " << (isMatrixImage ? "spatial Jacobian" : "spatial Jacobian determinant") << " ..."
+         << std::endl;
+  try
+  {
+    jacWriter->Update();
+  }
+  catch (itk::ExceptionObject & excp)
+  {
+    /** Add information to the exception. */
+    excp.SetLocation("TransformBase - WriteSpatialJacobianImage()");
+    std::string err_str = excp.GetDescription();
+    err_str += "\nError occurred while writing " + baseName + " image.\n";
+    excp.SetDescription(err_str);
+
+    /** Pass the exception to an higher level. */
+    throw excp;
+  }
+
+} // end WriteSpatialJacobianImage()
+
+
 /**
  * ************** SetTransformParametersFileName ****************
  */
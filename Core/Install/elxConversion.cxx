@@ -22,6 +22,7 @@
 
 #include <cassert>
 #include <cmath>   // For fmod.
+#include <cstdio>  // For snprintf.
 #include <iomanip> // For setprecision.
 #include <numeric> // For accumulate.
 #include <regex>
@@ -153,6 +154,46 @@ Conversion::ToString(const float scalar)
 }
 
 
+void
+Conversion::AppendIntegerToString(std::string & text, const long long integerValue)
+{
+  // Sufficient for the 19 digits and the sign of any 64-bit integer.
+  char         buffer[24];
+  char * const end = buffer + sizeof(buffer);
+  char *       begin = end;
+
+  // Take the magnitude as unsigned, to support the most negative value as well.
+  auto magnitude = static_cast<unsigned long long>(integerValue);
+  if (integerValue < 0)
+  {
+    magnitude = 0ULL - magnitude;
+  }
+
+  do
+  {
+    *--begin = static_cast<char>('0' + (magnitude % 10));
+    magnitude /= 10;
+  } while (magnitude != 0);
+
+  if (integerValue < 0)
+  {
+    *--begin = '-';
+  }
+  text.append(begin, end);
+}
+
+
+void
+Conversion::AppendFixedPointToString(std::string & text, const double scalar)
+{
+  // Sufficient for the 309 integer digits of the largest double, the sign, and the six decimals.
+  char      buffer[320];
+  const int numberOfChars = std::snprintf(buffer, sizeof(buffer), "%.6f", scalar);
+  assert(numberOfChars > 0 && static_cast<std::size_t>(numberOfChars) < sizeof(buffer));
+  text.append(buffer, static_cast<std::size_t>(numberOfChars));
+}
+
+
 bool
 Conversion::IsNumber(const std::string & str)
 {
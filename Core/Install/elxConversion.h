@@ -19,9 +19,12 @@
 #define elxConversion_h
 
 #include "itkMatrix.h"
+#include "itkSize.h"
 
 #include <vnl_vector.h>
 
+#include <algorithm> // For max and min.
+#include <cmath>     // For ceil.
 #include <iterator>
 #include <map>
 #include <string>
@@ -103,6 +106,20 @@ public:
   }
 
 
+  /** Appends an integer to the specified text, in decimal notation. Equivalent
+   * to `std::ostream::operator<<`, but much faster.
+   */
+  static void
+  AppendIntegerToString(std::string & text, long long integerValue);
+
+  /** Appends a floating point number to the specified text, in fixed notation with
+   * six digits after the decimal point. Equivalent to `std::ostream::operator<<`
+   * after `std::fixed` with the default precision, but without the overhead of a stream.
+   */
+  static void
+  AppendFixedPointToString(std::string & text, double scalar);
+
+
   /** Convenience function overload to convert a container to a vector of
    * text strings. The container may be an itk::Size, itk::Index,
    * itk::Point<double,N>, or itk::Vector<double,N>, or
@@ -159,6 +176,33 @@ public:
   }
 
 
+  /** Converts a memory budget, in megabytes, to the number of slabs along the last dimension in which
+   * an image of the specified size is streamed, given the number of bytes that each voxel takes while
+   * it is processed. A budget of zero or less means that the image is not streamed. The slabs are at
+   * least one slice thick.
+   */
+  template <unsigned int NDimension>
+  static unsigned int
+  MemoryBudgetToNumberOfStreamDivisions(const itk::Size<NDimension> & size,
+                                        const double                  numberOfBytesPerVoxel,
+                                        const double                  memoryBudget)
+  {
+    if (memoryBudget <= 0.0)
+    {
+      return 1;
+    }
+
+    double numberOfBytes = numberOfBytesPerVoxel;
+    for (unsigned int i = 0; i < NDimension; ++i)
+    {
+      numberOfBytes *= static_cast<double>(size[i]);
+    }
+    const double numberOfDivisions = std::ceil(numberOfBytes / (memoryBudget * 1024.0 * 1024.0));
+    const double maximumNumberOfDivisions = static_cast<double>(size[NDimension - 1]);
+    return static_cast<unsigned int>(std::max(1.0, std::min(numberOfDivisions, maximumNumberOfDivisions)));
+  }
+
+
   /** Convenience function which tells whether the argument may represent a number (either fixed point, floating point,
    * or integer/whole number).
    * \note IsNumber("NaN") and IsNumber("nan") return false.
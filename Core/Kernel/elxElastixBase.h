@@ -248,6 +248,15 @@ public:
   elxGetObjectMacro(ResultDeformationFieldContainer, DataObjectContainerType);
   elxSetObjectMacro(ResultDeformationFieldContainer, DataObjectContainerType);
 
+  /** Set/Get the input point set, whose points are transformed by transformix, instead of
+   * the points of the file specified by "-def". The result is stored as result point set.
+   * Both are stored as pointers to itk::DataObject.
+   */
+  elxGetObjectMacro(InputPointSet, DataObjectType);
+  elxSetObjectMacro(InputPointSet, DataObjectType);
+  elxGetObjectMacro(ResultPointSet, DataObjectType);
+  elxSetObjectMacro(ResultPointSet, DataObjectType);
+
   /** Set/Get The Image FileName containers.
    * Normally, these are filled in the BeforeAllBase function.
    */
@@ -543,6 +552,10 @@ private:
   /** The result deformation field container. These are stored as pointers to itk::DataObject. */
   DataObjectContainerPointer m_ResultDeformationFieldContainer;
 
+  /** The input and result point set of transformix. */
+  DataObjectPointer m_InputPointSet;
+  DataObjectPointer m_ResultPointSet;
+
   /** The image and mask FileNameContainers. */
   FileNameContainerPointer m_FixedImageFileNameContainer;
   FileNameContainerPointer m_MovingImageFileNameContainer;
@@ -308,6 +308,32 @@ ElastixTemplate<TFixedImage, TMovingImage>::ApplyTransform(void)
   timer.Stop();
   elxout << "  Calling all ReadFromFile()'s took " << timer.GetMean() << " s" << std::endl;
 
+  /** When several of the deformation field, the determinant of the spatial Jacobian,
+   * the full spatial Jacobian and the result image are requested, compute them in a
+   * single pass, so that the transform is evaluated only once per voxel.
+   */
+  typename MovingImageType::Pointer resultImage;
+  if (this->GetElxTransformBase()->UseSinglePassForSpatialOutputs())
+  {
+    timer.Reset();
+    timer.Start();
+    elxout << "Compute the spatial outputs in a single pass ..." << std::endl;
+    try
+    {
+      resultImage = this->GetElxTransformBase()->ComputeDeformationFieldAndSpatialJacobians();
+    }
+    catch (itk::ExceptionObject & excp)
+    {
+      /** The outputs are then computed one by one, by the functions below. */
+      xl::xout["error"] << excp << std::endl;
+      xl::xout["error"] << "However, transformix continues anyway, computing the spatial outputs separately."
+                        << std::endl;
+    }
+    timer.Stop();
+    elxout << "  Computing the spatial outputs done, it took " << Conversion::SecondsToDHMS(timer.GetMean(), 2)
+           << std::endl;
+  }
+
   /** Call TransformPoints.
    * Actually we could loop over all transforms.
    * But for now, there seems to be no use yet for that.
@@ -382,10 +408,22 @@ ElastixTemplate<TFixedImage, TMovingImage>::ApplyTransform(void)
     /** Write the resampled image to disk.
      * Actually we could loop over all resamplers.
      * But for now, there seems to be no use yet for that.
+     * The image may already have been resampled in the single pass.
      */
     if (!BaseComponent::IsElastixLibrary())
     {
-      this->GetElxResamplerBase()->ResampleAndWriteResultImage(makeFileName.str().c_str());
+      if (resultImage)
+      {
+        this->GetElxResamplerBase()->WriteResultImage(resultImage, makeFileName.str().c_str());
+      }
+      else
+      {
+        this->GetElxResamplerBase()->ResampleAndWriteResultImage(makeFileName.str().c_str());
+      }
+    }
+    else if (resultImage)
+    {
+      this->GetElxResamplerBase()->CreateItkResultImage(resultImage);
     }
     else
     {
@@ -127,6 +127,9 @@ TransformixMain::Run(void)
    */
   this->GetElastixBase()->SetMovingImageContainer(this->GetModifiableMovingImageContainer());
 
+  /** Set the input point set. If not set by the user, the points are read from disk. */
+  this->GetElastixBase()->SetInputPointSet(this->GetModifiableInputPointSet());
+
   /** Set the initial transform, if it happens to be there
    * \todo: Does this make sense for transformix?
    */
@@ -150,6 +153,7 @@ TransformixMain::Run(void)
   this->SetMovingImageContainer(this->GetElastixBase()->GetMovingImageContainer());
   this->SetResultImageContainer(this->GetElastixBase()->GetResultImageContainer());
   this->SetResultDeformationFieldContainer(this->GetElastixBase()->GetResultDeformationFieldContainer());
+  this->SetResultPointSet(this->GetElastixBase()->GetResultPointSet());
 
   return errorCode;
 
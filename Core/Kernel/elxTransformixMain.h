@@ -101,6 +101,14 @@ public:
   virtual void
   SetInputImageContainer(DataObjectContainerType * inputImageContainer);
 
+  /** Set/Get the input point set and the result point set. When an input point set
+   * is set, its points are transformed in memory, instead of the points of a file.
+   */
+  itkSetObjectMacro(InputPointSet, DataObjectType);
+  itkGetModifiableObjectMacro(InputPointSet, DataObjectType);
+  itkSetObjectMacro(ResultPointSet, DataObjectType);
+  itkGetModifiableObjectMacro(ResultPointSet, DataObjectType);
+
 protected:
   TransformixMain() = default;
   ~TransformixMain() override;
@@ -115,6 +123,10 @@ private:
   TransformixMain(const Self &) = delete;
   void
   operator=(const Self &) = delete;
+
+  /** The input and result point set. */
+  DataObjectPointer m_InputPointSet;
+  DataObjectPointer m_ResultPointSet;
 };
 
 } // end namespace elastix
@@ -0,0 +1,188 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include <elxTransformixFilter.h>
+
+// ITK header file:
+#include <itkImage.h>
+
+// GoogleTest header file:
+#include <gtest/gtest.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+constexpr auto ImageDimension = 2U;
+using ImageType = itk::Image<float, ImageDimension>;
+using FilterType = elastix::TransformixFilter<ImageType>;
+using PointSetType = FilterType::PointSetType;
+
+
+// Returns a parameter object for a translation by (1, -2), on a small (5x6) fixed image domain. The additional
+// parameters are added to the parameter map.
+elastix::ParameterObject::Pointer
+CreateTranslationParameterObject(const std::map<std::string, std::vector<std::string>> & additionalParameters = {})
+{
+  std::map<std::string, std::vector<std::string>> parameterMap = {
+    // Parameters in alphabetic order:
+    { "DefaultPixelValue", { "0" } },
+    { "Direction", { "1", "0", "0", "1" } },
+    { "HowToCombineTransforms", { "Compose" } },
+    { "Index", { "0", "0" } },
+    { "InitialTransformParametersFileName", { "NoInitialTransform" } },
+    { "NumberOfParameters", { "2" } },
+    { "Origin", { "0", "0" } },
+    { "ResampleInterpolator", { "FinalLinearInterpolator" } },
+    { "Resampler", { "DefaultResampler" } },
+    { "Size", { "5", "6" } },
+    { "Spacing", { "1", "1" } },
+    { "Transform", { "TranslationTransform" } },
+    { "TransformParameters", { "1", "-2" } }
+  };
+  for (const auto & parameter : additionalParameters)
+  {
+    parameterMap[parameter.first] = parameter.second;
+  }
+
+  const auto parameterObject = elastix::ParameterObject::New();
+  parameterObject->SetParameterMap(parameterMap);
+  return parameterObject;
+}
+
+} // namespace
+
+
+// Tests that the points of the fixed point set are transformed in memory, in the order in which they are specified.
+GTEST_TEST(TransformixFilter, TranslateFixedPointSet)
+{
+  const auto fixedPoints = PointSetType::PointsContainer::New();
+
+  // Includes points outside the fixed image domain, and non-integer coordinates.
+  for (const double x : { -3.5, 0.0, 0.25, 2.0, 4.0, 17.5 })
+  {
+    PointSetType::PointType point;
+    point[0] = x;
+    point[1] = 1.5 - x;
+    fixedPoints->push_back(point);
+  }
+
+  const auto fixedPointSet = PointSetType::New();
+  fixedPointSet->SetPoints(fixedPoints);
+
+  const auto filter = FilterType::New();
+  ASSERT_NE(filter, nullptr);
+
+  filter->SetFixedPointSet(fixedPointSet);
+  filter->SetTransformParameterObject(CreateTranslationParameterObject());
+  filter->Update();
+
+  const PointSetType * const outputPointSet = filter->GetOutputPointSet();
+  ASSERT_NE(outputPointSet, nullptr);
+  ASSERT_EQ(outputPointSet->GetNumberOfPoints(), fixedPoints->Size());
+
+  for (PointSetType::PointIdentifier i = 0; i < fixedPoints->Size(); ++i)
+  {
+    const auto & fixedPoint = fixedPoints->ElementAt(i);
+    const auto   outputPoint = outputPointSet->GetPoint(i);
+    EXPECT_DOUBLE_EQ(outputPoint[0], fixedPoint[0] + 1.0);
+    EXPECT_DOUBLE_EQ(outputPoint[1], fixedPoint[1] - 2.0);
+  }
+
+  // The input point set is not modified.
+  EXPECT_EQ(fixedPointSet->GetNumberOfPoints(), fixedPoints->Size());
+  EXPECT_EQ(fixedPointSet->GetPoint(0)[0], -3.5);
+}
+
+
+// Tests that an empty fixed point set yields an empty output point set.
+GTEST_TEST(TransformixFilter, EmptyFixedPointSet)
+{
+  const auto fixedPointSet = PointSetType::New();
+  fixedPointSet->SetPoints(PointSetType::PointsContainer::New());
+
+  const auto filter = FilterType::New();
+  filter->SetFixedPointSet(fixedPointSet);
+  filter->SetTransformParameterObject(CreateTranslationParameterObject());
+  filter->Update();
+
+  const PointSetType * const outputPointSet = filter->GetOutputPointSet();
+  ASSERT_NE(outputPointSet, nullptr);
+  EXPECT_EQ(outputPointSet->GetNumberOfPoints(), 0);
+}
+
+
+// Tests that the fixed point set and the fixed point set file name cannot be used at the same time.
+GTEST_TEST(TransformixFilter, FixedPointSetAndFileNameAreMutuallyExclusive)
+{
+  const auto fixedPointSet = PointSetType::New();
+  fixedPointSet->SetPoints(PointSetType::PointsContainer::New());
+
+  const auto filter = FilterType::New();
+  filter->SetFixedPointSet(fixedPointSet);
+  filter->SetFixedPointSetFileName("inputpoints.txt");
+  filter->SetTransformParameterObject(CreateTranslationParameterObject());
+  EXPECT_THROW(filter->Update(), itk::ExceptionObject);
+  EXPECT_EQ(filter->GetOutputPointSet(), nullptr);
+
+  // The fixed point set can be removed again.
+  filter->RemoveFixedPointSet();
+  EXPECT_EQ(filter->GetFixedPointSet(), nullptr);
+}
+
+
+// Tests that a result image that is computed slab by slab (ResultImageMemoryBudget > 0) equals the one that is
+// computed at once.
+GTEST_TEST(TransformixFilter, StreamedResultImageEqualsUnstreamedResultImage)
+{
+  const auto movingImage = ImageType::New();
+  movingImage->SetRegions(ImageType::SizeType{ { 5, 6 } });
+  movingImage->Allocate();
+  float * const movingPixels = movingImage->GetBufferPointer();
+  for (unsigned int i = 0; i < movingImage->GetBufferedRegion().GetNumberOfPixels(); ++i)
+  {
+    movingPixels[i] = static_cast<float>(i * i % 7) - 2.5f;
+  }
+
+  const auto ComputeResultImage = [movingImage](const char * const memoryBudget) {
+    const auto filter = FilterType::New();
+    filter->SetMovingImage(movingImage);
+    filter->SetTransformParameterObject(
+      CreateTranslationParameterObject({ { "ResultImageMemoryBudget", { memoryBudget } } }));
+    filter->Update();
+    return ImageType::Pointer(filter->GetOutput());
+  };
+
+  const auto expectedImage = ComputeResultImage("0");
+
+  // A budget that is smaller than a single row of pixels, so that each row is computed separately.
+  const auto actualImage = ComputeResultImage("1e-6");
+
+  ASSERT_NE(expectedImage, nullptr);
+  ASSERT_NE(actualImage, nullptr);
+  ASSERT_EQ(actualImage->GetBufferedRegion(), expectedImage->GetBufferedRegion());
+  for (unsigned int i = 0; i < expectedImage->GetBufferedRegion().GetNumberOfPixels(); ++i)
+  {
+    EXPECT_EQ(actualImage->GetBufferPointer()[i], expectedImage->GetBufferPointer()[i]);
+  }
+}
@@ -19,6 +19,8 @@
 #define elxTransformixFilter_h
 
 #include "itkImageSource.h"
+#include "itkPointSet.h"
+#include "itkDefaultStaticMeshTraits.h"
 
 #include "elxTransformixMain.h"
 #include "elxParameterObject.h"
@@ -75,6 +77,11 @@ public:
 
   itkStaticConstMacro(MovingImageDimension, unsigned int, TMovingImage::ImageDimension);
 
+  /** The type of the point sets that are transformed in memory. */
+  typedef itk::DefaultStaticMeshTraits<unsigned char, MovingImageDimension, MovingImageDimension, double>
+                                                                                 PointSetTraitsType;
+  typedef itk::PointSet<unsigned char, MovingImageDimension, PointSetTraitsType> PointSetType;
+
   /** Set/Get/Add moving image. */
   virtual void
   SetMovingImage(TMovingImage * inputImage);
@@ -92,6 +99,24 @@ public:
     this->SetFixedPointSetFileName("");
   }
 
+  /** Set/Get/Remove the fixed point set, whose points are transformed in memory.
+   * This is an alternative to SetFixedPointSetFileName(), avoiding any file I/O.
+   * The transformed points are available by GetOutputPointSet(), after Update().
+   */
+  virtual void
+  SetFixedPointSet(const PointSetType * pointSet);
+  const PointSetType *
+  GetFixedPointSet(void) const;
+  virtual void
+  RemoveFixedPointSet(void);
+
+  /** Get the transformed points of the fixed point set. */
+  const PointSetType *
+  GetOutputPointSet(void) const
+  {
+    return this->m_OutputPointSet.GetPointer();
+  }
+
   /** Compute spatial Jacobian On/Off. */
   itkSetMacro(ComputeSpatialJacobian, bool);
   itkGetConstMacro(ComputeSpatialJacobian, bool);
@@ -192,6 +217,8 @@ private:
 
   bool m_LogToConsole;
   bool m_LogToFile;
+
+  typename PointSetType::Pointer m_OutputPointSet;
 };
 
 } // namespace elastix
@@ -61,11 +61,13 @@ TransformixFilter<TMovingImage>::GenerateData(void)
   const unsigned int movingImageDimension = MovingImageDimension;
 
   if (this->IsEmpty(itkDynamicCastInDebugMode<TMovingImage *>(this->GetInput("InputImage"))) &&
-      this->GetFixedPointSetFileName().empty() && !this->GetComputeSpatialJacobian() &&
-      !this->GetComputeDeterminantOfSpatialJacobian() && !this->GetComputeDeformationField())
+      this->GetFixedPointSetFileName().empty() && this->GetFixedPointSet() == nullptr &&
+      !this->GetComputeSpatialJacobian() && !this->GetComputeDeterminantOfSpatialJacobian() &&
+      !this->GetComputeDeformationField())
   {
     itkExceptionMacro("Expected at least one of SeTMovingImage(), "
                       << "SetFixedPointSetFileName() "
+                      << "SetFixedPointSet(), "
                       << "ComputeSpatialJacobianOn(), "
                       << "ComputeDeterminantOfSpatialJacobianOn() or "
                       << "ComputeDeformationFieldOn(), "
@@ -80,6 +82,11 @@ TransformixFilter<TMovingImage>::GenerateData(void)
                       << "or SetFixedPointSetFileName() can be active at any one time.")
   }
 
+  if (this->GetFixedPointSet() != nullptr && !this->GetFixedPointSetFileName().empty())
+  {
+    itkExceptionMacro(<< "Only one of SetFixedPointSet() or SetFixedPointSetFileName() can be active at any one time.")
+  }
+
   // Setup argument map which transformix uses internally ito figure out what needs to be done
   ArgumentMapType argumentMap;
 
@@ -161,6 +168,10 @@ TransformixFilter<TMovingImage>::GenerateData(void)
     transformix->SetInputImageContainer(inputImageContainer);
   }
 
+  // Setup transformix for transforming the fixed point set in memory, if given
+  this->m_OutputPointSet = nullptr;
+  transformix->SetInputPointSet(this->GetInput("FixedPointSet"));
+
   // Get ParameterMap
   ParameterObjectPointer transformParameterObject =
     itkDynamicCastInDebugMode<ParameterObject *>(this->GetInput("TransformParameterObject"));
@@ -219,6 +230,8 @@ TransformixFilter<TMovingImage>::GenerateData(void)
   {
     this->GraftOutput("ResultDeformationField", resultDeformationFieldContainer->ElementAt(0));
   }
+  // Optionally, save the transformed fixed point set
+  this->m_OutputPointSet = dynamic_cast<PointSetType *>(transformix->GetResultPointSet());
 } // end GenerateData()
 
 
@@ -383,6 +396,42 @@ TransformixFilter<TMovingImage>::RemoveMovingImage(void)
 } // end RemoveMovingImage
 
 
+/**
+ * ********************* SetFixedPointSet *********************
+ */
+
+template <typename TMovingImage>
+void
+TransformixFilter<TMovingImage>::SetFixedPointSet(const PointSetType * pointSet)
+{
+  this->SetInput("FixedPointSet", const_cast<PointSetType *>(pointSet));
+} // end SetFixedPointSet()
+
+
+/**
+ * ********************* GetFixedPointSet *********************
+ */
+
+template <typename TMovingImage>
+const typename TransformixFilter<TMovingImage>::PointSetType *
+TransformixFilter<TMovingImage>::GetFixedPointSet(void) const
+{
+  return dynamic_cast<const PointSetType *>(this->GetInput("FixedPointSet"));
+} // end GetFixedPointSet()
+
+
+/**
+ * ********************* RemoveFixedPointSet *********************
+ */
+
+template <typename TMovingImage>
+void
+TransformixFilter<TMovingImage>::RemoveFixedPointSet(void)
+{
+  this->RemoveInput("FixedPointSet");
+} // end RemoveFixedPointSet()
+
+
 /**
  * ********************* SetTransformParameterObject *********************
  */
@@ -223,8 +223,72 @@ main(int argc, char * argv[])
   }
   timeCollector.Stop("JacobianGradient recursive new");
 
+  /** Time the scalar and the explicitly vectorized kernel of the recursive
+   * EvaluateJacobianWithImageGradientProduct() directly.
+   */
+  typedef itk::RecursiveBSplineInterpolationWeightFunction<CoordinateRepresentationType, Dimension, SplineOrder>
+    RecursiveWeightFunctionType;
+  typedef itk::RecursiveBSplineTransformImplementation<Dimension, Dimension, SplineOrder, CoordinateRepresentationType>
+    ScalarKernelType;
+  typedef itk::
+    RecursiveBSplineTransformVectorizedImplementation<Dimension, Dimension, SplineOrder, CoordinateRepresentationType>
+      VectorizedKernelType;
+  typedef RecursiveWeightFunctionType::WeightsType         RecursiveWeightsType;
+  typedef RecursiveWeightFunctionType::ContinuousIndexType ContinuousIndexType;
+
+  RecursiveWeightFunctionType::Pointer weightFunction = RecursiveWeightFunctionType::New();
+  const unsigned int                   numberOfWeights = RecursiveWeightFunctionType::NumberOfWeights;
+  RecursiveWeightsType::ValueType      weightsArray1D[numberOfWeights];
+  RecursiveWeightsType                 weights1D(weightsArray1D, numberOfWeights, false);
+  ContinuousIndexType                  cindex;
+  cindex[0] = 20.3;
+  cindex[1] = 18.7;
+  cindex[2] = 15.2;
+  IndexType supportIndex;
+  weightFunction->Evaluate(cindex, weights1D, supportIndex);
+
+  double migArray[Dimension];
+  for (unsigned int j = 0; j < Dimension; ++j)
+  {
+    migArray[j] = movingImageGradient[j];
+  }
+
+  DerivativeType imageJacobian_scalar(nnzji);
+  DerivativeType imageJacobian_vectorized(nnzji);
+  itk::TimeProbe timeProbeScalar, timeProbeVectorized;
+
+  timeProbeScalar.Start();
+  for (unsigned int i = 0; i < N; ++i)
+  {
+    CoordinateRepresentationType * imageJacobianPointer = imageJacobian_scalar.data_block();
+    ScalarKernelType::EvaluateJacobianWithImageGradientProduct(imageJacobianPointer, migArray, weightsArray1D, 1.0);
+
+    sum += imageJacobian_scalar(0); // just to avoid compiler to optimize away
+  }
+  timeProbeScalar.Stop();
+
+  timeProbeVectorized.Start();
+  for (unsigned int i = 0; i < N; ++i)
+  {
+    CoordinateRepresentationType * imageJacobianPointer = imageJacobian_vectorized.data_block();
+    VectorizedKernelType::EvaluateJacobianWithImageGradientProduct(
+      imageJacobianPointer, migArray, weightsArray1D, 1.0);
+
+    sum += imageJacobian_vectorized(0); // just to avoid compiler to optimize away
+  }
+  timeProbeVectorized.Stop();
+
   /** Report timings. */
   timeCollector.Report();
+  std::cerr << std::setprecision(4);
+  std::cerr << "Vectorized recursive kernel available: " << (VectorizedKernelType::IsVectorized ? "yes" : "no")
+            << std::endl;
+  std::cerr << "Time recursive kernel SCALAR = " << timeProbeScalar.GetMean() << " " << timeProbeScalar.GetUnit()
+            << std::endl;
+  std::cerr << "Time recursive kernel VECTORIZED = " << timeProbeVectorized.GetMean() << " "
+            << timeProbeVectorized.GetUnit() << std::endl;
+  std::cerr << "Speedup factor vectorized = " << timeProbeScalar.GetMean() / timeProbeVectorized.GetMean()
+            << std::endl;
 
   // Avoid compiler optimizations, so use sum
   std::cerr << sum << std::endl; // works but ugly on screen
@@ -249,6 +313,15 @@ main(int argc, char * argv[])
     return EXIT_FAILURE;
   }
 
+  diffNorm = (imageJacobian_scalar - imageJacobian_vectorized).magnitude();
+  std::cerr << "Vectorized recursive B-spline MSD with scalar: " << diffNorm << std::endl;
+  if (diffNorm > 1e-10)
+  {
+    std::cerr << "ERROR: Vectorized recursive B-spline EvaluateJacobianWithImageGradientProduct() returning "
+              << "incorrect result." << std::endl;
+    return EXIT_FAILURE;
+  }
+
   /** Return a value. */
   return EXIT_SUCCESS;
 
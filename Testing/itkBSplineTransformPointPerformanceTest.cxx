@@ -16,12 +16,14 @@
  *
  *=========================================================================*/
 #include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkRecursiveBSplineTransformImplementation.h"
 
 #include "itkImageRegionIterator.h"
 
 // Report timings
 #include "itkTimeProbe.h"
 
+#include <cmath>
 #include <fstream>
 #include <iomanip>
 
@@ -287,6 +289,61 @@ main(int argc, char * argv[])
   timeProbeNEW.Stop();
   const double newTime = timeProbeNEW.GetMean();
 
+  /** Time the scalar and the explicitly vectorized kernel of the recursive B-spline
+   * TransformPoint() directly, on the coefficients of the transform above.
+   */
+  typedef itk::RecursiveBSplineInterpolationWeightFunction<CoordinateRepresentationType, Dimension, SplineOrder>
+    RecursiveWeightFunctionType;
+  typedef itk::RecursiveBSplineTransformImplementation<Dimension, Dimension, SplineOrder, CoordinateRepresentationType>
+    ScalarKernelType;
+  typedef itk::
+    RecursiveBSplineTransformVectorizedImplementation<Dimension, Dimension, SplineOrder, CoordinateRepresentationType>
+      VectorizedKernelType;
+  typedef RecursiveWeightFunctionType::WeightsType         RecursiveWeightsType;
+  typedef RecursiveWeightFunctionType::ContinuousIndexType ContinuousIndexType;
+  typedef TransformType::ImagePointer                      CoefficientImagePointer;
+
+  RecursiveWeightFunctionType::Pointer weightFunction = RecursiveWeightFunctionType::New();
+  const unsigned int                   numberOfWeights = RecursiveWeightFunctionType::NumberOfWeights;
+  RecursiveWeightsType::ValueType      weightsArray1D[numberOfWeights];
+  RecursiveWeightsType                 weights1D(weightsArray1D, numberOfWeights, false);
+  ContinuousIndexType                  cindex;
+  cindex[0] = 20.3;
+  cindex[1] = 18.7;
+  cindex[2] = 15.2;
+  IndexType supportIndex;
+  weightFunction->Evaluate(cindex, weights1D, supportIndex);
+
+  const CoefficientImagePointer * coefficientImages = transform->GetCoefficientImages();
+  const itk::OffsetValueType *    offsetTable = coefficientImages[0]->GetOffsetTable();
+  CoordinateRepresentationType *  mu[Dimension];
+  for (unsigned int j = 0; j < Dimension; ++j)
+  {
+    mu[j] = coefficientImages[j]->GetBufferPointer() + coefficientImages[j]->ComputeOffset(supportIndex);
+  }
+
+  CoordinateRepresentationType displacementScalar[Dimension];
+  CoordinateRepresentationType displacementVectorized[Dimension];
+  itk::TimeProbe               timeProbeScalar, timeProbeVectorized;
+
+  timeProbeScalar.Start();
+  for (unsigned int i = 0; i < N; ++i)
+  {
+    ScalarKernelType::TransformPoint(displacementScalar, mu, offsetTable, weightsArray1D);
+    sum += displacementScalar[0];
+  }
+  timeProbeScalar.Stop();
+  const double scalarTime = timeProbeScalar.GetMean();
+
+  timeProbeVectorized.Start();
+  for (unsigned int i = 0; i < N; ++i)
+  {
+    VectorizedKernelType::TransformPoint(displacementVectorized, mu, offsetTable, weightsArray1D);
+    sum += displacementVectorized[0];
+  }
+  timeProbeVectorized.Stop();
+  const double vectorizedTime = timeProbeVectorized.GetMean();
+
   // Avoid compiler optimizations, so use sum
   std::cerr << sum << std::endl; // works but ugly on screen
   //  volatile double a = sum; // works but gives unused variable warning
@@ -298,6 +355,22 @@ main(int argc, char * argv[])
   std::cerr << "Time OLD = " << oldTime << " " << timeProbeOLD.GetUnit() << std::endl;
   std::cerr << "Time NEW = " << newTime << " " << timeProbeNEW.GetUnit() << std::endl;
   std::cerr << "Speedup factor = " << oldTime / newTime << std::endl;
+  std::cerr << "Vectorized recursive kernel available: " << (VectorizedKernelType::IsVectorized ? "yes" : "no")
+            << std::endl;
+  std::cerr << "Time recursive kernel SCALAR = " << scalarTime << " " << timeProbeScalar.GetUnit() << std::endl;
+  std::cerr << "Time recursive kernel VECTORIZED = " << vectorizedTime << " " << timeProbeVectorized.GetUnit()
+            << std::endl;
+  std::cerr << "Speedup factor vectorized = " << scalarTime / vectorizedTime << std::endl;
+
+  /** Check that the vectorized kernel agrees with the scalar kernel. */
+  for (unsigned int j = 0; j < Dimension; ++j)
+  {
+    if (std::abs(displacementScalar[j] - displacementVectorized[j]) > 1e-10)
+    {
+      std::cerr << "ERROR: vectorized recursive B-spline TransformPoint() returning incorrect result." << std::endl;
+      return 1;
+    }
+  }
 
   /** Return a value. */
   return 0;